@@ -0,0 +1,334 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <Compression.h>
+#include <RZip.h>
+#include "NLogger.h"
+
+#include "NBinaryPayload.h"
+
+namespace Ndmspc {
+
+namespace {
+const size_t kBlobHeaderSize = 32; ///< Size of blob header
+const char * kAxes[3]        = {"fXaxis", "fYaxis", "fZaxis"};
+
+/// Size of element of content type (0 if not a histogram type)
+size_t GetTypeSize(int type)
+{
+  static const size_t sizes[] = {0, 1, 2, 4, 4, 8};
+  return type > 0 && type <= 5 ? sizes[type] : 0;
+}
+
+/// Content type of histogram in TBufferJSON form (0 if not a histogram)
+int GetContentType(const json & j)
+{
+  auto it = j.find("_typename");
+  if (it == j.end() || !it->is_string()) return 0;
+  const std::string & t = it->get_ref<const std::string &>();
+  if (t.size() != 4 || t.compare(0, 2, "TH") != 0 || t[2] < '1' || t[2] > '3') return 0;
+  const char * types = "CSIFD";
+  const char * type  = std::strchr(types, t[3]);
+  return type && *type ? static_cast<int>(type - types) + 1 : 0;
+}
+
+bool IsNumberArray(const json & j)
+{
+  return j.is_array() && std::all_of(j.begin(), j.end(), [](const json & v) { return v.is_number(); });
+}
+
+void PutU32(std::string & out, size_t pos, uint32_t v) { std::memcpy(&out[pos], &v, sizeof(v)); }
+
+uint32_t GetU32(const char * in)
+{
+  uint32_t v;
+  std::memcpy(&v, in, sizeof(v));
+  return v;
+}
+
+void Pad(std::string & out, char c = '\0') { out.resize((out.size() + 7) / 8 * 8, c); }
+
+template <typename T>
+void AppendArray(std::string & out, const json & a)
+{
+  size_t pos = out.size();
+  out.resize(pos + a.size() * sizeof(T));
+  for (const auto & v : a) {
+    T x = static_cast<T>(v.get<double>());
+    std::memcpy(&out[pos], &x, sizeof(T));
+    pos += sizeof(T);
+  }
+  Pad(out);
+}
+
+template <typename T>
+json ReadArray(const char *& in, size_t n)
+{
+  json a = json::array();
+  for (size_t i = 0; i < n; i++) {
+    T x;
+    std::memcpy(&x, in + i * sizeof(T), sizeof(T));
+    a.push_back(x);
+  }
+  in += (n * sizeof(T) + 7) / 8 * 8;
+  return a;
+}
+} // namespace
+
+std::string NBinaryPayload::Pack(json message, ECompression compression, int level)
+{
+  ///
+  /// Pack message to binary frame
+  ///
+  std::string blobs;
+  Extract(message, blobs, compression, level);
+
+  std::string js = message.dump();
+  Pad(js, ' ');
+  std::string frame("NDMB\0\0\0\0", 8);
+  PutU32(frame, 4, js.size());
+  frame.reserve(frame.size() + js.size() + blobs.size());
+  frame += js;
+  frame += blobs;
+  return frame;
+}
+
+std::string NBinaryPayload::Pack(json message, const NUtils::RawJsonInjections & injections, ECompression compression,
+                                 int level)
+{
+  ///
+  /// Pack message with raw JSON injections to binary frame
+  ///
+  for (const auto & [path, rawJson] : injections) {
+    if (path.empty()) continue;
+    json * current = &message;
+    for (size_t k = 0; k + 1 < path.size(); ++k) current = &(*current)[path[k]];
+    try {
+      (*current)[path.back()] = json::parse(rawJson);
+    }
+    catch (const std::exception & e) {
+      NLogError("NBinaryPayload::Pack: Failed to parse raw JSON for '%s': %s", path.back().c_str(), e.what());
+    }
+  }
+  return Pack(std::move(message), compression, level);
+}
+
+bool NBinaryPayload::Unpack(const std::string & frame, json & message)
+{
+  ///
+  /// Unpack binary frame to message
+  ///
+  if (frame.size() < 8 || !IsFrame(frame)) return false;
+  size_t jsonSize = GetU32(frame.data() + 4);
+  if (8 + jsonSize > frame.size()) return false;
+  try {
+    message = json::parse(frame.begin() + 8, frame.begin() + 8 + jsonSize);
+  }
+  catch (const std::exception & e) {
+    NLogError("NBinaryPayload::Unpack: Failed to parse JSON part: %s", e.what());
+    return false;
+  }
+  try {
+    return Restore(message, frame.data() + 8 + jsonSize, frame.size() - 8 - jsonSize);
+  }
+  catch (const std::exception & e) {
+    NLogError("NBinaryPayload::Unpack: Failed to restore histograms: %s", e.what());
+    return false;
+  }
+}
+
+NBinaryPayload::ECompression NBinaryPayload::GetCompression(const std::string & name)
+{
+  ///
+  /// Get compression from name
+  ///
+  if (name == "zstd") return kZstd;
+  if (name == "zlib" || name == "deflate") return kZlib;
+  return kNone;
+}
+
+std::string NBinaryPayload::GetCompressionName(ECompression compression)
+{
+  ///
+  /// Get name of compression
+  ///
+  if (compression == kZstd) return "zstd";
+  if (compression == kZlib) return "zlib";
+  return "none";
+}
+
+void NBinaryPayload::Extract(json & j, std::string & blobs, ECompression compression, int level)
+{
+  ///
+  /// Moves histogram arrays of j to blobs
+  ///
+  if (j.is_array()) {
+    for (auto & v : j) Extract(v, blobs, compression, level);
+    return;
+  }
+  if (!j.is_object()) return;
+
+  const int type = GetContentType(j);
+  if (type == 0) {
+    for (auto & v : j) Extract(v, blobs, compression, level);
+    return;
+  }
+
+  // Arrays stay in JSON if any of them is not plain (e.g. TBufferJSON compressed form)
+  static const json empty = json::array();
+  const json &      contents = j.contains("fArray") ? j["fArray"] : empty;
+  const json &      errors   = j.contains("fSumw2") ? j["fSumw2"] : empty;
+  std::vector<const json *> edges;
+  bool                      valid = IsNumberArray(contents) && IsNumberArray(errors);
+  for (const char * axis : kAxes) {
+    const json * e = j.contains(axis) && j[axis].contains("fXbins") ? &j[axis]["fXbins"] : &empty;
+    valid          = valid && IsNumberArray(*e);
+    edges.push_back(e);
+  }
+  if (!valid) return;
+
+  std::string body;
+  switch (type) {
+  case 1: AppendArray<int8_t>(body, contents); break;
+  case 2: AppendArray<int16_t>(body, contents); break;
+  case 3: AppendArray<int32_t>(body, contents); break;
+  case 4: AppendArray<float>(body, contents); break;
+  default: AppendArray<double>(body, contents); break;
+  }
+  AppendArray<double>(body, errors);
+  for (const json * e : edges) AppendArray<double>(body, *e);
+
+  std::string compressed;
+  if (compression != kNone && !Compress(body, compressed, compression, level)) compression = kNone;
+  const std::string & stored = compression != kNone ? compressed : body;
+
+  const size_t offset = blobs.size();
+  blobs.append(kBlobHeaderSize, '\0');
+  std::memcpy(&blobs[offset], "NDMH", 4);
+  blobs[offset + 4] = 1;
+  blobs[offset + 5] = static_cast<char>(compression);
+  blobs[offset + 6] = static_cast<char>(type);
+  PutU32(blobs, offset + 8, contents.size());
+  PutU32(blobs, offset + 12, errors.size());
+  for (size_t i = 0; i < 3; i++) PutU32(blobs, offset + 16 + 4 * i, edges[i]->size());
+  PutU32(blobs, offset + 28, stored.size());
+  blobs += stored;
+  j["_blob"] = {offset, blobs.size() - offset};
+  Pad(blobs);
+
+  j.erase("fArray");
+  j.erase("fSumw2");
+  for (const char * axis : kAxes) {
+    if (j.contains(axis) && j[axis].is_object()) j[axis].erase("fXbins");
+  }
+}
+
+bool NBinaryPayload::Restore(json & j, const char * blobs, size_t size)
+{
+  ///
+  /// Restores histogram arrays of j from blobs
+  ///
+  if (j.is_array()) {
+    for (auto & v : j) {
+      if (!Restore(v, blobs, size)) return false;
+    }
+    return true;
+  }
+  if (!j.is_object()) return true;
+  if (!j.contains("_blob")) {
+    for (auto & v : j) {
+      if (!Restore(v, blobs, size)) return false;
+    }
+    return true;
+  }
+
+  const json & location = j["_blob"];
+  if (!location.is_array() || location.size() != 2 || !location[0].is_number_unsigned()) return false;
+  const size_t offset = location[0].get<size_t>();
+  if (offset + kBlobHeaderSize > size) return false;
+  const char * blob = blobs + offset;
+  if (std::memcmp(blob, "NDMH", 4) != 0 || blob[4] != 1) return false;
+  const int    compression = blob[5];
+  const int    type        = blob[6];
+  const size_t typeSize    = GetTypeSize(type);
+  const size_t nContents   = GetU32(blob + 8);
+  const size_t nErrors     = GetU32(blob + 12);
+  size_t       nEdges[3];
+  for (size_t i = 0; i < 3; i++) nEdges[i] = GetU32(blob + 16 + 4 * i);
+  const size_t stored = GetU32(blob + 28);
+  if (typeSize == 0 || offset + kBlobHeaderSize + stored > size) return false;
+
+  size_t bodySize = (nContents * typeSize + 7) / 8 * 8 + nErrors * 8;
+  for (size_t n : nEdges) bodySize += n * 8;
+
+  std::string  decompressed;
+  const char * body = blob + kBlobHeaderSize;
+  if (compression != kNone) {
+    if (!Decompress(body, stored, decompressed, bodySize)) return false;
+    body = decompressed.data();
+  }
+  else if (stored != bodySize) {
+    return false;
+  }
+
+  switch (type) {
+  case 1: j["fArray"] = ReadArray<int8_t>(body, nContents); break;
+  case 2: j["fArray"] = ReadArray<int16_t>(body, nContents); break;
+  case 3: j["fArray"] = ReadArray<int32_t>(body, nContents); break;
+  case 4: j["fArray"] = ReadArray<float>(body, nContents); break;
+  default: j["fArray"] = ReadArray<double>(body, nContents); break;
+  }
+  j["fSumw2"] = ReadArray<double>(body, nErrors);
+  for (size_t i = 0; i < 3; i++) {
+    json e = ReadArray<double>(body, nEdges[i]);
+    if (j.contains(kAxes[i]) && j[kAxes[i]].is_object()) j[kAxes[i]]["fXbins"] = e;
+  }
+  j.erase("_blob");
+  return true;
+}
+
+bool NBinaryPayload::Compress(const std::string & in, std::string & out, ECompression compression, int level)
+{
+  ///
+  /// Compress buffer to ROOT blocks
+  ///
+  const auto algorithm = compression == kZstd ? ROOT::RCompressionSetting::EAlgorithm::kZSTD
+                                              : ROOT::RCompressionSetting::EAlgorithm::kZLIB;
+  const size_t      kMaxBlock = 0xffffff; // Maximum size of one ROOT compression block
+  std::vector<char> block(std::min(in.size(), kMaxBlock));
+  out.clear();
+  for (size_t pos = 0; pos < in.size();) {
+    int srcSize = std::min(in.size() - pos, kMaxBlock);
+    int tgtSize = srcSize;
+    int irep    = 0;
+    R__zipMultipleAlgorithm(level, &srcSize, const_cast<char *>(in.data() + pos), &tgtSize, block.data(), &irep,
+                            algorithm);
+    if (irep <= 0 || irep >= srcSize) return false;
+    out.append(block.data(), irep);
+    pos += srcSize;
+  }
+  return !in.empty();
+}
+
+bool NBinaryPayload::Decompress(const char * in, size_t size, std::string & out, size_t outSize)
+{
+  ///
+  /// Decompress ROOT blocks
+  ///
+  out.resize(outSize);
+  size_t inPos = 0, outPos = 0;
+  while (inPos < size && outPos < outSize) {
+    int            srcSize = 0, tgtSize = 0, irep = 0;
+    unsigned char * src    = reinterpret_cast<unsigned char *>(const_cast<char *>(in + inPos));
+    if (size - inPos < 9 || R__unzip_header(&srcSize, src, &tgtSize) != 0) return false;
+    if (inPos + srcSize > size || outPos + tgtSize > outSize) return false;
+    R__unzip(&srcSize, src, &tgtSize, reinterpret_cast<unsigned char *>(&out[outPos]), &irep);
+    if (irep != tgtSize) return false;
+    inPos += srcSize;
+    outPos += tgtSize;
+  }
+  return inPos == size && outPos == outSize;
+}
+
+} // namespace Ndmspc
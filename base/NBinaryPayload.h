@@ -0,0 +1,101 @@
+#ifndef Ndmspc_NBinaryPayload_H
+#define Ndmspc_NBinaryPayload_H
+#include <string>
+#include "NUtils.h"
+
+namespace Ndmspc {
+
+/**
+ * @class NBinaryPayload
+ * @brief Binary form of JSON messages with histograms, for clients which ask for it.
+ *
+ * Histograms serialized by TBufferJSON (TH1, TH2 and TH3 of C, S, I, F and D types) are mostly arrays of
+ * numbers printed as text. Pack() moves the arrays of every such histogram in a message to a typed binary
+ * blob and leaves the rest of the histogram in the JSON part with "_blob": [offset, size] added, so the
+ * client gets JSROOT objects back by setting the arrays from the blob.
+ *
+ * Frame (little-endian, every part starts at a multiple of 8 bytes):
+ * - "NDMB", uint32 size of JSON part, JSON part (padded by spaces), blobs (offsets are relative to the
+ *   first byte after the JSON part)
+ *
+ * Blob:
+ * - "NDMH", uint8 version, uint8 compression (0 none, 1 zlib, 2 zstd), uint8 content type (1 int8,
+ *   2 int16, 3 int32, 4 float32, 5 float64), uint8 reserved
+ * - uint32 number of contents (fArray), errors (fSumw2), variable edges of x, y and z axes (fXbins),
+ *   uint32 size of body
+ * - body: contents of content type, errors and edges as float64 (each padded to 8 bytes), compressed
+ *   by ROOT (R__zip blocks, as in ROOT files) if compression is set
+ *
+ * @par Example Usage:
+ * @code{.cpp}
+ * json msg;
+ * msg["payload"]["map"]["obj"] = json::parse(TBufferJSON::ConvertToJSON(h).Data());
+ * std::string frame = NBinaryPayload::Pack(msg, NBinaryPayload::kZstd);
+ * @endcode
+ */
+class NBinaryPayload {
+  public:
+  /// Compression of blobs
+  enum ECompression { kNone = 0, kZlib = 1, kZstd = 2 };
+
+  /**
+   * @brief Pack message to binary frame.
+   * @param message Message (histograms in TBufferJSON form are moved to blobs).
+   * @param compression Compression of blobs.
+   * @param level Compression level (1-9).
+   * @return Frame.
+   */
+  static std::string Pack(json message, ECompression compression = kNone, int level = 1);
+
+  /**
+   * @brief Pack message with raw JSON injections (see NUtils::AddRawJsonInjection()) to binary frame.
+   * @param message Message.
+   * @param injections Raw JSON strings and their paths in message.
+   * @param compression Compression of blobs.
+   * @param level Compression level (1-9).
+   * @return Frame.
+   */
+  static std::string Pack(json message, const NUtils::RawJsonInjections & injections, ECompression compression = kNone,
+                          int level = 1);
+
+  /**
+   * @brief Unpack binary frame to message with histograms in TBufferJSON form.
+   * @param frame Frame.
+   * @param message Output message.
+   * @return True if frame is valid.
+   */
+  static bool Unpack(const std::string & frame, json & message);
+
+  /**
+   * @brief Check if buffer is a binary frame.
+   * @param frame Buffer.
+   * @return True if buffer starts with frame magic.
+   */
+  static bool IsFrame(const std::string & frame) { return frame.compare(0, 4, "NDMB") == 0; }
+
+  /**
+   * @brief Get compression from name.
+   * @param name "zstd", "zlib" or "deflate" (anything else is no compression).
+   * @return Compression.
+   */
+  static ECompression GetCompression(const std::string & name);
+
+  /**
+   * @brief Get name of compression.
+   * @param compression Compression.
+   * @return "zstd", "zlib" or "none".
+   */
+  static std::string GetCompressionName(ECompression compression);
+
+  private:
+  /// Moves histogram arrays of j to blobs
+  static void Extract(json & j, std::string & blobs, ECompression compression, int level);
+  /// Restores histogram arrays of j from blobs
+  static bool Restore(json & j, const char * blobs, size_t size);
+  /// Compress buffer to ROOT blocks, false if it does not get smaller
+  static bool Compress(const std::string & in, std::string & out, ECompression compression, int level);
+  /// Decompress ROOT blocks
+  static bool Decompress(const char * in, size_t size, std::string & out, size_t outSize);
+};
+} // namespace Ndmspc
+#endif
@@ -15,12 +15,13 @@
 namespace Ndmspc {
 
 // Singleton instance and mutex
-std::mutex     NLogger::fgLoggerMutex;
-logs::Severity NLogger::fgMinSeverity   = logs::Severity::kInfo;
-std::string    NLogger::fgLogDirectory  = "/tmp/.ndmspc/logs";
-bool           NLogger::fgConsoleOutput = true;
-bool           NLogger::fgFileOutput    = false; // Default: no file logging
-std::string    NLogger::fgProcessName   = "";
+std::mutex        NLogger::fgLoggerMutex;
+std::atomic<bool> NLogger::fgInitialized{false};
+logs::Severity    NLogger::fgMinSeverity   = logs::Severity::kInfo;
+std::string       NLogger::fgLogDirectory  = "/tmp/.ndmspc/logs";
+bool              NLogger::fgConsoleOutput = true;
+bool              NLogger::fgFileOutput    = false; // Default: no file logging
+std::string       NLogger::fgProcessName   = "";
 
 NLogger::NLogger()
 {
@@ -100,6 +101,8 @@ void NLogger::Init()
       fgFileOutput = false; // Disable file output on error
     }
   }
+
+  fgInitialized.store(true, std::memory_order_release);
 }
 
 void NLogger::Cleanup()
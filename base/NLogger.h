@@ -1,10 +1,7 @@
 #ifndef NdmspcCoreNLogger_H
 #define NdmspcCoreNLogger_H
 
-#include <memory>
-#include <mutex>
-#include <string>
-#include <unordered_map>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -22,9 +19,13 @@ using json = nlohmann::json;
  * @param format The printf-style format string.
  * @param ... Arguments for the format string.
  *
- * Logs the message with file name and line number information.
+ * Logs the message with file name and line number information. The severity is checked before
+ * the arguments are evaluated, so disabled levels cost a single comparison.
  */
-#define NLog(level, format, ...) Ndmspc::NLogger::Log(__FILE__, __LINE__, level, format, ##__VA_ARGS__)
+#define NLog(level, format, ...)                                                                                       \
+  do {                                                                                                                 \
+    if (Ndmspc::NLogger::IsEnabled(level)) Ndmspc::NLogger::Log(__FILE__, __LINE__, level, format, ##__VA_ARGS__);     \
+  } while (0)
 
 /**
  * @def NLogTrace
@@ -32,8 +33,7 @@ using json = nlohmann::json;
  * @param format The printf-style format string.
  * @param ... Arguments for the format string.
  */
-#define NLogTrace(format, ...) \
-  Ndmspc::NLogger::Log(__FILE__, __LINE__, Ndmspc::logs::Severity::kTrace, format, ##__VA_ARGS__)
+#define NLogTrace(format, ...) NLog(Ndmspc::logs::Severity::kTrace, format, ##__VA_ARGS__)
 
 /**
  * @def NLogDebug
@@ -41,8 +41,7 @@ using json = nlohmann::json;
  * @param format The printf-style format string.
  * @param ... Arguments for the format string.
  */
-#define NLogDebug(format, ...) \
-  Ndmspc::NLogger::Log(__FILE__, __LINE__, Ndmspc::logs::Severity::kDebug, format, ##__VA_ARGS__)
+#define NLogDebug(format, ...) NLog(Ndmspc::logs::Severity::kDebug, format, ##__VA_ARGS__)
 
 /**
  * @def NLogInfo
@@ -50,8 +49,7 @@ using json = nlohmann::json;
  * @param format The printf-style format string.
  * @param ... Arguments for the format string.
  */
-#define NLogInfo(format, ...) \
-  Ndmspc::NLogger::Log(__FILE__, __LINE__, Ndmspc::logs::Severity::kInfo, format, ##__VA_ARGS__)
+#define NLogInfo(format, ...) NLog(Ndmspc::logs::Severity::kInfo, format, ##__VA_ARGS__)
 
 /**
  * @def NLogWarning
@@ -59,8 +57,7 @@ using json = nlohmann::json;
  * @param format The printf-style format string.
  * @param ... Arguments for the format string.
  */
-#define NLogWarning(format, ...) \
-  Ndmspc::NLogger::Log(__FILE__, __LINE__, Ndmspc::logs::Severity::kWarn, format, ##__VA_ARGS__)
+#define NLogWarning(format, ...) NLog(Ndmspc::logs::Severity::kWarn, format, ##__VA_ARGS__)
 
 /**
  * @def NLogError
@@ -68,8 +65,7 @@ using json = nlohmann::json;
  * @param format The printf-style format string.
  * @param ... Arguments for the format string.
  */
-#define NLogError(format, ...) \
-  Ndmspc::NLogger::Log(__FILE__, __LINE__, Ndmspc::logs::Severity::kError, format, ##__VA_ARGS__)
+#define NLogError(format, ...) NLog(Ndmspc::logs::Severity::kError, format, ##__VA_ARGS__)
 
 /**
  * @def NLogFatal
@@ -77,8 +73,7 @@ using json = nlohmann::json;
  * @param format The printf-style format string.
  * @param ... Arguments for the format string.
  */
-#define NLogFatal(format, ...) \
-  Ndmspc::NLogger::Log(__FILE__, __LINE__, Ndmspc::logs::Severity::kFatal, format, ##__VA_ARGS__)
+#define NLogFatal(format, ...) NLog(Ndmspc::logs::Severity::kFatal, format, ##__VA_ARGS__)
 
 /**
  * @def NLogPrint
@@ -385,7 +380,7 @@ static const std::unordered_map<std::string, Severity> fgSeverityMap = {
  *
  * 1. Set severity appropriately: Use DEBUG/TRACE for development, INFO+ for production
  * 2. Name your threads: Easier debugging and log analysis
- * 3. Avoid tight loops: Don't log in high-frequency loops
+ * 3. Avoid tight loops: Don't log in high-frequency loops; count with NMetrics instead
  * 4. Use environment variables: Easy configuration without recompilation
  *
  * @code{.cpp}
@@ -502,6 +497,20 @@ class NLogger {
    */
   static logs::Severity GetMinSeverity() { return fgMinSeverity; }
 
+  /**
+   * @brief Checks if messages of a given severity are logged.
+   * @param level The severity level to check.
+   * @return True if the level passes the minimum severity.
+   *
+   * Used by the logging macros before their arguments are evaluated. The logger is initialized on
+   * first use so that NDMSPC_LOG_LEVEL is honoured.
+   */
+  static bool IsEnabled(logs::Severity level)
+  {
+    if (!fgInitialized.load(std::memory_order_acquire)) Instance();
+    return level >= fgMinSeverity;
+  }
+
   /**
    * @brief Sets the directory where log files will be stored.
    * @param dir The path to the log directory.
@@ -552,6 +561,7 @@ class NLogger {
 
   private:
   static std::mutex               fgLoggerMutex;   ///< Mutex for thread-safe singleton access
+  static std::atomic<bool>        fgInitialized;   ///< Flag set once environment configuration is read
   static logs::Severity           fgMinSeverity;   ///< Minimum severity level for logging
   static std::string              fgLogDirectory;  ///< Directory for log files
   static bool                     fgConsoleOutput; ///< Flag for console output
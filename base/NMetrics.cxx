@@ -0,0 +1,87 @@
+#include <string>
+#include <TSystem.h>
+#include "NLogger.h"
+
+#include "NMetrics.h"
+
+namespace Ndmspc {
+
+std::atomic<Long64_t> NMetrics::fgCounters[NMetrics::kNCounters] = {};
+std::atomic<Long64_t> NMetrics::fgSampleInterval{-1};
+
+const char * NMetrics::GetName(Counter c)
+{
+  ///
+  /// Returns counter name
+  ///
+  switch (c) {
+  case kTreeEntriesRead: return "tree_entries_read";
+  case kTreeBytesRead: return "tree_bytes_read";
+  case kTreeEntriesWritten: return "tree_entries_written";
+  case kTreeBytesWritten: return "tree_bytes_written";
+  case kTreeEntriesCloned: return "tree_entries_cloned";
+  case kRssSamples: return "rss_samples";
+  case kRssLastKB: return "rss_last_kb";
+  case kRssPeakKB: return "rss_peak_kb";
+  default: return "unknown";
+  }
+}
+
+Long64_t NMetrics::InitSampleInterval()
+{
+  ///
+  /// Read sampling interval from NDMSPC_METRICS_SAMPLE_INTERVAL (default 1000)
+  ///
+  Long64_t     interval = 1000;
+  const char * env      = gSystem->Getenv("NDMSPC_METRICS_SAMPLE_INTERVAL");
+  try {
+    if (env) interval = std::stoll(std::string(env));
+  }
+  catch (...) {
+    NLogWarning("NDMSPC_METRICS_SAMPLE_INTERVAL invalid: '%s'", env);
+  }
+  if (interval < 0) interval = 0;
+  fgSampleInterval.store(interval, std::memory_order_relaxed);
+  return interval;
+}
+
+void NMetrics::Sample(Counter c)
+{
+  ///
+  /// Sample resident memory
+  ///
+  ProcInfo_t info;
+  gSystem->GetProcInfo(&info);
+  const Long64_t rss = info.fMemResident;
+
+  fgCounters[kRssSamples].fetch_add(1, std::memory_order_relaxed);
+  fgCounters[kRssLastKB].store(rss, std::memory_order_relaxed);
+  Long64_t peak = fgCounters[kRssPeakKB].load(std::memory_order_relaxed);
+  while (rss > peak && !fgCounters[kRssPeakKB].compare_exchange_weak(peak, rss, std::memory_order_relaxed)) {
+  }
+
+  NLogDebug("NMetrics: [%s=%lld] read : %.3f MB written : %.3f MB [RSS]: %lld kB (peak %lld kB)", GetName(c),
+            Get(c), (double)Get(kTreeBytesRead) / (1024 * 1024), (double)Get(kTreeBytesWritten) / (1024 * 1024), rss,
+            Get(kRssPeakKB));
+}
+
+void NMetrics::Reset()
+{
+  ///
+  /// Reset all counters
+  ///
+  for (auto & c : fgCounters) c.store(0, std::memory_order_relaxed);
+}
+
+void NMetrics::Print()
+{
+  ///
+  /// Print all counters
+  ///
+  NLogInfo("NMetrics: sample interval=%lld", GetSampleInterval());
+  for (int i = 0; i < kNCounters; ++i) {
+    NLogInfo("  %-22s %lld", GetName(static_cast<Counter>(i)), Get(static_cast<Counter>(i)));
+  }
+}
+
+} // namespace Ndmspc
@@ -0,0 +1,114 @@
+#ifndef NdmspcBaseNMetrics_H
+#define NdmspcBaseNMetrics_H
+
+#include <atomic>
+#include <Rtypes.h>
+
+namespace Ndmspc {
+
+/**
+ * @class NMetrics
+ * @brief Process wide counters for hot paths.
+ *
+ * Counters are relaxed atomics, so updating them from the entry loops costs one add. Resident
+ * memory is not polled per entry but sampled by Tick() every NDMSPC_METRICS_SAMPLE_INTERVAL
+ * ticks (default 1000, 0 disables sampling); each sample is reported with NLogDebug.
+ *
+ * @par Example Usage:
+ * @code{.cpp}
+ * Ndmspc::NMetrics::Add(Ndmspc::NMetrics::kTreeBytesRead, nBytes);
+ * Ndmspc::NMetrics::Tick(Ndmspc::NMetrics::kTreeEntriesRead);
+ * Ndmspc::NMetrics::Print();
+ * @endcode
+ */
+class NMetrics {
+  public:
+  /// Counter identifiers
+  enum Counter {
+    kTreeEntriesRead = 0, ///< Entries read by NStorageTree::GetEntry
+    kTreeBytesRead,       ///< Bytes read by NStorageTree::GetEntry
+    kTreeEntriesWritten,  ///< Entries written by NStorageTree::Fill
+    kTreeBytesWritten,    ///< Bytes written by NStorageTree::Fill
+    kTreeEntriesCloned,   ///< Entries copied by fast cloning in NGnTree::Import
+    kRssSamples,          ///< Number of resident memory samples
+    kRssLastKB,           ///< Resident memory of the last sample [kB]
+    kRssPeakKB,           ///< Largest sampled resident memory [kB]
+    kNCounters            ///< Number of counters
+  };
+
+  /**
+   * @brief Add value to counter.
+   * @param c Counter.
+   * @param value Value to add.
+   */
+  static void Add(Counter c, Long64_t value) { fgCounters[c].fetch_add(value, std::memory_order_relaxed); }
+
+  /**
+   * @brief Increment counter and sample resident memory every sampling interval.
+   * @param c Counter.
+   */
+  static void Tick(Counter c)
+  {
+    const Long64_t n        = fgCounters[c].fetch_add(1, std::memory_order_relaxed) + 1;
+    const Long64_t interval = GetSampleInterval();
+    if (interval > 0 && n % interval == 0) Sample(c);
+  }
+
+  /**
+   * @brief Get counter value.
+   * @param c Counter.
+   * @return Current value.
+   */
+  static Long64_t Get(Counter c) { return fgCounters[c].load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Get counter name.
+   * @param c Counter.
+   * @return Name of counter.
+   */
+  static const char * GetName(Counter c);
+
+  /**
+   * @brief Sample resident memory now.
+   * @param c Counter that triggered the sample (used in the debug message).
+   */
+  static void Sample(Counter c);
+
+  /**
+   * @brief Get sampling interval in ticks.
+   * @return Interval, 0 if sampling is disabled.
+   */
+  static Long64_t GetSampleInterval()
+  {
+    Long64_t interval = fgSampleInterval.load(std::memory_order_relaxed);
+    return interval >= 0 ? interval : InitSampleInterval();
+  }
+
+  /**
+   * @brief Set sampling interval in ticks.
+   * @param interval Interval, 0 disables sampling.
+   */
+  static void SetSampleInterval(Long64_t interval)
+  {
+    fgSampleInterval.store(interval < 0 ? 0 : interval, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Reset all counters to zero.
+   */
+  static void Reset();
+
+  /**
+   * @brief Print all counters.
+   */
+  static void Print();
+
+  private:
+  static Long64_t InitSampleInterval();
+
+  static std::atomic<Long64_t> fgCounters[kNCounters]; ///< Counter values
+  static std::atomic<Long64_t> fgSampleInterval;       ///< Sampling interval (-1 until read from environment)
+};
+
+} // namespace Ndmspc
+#endif
@@ -1,5 +1,6 @@
 #include <cstddef>
 #include <iostream>
+#include <atomic>
 #include <mutex>
 #include <unordered_map>
 #include <chrono>
@@ -13,6 +14,9 @@
 #include <TF1.h>
 #include <TFile.h>
 #include <TThread.h>
+#include <TVirtualMutex.h>
+#include <TTree.h>
+#include <ROOT/TThreadExecutor.hxx>
 #include <TAxis.h>
 #include <THnSparse.h>
 #include <string>
@@ -60,6 +64,37 @@ static std::mutex gProgressThrottleMutex;
  */
 static std::unordered_map<void *, std::chrono::high_resolution_clock::time_point> gLastProgressTime;
 
+/**
+ * @brief Serialises TTree merges and clones (TTree::Merge is not thread safe).
+ */
+static std::mutex gTreeMergeMutex;
+
+/**
+ * @brief Macro load generation (see NUtils::GetMacroLoadGeneration()).
+ */
+static std::atomic<ULong64_t> gMacroLoadGeneration{0};
+
+/**
+ * @brief Merge objects of 'source' into the same-named objects of 'target'.
+ */
+static bool MergeListInto(TList * target, TList * source)
+{
+  bool      ok  = true;
+  TObject * obj = nullptr;
+  TIter     next(source);
+  while ((obj = next())) {
+    TObject * existing = target->FindObject(obj->GetName());
+    if (existing) {
+      ok = NUtils::MergeObject(existing, obj) && ok;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(gTreeMergeMutex, std::defer_lock);
+    if (obj->InheritsFrom(TTree::Class())) lock.lock();
+    target->Add(obj->Clone());
+  }
+  return ok;
+}
+
 /**
  * @brief Minimum seconds between progress updates (configurable via NDMSPC_PROGRESS_THROTTLE_SEC).
  */
@@ -75,6 +110,14 @@ static double gProgressThrottleSeconds = []() {
   return 1.0; // default 1 second
 }();
 
+bool NUtils::IsThreadSafetyEnabled()
+{
+  ///
+  /// Returns true if ROOT thread safety is enabled (the global mutex exists)
+  ///
+  return gGlobalMutex != nullptr;
+}
+
 bool NUtils::EnableMT(Int_t numthreads)
 {
   ///
@@ -891,9 +934,26 @@ TMacro * NUtils::OpenMacro(std::string filename)
   TMacro * m = new TMacro();
   m->SetName(basefilename.c_str());
   m->AddLine(content.c_str());
+  BumpMacroLoadGeneration();
   return m;
 }
 
+ULong64_t NUtils::GetMacroLoadGeneration()
+{
+  ///
+  /// Return macro load generation
+  ///
+  return gMacroLoadGeneration.load();
+}
+
+void NUtils::BumpMacroLoadGeneration()
+{
+  ///
+  /// Increase macro load generation
+  ///
+  ++gMacroLoadGeneration;
+}
+
 bool NUtils::LoadJsonFile(json & cfg, std::string filename)
 {
   ///
@@ -2209,6 +2269,82 @@ void NUtils::SafeDeleteObject(TObject *& obj)
   }
 }
 
+Long64_t NUtils::MergeListsPairwise(const std::vector<TList *> & lists)
+{
+  ///
+  /// Deterministic log-depth pairwise reduction of lists into the first one
+  ///
+  std::vector<TList *> work;
+  work.reserve(lists.size());
+  for (auto * lst : lists) {
+    if (lst) work.push_back(lst);
+  }
+  const size_t n = work.size();
+  if (n < 2) return 0;
+
+  for (size_t stride = 1; stride < n; stride *= 2) {
+    std::vector<size_t> targets;
+    for (size_t i = 0; i + stride < n; i += 2 * stride) targets.push_back(i);
+
+    auto mergePair = [&work, stride](size_t i) {
+      if (!MergeListInto(work[i], work[i + stride])) {
+        NLogWarning("NUtils::MergeListsPairwise: Some objects of list %zu could not be merged into list %zu",
+                    i + stride, i);
+      }
+    };
+    NLogTrace("NUtils::MergeListsPairwise: Round stride=%zu merging %zu pair(s)", stride, targets.size());
+    if (ROOT::IsImplicitMTEnabled() && targets.size() > 1) {
+      ROOT::TThreadExecutor pool;
+      pool.Foreach(mergePair, targets);
+    }
+    else {
+      for (auto i : targets) mergePair(i);
+    }
+  }
+  return static_cast<Long64_t>(n - 1);
+}
+
+bool NUtils::MergeObject(TObject * target, TObject * source)
+{
+  ///
+  /// Merge a single object into another one
+  ///
+  if (!target || !source) return false;
+  if (!source->InheritsFrom(target->IsA()) && !target->InheritsFrom(source->IsA())) {
+    NLogWarning("NUtils::MergeObject: Cannot merge '%s' (%s) into '%s' (%s) !!!", source->GetName(),
+                source->ClassName(), target->GetName(), target->ClassName());
+    return false;
+  }
+
+  if (auto * targetList = dynamic_cast<TList *>(target)) {
+    auto * sourceList = dynamic_cast<TList *>(source);
+    return sourceList ? MergeListInto(targetList, sourceList) : false;
+  }
+
+  TList single;
+  single.Add(source);
+  Long64_t rc = 0;
+  if (auto * h = dynamic_cast<TH1 *>(target)) {
+    rc = h->Merge(&single);
+  }
+  else if (auto * hn = dynamic_cast<THnBase *>(target)) {
+    rc = hn->Merge(&single);
+  }
+  else if (auto * t = dynamic_cast<TTree *>(target)) {
+    std::lock_guard<std::mutex> lock(gTreeMergeMutex);
+    rc = t->Merge(&single);
+  }
+  else if (ROOT::MergeFunc_t merge = target->IsA()->GetMerge()) {
+    rc = merge(target, &single, nullptr);
+  }
+  else {
+    NLogWarning("NUtils::MergeObject: Class '%s' of '%s' has no Merge method, keeping target only",
+                target->ClassName(), target->GetName());
+    return false;
+  }
+  return rc >= 0;
+}
+
 json NUtils::GetSystemStats()
 {
   json       out;
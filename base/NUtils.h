@@ -36,6 +36,15 @@ class NUtils : TObject {
    */
   static bool EnableMT(Int_t numthreads = -1);
 
+  /**
+   * @brief Check whether ROOT thread safety is enabled.
+   *
+   * ndmspc-run enables it at startup and NGnTree::Process via EnableMT(). Library code does not
+   * enable it on its own and runs sequentially when it is off.
+   * @return True after ROOT::EnableThreadSafety().
+   */
+  static bool IsThreadSafetyEnabled();
+
   /**
    * @brief Check if a path is accessible.
    * @param path Path to check.
@@ -92,6 +101,22 @@ class NUtils : TObject {
    */
   static TMacro * OpenMacro(std::string filename);
 
+  /**
+   * @brief Macro load generation of this process.
+   *
+   * Increased by OpenMacro() and BumpMacroLoadGeneration(). Forked workers keep the value they
+   * were started with, so a different value tells them that code was loaded after the fork.
+   * @return Current generation.
+   */
+  static ULong64_t GetMacroLoadGeneration();
+
+  /**
+   * @brief Increase the macro load generation.
+   *
+   * Call it after loading code by other means than OpenMacro() (e.g. gROOT->ProcessLine(".L ...")).
+   */
+  static void BumpMacroLoadGeneration();
+
   /**
    * @brief Loads a JSON configuration file into the provided json object.
    *
@@ -576,6 +601,33 @@ class NUtils : TObject {
    */
   static void SafeDeleteObject(TObject *& obj);
 
+  /**
+   * @brief Merge a sequence of lists with a log-depth pairwise reduction.
+   *
+   * Round r merges lists[i + 2^r] into lists[i] for every i that is a multiple
+   * of 2^(r+1). Pairs of one round run concurrently on the ROOT IMT pool when it
+   * is enabled. The reduction tree depends only on the order of the lists, so the
+   * result is bit-reproducible for any number of threads. Objects are matched by
+   * name and merged with MergeObject(); objects missing in the target are cloned.
+   * Lists other than lists[0] are used as intermediate results and may be modified.
+   *
+   * @param lists Lists to merge (nullptr entries are skipped). The result ends up in the first list.
+   * @return Number of lists merged into the first one.
+   */
+  static Long64_t MergeListsPairwise(const std::vector<TList *> & lists);
+
+  /**
+   * @brief Merge a single object into another one of the same kind.
+   *
+   * Supports TH1, THnBase, in-memory TTree (merges are serialised, TTree::Merge is
+   * not thread safe) and nested TList. Other classes use their dictionary merge function.
+   *
+   * @param target Object to merge into.
+   * @param source Object to merge from (unchanged).
+   * @return True on success.
+   */
+  static bool MergeObject(TObject * target, TObject * source);
+
   /**
    * @brief Create THnSparse from Parquet Taxi file.
    * @param filename Parquet file name.
@@ -47,5 +47,20 @@ void NWsClientInfo::IncrementMessageCount()
   fMessageCount++;
 }
 
+// Message format getters and setter implementation
+bool NWsClientInfo::IsBinary() const
+{
+  return fBinary;
+}
+int NWsClientInfo::GetCompression() const
+{
+  return fCompression;
+}
+void NWsClientInfo::SetFormat(bool binary, int compression)
+{
+  fBinary      = binary;
+  fCompression = compression;
+}
+
 
 } // namespace Ndmspc
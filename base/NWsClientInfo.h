@@ -19,6 +19,8 @@ class NWsClientInfo {
   std::string fUsername;     ///< Username associated with the client
   int         fMessageCount; ///< Number of messages sent/received
   std::chrono::system_clock::time_point fConnectedAt; ///< Connection start time
+  bool        fBinary{false};  ///< Client accepts binary frames (NBinaryPayload)
+  int         fCompression{0}; ///< Compression of binary frames (NBinaryPayload::ECompression)
 
   public:
   /**
@@ -68,6 +70,25 @@ class NWsClientInfo {
    */
   void IncrementMessageCount();
 
+  /**
+   * @brief Check if client accepts binary frames.
+   * @return True if binary frames are sent to client.
+   */
+  bool IsBinary() const;
+
+  /**
+   * @brief Get compression of binary frames.
+   * @return Compression (NBinaryPayload::ECompression).
+   */
+  int GetCompression() const;
+
+  /**
+   * @brief Set format of messages sent to client.
+   * @param binary Send binary frames instead of JSON text.
+   * @param compression Compression of binary frames (NBinaryPayload::ECompression).
+   */
+  void SetFormat(bool binary, int compression = 0);
+
 };
 
 } // namespace Ndmspc
@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <TAxis.h>
+#include <TObjArray.h>
+#include <TROOT.h>
+#include "NBinning.h"
+#include "NBinningDef.h"
+
+using namespace Ndmspc;
+
+/// Binning with `nAxes` axes of 10 bins each, so a rebin-1 definition has 10^nAxes combinations.
+static std::unique_ptr<NBinning> MakeBinning(int nAxes)
+{
+  TObjArray * axes = new TObjArray();
+  for (int i = 0; i < nAxes; ++i) {
+    TAxis * a = new TAxis(10, 0., 10.);
+    a->SetNameTitle(TString::Format("a%d", i).Data(), TString::Format("Axis %d", i).Data());
+    axes->Add(a);
+  }
+  return std::make_unique<NBinning>(axes);
+}
+
+/// NBinning::AddBinningDefinition is dominated by FillAll for fine definitions.
+static void BM_NBinning_FillAll(benchmark::State & state)
+{
+  const int  nAxes = static_cast<int>(state.range(0));
+  const bool imt   = state.range(1) != 0;
+  if (imt) ROOT::EnableImplicitMT();
+
+  std::map<std::string, std::vector<std::vector<int>>> b0;
+  for (int i = 0; i < nAxes; ++i) b0[TString::Format("a%d", i).Data()] = {{1}};
+
+  Long64_t nFilled = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto binning = MakeBinning(nAxes);
+    state.ResumeTiming();
+    binning->AddBinningDefinition("b0", b0);
+    nFilled = binning->GetDefinition("b0")->GetIds().size();
+    state.PauseTiming();
+    binning.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * nFilled);
+
+  if (imt) ROOT::DisableImplicitMT();
+}
+
+// Args: {axes (10 bins each, 1e5..1e8 combinations), implicit MT}
+BENCHMARK(BM_NBinning_FillAll)
+    ->ArgsProduct({{5, 6, 7, 8}, {0, 1}})
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+#include <TAxis.h>
+#include <TObjArray.h>
+#include "NBinning.h"
+#include "NBinningDef.h"
+#include "NBinningPoint.h"
+#include "NUtils.h"
+
+using namespace Ndmspc;
+
+/// Three-axis binning with one rebinned definition, similar to the binning tutorials.
+static std::unique_ptr<NBinning> MakeBinning()
+{
+  TObjArray * axes = new TObjArray();
+  TAxis *     a1   = new TAxis(100, -5., 5.);
+  a1->SetNameTitle("mean", "Mean");
+  axes->Add(a1);
+  TAxis * a2 = new TAxis(100, 0., 10.);
+  a2->SetNameTitle("sigma", "Sigma");
+  axes->Add(a2);
+  axes->Add(NUtils::CreateAxisFromLabels("entries", "Entries", {"10", "100", "1000", "10000"}));
+
+  auto binning = std::make_unique<NBinning>(axes);
+
+  std::map<std::string, std::vector<std::vector<int>>> b0;
+  b0["mean"]    = {{2}};
+  b0["sigma"]   = {{4}};
+  b0["entries"] = {{1}};
+  binning->AddBinningDefinition("b0", b0);
+  binning->SetCurrentDefinitionName("b0");
+  return binning;
+}
+
+/// Previous decoding path: coordinates copied to a vector and ranges returned as nested vectors.
+static void BM_NBinning_GetAxisRanges(benchmark::State & state)
+{
+  auto                          binning = MakeBinning();
+  const std::vector<Long64_t> & ids     = binning->GetDefinition()->GetIds();
+  NBinningPoint                 point(binning.get());
+  size_t                        i = 0;
+  for (auto _ : state) {
+    binning->GetContent()->GetBinContent(ids[i++ % ids.size()], point.GetCoords());
+    std::vector<int> contentVec = NUtils::ArrayToVector(point.GetCoords(), point.GetNDimensionsContent());
+    auto             ranges     = binning->GetAxisRanges(contentVec);
+    benchmark::DoNotOptimize(ranges.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// Current path: precomputed axis layout decoded into the point buffers.
+static void BM_NBinningPoint_RecalculateStorageCoords(benchmark::State & state)
+{
+  auto                          binning = MakeBinning();
+  const std::vector<Long64_t> & ids     = binning->GetDefinition()->GetIds();
+  NBinningPoint                 point(binning.get());
+  size_t                        i = 0;
+  for (auto _ : state) {
+    const Long64_t id = ids[i++ % ids.size()];
+    binning->GetContent()->GetBinContent(id, point.GetCoords());
+    benchmark::DoNotOptimize(point.RecalculateStorageCoords(id, false));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_NBinning_GetAxisRanges);
+BENCHMARK(BM_NBinningPoint_RecalculateStorageCoords);
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "NDimensionalExecutor.h"
+#include "NThreadData.h"
+
+using namespace Ndmspc;
+
+/// Cheap per-point work, comparable to a trivial per-bin process function.
+static void CheapTask(const std::vector<int> & coords, NThreadData & obj)
+{
+  long long sum = 0;
+  for (int v : coords) sum += v;
+  obj.SetCoordSum(obj.GetCoordSum() + sum);
+  obj.SetItemCount(obj.GetItemCount() + 1);
+}
+
+/// Uneven per-point work: the first tenth of the space is ~100x more expensive.
+static void UnevenTask(const std::vector<int> & coords, NThreadData & obj)
+{
+  const int iterations = (coords[0] < 10) ? 20000 : 200;
+  double    acc        = 0;
+  for (int i = 0; i < iterations; ++i) acc += std::sqrt(static_cast<double>(i + coords.back()));
+  benchmark::DoNotOptimize(acc);
+  obj.SetItemCount(obj.GetItemCount() + 1);
+}
+
+static void RunExecutor(benchmark::State & state, ParallelScheduler scheduler,
+                        void (*taskFunc)(const std::vector<int> &, NThreadData &))
+{
+  const int    nPerAxis = static_cast<int>(state.range(0));
+  const size_t nThreads = static_cast<size_t>(state.range(1));
+
+  NDimensionalExecutor executor({0, 0, 0}, {99, nPerAxis - 1, nPerAxis - 1});
+  executor.SetParallelScheduler(scheduler);
+  std::function<void(const std::vector<int> &, NThreadData &)> func = taskFunc;
+
+  for (auto _ : state) {
+    std::vector<NThreadData> threadData(nThreads);
+    for (size_t i = 0; i < threadData.size(); ++i) threadData[i].SetAssignedIndex(i);
+    executor.ExecuteParallel<NThreadData>(func, threadData);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(executor.GetTotalPoints()));
+}
+
+static void BM_ExecuteParallel_Queue_Cheap(benchmark::State & state)
+{
+  RunExecutor(state, ParallelScheduler::kQueue, CheapTask);
+}
+static void BM_ExecuteParallel_WorkStealing_Cheap(benchmark::State & state)
+{
+  RunExecutor(state, ParallelScheduler::kWorkStealing, CheapTask);
+}
+static void BM_ExecuteParallel_Queue_Uneven(benchmark::State & state)
+{
+  RunExecutor(state, ParallelScheduler::kQueue, UnevenTask);
+}
+static void BM_ExecuteParallel_WorkStealing_Uneven(benchmark::State & state)
+{
+  RunExecutor(state, ParallelScheduler::kWorkStealing, UnevenTask);
+}
+
+// Args: {points per inner axis, threads}
+#define NDMSPC_EXECUTOR_ARGS                                                                                            \
+  ->Args({10, 1})->Args({10, 4})->Args({30, 4})->Args({30, 16})->UseRealTime()->Unit(benchmark::kMillisecond)
+
+BENCHMARK(BM_ExecuteParallel_Queue_Cheap) NDMSPC_EXECUTOR_ARGS;
+BENCHMARK(BM_ExecuteParallel_WorkStealing_Cheap) NDMSPC_EXECUTOR_ARGS;
+BENCHMARK(BM_ExecuteParallel_Queue_Uneven) NDMSPC_EXECUTOR_ARGS;
+BENCHMARK(BM_ExecuteParallel_WorkStealing_Uneven) NDMSPC_EXECUTOR_ARGS;
@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <string>
+#include <thread>
 #include <vector>
 #include "TAxis.h"
 #include <TAttAxis.h>
 #include <TObjArray.h>
+#include <TROOT.h>
 #include "NBinningDef.h"
 #include "NBinningPoint.h"
 #include "NDimensionalExecutor.h"
@@ -418,131 +421,198 @@ Long64_t NBinning::FillAll(NBinningDef * def)
   ///
   /// Fill content binnings from mapping
   ///
+  /// All combinations of the selected binnings are filled in the same order as a scan over the
+  /// binnings (last axis fastest). Coordinates are taken from flat per-axis tables and the content and
+  /// definition histograms are filled by separate threads when ROOT implicit MT is enabled.
+  ///
   Long64_t nBinsFilled = 0;
 
   // fContent->Reset();
 
-  std::vector<int>                           mins(fMap->GetAxis(0)->GetNbins(), 1);
-  std::vector<int>                           maxs(fMap->GetAxis(0)->GetNbins(), 0);
-  std::vector<std::vector<std::vector<int>>> content(fMap->GetAxis(0)->GetNbins());
+  // Per axis: content coordinates of each selected binning (nCoords values per binning)
+  const Int_t                     nAxes = fMap->GetAxis(0)->GetNbins();
+  std::vector<std::vector<Int_t>> contentTable(nAxes);
+  std::vector<Int_t>              nCoords(nAxes, 0);
+  std::vector<Int_t>              nEntries(nAxes, 0);
 
   // loop over all selected bins via ROOT iterarot for THnSparse
   THnSparse *                                     cSparse = fMap;
   Int_t *                                         p       = new Int_t[cSparse->GetNdimensions()];
   Long64_t                                        linBin  = 0;
   std::unique_ptr<ROOT::Internal::THnBaseBinIter> iter{cSparse->CreateIter(true /*use axis range*/)};
-  // Print number of filled bins
-  // NLogInfo("Filled bins = %lld", cSparse->GetNbins());
   while ((linBin = iter->Next()) >= 0) {
-    Double_t v = cSparse->GetBinContent(linBin, p);
-    // continue;
-    int idx = p[0] - 1;
+    Double_t v   = cSparse->GetBinContent(linBin, p);
+    int      idx = p[0] - 1;
     NLogTrace("NBinning::FillAll: Bin %lld: %d %d %d %d type=%d content=%f", linBin, p[0], p[1], p[2], p[3],
               fBinningTypes[idx], v);
     if (fBinningTypes[idx] == Binning::kSingle) {
-
-      content[idx].push_back({p[0], p[3]});
+      contentTable[idx].push_back(p[3]);
+      nCoords[idx] = 1;
     }
     else if (fBinningTypes[idx] == Binning::kMultiple) {
-      // NLogDebug("Binning %d: %d", i, axes[idim]->GetNbins());
-      content[idx].push_back({p[0], p[1], p[2], p[3]});
+      contentTable[idx].insert(contentTable[idx].end(), {p[1], p[2], p[3]});
+      nCoords[idx] = 3;
     }
     else if (fBinningTypes[idx] == Binning::kUser) {
       // TODO: Fix nbins for user binning (it should ok now)
-      content[idx].push_back({p[0], 1});
+      contentTable[idx].push_back(1);
+      nCoords[idx] = 1;
     }
     else {
       NLogError("NBinning::FillAll: Unknown binning type %d", fBinningTypes[idx]);
       continue;
     }
-    maxs[idx] = maxs[idx] + 1;
+    nEntries[idx]++;
   }
   delete[] p;
+  fMap->Reset();
 
   Long64_t nTotalBins = 1;
   // loop over content vector and set axis types
-  for (size_t i = 0; i < content.size(); i++) {
-    if (content[i].size() == 0) {
-      NLogWarning("NBinning::FillAll: No content for binning %zu", i);
+  for (Int_t i = 0; i < nAxes; i++) {
+    if (nEntries[i] == 0) {
+      NLogWarning("NBinning::FillAll: No content for binning %d", i);
+      nTotalBins = 0;
       continue;
     }
 
-    if (content[i].size() > 0) {
-      TAxis * axis  = fAxes[i];
-      fAxisTypes[i] = AxisType::kVariable;
-      NLogTrace("NBinning::FillAll: Axis id=%d name=%s bins=%zu", i, axis->GetName(), content[i].size());
-      // check if i is persent in variable axes of def
-      bool found = false;
-      for (size_t j = 0; j < def->GetVariableAxes().size(); j++) {
-        if (def->GetVariableAxes()[j] == static_cast<int>(i)) {
-          NLogTrace("NBinning::FillAll: Axis id=%d name=%s already in variable axes of def", i, axis->GetName());
-          found = true;
-          break;
-        }
+    TAxis * axis  = fAxes[i];
+    fAxisTypes[i] = AxisType::kVariable;
+    NLogTrace("NBinning::FillAll: Axis id=%d name=%s bins=%d", i, axis->GetName(), nEntries[i]);
+    // check if i is persent in variable axes of def
+    bool found = false;
+    for (size_t j = 0; def && j < def->GetVariableAxes().size(); j++) {
+      if (def->GetVariableAxes()[j] == i) {
+        NLogTrace("NBinning::FillAll: Axis id=%d name=%s already in variable axes of def", i, axis->GetName());
+        found = true;
+        break;
       }
-      NLogTrace("NBinning::FillAll: Axis id=%d name=%s set to variable found=%d", i, axis->GetName(), found);
-      if (!found) def->AddVariableAxis(i);
     }
-    nTotalBins *= content[i].size();
+    NLogTrace("NBinning::FillAll: Axis id=%d name=%s set to variable found=%d", i, axis->GetName(), found);
+    if (def && !found) def->AddVariableAxis(i);
+    nTotalBins *= nEntries[i];
+  }
+
+  std::vector<Int_t> offsets(nAxes, 0);
+  Int_t              nContentDims = 0;
+  for (Int_t i = 0; i < nAxes; i++) {
+    offsets[i] = nContentDims;
+    nContentDims += nCoords[i];
+  }
+  if (nTotalBins == 0 || nContentDims != fContent->GetNdimensions()) {
+    NLogError("NBinning::FillAll: Nothing to fill (combinations=%lld content dims=%d expected=%d)", nTotalBins,
+              nContentDims, fContent->GetNdimensions());
+    return 0;
   }
 
-  def->Print();
+  if (def) {
+    def->SelectStorage(nTotalBins);
+    def->Print();
+  }
   NLogDebug("NBinning::FillAll: Filling total of %lld bins ...", nTotalBins);
 
   auto start_par = std::chrono::high_resolution_clock::now();
-  // Loop over all binning combinations
-  NDimensionalExecutor executor(mins, maxs);
-  auto binning_task = [&content, &nBinsFilled, &nTotalBins, start_par, def, this](const std::vector<int> & coords) {
-    std::vector<int> pointContentVector;
-    NLogTrace("Binning task: %s", NUtils::GetCoordsString(coords, -1).c_str());
-    for (size_t i = 0; i < coords.size(); i++) {
-      NLogTrace("  Binning %zu: coord=%d content size=%zu", i, coords[i], content[i].size());
-      if (content[i][coords[i] - 1].size() == 2) {
-        pointContentVector.push_back(content[i][coords[i] - 1][1]);
-      }
-      else {
-        pointContentVector.push_back(content[i][coords[i] - 1][1]);
-        pointContentVector.push_back(content[i][coords[i] - 1][2]);
-        pointContentVector.push_back(content[i][coords[i] - 1][3]);
+
+  // Per axis: storage bin of each selected binning. It depends only on the binning of that axis, so it is
+  // computed once per binning instead of once per combination.
+  const bool                      denseDef   = def && def->IsDense();
+  THnSparse *                     defContent = def && !denseDef ? def->GetContent() : nullptr;
+  std::vector<std::vector<Int_t>> storageTable(nAxes);
+  if (def) {
+    NBinningPoint point(this);
+    Int_t *       coords = point.GetCoords();
+    for (Int_t i = 0; i < nAxes; i++) {
+      std::copy_n(contentTable[i].data(), nCoords[i], coords + offsets[i]);
+    }
+    for (Int_t i = 0; i < nAxes; i++) {
+      storageTable[i].resize(nEntries[i]);
+      for (Int_t k = 0; k < nEntries[i]; k++) {
+        std::copy_n(contentTable[i].data() + k * nCoords[i], nCoords[i], coords + offsets[i]);
+        point.RecalculateStorageCoords();
+        storageTable[i][k] = point.GetStorageCoords()[i];
       }
+      std::copy_n(contentTable[i].data(), nCoords[i], coords + offsets[i]);
     }
+    def->ReserveIds(def->GetIds().size() + nTotalBins);
+  }
 
-    // NUtils::PrintPointSafe(pointContentVector, -1);
-    Int_t nContentDims = fContent->GetNdimensions();
-    NLogTrace("NBinning::FillAll: pointContentVector dims=%zu nContentDims=%d", pointContentVector.size(),
-              nContentDims);
+  // Moves to the next combination (last axis fastest)
+  auto next = [&nEntries, nAxes](std::vector<Int_t> & digits) {
+    for (Int_t i = nAxes - 1; i >= 0; --i) {
+      if (++digits[i] < nEntries[i]) return;
+      digits[i] = 0;
+    }
+  };
 
-    auto pointContent = std::make_unique<Int_t[]>(nContentDims);
+  // THnSparse is filled by one thread at a time, so the content and the definition histograms get one
+  // thread each. Both walk the combinations block by block in the same order. A dense definition
+  // is filled directly by storage coordinates.
+  const Long64_t        kBlockSize = 1 << 18;
+  std::vector<Long64_t> contentBins(std::min(kBlockSize, nTotalBins));
+  std::vector<Long64_t> storageBins(defContent ? contentBins.size() : 0);
+  std::vector<Int_t>    contentDigits(nAxes, 0);
+  std::vector<Int_t>    storageDigits(nAxes, 0);
+
+  auto fillContent = [&](Long64_t n) {
+    std::vector<Int_t> c(nContentDims);
+    for (Long64_t j = 0; j < n; j++) {
+      for (Int_t i = 0; i < nAxes; i++) {
+        std::copy_n(contentTable[i].data() + contentDigits[i] * nCoords[i], nCoords[i], c.data() + offsets[i]);
+      }
+      const Long64_t bin = fContent->GetBin(c.data());
+      fContent->SetBinContent(bin, 1);
+      contentBins[j] = bin;
+      next(contentDigits);
+    }
+  };
+  auto fillStorage = [&](Long64_t n) {
+    std::vector<Int_t> c(nAxes);
+    for (Long64_t j = 0; j < n; j++) {
+      for (Int_t i = 0; i < nAxes; i++) {
+        c[i] = storageTable[i][storageDigits[i]];
+      }
+      storageBins[j] = defContent->GetBin(c.data());
+      next(storageDigits);
+    }
+  };
 
-    // Int_t pointContent[nContentDims];
-    NUtils::VectorToArray(pointContentVector, pointContent.get());
-    Long64_t pointContentBin = fContent->GetBin(pointContent.get());
+  // Separate THnSparse objects can be filled concurrently once ROOT thread safety is on (implied by implicit MT)
+  const bool concurrent = defContent && nTotalBins > kBlockSize / 4 && ROOT::GetThreadPoolSize() > 1;
+  NLogDebug("NBinning::FillAll: Filling %s", concurrent ? "content and definition concurrently" : "sequentially");
 
-    // ids.push_back(pointContentBin);
-    if (def) {
-      NBinningPoint point(this);
-      fContent->GetBinContent(pointContentBin, point.GetCoords());
-      point.RecalculateStorageCoords();
-      Long64_t linBin = def->GetContent()->GetBin(point.GetStorageCoords());
-      def->GetContent()->SetBinContent(linBin, pointContentBin);
-      def->GetIds().push_back(pointContentBin);
+  for (Long64_t first = 0; first < nTotalBins; first += kBlockSize) {
+    const Long64_t n = std::min(kBlockSize, nTotalBins - first);
+    if (concurrent) {
+      std::thread storageThread(fillStorage, n);
+      fillContent(n);
+      storageThread.join();
+    }
+    else {
+      fillContent(n);
+      if (defContent) fillStorage(n);
     }
 
-    NLogTrace("NBinning::FillAll: Setting content bin %lld", pointContentBin);
-
-    fContent->SetBinContent(pointContentBin, 1);
-    nBinsFilled++;
-    // NLogDebug("NBinning::FillAll: Filled bin %lld: %s", nBinsFilled,
-    //                NUtils::GetCoordsString(pointContentVector, -1).c_str());
+    if (denseDef) {
+      std::vector<Int_t> c(nAxes);
+      for (Long64_t j = 0; j < n; j++) {
+        for (Int_t i = 0; i < nAxes; i++) {
+          c[i] = storageTable[i][storageDigits[i]];
+        }
+        def->SetContentAt(c.data(), contentBins[j]);
+        def->AddId(contentBins[j]);
+        next(storageDigits);
+      }
+    }
+    else if (defContent) {
+      for (Long64_t j = 0; j < n; j++) {
+        defContent->SetBinContent(storageBins[j], contentBins[j]);
+        def->AddId(contentBins[j]);
+      }
+    }
+    nBinsFilled += n;
     NLogTrace("NBinning::FillAll: Filled bin %lld: %lld", nBinsFilled, nTotalBins);
-    int refreshRate = nTotalBins / 100;
-    if (refreshRate == 0) refreshRate = nTotalBins;
-    if (nBinsFilled % (refreshRate) == 0 && nBinsFilled != nTotalBins)
-      Ndmspc::NUtils::ProgressBar(nBinsFilled, nTotalBins, start_par, "I    ");
-    // NLogDebug("NBinning::FillAll: [%3.2f%%] nBinsFilled=%lld", (double)nBinsFilled / nTotalBins * 100,
-    //                nBinsFilled);
-  };
-  executor.Execute(binning_task);
+    if (nBinsFilled != nTotalBins) Ndmspc::NUtils::ProgressBar(nBinsFilled, nTotalBins, start_par, "I    ");
+  }
 
   Ndmspc::NUtils::ProgressBar(nTotalBins, nTotalBins, start_par, "I    ");
 
@@ -552,8 +622,6 @@ Long64_t NBinning::FillAll(NBinningDef * def)
   NLogInfo("NBinning::FillAll: Filled %lld bins in %s s", nTotalBins,
            NUtils::FormatTime(par_duration.count() / 1000).c_str());
 
-  fMap->Reset();
-
   return nBinsFilled;
 }
 
@@ -1119,8 +1187,7 @@ void NBinning::AddBinningDefinition(std::string name, std::map<std::string, std:
   // std::vector<Long64_t> entries;
   Long64_t nFilled = FillAll(def);
   // def->Print();
-  NLogTrace("NBinning::AddBinningDefinition: Filled %lld bins for definition '%s'", nFilled,
-            NUtils::GetCoordsString(def->GetIds(), -1).c_str());
+  NLogTrace("NBinning::AddBinningDefinition: Filled %lld bins for definition '%s'", nFilled, name.c_str());
   // def->SetNEntries(nFilled);
 
   if (forceDefault || fCurrentDefinitionName.empty()) {
@@ -220,7 +220,7 @@ class NBinning : public TObject {
    * @brief Get vector of axis pointers.
    * @return Vector of TAxis pointers.
    */
-  std::vector<TAxis *> GetAxes() const { return fAxes; }
+  const std::vector<TAxis *> & GetAxes() const { return fAxes; }
 
   /**
    * @brief Get axes by type.
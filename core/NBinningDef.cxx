@@ -1,7 +1,15 @@
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <thread>
+#include <TBuffer.h>
+#include <TClass.h>
+#include <TDirectory.h>
+#include <TROOT.h>
+#include <TSystem.h>
 #include "NBinningDef.h"
 #include "TObjArray.h"
 #include "TObject.h"
-#include "NDimensionalExecutor.h"
 #include "NLogger.h"
 #include "NUtils.h"
 #include "NBinning.h"
@@ -11,6 +19,13 @@ ClassImp(Ndmspc::NBinningDef);
 /// \endcond
 
 namespace Ndmspc {
+
+namespace {
+/// Marks an empty bin in the dense content
+constexpr Long64_t kDenseEmpty = std::numeric_limits<Long64_t>::min();
+/// Largest dense content (8 bytes per bin)
+constexpr Long64_t kDenseMaxBins = Long64_t(1) << 27;
+} // namespace
 NBinningDef::NBinningDef(std::string name, std::map<std::string, std::vector<std::vector<int>>> definition,
                          NBinning * binning)
     : TObject(), fBinning(binning), fName(name), fDefinition(definition)
@@ -148,6 +163,7 @@ void NBinningDef::Print(Option_t * option) const
   /// Print the binning definition
   ///
 
+  EnsureIds();
   NLogInfo("NBinningDef: name='%s' %zu axes with %zu entries : %s", fName.c_str(), fDefinition.size(), fIds.size(),
            NUtils::GetCoordsString(fIds, -1).c_str());
 
@@ -182,6 +198,7 @@ Long64_t NBinningDef::GetId(size_t index) const
   /// Returns ID for given index
   ///
 
+  EnsureIds();
   if (index >= fIds.size()) {
     NLogError("NBinningDef::GetId: Index %d is out of range [0, %zu)", index, fIds.size());
     return -1;
@@ -194,35 +211,7 @@ void NBinningDef::RefreshIdsFromContent()
   ///
   /// Refresh IDs from content
   ///
-
-  fIds.clear();
-  Int_t * c    = new Int_t[fContent->GetNdimensions()];
-  auto    task = [this, c](const std::vector<int> & coords) {
-    NLogTrace("NBinningDef::RefreshIdsFromContent: Processing coordinates %s", NUtils::GetCoordsString(coords).c_str());
-
-    for (int i = 0; i < fContent->GetNdimensions(); i++) {
-      c[i] = coords[i];
-    }
-
-    Long64_t id = fContent->GetBinContent(c);
-    if (id > 0) {
-      NLogTrace("NBinningDef::RefreshIdsFromContent: -> Bin content: %lld", id - 1);
-      fIds.push_back(id - 1);
-    }
-  };
-
-  std::vector<int> mins(fContent->GetNdimensions(), 1);
-  std::vector<int> maxs(fContent->GetNdimensions());
-  for (int i = 0; i < fContent->GetNdimensions(); i++) {
-    TAxis * axis = fContent->GetAxis(i);
-    NLogTrace("NBinningDef::RefreshIdsFromContent: Axis %d: name='%s' title='%s' nbins=%d min=%.3f max=%.3f", i,
-              axis->GetName(), axis->GetTitle(), axis->GetNbins(), axis->GetXmin(), axis->GetXmax());
-    maxs[i] = axis->GetNbins();
-  }
-
-  NDimensionalExecutor executor(mins, maxs);
-  executor.Execute(task);
-  delete[] c;
+  CollectIdsFromContent();
 }
 
 void NBinningDef::RefreshContentFromIds()
@@ -232,49 +221,349 @@ void NBinningDef::RefreshContentFromIds()
   ///
 
   // print all ids
+  EnsureIds();
   NLogTrace("NBinningDef::RefreshContentfomIds: Refreshing content from %zu IDs: %s", fIds.size(),
             NUtils::GetCoordsString(fIds, -1).c_str());
 
-  fContent->Reset();
+  ResetContent();
   // loop over all ids and set content
   Long64_t id;
   for (size_t i = 0; i < fIds.size(); ++i) {
     id = fIds[i];
     fBinning->GetPoint()->SetPointContentFromLinearIndex(id);
-    fContent->SetBinContent(fBinning->GetPoint()->GetStorageCoords(), id + 1);
+    SetContentAt(fBinning->GetPoint()->GetStorageCoords(), id + 1);
   }
-  Int_t *               c = new Int_t[fContent->GetNdimensions()];
-  std::vector<Long64_t> newIds;
-  fIds.clear();
-  auto task = [this, &newIds, c](const std::vector<int> & coords) {
-    NLogTrace("NBinningDef::RefreshContentfomIds: Processing coordinates %s", NUtils::GetCoordsString(coords).c_str());
+  CollectIdsFromContent();
+}
 
-    for (int i = 0; i < fContent->GetNdimensions(); i++) {
-      c[i] = coords[i];
+void NBinningDef::CollectIdsFromContent()
+{
+  ///
+  /// Rebuild fIds from the filled bins of the content, ordered by content coordinates
+  /// (first axis slowest), i.e. the same order as a scan over all bins
+  ///
+  ClearIds();
+  if (IsDense()) {
+    // The dense array is already in coordinate order
+    for (const Long64_t v : fDenseContent) {
+      if (v > 0) fIds.push_back(v - 1);
     }
+    return;
+  }
 
-    Long64_t id = fContent->GetBinContent(c);
+  const Int_t    nDims   = fContent->GetNdimensions();
+  const Long64_t nFilled = fContent->GetNbins();
 
-    // FIXME: This is a workaround to skip empty bins after first filled one
-    // if (id == 0 && fIds.size() > 0) return; // skip empty bins after first filled one
-    // it should be ok now
-    if (id > 0) {
-      NLogTrace("NBinningDef::RefreshContentfomIds: -> Bin content: %lld", id - 1);
-      fIds.push_back(id - 1);
-    }
+  std::vector<Int_t> nBins(nDims);
+  for (Int_t i = 0; i < nDims; i++) {
+    nBins[i] = fContent->GetAxis(i)->GetNbins();
+  }
+
+  // THnSparse reads share a coordinate buffer, so the filled bins are read sequentially
+  std::vector<Int_t>    coords(static_cast<size_t>(nFilled) * nDims);
+  std::vector<Long64_t> ids;
+  ids.reserve(nFilled);
+  for (Long64_t bin = 0; bin < nFilled; ++bin) {
+    Int_t *        c  = &coords[ids.size() * nDims];
+    const Long64_t id = (Long64_t)fContent->GetBinContent(bin, c);
+    if (id <= 0) continue;
+    bool inRange = true;
+    for (Int_t i = 0; i < nDims && inRange; i++) inRange = c[i] >= 1 && c[i] <= nBins[i];
+    if (!inRange) continue;
+    ids.push_back(id - 1);
+  }
+  NLogTrace("NBinningDef::CollectIdsFromContent: %zu of %lld filled bins hold ids", ids.size(), nFilled);
+
+  const size_t kParallelMinBins = 1 << 16;
+  const size_t nChunks =
+      ids.size() < kParallelMinBins ? 1 : std::min<size_t>(std::max(1u, ROOT::GetThreadPoolSize()), 16);
+  const std::vector<size_t> order = SortByCoords(coords, nDims, ids.size(), nChunks);
+
+  fIds.reserve(ids.size());
+  for (const size_t i : order) fIds.push_back(ids[i]);
+}
+
+std::vector<size_t> NBinningDef::SortByCoords(const std::vector<Int_t> & coords, Int_t nDims, size_t n,
+                                              size_t nChunks)
+{
+  ///
+  /// Returns indices of the first n coordinate tuples sorted lexicographically. With nChunks > 1
+  /// the chunks are sorted in parallel threads and merged pairwise.
+  ///
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  auto lessCoords = [&coords, nDims](size_t a, size_t b) {
+    const Int_t * ca = &coords[a * nDims];
+    const Int_t * cb = &coords[b * nDims];
+    return std::lexicographical_compare(ca, ca + nDims, cb, cb + nDims);
   };
 
-  std::vector<int> mins(fContent->GetNdimensions(), 1);
-  std::vector<int> maxs(fContent->GetNdimensions());
-  for (int i = 0; i < fContent->GetNdimensions(); i++) {
-    TAxis * axis = fContent->GetAxis(i);
-    NLogTrace("NBinningDef::RefreshContentfomIds: Axis %d: name='%s' title='%s' nbins=%d min=%.3f max=%.3f", i,
-              axis->GetName(), axis->GetTitle(), axis->GetNbins(), axis->GetXmin(), axis->GetXmax());
-    maxs[i] = axis->GetNbins();
+  // Filled bins have distinct coordinates, so the order does not depend on the chunking
+  nChunks = std::min(nChunks, std::max<size_t>(1, n));
+  if (nChunks <= 1) {
+    std::sort(order.begin(), order.end(), lessCoords);
+  }
+  else {
+    std::vector<size_t> bounds(nChunks + 1);
+    for (size_t i = 0; i <= nChunks; ++i) bounds[i] = order.size() * i / nChunks;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nChunks; ++i) {
+      threads.emplace_back(
+          [&, i]() { std::sort(order.begin() + bounds[i], order.begin() + bounds[i + 1], lessCoords); });
+    }
+    for (auto & t : threads) t.join();
+    for (size_t width = 1; width < nChunks; width *= 2) {
+      for (size_t i = 0; i + width < nChunks; i += 2 * width) {
+        std::inplace_merge(order.begin() + bounds[i], order.begin() + bounds[i + width],
+                           order.begin() + bounds[std::min(i + 2 * width, nChunks)], lessCoords);
+      }
+    }
+  }
+  return order;
+}
+
+THnSparse * NBinningDef::GetContent() const
+{
+  ///
+  /// Returns content histogram (refreshed from the dense content in dense mode)
+  ///
+  SyncContent();
+  return fContent;
+}
+
+Long64_t NBinningDef::GetContentAt(const Int_t * coords) const
+{
+  ///
+  /// Returns content at storage coordinates
+  ///
+  if (IsDense()) {
+    const Long64_t index = DenseIndex(coords);
+    if (index < 0 || fDenseContent[index] == kDenseEmpty) return 0;
+    return fDenseContent[index];
+  }
+  const Long64_t bin = fContent->GetBin(coords, kFALSE);
+  return bin < 0 ? 0 : (Long64_t)fContent->GetBinContent(bin);
+}
+
+void NBinningDef::SetContentAt(const Int_t * coords, Long64_t value)
+{
+  ///
+  /// Sets content at storage coordinates
+  ///
+  if (IsDense()) {
+    const Long64_t index = DenseIndex(coords);
+    if (index >= 0) {
+      if (fDenseContent[index] == kDenseEmpty) fDenseOrder.push_back(index);
+      fDenseContent[index] = value;
+      fContentSynced       = false;
+      return;
+    }
+    // Under/overflow bins are only kept by THnSparse
+    NLogDebug("NBinningDef::SetContentAt: Coordinates outside of axes, switching '%s' to sparse content",
+              fName.c_str());
+    SetDense(false);
+  }
+  fContent->SetBinContent(coords, value);
+}
+
+void NBinningDef::ResetContent()
+{
+  ///
+  /// Removes all content
+  ///
+  fContent->Reset();
+  std::fill(fDenseContent.begin(), fDenseContent.end(), kDenseEmpty);
+  fDenseOrder.clear();
+  fContentSynced = true;
+}
+
+bool NBinningDef::SetDense(bool dense)
+{
+  ///
+  /// Switches between dense and sparse content
+  ///
+  if (dense == IsDense()) return true;
+
+  if (!dense) {
+    SyncContent();
+    std::vector<Long64_t>().swap(fDenseContent);
+    std::vector<Long64_t>().swap(fDenseOrder);
+    std::vector<Long64_t>().swap(fDenseStrides);
+    NLogDebug("NBinningDef::SetDense: Definition '%s' uses sparse content", fName.c_str());
+    return true;
+  }
+
+  const Int_t nDims = fContent->GetNdimensions();
+  Long64_t    nBins = 1;
+  fDenseStrides.assign(nDims, 1);
+  for (Int_t i = nDims - 1; i >= 0; i--) {
+    fDenseStrides[i] = nBins;
+    nBins *= fContent->GetAxis(i)->GetNbins();
+    if (nBins > kDenseMaxBins) {
+      NLogWarning("NBinningDef::SetDense: Definition '%s' has more than %lld bins, keeping sparse content",
+                  fName.c_str(), kDenseMaxBins);
+      fDenseStrides.clear();
+      return false;
+    }
+  }
+
+  fDenseContent.assign(nBins, kDenseEmpty);
+  fDenseOrder.clear();
+  fDenseOrder.reserve(fContent->GetNbins());
+  std::vector<Int_t> coords(nDims);
+  for (Long64_t bin = 0; bin < fContent->GetNbins(); ++bin) {
+    const Long64_t v     = (Long64_t)fContent->GetBinContent(bin, coords.data());
+    const Long64_t index = DenseIndex(coords.data());
+    if (index < 0) {
+      NLogDebug("NBinningDef::SetDense: Definition '%s' has under/overflow content, keeping sparse content",
+                fName.c_str());
+      std::vector<Long64_t>().swap(fDenseContent);
+      std::vector<Long64_t>().swap(fDenseOrder);
+      fDenseStrides.clear();
+      return false;
+    }
+    fDenseContent[index] = v;
+    fDenseOrder.push_back(index);
+  }
+  fContentSynced = true;
+  NLogDebug("NBinningDef::SetDense: Definition '%s' uses dense content with %lld bins", fName.c_str(), nBins);
+  return true;
+}
+
+void NBinningDef::SelectStorage(Long64_t nFilled)
+{
+  ///
+  /// Selects dense or sparse content for the expected number of filled bins
+  ///
+  std::string mode = "auto";
+  if (const char * env = gSystem->Getenv("NDMSPC_BINNING_DENSE")) {
+    mode = env;
+    std::transform(mode.begin(), mode.end(), mode.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  }
+
+  if (mode == "0" || mode == "false" || mode == "no" || mode == "off") {
+    SetDense(false);
+    return;
+  }
+  if (mode == "1" || mode == "true" || mode == "yes" || mode == "on") {
+    SetDense(true);
+    return;
+  }
+  if (mode != "auto") {
+    NLogWarning("NBinningDef::SelectStorage: Invalid NDMSPC_BINNING_DENSE='%s', using 'auto'", mode.c_str());
+  }
+
+  Long64_t nBins = 1;
+  for (Int_t i = 0; i < fContent->GetNdimensions() && nBins <= kDenseMaxBins; i++) {
+    nBins *= fContent->GetAxis(i)->GetNbins();
+  }
+  SetDense(nFilled >= nBins);
+}
+
+bool NBinningDef::HasId(Long64_t id) const
+{
+  ///
+  /// Checks if ID is in the definition
+  ///
+  EnsureIds();
+  if (!fSortedIdsValid) {
+    fSortedIds = fIds;
+    std::sort(fSortedIds.begin(), fSortedIds.end());
+    fSortedIds.erase(std::unique(fSortedIds.begin(), fSortedIds.end()), fSortedIds.end());
+    fSortedIdsValid = true;
   }
+  return std::binary_search(fSortedIds.begin(), fSortedIds.end(), id);
+}
 
-  NDimensionalExecutor executor(mins, maxs);
-  executor.Execute(task);
-  delete[] c;
+Long64_t NBinningDef::DenseIndex(const Int_t * coords) const
+{
+  Long64_t index = 0;
+  for (size_t i = 0; i < fDenseStrides.size(); i++) {
+    const Int_t c = coords[i];
+    if (c < 1 || c > fContent->GetAxis(i)->GetNbins()) return -1;
+    index += (c - 1) * fDenseStrides[i];
+  }
+  return index;
 }
+
+void NBinningDef::SyncContent() const
+{
+  ///
+  /// Rebuilds fContent from the dense content
+  ///
+  if (!IsDense() || fContentSynced) return;
+
+  // Bins are added in the order they were first filled, so linear bins of fContent match what
+  // filling THnSparse directly would give (fIds and GetId() rely on it)
+  fContent->Reset();
+  const size_t       nDims = fDenseStrides.size();
+  std::vector<Int_t> coords(nDims);
+  for (const Long64_t index : fDenseOrder) {
+    Long64_t rest = index;
+    for (size_t i = 0; i < nDims; i++) {
+      coords[i] = rest / fDenseStrides[i] + 1;
+      rest %= fDenseStrides[i];
+    }
+    fContent->SetBinContent(coords.data(), fDenseContent[index]);
+  }
+  fContentSynced = true;
+}
+
+void NBinningDef::SetIdsDirectory(TDirectory * dir)
+{
+  ///
+  /// Read IDs on first use from the index directory
+  ///
+  fIds.clear();
+  fIdsDir    = dir;
+  fIdsLoaded = false;
+  InvalidateSortedIds();
+}
+
+void NBinningDef::LoadIds() const
+{
+  ///
+  /// Read IDs from the index directory, or rebuild them from the content without it
+  ///
+  fIdsLoaded                  = true;
+  std::vector<Long64_t> * ids = fIdsDir ? fIdsDir->Get<std::vector<Long64_t>>(fName.c_str()) : nullptr;
+  if (ids) {
+    fIds.swap(*ids);
+    delete ids;
+    fSortedIdsValid = false;
+    NLogTrace("NBinningDef::LoadIds: Read %zu IDs of '%s' from the index", fIds.size(), fName.c_str());
+    return;
+  }
+  NLogDebug("NBinningDef::LoadIds: No index for '%s', rebuilding IDs from content ...", fName.c_str());
+  const_cast<NBinningDef *>(this)->CollectIdsFromContent();
+}
+
+void NBinningDef::Streamer(TBuffer & R__b)
+{
+  ///
+  /// Stream an object of class NBinningDef. Dense content is written as THnSparse.
+  ///
+  if (R__b.IsReading()) {
+    R__b.ReadClassBuffer(NBinningDef::Class(), this);
+    std::vector<Long64_t>().swap(fDenseContent);
+    std::vector<Long64_t>().swap(fDenseOrder);
+    fDenseStrides.clear();
+    fContentSynced  = true;
+    fSortedIdsValid = false;
+    fIdsDir         = nullptr;
+    fIdsLoaded      = true;
+  }
+  else {
+    EnsureIds();
+    SyncContent();
+    R__b.WriteClassBuffer(NBinningDef::Class(), this);
+    if (IsDense() && !fDenseOrder.empty()) {
+      // Do not keep the written bins next to the dense content
+      fContent->Reset();
+      fContentSynced = false;
+    }
+  }
+}
+
 } // namespace Ndmspc
@@ -1,11 +1,13 @@
 #ifndef Ndmspc_NBinningDef_H
 #define Ndmspc_NBinningDef_H
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <map>
 #include <TObject.h>
 #include <TAxis.h>
 #include <THnSparse.h>
+class TDirectory;
 namespace Ndmspc {
 
 /**
@@ -88,15 +90,99 @@ class NBinningDef : public TObject {
 
   /**
    * @brief Get list of bin IDs.
-   * @return Vector of bin IDs.
+   * @return Reference to vector of bin IDs.
    */
-  std::vector<Long64_t> GetIds() const { return fIds; }
+  const std::vector<Long64_t> & GetIds() const
+  {
+    EnsureIds();
+    return fIds;
+  }
 
   /**
-   * @brief Get reference to list of bin IDs.
-   * @return Reference to vector of bin IDs.
+   * @brief Set list of bin IDs.
+   * @param ids Bin IDs.
+   */
+  void SetIds(std::vector<Long64_t> ids)
+  {
+    fIds       = std::move(ids);
+    fIdsLoaded = true;
+    InvalidateSortedIds();
+  }
+
+  /**
+   * @brief Append bin ID.
+   * @param id Bin ID.
+   */
+  void AddId(Long64_t id)
+  {
+    EnsureIds();
+    fIds.push_back(id);
+    InvalidateSortedIds();
+  }
+
+  /**
+   * @brief Remove all bin IDs.
+   */
+  void ClearIds()
+  {
+    fIds.clear();
+    fIdsLoaded = true;
+    InvalidateSortedIds();
+  }
+
+  /**
+   * @brief Reserve space for bin IDs.
+   * @param n Number of IDs.
+   */
+  void ReserveIds(size_t n)
+  {
+    EnsureIds();
+    fIds.reserve(n);
+  }
+
+  /**
+   * @brief Sort bin IDs in ascending order.
+   */
+  void SortIds()
+  {
+    EnsureIds();
+    std::sort(fIds.begin(), fIds.end());
+  }
+
+  /**
+   * @brief Read bin IDs on first use from the key with the definition name in a directory.
+   *
+   * Drops the current IDs. Without the key (or with dir = nullptr) they are rebuilt from the content.
+   * @param dir Index directory of the file the definition was read from.
    */
-  std::vector<Long64_t> & GetIds() { return fIds; }
+  void SetIdsDirectory(TDirectory * dir);
+
+  /**
+   * @brief Forget the index directory before its file is closed.
+   *
+   * IDs not read yet are rebuilt from the content on first use.
+   */
+  void DetachIdsDirectory() { fIdsDir = nullptr; }
+
+  /**
+   * @brief Check if bin IDs are in memory.
+   * @return False while IDs are still to be read on first use.
+   */
+  bool HasIdsLoaded() const { return fIdsLoaded; }
+
+  /**
+   * @brief Check if an ID belongs to the definition.
+   *
+   * Binary search in a sorted copy of the IDs, built on first use after the IDs changed.
+   * @param id Bin ID.
+   * @return True if the ID is in the definition.
+   */
+  bool HasId(Long64_t id) const;
+
+  /**
+   * @brief Drop the sorted copy of the IDs used by HasId().
+   */
+  void InvalidateSortedIds() { fSortedIdsValid = false; }
 
   /**
    * @brief Get bin ID at specified index.
@@ -111,11 +197,89 @@ class NBinningDef : public TObject {
    */
   TObjArray * GetAxes() const { return fContent->GetListOfAxes(); }
 
+  /**
+   * @brief Get number of content axes (does not refresh dense content).
+   * @return Number of dimensions.
+   */
+  Int_t GetNdimensions() const { return fContent->GetNdimensions(); }
+
+  /**
+   * @brief Get content axis (does not refresh dense content).
+   * @param i Axis index.
+   * @return Pointer to TAxis.
+   */
+  TAxis * GetAxis(Int_t i) const { return fContent->GetAxis(i); }
+
+  /**
+   * @brief Get the content histogram for its axes only.
+   *
+   * Unlike GetContent() the bins are not refreshed from the dense array, so they must not be read.
+   * @return Pointer to THnSparse histogram.
+   */
+  THnSparse * GetContentTemplate() const { return fContent; }
+
   /**
    * @brief Get the template content histogram.
+   *
+   * In dense mode the histogram is first refreshed from the dense array. Content must then be
+   * modified via SetContentAt() and ResetContent(), not through the returned histogram.
    * @return Pointer to THnSparse histogram.
    */
-  THnSparse * GetContent() const { return fContent; }
+  THnSparse * GetContent() const;
+
+  /**
+   * @brief Get content stored at storage coordinates.
+   * @param coords Storage coordinates (one per axis).
+   * @return Stored value, 0 for an empty bin.
+   */
+  Long64_t GetContentAt(const Int_t * coords) const;
+
+  /**
+   * @brief Set content at storage coordinates.
+   * @param coords Storage coordinates (one per axis).
+   * @param value Value to store.
+   */
+  void SetContentAt(const Int_t * coords, Long64_t value);
+
+  /**
+   * @brief Remove all content.
+   */
+  void ResetContent();
+
+  /**
+   * @brief Keep content as a dense array indexed by strides instead of THnSparse.
+   *
+   * The THnSparse content is rebuilt from the dense array only when it is requested
+   * via GetContent() or when the definition is written; after writing the rebuilt bins are dropped again.
+   * @param dense Use dense storage.
+   * @return True if the requested storage is used (dense storage fails for too many bins).
+   */
+  bool SetDense(bool dense);
+
+  /**
+   * @brief Check if content is kept as a dense array.
+   * @return True in dense mode.
+   */
+  bool IsDense() const { return !fDenseContent.empty(); }
+
+  /**
+   * @brief Choose content storage for the expected number of filled bins.
+   *
+   * Controlled by NDMSPC_BINNING_DENSE: `auto` (default, dense when all bins are filled),
+   * `on` (dense whenever it fits) or `off`.
+   * @param nFilled Number of bins that will be filled.
+   */
+  void SelectStorage(Long64_t nFilled);
+
+  /**
+   * @brief Sort coordinate tuples lexicographically (first axis slowest).
+   * @param coords Coordinates, nDims values per tuple.
+   * @param nDims Number of dimensions.
+   * @param n Number of tuples to sort.
+   * @param nChunks Number of chunks sorted in parallel and merged (1 sorts sequentially).
+   * @return Indices of the tuples in sorted order.
+   */
+  static std::vector<size_t> SortByCoords(const std::vector<Int_t> & coords, Int_t nDims, size_t n, size_t nChunks);
 
   /**
    * @brief Get pointer to parent NBinning object.
@@ -124,12 +288,38 @@ class NBinningDef : public TObject {
   NBinning * GetBinning() const { return fBinning; }
 
   private:
+  /// Rebuild fIds from the filled content bins
+  void CollectIdsFromContent();
+
+  /// Read fIds if they are still to be read on first use
+  void EnsureIds() const
+  {
+    if (!fIdsLoaded) LoadIds();
+  }
+
+  /// Read fIds from the index directory, or rebuild them from the content
+  void LoadIds() const;
+
+  /// Index of storage coordinates in the dense array, -1 if outside the axes
+  Long64_t DenseIndex(const Int_t * coords) const;
+
+  /// Rebuild fContent from the dense array if it changed
+  void SyncContent() const;
+
   NBinning *                                           fBinning{nullptr}; ///< Pointer to the parent binning
   std::string                                          fName;             ///< Name of the binning definition
   std::map<std::string, std::vector<std::vector<int>>> fDefinition;       ///< Binning mapping definition
-  std::vector<int>      fVariableAxes{};   ///< List of variable axes indices in the content histogram
-  std::vector<Long64_t> fIds{};            ///< List of IDs for the binning definition
-  THnSparse *           fContent{nullptr}; ///< Template histogram for the binning definition
+  std::vector<int>              fVariableAxes{};       ///< List of variable axes indices in the content histogram
+  mutable std::vector<Long64_t> fIds{};                ///< List of IDs for the binning definition
+  THnSparse *                   fContent{nullptr};     ///< Template histogram for the binning definition
+  std::vector<Long64_t>         fDenseContent{};       ///<! Dense content (last axis fastest), empty in sparse mode
+  std::vector<Long64_t>         fDenseOrder{};         ///<! Dense bins in the order they were first filled
+  std::vector<Long64_t>         fDenseStrides{};       ///<! Strides of the dense content per axis
+  mutable bool                  fContentSynced{true};  ///<! fContent matches the dense content
+  mutable std::vector<Long64_t> fSortedIds{};          ///<! Sorted copy of fIds for HasId()
+  mutable bool                  fSortedIdsValid{false}; ///<! fSortedIds matches fIds
+  TDirectory *                  fIdsDir{nullptr};       ///<! Index directory fIds are read from on first use
+  mutable bool                  fIdsLoaded{true};       ///<! fIds are in memory
 
   /// \cond CLASSIMP
   ClassDef(NBinningDef, 1);
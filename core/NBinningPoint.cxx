@@ -1,6 +1,7 @@
 #include <vector>
 #include <TAxis.h>
 #include "NBinningDef.h"
+#include "NBulkProjection.h"
 #include "NLogger.h"
 #include "NStorageTree.h"
 #include "NUtils.h"
@@ -35,9 +36,11 @@ NBinningPoint::NBinningPoint(NBinning * b) : TObject(), fBinning(b)
   fStorageCoords      = new Int_t[fNDimensions];
   fMins               = new Double_t[fNDimensions];
   fMaxs               = new Double_t[fNDimensions];
+  fCenters            = new Double_t[fNDimensions];
   fBaseBinMin         = new Int_t[fNDimensions];
   fBaseBinMax         = new Int_t[fNDimensions];
   fLabels.resize(fNDimensions);
+  BuildLayout();
 
   Reset();
 }
@@ -47,6 +50,7 @@ NBinningPoint::~NBinningPoint()
   delete[] fStorageCoords;
   delete[] fMins;
   delete[] fMaxs;
+  delete[] fCenters;
   delete[] fBaseBinMin;
   delete[] fBaseBinMax;
   fLabels.clear();
@@ -71,6 +75,7 @@ void NBinningPoint::Reset()
     fStorageCoords[i] = -1;
     fMins[i]          = -1;
     fMaxs[i]          = -1;
+    fCenters[i]       = -1;
     fBaseBinMin[i]    = -1;
     fBaseBinMax[i]    = -1;
     fLabels[i]        = "";
@@ -117,39 +122,23 @@ bool NBinningPoint::RecalculateStorageCoords(Long64_t entry, bool useBinningDefC
     return false;
   }
 
-  fEntryNumber                             = entry;
-  std::vector<int>              contentVec = NUtils::ArrayToVector(fContentCoords, fContentNDimensions);
-  std::vector<std::vector<int>> axisRanges = fBinning->GetAxisRanges(contentVec);
-  if (axisRanges.size() != static_cast<size_t>(fNDimensions)) {
-    NLogError("NBinningPoint::RecalculateStorageCoords: Invalid axis ranges size=%zu expected=%d for entry=%lld",
-              axisRanges.size(), fNDimensions, fEntryNumber);
+  fEntryNumber = entry;
+  if (!DecodeBaseRanges()) {
+    NLogError("NBinningPoint::RecalculateStorageCoords: Invalid axis ranges for entry=%lld", fEntryNumber);
     return false;
   }
-  for (size_t i = 0; i < axisRanges.size(); ++i) {
-    if (axisRanges[i].size() < 3) {
-      NLogError("NBinningPoint::RecalculateStorageCoords: Invalid axis range format at axis=%zu size=%zu for entry=%lld",
-                i, axisRanges[i].size(), fEntryNumber);
-      return false;
-    }
-  }
-  // for (size_t i = 0; i < axisRanges.size(); i++) {
-  //   NLogDebug("Axis %zu: %s", i, NUtils::GetCoordsString(axisRanges[i], -1).c_str());
-  // }
   NBinningDef * binDef = fBinning->GetDefinition();
   if (binDef == nullptr) {
     NLogError("NBinningPoint::RecalculateStorageCoords: Binning definition is nullptr");
     return false;
   }
-  std::vector<Long64_t> ids = binDef->GetIds();
-
   // useBinningDefCheck = false;
   if (useBinningDefCheck) {
     if (fTreeStorage == nullptr) {
       NLogError("NBinningPoint::RecalculateStorageCoords: Storage tree is nullptr !!! Skipping check ...");
     }
     else {
-      if (std::find(ids.begin(), ids.end(), fEntryNumber) == ids.end() && fEntryNumber >= 0 &&
-          fEntryNumber < fTreeStorage->GetEntries()) {
+      if (!binDef->HasId(fEntryNumber) && fEntryNumber >= 0 && fEntryNumber < fTreeStorage->GetEntries()) {
         NLogError("NBinningPoint::RecalculateStorageCoords: Entry %lld not found in binning definition '%s' !!!",
                   fEntryNumber, fBinning->GetCurrentDefinitionName().c_str());
 
@@ -159,10 +148,9 @@ bool NBinningPoint::RecalculateStorageCoords(Long64_t entry, bool useBinningDefC
         for (const auto & kv : fBinning->GetDefinitions()) {
           NBinningDef * def = kv.second;
           if (def == nullptr) continue;
-          std::vector<Long64_t> defIds = def->GetIds();
-          if (std::find(defIds.begin(), defIds.end(), fEntryNumber) != defIds.end()) {
+          if (def->HasId(fEntryNumber)) {
             if (firstDefName.empty()) firstDefName = kv.first;
-            NLogError("  Definition '%s' size=%zu ", kv.first.c_str(), defIds.size());
+            NLogError("  Definition '%s' size=%zu ", kv.first.c_str(), def->GetIds().size());
           }
         }
 
@@ -176,16 +164,16 @@ bool NBinningPoint::RecalculateStorageCoords(Long64_t entry, bool useBinningDefC
   }
 
   // binDef->Print();
+  TObjArray * storageAxes = binDef->GetAxes();
   for (Int_t i = 0; i < fNDimensions; ++i) {
-    TAxis * axis        = fBinning->GetAxes()[i];
-    TAxis * axisStorage = (TAxis *)binDef->GetAxes()->At(i);
-    fBaseBinMin[i]      = axisRanges[i][1];
-    fBaseBinMax[i]      = axisRanges[i][2];
-    fMins[i]            = axis->GetBinLowEdge(axisRanges[i][1]);
-    fMaxs[i]            = axis->GetBinUpEdge(axisRanges[i][2]);
+    TAxis * axis        = fLayout[i].axis;
+    TAxis * axisStorage = (TAxis *)storageAxes->UncheckedAt(i);
+    fMins[i]            = axis->GetBinLowEdge(fBaseBinMin[i]);
+    fMaxs[i]            = axis->GetBinUpEdge(fBaseBinMax[i]);
+    fCenters[i]         = (fMins[i] + fMaxs[i]) / 2.0;
     // FIXME: Check if GetBinLabel works when min and max are not the same
-    fLabels[i]        = axis->GetBinLabel(axisRanges[i][1]);
-    fStorageCoords[i] = axisStorage->FindBin((fMins[i] + fMaxs[i]) / 2.0);
+    fLabels[i]        = axis->GetBinLabel(fBaseBinMin[i]);
+    fStorageCoords[i] = axisStorage->FindBin(fCenters[i]);
   }
 
   if (fParameters) fParameters->GetHisto()->Reset();
@@ -193,6 +181,73 @@ bool NBinningPoint::RecalculateStorageCoords(Long64_t entry, bool useBinningDefC
   return true;
 }
 
+void NBinningPoint::BuildLayout()
+{
+  ///
+  /// Precompute where each axis reads its binning from the content coordinates
+  ///
+  fLayout.clear();
+  if (fBinning == nullptr) return;
+
+  const std::vector<TAxis *> & axes   = fBinning->GetAxes();
+  Int_t                        offset = 0;
+  fLayout.reserve(axes.size());
+  for (size_t i = 0; i < axes.size(); ++i) {
+    AxisLayout layout;
+    layout.axis   = axes[i];
+    layout.offset = offset;
+    switch (fBinning->GetBinningType(i)) {
+    case Binning::kSingle: layout.nCoords = 1; break;
+    case Binning::kMultiple: layout.nCoords = 3; break;
+    case Binning::kUser:
+      layout.nCoords = 1;
+      layout.whole   = true;
+      break;
+    default: NLogError("NBinningPoint::BuildLayout: Unknown binning type for axis %zu", i); break;
+    }
+    offset += layout.nCoords;
+    fLayout.push_back(layout);
+  }
+}
+
+bool NBinningPoint::DecodeBaseRanges()
+{
+  ///
+  /// Decode content coordinates into base bin ranges (same result as NBinning::GetAxisRanges)
+  ///
+  if (static_cast<Int_t>(fLayout.size()) != fNDimensions) {
+    return false;
+  }
+  for (Int_t i = 0; i < fNDimensions; ++i) {
+    const AxisLayout & layout = fLayout[i];
+    if (layout.nCoords == 0 || layout.axis == nullptr) return false;
+
+    // Content coordinates of an axis are (rebin, rebin start, bin) or just the bin for rebin 1
+    Int_t rebin = 1, start = 1, bin = 1;
+    if (layout.whole) {
+      rebin = layout.axis->GetNbins();
+    }
+    else if (layout.nCoords == 3) {
+      rebin = fContentCoords[layout.offset];
+      start = fContentCoords[layout.offset + 1];
+      bin   = fContentCoords[layout.offset + 2];
+    }
+    else {
+      bin = fContentCoords[layout.offset];
+    }
+    const Int_t min = rebin * (bin - 1) + start;
+    const Int_t max = min + rebin - 1;
+    if (min < 1 || max > layout.axis->GetNbins()) {
+      NLogError("NBinningPoint::DecodeBaseRanges: Axis '%s' range [%d,%d] is outside [1,%d]",
+                layout.axis->GetName(), min, max, layout.axis->GetNbins());
+      return false;
+    }
+    fBaseBinMin[i] = min;
+    fBaseBinMax[i] = max;
+  }
+  return true;
+}
+
 std::map<int, std::vector<int>> NBinningPoint::GetBaseAxisRanges() const
 {
   ///
@@ -248,8 +303,8 @@ Long64_t NBinningPoint::Fill(bool ignoreFilledCheck)
   // TODO: Find more efficient way to verify if bin exists
   Long64_t bin = fBinning->GetContent()->GetBin(fContentCoords, kFALSE);
   if (bin >= 0 && ignoreFilledCheck == false) {
-    fBinning->GetDefinition()->GetContent()->SetBinContent(fStorageCoords, bin);
-    fBinning->GetDefinition()->GetIds().push_back(bin);
+    fBinning->GetDefinition()->SetContentAt(fStorageCoords, bin);
+    fBinning->GetDefinition()->AddId(bin);
     // NLogError("NBinningPoint::Fill: Bin for content already exists for coordinates: %s",
     //                NUtils::GetCoordsString(NUtils::ArrayToVector(fContentCoords, fContentNDimensions)).c_str());
     return -bin;
@@ -279,48 +334,44 @@ bool NBinningPoint::SetPointContentFromLinearIndex(Long64_t linBin, bool checkBi
   return RecalculateStorageCoords(linBin, checkBinningDef);
 }
 
-Double_t NBinningPoint::GetBinMin(std::string axis) const
+Int_t NBinningPoint::GetAxisHandle(const std::string & axis) const
 {
   ///
-  /// Get minimum value for specific axis
+  /// Resolve axis name to its index in the binning
   ///
-
-  // check if axis exists in fBinning->GetAxes()
-  for (int i = 0; i < fNDimensions; i++) {
-    TAxis * a = fBinning->GetAxes()[i];
-    if (a == nullptr) {
-      NLogError("NBinningPoint::GetMin: Axis %d is nullptr !!!", i);
+  if (fBinning == nullptr) {
+    NLogError("NBinningPoint::GetAxisHandle: Binning is nullptr !!!");
+    return -1;
+  }
+  const std::vector<TAxis *> & axes = fBinning->GetAxes();
+  for (Int_t i = 0; i < fNDimensions && i < (Int_t)axes.size(); i++) {
+    if (axes[i] == nullptr) {
+      NLogError("NBinningPoint::GetAxisHandle: Axis %d is nullptr !!!", i);
       continue;
     }
-    if (axis.compare(a->GetName()) == 0) {
-      return fMins[i];
+    if (axis.compare(axes[i]->GetName()) == 0) {
+      return i;
     }
   }
 
-  NLogError("NBinningPoint::GetMin: Axis '%s' not found !!!", axis.c_str());
+  NLogError("NBinningPoint::GetAxisHandle: Axis '%s' not found !!!", axis.c_str());
   return -1;
 }
 
+Double_t NBinningPoint::GetBinMin(std::string axis) const
+{
+  ///
+  /// Get minimum value for specific axis
+  ///
+  return GetBinMin(GetAxisHandle(axis));
+}
+
 Double_t NBinningPoint::GetBinMax(std::string axis) const
 {
   ///
   /// Get maximum value for specific axis
   ///
-
-  // check if axis exists in fBinning->GetAxes()
-  for (int i = 0; i < fNDimensions; i++) {
-    TAxis * a = fBinning->GetAxes()[i];
-    if (a == nullptr) {
-      NLogError("NBinningPoint::GetMax: Axis %d is nullptr !!!", i);
-      continue;
-    }
-    if (axis.compare(a->GetName()) == 0) {
-      return fMaxs[i];
-    }
-  }
-
-  NLogError("NBinningPoint::GetMax: Axis '%s' not found !!!", axis.c_str());
-  return -1;
+  return GetBinMax(GetAxisHandle(axis));
 }
 
 Double_t NBinningPoint::GetBinCenter(std::string axis) const
@@ -328,21 +379,7 @@ Double_t NBinningPoint::GetBinCenter(std::string axis) const
   ///
   /// Get center value for specific axis
   ///
-
-  // check if axis exists in fBinning->GetAxes()
-  for (int i = 0; i < fNDimensions; i++) {
-    TAxis * a = fBinning->GetAxes()[i];
-    if (a == nullptr) {
-      NLogError("NBinningPoint::GetCenter: Axis %d is nullptr !!!", i);
-      continue;
-    }
-    if (axis.compare(a->GetName()) == 0) {
-      return (fMins[i] + fMaxs[i]) / 2.0;
-    }
-  }
-
-  NLogError("NBinningPoint::GetCenter: Axis '%s' not found !!!", axis.c_str());
-  return -1;
+  return GetBinCenter(GetAxisHandle(axis));
 }
 
 std::string NBinningPoint::GetBinLabel(std::string axis) const
@@ -350,21 +387,16 @@ std::string NBinningPoint::GetBinLabel(std::string axis) const
   ///
   /// Get label for specific axis
   ///
+  return GetBinLabel(GetAxisHandle(axis));
+}
 
-  // check if axis exists in fBinning->GetAxes()
-  for (int i = 0; i < fNDimensions; i++) {
-    TAxis * a = fBinning->GetAxes()[i];
-    if (a == nullptr) {
-      NLogError("NBinningPoint::GetLabel: Axis %d is nullptr !!!", i);
-      continue;
-    }
-    if (axis.compare(a->GetName()) == 0) {
-      return fLabels[i];
-    }
-  }
-
-  NLogError("NBinningPoint::GetLabel: Axis '%s' not found !!!", axis.c_str());
-  return "";
+const std::string & NBinningPoint::GetBinLabel(Int_t handle) const
+{
+  ///
+  /// Get label for axis handle
+  ///
+  static const std::string empty;
+  return IsValidHandle(handle) ? fLabels[handle] : empty;
 }
 
 int NBinningPoint::GetBin(std::string axis) const
@@ -372,21 +404,7 @@ int NBinningPoint::GetBin(std::string axis) const
   ///
   /// Get bin for specific axis
   ///
-
-  // check if axis exists in fBinning->GetAxes()
-  for (int i = 0; i < fNDimensions; i++) {
-    TAxis * a = fBinning->GetAxes()[i];
-    if (a == nullptr) {
-      NLogError("NBinningPoint::GetBin: Axis %d is nullptr !!!", i);
-      continue;
-    }
-    if (axis.compare(a->GetName()) == 0) {
-      return fStorageCoords[i];
-    }
-  }
-
-  NLogError("NBinningPoint::GetLabel: Axis '%s' not found !!!", axis.c_str());
-  return -1;
+  return GetBin(GetAxisHandle(axis));
 }
 
 TObject * NBinningPoint::GetTempObject(const std::string & name) const
@@ -398,4 +416,13 @@ TObject * NBinningPoint::GetTempObject(const std::string & name) const
   return nullptr;
 }
 
+TH1 * NBinningPoint::TakeProjection(const std::string & name)
+{
+  ///
+  /// Take projection prepared for this point by NBulkProjection
+  ///
+  if (fBulkProjection == nullptr) return nullptr;
+  return fBulkProjection->Take(name, fEntryNumber);
+}
+
 } // namespace Ndmspc
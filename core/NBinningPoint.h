@@ -1,6 +1,8 @@
 #ifndef Ndmspc_NBinningPoint_H
 #define Ndmspc_NBinningPoint_H
 #include <TObject.h>
+#include <TAxis.h>
+#include <TH1.h>
 #include "NLogger.h"
 #include "NParameters.h"
 
@@ -16,6 +18,7 @@ namespace Ndmspc {
  * @author Martin Vala <mvala@cern.ch>
  */
 class NBinning;
+class NBulkProjection;
 class NStorageTree;
 class NGnTree;
 class NBinningPoint : public TObject {
@@ -141,6 +144,26 @@ class NBinningPoint : public TObject {
    */
   Double_t * GetMaxs() const { return fMaxs; }
 
+  /**
+   * @brief Get the array of bin center values for all axes.
+   *
+   * Together with GetMins() and GetMaxs() this gives all per-axis values of the
+   * current point as contiguous arrays of GetNDimensions() entries, indexed by axis handle.
+   * @return Pointer to the array of center values.
+   */
+  Double_t * GetCenters() const { return fCenters; }
+
+  /**
+   * @brief Resolve an axis name to a handle for the handle based accessors.
+   *
+   * The handle is the axis index in the binning, so it stays valid for every point
+   * of the same binning. Resolve it once (e.g. in the begin function) and use
+   * GetBinMin(Int_t), GetBinMax(Int_t), ... in the process function.
+   * @param axis The name of the axis.
+   * @return Axis handle, or -1 if the axis does not exist.
+   */
+  Int_t GetAxisHandle(const std::string & axis) const;
+
   /**
    * @brief Get the minimum value for a specific axis.
    * @param axis The name of the axis.
@@ -148,6 +171,41 @@ class NBinningPoint : public TObject {
    */
   Double_t GetBinMin(std::string axis) const;
 
+  /**
+   * @brief Get the minimum value for an axis handle.
+   * @param handle Axis handle from GetAxisHandle().
+   * @return The minimum value for the given axis.
+   */
+  Double_t GetBinMin(Int_t handle) const { return IsValidHandle(handle) ? fMins[handle] : -1; }
+
+  /**
+   * @brief Get the maximum value for an axis handle.
+   * @param handle Axis handle from GetAxisHandle().
+   * @return The maximum value for the given axis.
+   */
+  Double_t GetBinMax(Int_t handle) const { return IsValidHandle(handle) ? fMaxs[handle] : -1; }
+
+  /**
+   * @brief Get the center value for an axis handle.
+   * @param handle Axis handle from GetAxisHandle().
+   * @return The center value for the given axis.
+   */
+  Double_t GetBinCenter(Int_t handle) const { return IsValidHandle(handle) ? fCenters[handle] : -1; }
+
+  /**
+   * @brief Get the label for an axis handle.
+   * @param handle Axis handle from GetAxisHandle().
+   * @return The label for the given axis.
+   */
+  const std::string & GetBinLabel(Int_t handle) const;
+
+  /**
+   * @brief Get the bin index for an axis handle.
+   * @param handle Axis handle from GetAxisHandle().
+   * @return The bin index for the given axis.
+   */
+  Int_t GetBin(Int_t handle) const { return IsValidHandle(handle) ? fStorageCoords[handle] : -1; }
+
   /**
    * @brief Get the maximum value for a specific axis.
    * @param axis The name of the axis.
@@ -260,6 +318,25 @@ class NBinningPoint : public TObject {
    */
   void SetTempObject(const std::string & name, TObject * obj) { fTempObjects[name] = obj; }
 
+  /**
+   * @brief Set bulk projections of the current definition.
+   * @param bp Pointer to NBulkProjection (not owned), nullptr to unset.
+   */
+  void SetBulkProjection(NBulkProjection * bp) { fBulkProjection = bp; }
+
+  /**
+   * @brief Get bulk projections of the current definition.
+   * @return Pointer to NBulkProjection, nullptr if not set.
+   */
+  NBulkProjection * GetBulkProjection() const { return fBulkProjection; }
+
+  /**
+   * @brief Take projection prepared for this point by NBulkProjection.
+   * @param name Name of projection.
+   * @return Histogram owned by the caller, nullptr if no projection was prepared.
+   */
+  TH1 * TakeProjection(const std::string & name);
+
   /**
    * @brief Get reference to temporary configuration JSON object.
    * @return Reference to temporary JSON configuration.
@@ -267,23 +344,48 @@ class NBinningPoint : public TObject {
   json & GetTempCfg() { return fTempCfg; }
 
   private:
-  json                             fCfg{};                  ///< Configuration object
-  NGnTree *                        fInput{nullptr};         ///< Input NGnTree object
-  NBinning *                       fBinning{nullptr};       ///< Binning object
-  NStorageTree *                   fTreeStorage{nullptr};   ///< Storage tree object
-  Int_t                            fContentNDimensions{1};  ///< Number of dimensions in content histogram
-  Int_t *                          fContentCoords{nullptr}; ///< Coordinates of the point
-  Int_t                            fNDimensions{1};         ///< Number of dimensions
-  Int_t *                          fStorageCoords{nullptr}; ///< Storage coordinates of the point
-  Double_t *                       fMins{nullptr};          ///< Minimum values for each axis
-  Double_t *                       fMaxs{nullptr};          ///< Maximum values for each axis
-  Int_t *                          fBaseBinMin{nullptr};    ///< Base bin minimum (for variable binning)
-  Int_t *                          fBaseBinMax{nullptr};    ///< Base bin maximum (for variable binning)
-  std::vector<std::string>         fLabels{};               ///< Labels for each axis
-  Long64_t                         fEntryNumber{-1};        ///< Entry in the storage tree
-  NParameters *                    fParameters{nullptr};    ///< Parameter axis (if any)
-  std::map<std::string, TObject *> fTempObjects;            ///<! Outputs map
-  json                             fTempCfg{};              ///< Temporary configuration object
+  /// Precomputed decoding of one base axis from the content coordinates
+  struct AxisLayout {
+    TAxis * axis{nullptr}; ///< Base axis
+    Int_t   offset{0};     ///< Index of the first content coordinate of the axis
+    Int_t   nCoords{0};    ///< Content coordinates used (1 single, 3 multiple, 0 unknown)
+    bool    whole{false};  ///< User binning: the point spans the whole axis
+  };
+
+  /// Builds fLayout from the binning types of fBinning.
+  void BuildLayout();
+
+  /// Decodes fContentCoords into fBaseBinMin/fBaseBinMax using fLayout.
+  bool DecodeBaseRanges();
+
+  /// Checks an axis handle, logging an error for invalid ones.
+  bool IsValidHandle(Int_t handle) const
+  {
+    if (handle >= 0 && handle < fNDimensions && fMins) return true;
+    NLogError("NBinningPoint: Invalid axis handle %d !!!", handle);
+    return false;
+  }
+
+  json                             fCfg{};                   ///< Configuration object
+  NGnTree *                        fInput{nullptr};          ///< Input NGnTree object
+  NBinning *                       fBinning{nullptr};        ///< Binning object
+  NStorageTree *                   fTreeStorage{nullptr};    ///< Storage tree object
+  Int_t                            fContentNDimensions{1};   ///< Number of dimensions in content histogram
+  Int_t *                          fContentCoords{nullptr};  ///< Coordinates of the point
+  Int_t                            fNDimensions{1};          ///< Number of dimensions
+  Int_t *                          fStorageCoords{nullptr};  ///< Storage coordinates of the point
+  Double_t *                       fMins{nullptr};           ///< Minimum values for each axis
+  Double_t *                       fMaxs{nullptr};           ///< Maximum values for each axis
+  Double_t *                       fCenters{nullptr};        ///<! Center values for each axis
+  Int_t *                          fBaseBinMin{nullptr};     ///< Base bin minimum (for variable binning)
+  Int_t *                          fBaseBinMax{nullptr};     ///< Base bin maximum (for variable binning)
+  std::vector<std::string>         fLabels{};                ///< Labels for each axis
+  Long64_t                         fEntryNumber{-1};         ///< Entry in the storage tree
+  NParameters *                    fParameters{nullptr};     ///< Parameter axis (if any)
+  std::map<std::string, TObject *> fTempObjects;             ///<! Outputs map
+  json                             fTempCfg{};               ///< Temporary configuration object
+  std::vector<AxisLayout>          fLayout{};                ///<! Content coordinate layout per axis
+  NBulkProjection *                fBulkProjection{nullptr}; ///<! Bulk projections of the current definition
 
   /// \cond CLASSIMP
   ClassDef(NBinningPoint, 1);
@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <thread>
+#include <TH1D.h>
+#include <THnSparse.h>
+#include <TROOT.h>
+#include "NBinning.h"
+#include "NBinningPoint.h"
+#include "NLogger.h"
+
+#include "NBulkProjection.h"
+
+namespace Ndmspc {
+
+NBulkProjection::~NBulkProjection()
+{
+  ///
+  /// Destructor
+  ///
+  Clear();
+}
+
+bool NBulkProjection::Add(const std::string & name, THnSparse * input, const std::vector<int> & axes, int projAxis)
+{
+  ///
+  /// Register input to project
+  ///
+  if (input == nullptr) {
+    NLogError("NBulkProjection::Add: Input '%s' is nullptr !!!", name.c_str());
+    return false;
+  }
+  for (const auto & in : fInputs) {
+    if (in.name == name) {
+      NLogError("NBulkProjection::Add: Projection '%s' already exists !!!", name.c_str());
+      return false;
+    }
+  }
+
+  const int nDims = input->GetNdimensions();
+  if (projAxis < 0 || projAxis >= nDims) {
+    NLogError("NBulkProjection::Add: Invalid projection axis %d for '%s' !!!", projAxis, name.c_str());
+    return false;
+  }
+  for (const int axis : axes) {
+    if (axis < 0 || axis >= nDims || axis == projAxis || std::count(axes.begin(), axes.end(), axis) > 1) {
+      NLogError("NBulkProjection::Add: Invalid input axis %d for '%s' !!!", axis, name.c_str());
+      return false;
+    }
+  }
+
+  Input in;
+  in.name     = name;
+  in.hist     = input;
+  in.axes     = axes;
+  in.projAxis = projAxis;
+  fInputs.push_back(std::move(in));
+  return true;
+}
+
+bool NBulkProjection::Fill(NBinning * binning, const std::vector<Long64_t> & ids, int nThreads)
+{
+  ///
+  /// Project all inputs for the given cells
+  ///
+  Clear();
+  fGroups.clear();
+  fStrides.clear();
+  fDenseCells.clear();
+  fCells.clear();
+  fCellIds.clear();
+  fNCells = 0;
+
+  if (binning == nullptr || binning->GetContent() == nullptr) {
+    NLogError("NBulkProjection::Fill: Binning or content is nullptr !!!");
+    return false;
+  }
+
+  // Group of every base bin per axis. Groups of one definition do not overlap, so a base bin
+  // belongs to one group at most.
+  const size_t                  nAxes = binning->GetAxes().size();
+  std::vector<std::vector<int>> groupRanges(nAxes);
+  fGroups.resize(nAxes);
+  for (size_t i = 0; i < nAxes; ++i) {
+    fGroups[i].assign(binning->GetAxes()[i]->GetNbins() + 2, -1);
+  }
+
+  std::vector<std::vector<Int_t>> cellGroups;
+  cellGroups.reserve(ids.size());
+  NBinningPoint point(binning);
+  for (const Long64_t id : ids) {
+    if (!point.SetPointContentFromLinearIndex(id)) return false;
+    std::vector<Int_t> g(nAxes, 0);
+    for (const auto & [axis, range] : point.GetBaseAxisRanges()) {
+      std::vector<Int_t> & table = fGroups[axis];
+      const Int_t          min   = std::clamp(range[0], 0, (Int_t)table.size() - 1);
+      const Int_t          max   = std::clamp(range[1], min, (Int_t)table.size() - 1);
+      Int_t                group = table[min];
+      if (group < 0 && std::all_of(table.begin() + min, table.begin() + max + 1, [](Int_t x) { return x < 0; })) {
+        group = groupRanges[axis].size() / 2;
+        groupRanges[axis].insert(groupRanges[axis].end(), {min, max});
+        std::fill(table.begin() + min, table.begin() + max + 1, group);
+      }
+      if (group < 0 || groupRanges[axis][2 * group] != min || groupRanges[axis][2 * group + 1] != max) {
+        NLogError("NBulkProjection::Fill: Cells overlap on axis '%s' [%d,%d] !!!",
+                  binning->GetAxes()[axis]->GetName(), min, max);
+        return false;
+      }
+      g[axis] = group;
+    }
+    cellGroups.push_back(std::move(g));
+  }
+
+  Long64_t nKeys = 1;
+  fStrides.resize(nAxes);
+  for (size_t i = nAxes; i-- > 0;) {
+    fStrides[i] = nKeys;
+    nKeys *= std::max<Long64_t>(1, groupRanges[i].size() / 2);
+  }
+
+  // Cells are looked up for every filled bin of the inputs: a table when small, a hash map otherwise
+  const Long64_t kMaxDenseKeys = 1 << 24;
+  if (nKeys <= kMaxDenseKeys) fDenseCells.assign(nKeys, -1);
+  for (size_t k = 0; k < cellGroups.size(); ++k) {
+    Long64_t key = 0;
+    for (size_t i = 0; i < nAxes; ++i) key += cellGroups[k][i] * fStrides[i];
+    const bool added = fDenseCells.empty() ? fCells.emplace(key, k).second : fDenseCells[key] < 0;
+    if (!added) {
+      NLogWarning("NBulkProjection::Fill: Cell of id=%lld was already added, skipping ...", ids[k]);
+      continue;
+    }
+    if (!fDenseCells.empty()) fDenseCells[key] = k;
+    fCellIds[ids[k]] = k;
+  }
+  fNCells = cellGroups.size();
+
+  for (auto & input : fInputs) {
+    if (!Project(input, nThreads)) return false;
+  }
+  return true;
+}
+
+bool NBulkProjection::Project(Input & input, int nThreads)
+{
+  ///
+  /// Projects one input to all cells
+  ///
+  THnSparse *    hns    = input.hist;
+  const Int_t    nDims  = hns->GetNdimensions();
+  const Long64_t nBins  = hns->GetNbins();
+  TAxis *        axis   = hns->GetAxis(input.projAxis);
+  const Int_t    nProj  = axis->GetNbins() + 2;
+  const bool     errors = hns->GetCalculateErrors();
+
+  if (input.axes.size() != fGroups.size()) {
+    NLogError("NBulkProjection::Project: '%s' maps %zu axes, binning has %zu !!!", input.name.c_str(),
+              input.axes.size(), fGroups.size());
+    return false;
+  }
+
+  // Binning axis of every input axis (-1 if not binned)
+  std::vector<Int_t> binningAxes(nDims, -1);
+  for (size_t i = 0; i < input.axes.size(); ++i) {
+    if ((size_t)hns->GetAxis(input.axes[i])->GetNbins() + 2 != fGroups[i].size()) {
+      NLogError("NBulkProjection::Project: Axis %d of '%s' does not match binning axis %zu !!!", input.axes[i],
+                input.name.c_str(), i);
+      return false;
+    }
+    binningAxes[input.axes[i]] = i;
+  }
+  std::vector<Int_t> lastBins(nDims);
+  for (Int_t d = 0; d < nDims; ++d) lastBins[d] = hns->GetAxis(d)->GetNbins();
+
+  if (nThreads < 0) nThreads = std::max(1u, ROOT::GetThreadPoolSize());
+  const Long64_t kMinBinsPerThread = 1 << 16;
+  nThreads = static_cast<int>(std::max<Long64_t>(1, std::min<Long64_t>(nThreads, nBins / kMinBinsPerThread)));
+
+  // Coordinate decoder of THnSparse is created on first use, so it is done before the threads start
+  std::vector<Int_t> coords(nDims);
+  if (nBins > 0) hns->GetBinContent(0, coords.data());
+
+  std::vector<std::vector<Double_t>> sumw(nThreads), sumw2(nThreads);
+  auto scan = [&](int t) {
+    std::vector<Double_t> & w  = sumw[t];
+    std::vector<Double_t> & w2 = sumw2[t];
+    w.assign(fNCells * nProj, 0);
+    if (errors) w2.assign(fNCells * nProj, 0);
+    std::vector<Int_t> c(nDims);
+    const Long64_t     last = nBins * (t + 1) / nThreads;
+    for (Long64_t bin = nBins * t / nThreads; bin < last; ++bin) {
+      const Double_t v   = hns->GetBinContent(bin, c.data());
+      Long64_t       key = 0;
+      Int_t          d   = 0;
+      for (; d < nDims; ++d) {
+        if (binningAxes[d] < 0) {
+          if (c[d] < 1 || c[d] > lastBins[d]) break;
+          continue;
+        }
+        const Int_t group = fGroups[binningAxes[d]][c[d]];
+        if (group < 0) break;
+        key += group * fStrides[binningAxes[d]];
+      }
+      if (d < nDims) continue;
+      const Long64_t cell = FindCell(key);
+      if (cell < 0) continue;
+      const Long64_t idx = cell * nProj + c[input.projAxis];
+      w[idx] += v;
+      if (errors) w2[idx] += hns->GetBinError2(bin);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int t = 1; t < nThreads; ++t) threads.emplace_back(scan, t);
+  scan(0);
+  for (auto & t : threads) t.join();
+
+  input.projections.assign(fNCells, nullptr);
+  const TString name = TString::Format("%s_proj_%d", hns->GetName(), input.projAxis);
+  for (const auto & kv : fCellIds) {
+    const Long64_t cell = kv.second;
+    TH1D *         h    = axis->GetXbins()->GetSize() > 0
+                              ? new TH1D(name, hns->GetTitle(), axis->GetNbins(), axis->GetXbins()->GetArray())
+                              : new TH1D(name, hns->GetTitle(), axis->GetNbins(), axis->GetXmin(), axis->GetXmax());
+    h->SetDirectory(nullptr);
+    h->GetXaxis()->SetName(axis->GetName());
+    h->GetXaxis()->SetTitle(axis->GetTitle());
+    if (axis->GetLabels()) {
+      for (Int_t b = 1; b <= axis->GetNbins(); ++b) h->GetXaxis()->SetBinLabel(b, axis->GetBinLabel(b));
+    }
+    if (errors) h->Sumw2();
+    for (Int_t b = 0; b < nProj; ++b) {
+      Double_t v = 0, e2 = 0;
+      for (int t = 0; t < nThreads; ++t) {
+        v += sumw[t][cell * nProj + b];
+        if (errors) e2 += sumw2[t][cell * nProj + b];
+      }
+      h->SetBinContent(b, v);
+      if (errors) h->GetSumw2()->SetAt(e2, b);
+    }
+    // Entries as set by THnBase::Projection() when bins were skipped
+    h->ResetStats();
+    h->SetEntries(errors ? h->GetEffectiveEntries() : h->GetSumOfWeights());
+    input.projections[cell] = h;
+  }
+
+  NLogDebug("NBulkProjection::Project: Projected %lld bins of '%s' to %zu cells using %d threads", nBins,
+            input.name.c_str(), fCellIds.size(), nThreads);
+  return true;
+}
+
+TH1 * NBulkProjection::Take(const std::string & name, Long64_t id)
+{
+  ///
+  /// Take projection of a cell
+  ///
+  auto it = fCellIds.find(id);
+  if (it == fCellIds.end()) return nullptr;
+  for (auto & input : fInputs) {
+    if (input.name != name || (size_t)it->second >= input.projections.size()) continue;
+    TH1 * h                       = input.projections[it->second];
+    input.projections[it->second] = nullptr;
+    return h;
+  }
+  return nullptr;
+}
+
+void NBulkProjection::Clear()
+{
+  ///
+  /// Delete all projections left
+  ///
+  for (auto & input : fInputs) {
+    for (auto * h : input.projections) delete h;
+    input.projections.clear();
+  }
+}
+
+} // namespace Ndmspc
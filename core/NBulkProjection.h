@@ -0,0 +1,122 @@
+#ifndef Ndmspc_NBulkProjection_H
+#define Ndmspc_NBulkProjection_H
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Rtypes.h>
+
+class TH1;
+class THnSparse;
+
+namespace Ndmspc {
+
+class NBinning;
+
+/**
+ * @class NBulkProjection
+ * @brief Projections of THnSparse inputs for all cells of a binning definition in one pass.
+ *
+ * Projecting an input once per cell (NUtils::SetAxisRanges() followed by THnSparse::Projection())
+ * scans every filled bin of the input for every cell. Fill() scans each input once instead and adds
+ * every filled bin to the cell its coordinates fall into. The scan is split between threads, each
+ * filling its own arrays, which are summed in thread order at the end.
+ *
+ * Cells are the definition ids; the ranges of a cell are taken from NBinningPoint::GetBaseAxisRanges().
+ * As with NUtils::SetAxisRanges() (reset, no overflow), under/overflow bins of the other axes are
+ * skipped. NGnTree::Process() runs Fill() for every definition and the process function gets the
+ * histogram of its point via NBinningPoint::TakeProjection().
+ *
+ * @par Example Usage:
+ * @code{.cpp}
+ * ngnt->GetBulkProjection()->Add("unlikepm", hns, {1, 2}, 0); // binning axes -> input axes 1,2, project axis 0
+ * // in process function
+ * TH1 * proj = point->TakeProjection("unlikepm");
+ * @endcode
+ */
+class NBulkProjection {
+  public:
+  /**
+   * @brief Constructor.
+   */
+  NBulkProjection() = default;
+
+  /**
+   * @brief Destructor.
+   */
+  virtual ~NBulkProjection();
+
+  NBulkProjection(const NBulkProjection &)             = delete;
+  NBulkProjection & operator=(const NBulkProjection &) = delete;
+
+  /**
+   * @brief Register input to project.
+   * @param name Name of projection (used by Take()).
+   * @param input Input histogram (not owned, has to stay alive until Fill()).
+   * @param axes Input axis of every binning axis.
+   * @param projAxis Input axis to project on.
+   * @return True if input is valid.
+   */
+  bool Add(const std::string & name, THnSparse * input, const std::vector<int> & axes, int projAxis);
+
+  /**
+   * @brief Project all inputs for the given cells.
+   * @param binning Binning with content of the cells.
+   * @param ids Definition ids (content bins) of the cells.
+   * @param nThreads Number of threads (-1 uses the ROOT thread pool size).
+   * @return True if successful.
+   */
+  bool Fill(NBinning * binning, const std::vector<Long64_t> & ids, int nThreads = -1);
+
+  /**
+   * @brief Take projection of a cell.
+   *
+   * Every cell is taken by one thread only, so concurrent calls for different cells are safe.
+   *
+   * @param name Name of projection.
+   * @param id Definition id of the cell.
+   * @return Histogram owned by the caller, nullptr if not projected or already taken.
+   */
+  TH1 * Take(const std::string & name, Long64_t id);
+
+  /**
+   * @brief Delete all projections left.
+   */
+  void Clear();
+
+  /**
+   * @brief Get number of registered inputs.
+   * @return Number of inputs.
+   */
+  size_t GetNInputs() const { return fInputs.size(); }
+
+  private:
+  /// Registered input
+  struct Input {
+    std::string        name;          ///< Name of projection
+    THnSparse *        hist{nullptr}; ///< Input histogram
+    std::vector<int>   axes;          ///< Input axis of every binning axis
+    int                projAxis{0};   ///< Input axis to project on
+    std::vector<TH1 *> projections;   ///< Projection per cell (owned until taken)
+  };
+
+  /// Projects one input to all cells.
+  bool Project(Input & input, int nThreads);
+
+  /// Returns cell of a key, -1 if there is none.
+  Long64_t FindCell(Long64_t key) const
+  {
+    if (!fDenseCells.empty()) return fDenseCells[key];
+    auto it = fCells.find(key);
+    return it == fCells.end() ? -1 : it->second;
+  }
+
+  std::vector<Input>                     fInputs;     ///< Registered inputs
+  std::vector<std::vector<Int_t>>        fGroups;     ///< Group of every base bin per binning axis (-1 outside cells)
+  std::vector<Long64_t>                  fStrides;    ///< Key stride per binning axis
+  std::vector<Long64_t>                  fDenseCells; ///< Cell of every key (used for small number of keys)
+  std::unordered_map<Long64_t, Long64_t> fCells;      ///< Cell of key (used for large number of keys)
+  std::unordered_map<Long64_t, Long64_t> fCellIds;    ///< Cell of definition id
+  size_t                                 fNCells{0};  ///< Number of cells
+};
+} // namespace Ndmspc
+#endif
@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <sstream>
+#include <TSystem.h>
+#include "NLogger.h"
+#include "NCheckpointJournal.h"
+
+namespace Ndmspc {
+
+bool NCheckpointJournal::Load()
+{
+  ///
+  /// Read records of a previous run
+  ///
+  fFileIndex.clear();
+  fIndexFile.clear();
+  fFileIds.clear();
+
+  std::ifstream in(fFileName);
+  if (!in.is_open()) {
+    return false;
+  }
+
+  std::string line;
+  size_t      lineNo = 0;
+  while (std::getline(in, line)) {
+    ++lineNo;
+    // A record without its newline was cut short by a kill and may hold a truncated id
+    if (in.eof()) break;
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream iss(line);
+    std::string        type;
+    int                index = -1;
+    std::string        value;
+    iss >> type >> index;
+    std::getline(iss >> std::ws, value);
+
+    if (type == "F" && index >= 0 && !value.empty()) {
+      fFileIndex[value] = index;
+      fIndexFile[index] = value;
+      fFileIds[value];
+      continue;
+    }
+    std::vector<Long64_t> ids;
+    auto                  fileIt = fIndexFile.find(index);
+    if (type == "I" && fileIt != fIndexFile.end() && ParseIds(value, ids)) {
+      fFileIds[fileIt->second].insert(ids.begin(), ids.end());
+      continue;
+    }
+    NLogWarning("NCheckpointJournal::Load: Skipping malformed line %zu in '%s'", lineNo, fFileName.c_str());
+  }
+  return true;
+}
+
+bool NCheckpointJournal::Open(bool truncate)
+{
+  ///
+  /// Open the journal for appending
+  ///
+  Close();
+  if (truncate) {
+    fFileIndex.clear();
+    fIndexFile.clear();
+    fFileIds.clear();
+  }
+  const std::string dir = gSystem->GetDirName(fFileName.c_str()).Data();
+  if (!dir.empty()) gSystem->mkdir(dir.c_str(), kTRUE);
+
+  fOut.open(fFileName, truncate ? std::ios::trunc : std::ios::app);
+  if (!fOut.is_open()) {
+    NLogError("NCheckpointJournal::Open: Cannot open '%s' for writing", fFileName.c_str());
+    return false;
+  }
+  if (truncate) {
+    fOut << "# ndmspc checkpoint journal v1\n" << std::flush;
+  }
+  return fOut.good();
+}
+
+bool NCheckpointJournal::Rewrite(std::map<std::string, std::set<Long64_t>> fileIds)
+{
+  ///
+  /// Start a new journal holding only the given records
+  ///
+
+  // Records are written to a temporary journal which then replaces the current one
+  const std::string journalName = fFileName;
+  fFileName                     = journalName + ".tmp";
+  bool ok                       = Open(true);
+  for (auto it = fileIds.begin(); ok && it != fileIds.end(); ++it) {
+    if (it->second.empty()) continue;
+    const int index = AddFile(it->first);
+    ok = index >= 0 && AddIds(index, std::vector<Long64_t>(it->second.begin(), it->second.end()));
+  }
+  Close();
+  fFileName = journalName;
+  if (!ok || gSystem->Rename((journalName + ".tmp").c_str(), journalName.c_str()) != 0) {
+    NLogError("NCheckpointJournal::Rewrite: Cannot replace '%s'", journalName.c_str());
+    gSystem->Unlink((journalName + ".tmp").c_str());
+    return false;
+  }
+  return Open(false);
+}
+
+void NCheckpointJournal::Close()
+{
+  if (fOut.is_open()) fOut.close();
+}
+
+bool NCheckpointJournal::Remove()
+{
+  Close();
+  return gSystem->Unlink(fFileName.c_str()) == 0;
+}
+
+int NCheckpointJournal::AddFile(const std::string & filename)
+{
+  auto it = fFileIndex.find(filename);
+  if (it != fFileIndex.end()) {
+    return it->second;
+  }
+  const int index = fIndexFile.empty() ? 0 : fIndexFile.rbegin()->first + 1;
+  fOut << "F " << index << ' ' << filename << '\n' << std::flush;
+  if (!fOut.good()) {
+    NLogError("NCheckpointJournal::AddFile: Failed to write to '%s'", fFileName.c_str());
+    return -1;
+  }
+  fFileIndex[filename] = index;
+  fIndexFile[index]    = filename;
+  fFileIds[filename];
+  return index;
+}
+
+bool NCheckpointJournal::AddIds(int fileIndex, const std::vector<Long64_t> & ids)
+{
+  auto fileIt = fIndexFile.find(fileIndex);
+  if (fileIt == fIndexFile.end()) {
+    return false;
+  }
+  if (ids.empty()) {
+    return true;
+  }
+  // One line and one flush per call keeps the journal cheap enough to write on every ACK.
+  fOut << "I " << fileIndex << ' ' << FormatIds(ids) << '\n' << std::flush;
+  if (!fOut.good()) {
+    NLogError("NCheckpointJournal::AddIds: Failed to write to '%s'", fFileName.c_str());
+    return false;
+  }
+  fFileIds[fileIt->second].insert(ids.begin(), ids.end());
+  return true;
+}
+
+std::set<Long64_t> NCheckpointJournal::GetDoneIds() const
+{
+  std::set<Long64_t> ids;
+  for (const auto & kv : fFileIds) ids.insert(kv.second.begin(), kv.second.end());
+  return ids;
+}
+
+std::string NCheckpointJournal::DefaultPath(const std::string & outputFile, const std::string & tmpDir)
+{
+  TString out(outputFile.c_str());
+  if (out.IsNull()) {
+    return tmpDir + "/.ndmspc/ndmspc.ckpt";
+  }
+  if (out.BeginsWith("root://") || out.BeginsWith("http://") || out.BeginsWith("https://")) {
+    return tmpDir + "/.ndmspc/" + gSystem->BaseName(outputFile.c_str()) + ".ckpt";
+  }
+  return outputFile + ".ckpt";
+}
+
+std::string NCheckpointJournal::FormatIds(std::vector<Long64_t> ids)
+{
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  std::ostringstream oss;
+  size_t             i = 0;
+  while (i < ids.size()) {
+    size_t j = i;
+    while (j + 1 < ids.size() && ids[j + 1] == ids[j] + 1) ++j;
+    if (i != 0) oss << ',';
+    oss << ids[i];
+    if (j > i) oss << '-' << ids[j];
+    i = j + 1;
+  }
+  return oss.str();
+}
+
+bool NCheckpointJournal::ParseIds(const std::string & text, std::vector<Long64_t> & ids)
+{
+  ids.clear();
+  std::stringstream ss(text);
+  std::string       token;
+  try {
+    while (std::getline(ss, token, ',')) {
+      if (token.empty()) return false;
+      const size_t dash = token.find('-', 1);
+      size_t       pos  = 0;
+      if (dash == std::string::npos) {
+        ids.push_back(std::stoll(token, &pos));
+        if (pos != token.size()) return false;
+        continue;
+      }
+      const Long64_t first = std::stoll(token.substr(0, dash), &pos);
+      if (pos != dash) return false;
+      const std::string lastStr = token.substr(dash + 1);
+      const Long64_t    last    = std::stoll(lastStr, &pos);
+      if (pos != lastStr.size() || last < first) return false;
+      for (Long64_t id = first; id <= last; ++id) ids.push_back(id);
+    }
+  }
+  catch (...) {
+    return false;
+  }
+  return !ids.empty();
+}
+
+} // namespace Ndmspc
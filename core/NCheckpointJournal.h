@@ -0,0 +1,111 @@
+#ifndef N_CHECKPOINT_JOURNAL_H
+#define N_CHECKPOINT_JOURNAL_H
+
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <Rtypes.h>
+
+namespace Ndmspc {
+
+/**
+ * @class NCheckpointJournal
+ * @brief Append-only record of completed definition ids and the files holding them
+ *
+ * Used by NGnTree::Process to resume an interrupted run. Each line is one record:
+ * - `F <index> <path>`: a worker result file
+ * - `I <index> <ids>`: ids whose entries are stored in file `<index>`, written as
+ *   comma-separated values or `first-last` ranges
+ *
+ * Records are flushed as they are appended, so the journal stays valid when the
+ * process is killed. A last line without its newline is ignored on Load().
+ */
+class NCheckpointJournal {
+  public:
+  /**
+   * @brief Constructor
+   * @param filename Journal path
+   */
+  explicit NCheckpointJournal(const std::string & filename) : fFileName(filename) {}
+  ~NCheckpointJournal() { Close(); }
+
+  /**
+   * @brief Read an existing journal
+   * @return True if the journal was read (false if it does not exist or cannot be opened)
+   */
+  bool Load();
+
+  /**
+   * @brief Open the journal for appending
+   * @param truncate Discard existing records first
+   * @return True on success
+   */
+  bool Open(bool truncate = false);
+
+  /**
+   * @brief Replace the journal with the given records and open it for appending
+   *
+   * Files without ids are dropped. The new journal is written next to the old one and
+   * renamed over it, so an interruption keeps the previous records.
+   * @param fileIds Ids per result file to keep
+   * @return True on success
+   */
+  bool Rewrite(std::map<std::string, std::set<Long64_t>> fileIds);
+
+  /// Close the journal file
+  void Close();
+
+  /// Delete the journal file
+  bool Remove();
+
+  /**
+   * @brief Register a result file
+   * @param filename Result file path
+   * @return File index used by AddIds(), or -1 on write failure
+   */
+  int AddFile(const std::string & filename);
+
+  /**
+   * @brief Append ids stored in a registered file
+   * @param fileIndex Index returned by AddFile()
+   * @param ids Definition ids
+   * @return True if the record was written
+   */
+  bool AddIds(int fileIndex, const std::vector<Long64_t> & ids);
+
+  /// Journal path
+  const std::string & GetFileName() const { return fFileName; }
+
+  /// Ids recorded per result file
+  const std::map<std::string, std::set<Long64_t>> & GetFileIds() const { return fFileIds; }
+
+  /// All recorded ids
+  std::set<Long64_t> GetDoneIds() const;
+
+  /**
+   * @brief Default journal path for an output file
+   * @param outputFile Output file of the run
+   * @param tmpDir Directory used when the output is not a local path
+   * @return Journal path
+   */
+  static std::string DefaultPath(const std::string & outputFile, const std::string & tmpDir);
+
+  /// Format ids as a comma-separated list with `first-last` ranges
+  static std::string FormatIds(std::vector<Long64_t> ids);
+
+  /// Parse ids formatted by FormatIds(); false if malformed
+  static bool ParseIds(const std::string & text, std::vector<Long64_t> & ids);
+
+  private:
+  std::string                               fFileName;     ///< Journal path
+  std::ofstream                             fOut;          ///< Append stream
+  std::map<std::string, int>                fFileIndex{};  ///< Result file -> index
+  std::map<int, std::string>                fIndexFile{};  ///< Index -> result file
+  std::map<std::string, std::set<Long64_t>> fFileIds{};    ///< Result file -> recorded ids
+};
+
+} // namespace Ndmspc
+
+#endif // N_CHECKPOINT_JOURNAL_H
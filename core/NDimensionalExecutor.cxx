@@ -3,8 +3,12 @@
 #include <cctype>
 #include <chrono>
 #include <cerrno>
+#include <cmath>
 #include <csignal>
 #include <cstdio>
+#include <deque>
+#include <limits>
+#include <numeric>
 #include <queue>
 #include <set>
 #include <sstream>
@@ -19,6 +23,7 @@
 #include "NDimensionalExecutor.h"
 #include "NDimensionalIpcRunner.h"
 #include "NGnThreadData.h"
+#include "NTaskCostModel.h"
 #include "NUtils.h"
 
 namespace Ndmspc {
@@ -114,10 +119,12 @@ struct NDimensionalExecutor::IpcSession {
   size_t      bootstrapNextIdx{0}; ///< Auto-assigned index counter for BOOTSTRAP
   std::unordered_map<std::string, size_t> bootstrapAssignments; ///< BOOTSTRAP identity -> assigned slot
   std::vector<std::string> pendingReadyIdentities; ///< READY messages received while waiting for ACK
+  std::unordered_map<std::string, int> workerProtocol; ///< Worker identity -> negotiated task framing version
+  std::unordered_map<std::string, std::vector<Long64_t>> uncheckpointedIds; ///< Worker identity -> ids ACKed since its last checkpoint
 
   // Task state management: unified handling of pending, running, and done tasks
   NTaskStateManager taskStateManager;             ///< Per-session task state manager
-  std::unordered_map<std::string, std::set<size_t>> workerTaskHistory; ///< All tasks assigned per worker in current definition
+  std::unordered_map<std::string, NTaskRangeSet> workerTaskHistory; ///< All tasks assigned per worker in current definition
   std::set<std::string> earlyDoneWorkers;         ///< Workers that sent DONE early
 
   // TCP worker activity tracking for failure detection
@@ -128,13 +135,120 @@ struct NDimensionalExecutor::IpcSession {
 
 // --- Private Increment Logic ---
 bool NDimensionalExecutor::Increment()
+{
+  return Increment(fCurrentCoords);
+}
+
+bool NDimensionalExecutor::Increment(std::vector<int> & coords) const
 {
   for (int i = fNumDimensions - 1; i >= 0; --i) {
-    fCurrentCoords[i]++;
-    if (fCurrentCoords[i] <= fMaxBounds[i]) {
+    coords[i]++;
+    if (coords[i] <= fMaxBounds[i]) {
       return true;
     }
-    fCurrentCoords[i] = fMinBounds[i];
+    coords[i] = fMinBounds[i];
+  }
+  return false;
+}
+
+size_t NDimensionalExecutor::GetTotalPoints() const
+{
+  size_t total = (fNumDimensions > 0) ? 1 : 0;
+  for (size_t i = 0; i < fNumDimensions; ++i) {
+    total *= static_cast<size_t>(fMaxBounds[i] - fMinBounds[i] + 1);
+  }
+  return total;
+}
+
+void NDimensionalExecutor::DecodeLinearIndex(size_t index, std::vector<int> & coords) const
+{
+  coords.resize(fNumDimensions);
+  for (int i = fNumDimensions - 1; i >= 0; --i) {
+    const size_t extent = static_cast<size_t>(fMaxBounds[i] - fMinBounds[i] + 1);
+    coords[i]           = fMinBounds[i] + static_cast<int>(index % extent);
+    index /= extent;
+  }
+}
+
+double NDimensionalExecutor::GetMeanKnownCost(const std::vector<double> & costs, size_t * nKnown)
+{
+  double sumKnown = 0.0;
+  size_t n        = 0;
+  for (double c : costs) {
+    if (std::isfinite(c) && c >= 0.0) {
+      sumKnown += c;
+      ++n;
+    }
+  }
+  if (nKnown) *nKnown = n;
+  return n > 0 ? sumKnown / n : 0.0;
+}
+
+std::vector<size_t> NDimensionalExecutor::BuildLptOrder(const std::vector<double> & costs, double fallback)
+{
+  if (fallback < 0.0) fallback = GetMeanKnownCost(costs);
+
+  std::vector<size_t> order(costs.size());
+  std::iota(order.begin(), order.end(), 0);
+  auto costOf = [&](size_t i) { return (std::isfinite(costs[i]) && costs[i] >= 0.0) ? costs[i] : fallback; };
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return costOf(a) > costOf(b); });
+  return order;
+}
+
+void NDimensionalExecutor::ReorderByEstimatedCost(std::vector<size_t> & order, size_t from,
+                                                  const std::vector<double> & costs,
+                                                  const std::vector<std::vector<int>> & coords,
+                                                  const NTaskCostModel & model)
+{
+  if (from >= order.size()) return;
+  std::vector<std::pair<double, size_t>> remaining;
+  remaining.reserve(order.size() - from);
+  for (size_t i = from; i < order.size(); ++i) {
+    const size_t taskId = order[i];
+    double       cost   = taskId < costs.size() ? costs[taskId] : -1.0;
+    if ((!std::isfinite(cost) || cost < 0.0) && taskId < coords.size()) cost = model.Estimate(coords[taskId]);
+    remaining.emplace_back(cost, taskId);
+  }
+  std::stable_sort(remaining.begin(), remaining.end(),
+                   [](const auto & a, const auto & b) { return a.first > b.first; });
+  for (size_t i = 0; i < remaining.size(); ++i) order[from + i] = remaining[i].second;
+}
+
+bool NDimensionalExecutor::IsCostAware()
+{
+  const char * env = gSystem->Getenv("NDMSPC_IPC_COST_AWARE");
+  if (!env) return false;
+  std::string value(env);
+  std::transform(value.begin(), value.end(), value.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return value == "1" || value == "true" || value == "yes" || value == "on";
+}
+
+size_t NDimensionalExecutor::ScaleBatchByThroughput(size_t baseBatch, double workerRate, double meanRate,
+                                                    size_t maxBatch)
+{
+  baseBatch = std::max<size_t>(1, baseBatch);
+  maxBatch  = std::max<size_t>(1, maxBatch);
+  if (!(workerRate > 0.0) || !(meanRate > 0.0) || !std::isfinite(workerRate) || !std::isfinite(meanRate)) {
+    return std::min(baseBatch, maxBatch);
+  }
+  const double scaled = std::round(static_cast<double>(baseBatch) * workerRate / meanRate);
+  if (scaled < 1.0) return 1;
+  return std::min(maxBatch, static_cast<size_t>(scaled));
+}
+
+bool NDimensionalExecutor::ParseParallelScheduler(const std::string & name, ParallelScheduler & scheduler)
+{
+  std::string value(name);
+  std::transform(value.begin(), value.end(), value.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  if (value == "queue") {
+    scheduler = ParallelScheduler::kQueue;
+    return true;
+  }
+  if (value == "steal" || value == "worksteal" || value == "work-stealing") {
+    scheduler = ParallelScheduler::kWorkStealing;
+    return true;
   }
   return false;
 }
@@ -242,7 +356,7 @@ void NDimensionalExecutor::Execute(const std::function<void(const std::vector<in
 // --- Template Implementation for ExecuteParallel ---
 /**
  * @brief Execute a function in parallel over all coordinates, using thread-local objects.
- *        Handles task distribution, synchronization, and exception propagation.
+ *        Dispatches to the scheduler selected by SetParallelScheduler().
  *
  * @throws std::exception If any worker thread throws, the first exception is rethrown after joining.
  */
@@ -254,11 +368,29 @@ void NDimensionalExecutor::ExecuteParallel(
   if (fNumDimensions == 0) {
     return;
   }
-  size_t threads_to_use = thread_objects.size();
-  if (threads_to_use == 0) {
+  if (thread_objects.empty()) {
     throw std::invalid_argument("Thread objects vector cannot be empty.");
   }
 
+  if (fScheduler == ParallelScheduler::kWorkStealing) {
+    ExecuteParallelWorkStealing<TObject>(func, thread_objects);
+  }
+  else {
+    ExecuteParallelQueue<TObject>(func, thread_objects);
+  }
+}
+
+/**
+ * @brief Shared-queue scheduler: the calling thread enqueues one task per coordinate.
+ *        Handles task distribution, synchronization, and exception propagation.
+ */
+template <typename TObject>
+void NDimensionalExecutor::ExecuteParallelQueue(
+    const std::function<void(const std::vector<int> & coords, TObject & thread_object)> & func,
+    std::vector<TObject> &                                                                thread_objects)
+{
+  size_t threads_to_use = thread_objects.size();
+
   std::vector<std::thread>                   workers;
   std::queue<std::function<void(TObject &)>> tasks;
   std::mutex                                 queue_mutex;
@@ -430,6 +562,113 @@ void NDimensionalExecutor::ExecuteParallel(
   }
 }
 
+/**
+ * @brief Work-stealing scheduler: the linear index space is cut into chunks of consecutive
+ *        points, distributed as contiguous blocks over per-thread deques. A thread pops chunks
+ *        from the front of its own deque and, once it runs dry, steals from the back of the
+ *        others. No work is added after start, so a failed full steal scan means all work is taken.
+ */
+template <typename TObject>
+void NDimensionalExecutor::ExecuteParallelWorkStealing(
+    const std::function<void(const std::vector<int> & coords, TObject & thread_object)> & func,
+    std::vector<TObject> &                                                                thread_objects)
+{
+  const size_t threads_to_use = thread_objects.size();
+  const size_t total          = GetTotalPoints();
+
+  size_t chunkSize = fChunkSize;
+  if (chunkSize == 0) {
+    // Aim for ~8 chunks per thread so stealing can balance uneven bins, capped to keep
+    // per-chunk latency low when individual points are expensive.
+    chunkSize = std::max<size_t>(1, std::min<size_t>(64, total / (threads_to_use * 8)));
+  }
+
+  using Chunk = std::pair<size_t, size_t>; // [begin, end) in linear index space
+  struct WorkDeque {
+    std::mutex        mutex;
+    std::deque<Chunk> chunks;
+  };
+  std::vector<WorkDeque> deques(threads_to_use);
+  for (size_t t = 0; t < threads_to_use; ++t) {
+    const size_t begin = total * t / threads_to_use;
+    const size_t end   = total * (t + 1) / threads_to_use;
+    for (size_t c = begin; c < end; c += chunkSize) {
+      deques[t].chunks.emplace_back(c, std::min(end, c + chunkSize));
+    }
+  }
+
+  std::atomic<bool>  stop_pool{false};
+  std::exception_ptr first_exception = nullptr;
+  std::mutex         exception_mutex;
+
+  auto popLocal = [&](size_t self, Chunk & chunk) {
+    std::lock_guard<std::mutex> lock(deques[self].mutex);
+    if (deques[self].chunks.empty()) return false;
+    chunk = deques[self].chunks.front();
+    deques[self].chunks.pop_front();
+    return true;
+  };
+  auto steal = [&](size_t self, Chunk & chunk) {
+    for (size_t k = 1; k < threads_to_use; ++k) {
+      WorkDeque &                 victim = deques[(self + k) % threads_to_use];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (victim.chunks.empty()) continue;
+      chunk = victim.chunks.back();
+      victim.chunks.pop_back();
+      return true;
+    }
+    return false;
+  };
+
+  auto worker_logic = [&](size_t self) {
+    TObject &     my_object = thread_objects[self];
+    NThreadData * md        = (NThreadData *)&my_object;
+
+    std::ostringstream oss;
+    oss << "wk_" << std::setw(6) << std::setfill('0') << md->GetAssignedIndex();
+    NLogger::SetThreadName(oss.str());
+
+    std::vector<int> coords(fNumDimensions);
+    Chunk            chunk;
+    try {
+      while (!stop_pool.load(std::memory_order_relaxed)) {
+        if (!popLocal(self, chunk) && !steal(self, chunk)) break;
+        DecodeLinearIndex(chunk.first, coords);
+        for (size_t idx = chunk.first; idx < chunk.second; ++idx) {
+          if (stop_pool.load(std::memory_order_relaxed)) break;
+          func(coords, my_object);
+          Increment(coords);
+        }
+      }
+    }
+    catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(exception_mutex);
+        if (!first_exception) {
+          first_exception = std::current_exception();
+        }
+      }
+      // Remaining chunks are abandoned; other threads stop after their current point.
+      stop_pool = true;
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads_to_use);
+  for (size_t i = 0; i < threads_to_use; ++i) {
+    workers.emplace_back(worker_logic, i);
+  }
+  for (std::thread & worker : workers) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+
+  if (first_exception) {
+    std::rethrow_exception(first_exception);
+  }
+}
+
 size_t NDimensionalExecutor::ExecuteParallelProcessIpc(std::vector<NThreadData *> & workerObjects,
                                                        size_t                       processCount)
 {
@@ -474,11 +713,7 @@ bool NDimensionalExecutor::InitTcpWorker(const std::string & identity)
     return false;
   }
 
-  const std::string sessionId = std::to_string(getpid());
-  if (!NDimensionalIpcRunner::SendFrames(fIpcSession->router,
-                                         {identity, "INIT", std::to_string(workerIdx), sessionId,
-                                          fIpcSession->jobDir, fIpcSession->treeName,
-                                          fIpcSession->tmpDir, fIpcSession->tmpResultsDir})) {
+  if (!NDimensionalIpcRunner::SendFrames(fIpcSession->router, BuildInitFrames(identity, workerIdx))) {
     NLogError("NDimensionalExecutor::InitTcpWorker: failed to send INIT to '%s'", identity.c_str());
     return false;
   }
@@ -509,6 +744,7 @@ bool NDimensionalExecutor::InitTcpWorker(const std::string & identity)
       continue;
     }
     if (ackFrames.size() >= 2 && ackFrames[1] == "READY" && ackFrames[0] != identity) {
+      NoteWorkerReady(ackFrames);
       if (!fIpcSession->identityToWorker.count(ackFrames[0]) &&
           std::find(fIpcSession->pendingReadyIdentities.begin(), fIpcSession->pendingReadyIdentities.end(),
                     ackFrames[0]) == fIpcSession->pendingReadyIdentities.end()) {
@@ -545,6 +781,60 @@ bool NDimensionalExecutor::InitTcpWorker(const std::string & identity)
   return true;
 }
 
+std::vector<std::string> NDimensionalExecutor::BuildInitFrames(const std::string & identity, size_t workerIdx) const
+{
+  const std::string sessionId    = std::to_string(getpid());
+  const bool        streamResult = fResultStreamChunk > 0 && fResultHandler;
+  return {identity,
+          "INIT",
+          std::to_string(workerIdx),
+          sessionId,
+          fIpcSession->jobDir,
+          fIpcSession->treeName,
+          fIpcSession->tmpDir,
+          fIpcSession->tmpResultsDir,
+          std::to_string(streamResult ? fResultStreamChunk : 0),
+          std::to_string(std::max<size_t>(1, fResultStreamWindow)),
+          std::to_string(WorkerProtocol(identity))};
+}
+
+void NDimensionalExecutor::NoteWorkerReady(const std::vector<std::string> & frames)
+{
+  if (frames.size() < 2 || frames[1] != "READY") return;
+  // Old workers send a bare READY and only understand the text framing.
+  const int version = std::min(NDimensionalIpcRunner::ParseProtocolVersion(frames, 2),
+                               NDimensionalIpcRunner::GetProtocolVersion());
+  fIpcSession->workerProtocol[frames[0]] = version;
+  NLogDebug("NDimensionalExecutor: worker '%s' uses task framing v%d", frames[0].c_str(), version);
+}
+
+int NDimensionalExecutor::WorkerProtocol(const std::string & identity) const
+{
+  auto it = fIpcSession->workerProtocol.find(identity);
+  return it != fIpcSession->workerProtocol.end() ? it->second : 1;
+}
+
+bool NDimensionalExecutor::HandleResultFrames(const std::vector<std::string> & frames)
+{
+  if (frames.size() < 4 || (frames[1] != "RESULT" && frames[1] != "RESULTO")) return false;
+
+  const std::string & workerIdentity = frames[0];
+  auto                it             = fIpcSession->identityToWorker.find(workerIdentity);
+  if (it == fIpcSession->identityToWorker.end()) {
+    NLogWarning("NDimensionalExecutor: ignoring %s from unknown worker '%s'", frames[1].c_str(),
+                workerIdentity.c_str());
+    return true;
+  }
+  if (!fResultHandler || !fResultHandler(it->second, frames[1], frames[3])) {
+    NLogError("NDimensionalExecutor: failed to store %s #%s (%zu bytes) from worker '%s'", frames[1].c_str(),
+              frames[2].c_str(), frames[3].size(), workerIdentity.c_str());
+  }
+  // Acknowledge even on failure so the worker does not block; the error is reported above.
+  NDimensionalIpcRunner::SendFrames(fIpcSession->router, {workerIdentity, "RACK", frames[2]});
+  fIpcSession->workerLastActivity[workerIdentity] = std::chrono::steady_clock::now();
+  return true;
+}
+
 bool NDimensionalExecutor::HandleBootstrap(const std::string & identity)
 {
   if (!fIpcSession || !fIpcSession->isTcp) return false;
@@ -779,6 +1069,7 @@ void NDimensionalExecutor::StartProcessIpc(std::vector<NThreadData *> & workerOb
       continue;
     }
     if (cmd != "READY") continue;
+    NoteWorkerReady(frames);
 
     if (isTcp) {
       InitTcpWorker(identity);
@@ -841,16 +1132,22 @@ size_t NDimensionalExecutor::HandleWorkerFailure(const std::string & failedIdent
 
   auto historyIt = fIpcSession->workerTaskHistory.find(failedIdentity);
   if (historyIt != fIpcSession->workerTaskHistory.end()) {
-    for (const size_t taskId : historyIt->second) {
-      const bool wasDone = fIpcSession->taskStateManager.IsDone(taskId);
-      if (!fIpcSession->taskStateManager.RequeueTask(taskId)) {
-        continue;
-      }
-      ++redistributedCount;
-      if (wasDone) {
-        ++replayedDoneCount;
-      } else {
-        ++replayedLiveCount;
+    for (const auto & range : historyIt->second.Ranges()) {
+      for (size_t taskId = range.first; taskId < range.second; ++taskId) {
+        // Speculated task still running on another owner: let that copy finish.
+        if (fIpcSession->taskStateManager.ReleaseOwner(taskId, failedIdentity)) {
+          continue;
+        }
+        const bool wasDone = fIpcSession->taskStateManager.IsDone(taskId);
+        if (!fIpcSession->taskStateManager.RequeueTask(taskId)) {
+          continue;
+        }
+        ++redistributedCount;
+        if (wasDone) {
+          ++replayedDoneCount;
+        } else {
+          ++replayedLiveCount;
+        }
       }
     }
     fIpcSession->workerTaskHistory.erase(historyIt);
@@ -934,8 +1231,12 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
   }
 
   fIpcSession->taskStateManager.Clear();
+  // Task ids are linear indices into the bounds, so coordinates are derived instead of stored per task.
+  fIpcSession->taskStateManager.SetPayloadResolver(
+      [this](size_t taskId, std::vector<int> & coords) { DecodeLinearIndex(taskId, coords); });
   fIpcSession->workerTaskHistory.clear();
   fLastWorkerTaskCounts.clear();
+  fLastSpeculativeDuplicates.clear();
 
   // Save current definition so late-joining workers can catch up
   fIpcSession->currentDefName    = definitionName;
@@ -1014,6 +1315,36 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
     }
   }
 
+  // Cost-aware dispatch: idle workers first, batch sizes scaled by measured throughput.
+  const bool costAware = IsCostAware();
+
+  // Speculative re-execution of stragglers (TCP only): once everything is
+  // dispatched, duplicate tasks running much longer than the median onto idle workers.
+  bool   speculation       = false;
+  double speculationFactor = 3.0;
+  if (fIpcSession->isTcp) {
+    if (const char * envSpeculation = gSystem->Getenv("NDMSPC_TCP_SPECULATION")) {
+      std::string value(envSpeculation);
+      std::transform(value.begin(), value.end(), value.begin(),
+                     [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+      speculation = (value == "1" || value == "true" || value == "yes" || value == "on");
+    }
+    if (const char * envFactor = gSystem->Getenv("NDMSPC_TCP_SPECULATION_FACTOR")) {
+      try {
+        speculationFactor = std::max(1.0, std::stod(envFactor));
+      }
+      catch (...) {
+        NLogWarning("NGnTree::Process: Invalid NDMSPC_TCP_SPECULATION_FACTOR='%s', using default=%.1f", envFactor,
+                    speculationFactor);
+      }
+    }
+  }
+  const size_t speculationMinSamples = 5;
+  std::unordered_map<size_t, std::chrono::steady_clock::time_point> taskDispatchTime;
+  std::vector<double>                                               completedTaskSecs;
+  std::set<size_t>                                                  speculatedTasks;
+  std::set<std::pair<size_t, std::string>>                          speculativeLosers; // (task, losing worker)
+
   int stallTimeoutSec = 120;
   if (const char * envStallTimeout = gSystem->Getenv("NDMSPC_IPC_STALL_TIMEOUT")) {
     try {
@@ -1049,6 +1380,130 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
                ipcBatchSize, effectiveBatchSize, totalTasks, expectedWorkers);
     }
   }
+
+  // Per-task cost estimates (consumed by this call): dispatch new tasks
+  // longest-first so expensive bins do not end up in the tail of the run.
+  std::vector<double> taskCosts;
+  taskCosts.swap(fTaskCosts);
+  std::vector<size_t> dispatchOrder;
+  double              meanTaskCost = 1.0;
+  if (!taskCosts.empty()) {
+    if (taskCosts.size() == totalTasks) {
+      size_t       nKnown    = 0;
+      const double meanKnown = GetMeanKnownCost(taskCosts, &nKnown);
+      dispatchOrder          = BuildLptOrder(taskCosts, meanKnown);
+      if (meanKnown > 0.0) meanTaskCost = meanKnown;
+      NLogInfo("NDimensionalExecutor::IPC: dispatching %zu tasks in LPT order (%zu with cost history)", totalTasks,
+               nKnown);
+    }
+    else {
+      NLogWarning("NDimensionalExecutor::IPC: ignoring %zu task cost estimates for %zu tasks", taskCosts.size(),
+                  totalTasks);
+      taskCosts.clear();
+    }
+  }
+  auto taskWork = [&](size_t taskId) {
+    if (taskId >= taskCosts.size()) return 1.0;
+    const double c = taskCosts[taskId];
+    return (std::isfinite(c) && c >= 0.0) ? c / meanTaskCost : 1.0;
+  };
+
+  // Cost-aware dispatch also learns from the ACKs of this run: the observed costs estimate the
+  // tasks without cost history, and the tasks not dispatched yet are re-sorted longest-first
+  // each time the number of observations doubled.
+  // The model learns per task coordinate; tasks over a list of bins pass the bin coordinates,
+  // as their linear task indices say nothing about the tasks not run yet.
+  std::vector<std::vector<int>> taskCoords;
+  taskCoords.swap(fTaskCoords);
+  std::unique_ptr<NTaskCostModel> costModel;
+  size_t                          nextReorderObserved = 0;
+  if (costAware) {
+    if (!taskCoords.empty() && taskCoords.size() != totalTasks) {
+      NLogWarning("NDimensionalExecutor::IPC: ignoring %zu task coordinates for %zu tasks", taskCoords.size(),
+                  totalTasks);
+      taskCoords.clear();
+    }
+    std::vector<int> minCoords = fMinBounds, maxCoords = fMaxBounds;
+    if (taskCoords.empty()) {
+      taskCoords.assign(totalTasks, std::vector<int>(fNumDimensions));
+      for (size_t i = 0; i < totalTasks; ++i) DecodeLinearIndex(i, taskCoords[i]);
+    }
+    else {
+      minCoords = maxCoords = taskCoords[0];
+      for (const auto & c : taskCoords) {
+        for (size_t d = 0; d < c.size() && d < minCoords.size(); ++d) {
+          minCoords[d] = std::min(minCoords[d], c[d]);
+          maxCoords[d] = std::max(maxCoords[d], c[d]);
+        }
+      }
+    }
+    costModel = std::make_unique<NTaskCostModel>(minCoords, maxCoords);
+    if (dispatchOrder.empty()) {
+      dispatchOrder.resize(totalTasks);
+      std::iota(dispatchOrder.begin(), dispatchOrder.end(), 0);
+    }
+    nextReorderObserved = std::max<size_t>(8, fIpcSession->workerIdentityVec.size());
+  }
+  else {
+    taskCoords.clear();
+  }
+  auto reorderRemainingTasks = [&]() {
+    if (nextTaskId >= totalTasks) return;
+    ReorderByEstimatedCost(dispatchOrder, nextTaskId, taskCosts, taskCoords, *costModel);
+    NLogDebug("NDimensionalExecutor::IPC: re-sorted %zu remaining tasks using %zu observed costs",
+              totalTasks - nextTaskId, costModel->GetNObserved());
+  };
+
+  // Throughput bookkeeping for cost-aware batching. Workers process their
+  // messages in order, so a message starts when it was sent or when the
+  // previous one was acknowledged, whichever is later.
+  struct SentMessage {
+    std::chrono::steady_clock::time_point sentAt;  ///< Time the message was sent
+    double                                work;    ///< Work units of its tasks
+    std::vector<size_t>                   taskIds; ///< Tasks of the message
+  };
+  std::unordered_map<std::string, std::deque<SentMessage>>               sentMessages;
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point> lastAckTime;
+  std::unordered_map<std::string, double>                                workerThroughput;
+  auto recordMessageAck = [&](const std::string & identity) {
+    if (!costAware) return;
+    auto sentIt = sentMessages.find(identity);
+    if (sentIt == sentMessages.end() || sentIt->second.empty()) return;
+    const auto        now     = std::chrono::steady_clock::now();
+    const SentMessage message = std::move(sentIt->second.front());
+    sentIt->second.pop_front();
+    auto start  = message.sentAt;
+    auto lastIt = lastAckTime.find(identity);
+    if (lastIt != lastAckTime.end() && lastIt->second > start) start = lastIt->second;
+    lastAckTime[identity] = now;
+    const double elapsed = std::chrono::duration<double>(now - start).count();
+    if (elapsed <= 0.0 || message.work <= 0.0) return;
+    // The elapsed time is shared by the tasks of the message in proportion to their expected work
+    for (const size_t taskId : message.taskIds) {
+      if (taskId < taskCoords.size()) costModel->Add(taskCoords[taskId], elapsed * taskWork(taskId) / message.work);
+    }
+    if (costModel->GetNObserved() >= nextReorderObserved) {
+      reorderRemainingTasks();
+      nextReorderObserved = 2 * costModel->GetNObserved();
+    }
+    const double rate     = message.work / elapsed;
+    double &     smoothed = workerThroughput[identity];
+    smoothed              = (smoothed > 0.0) ? 0.7 * smoothed + 0.3 * rate : rate;
+  };
+  auto meanThroughput = [&]() {
+    double sum = 0.0;
+    size_t n   = 0;
+    for (const auto & identity : fIpcSession->workerIdentityVec) {
+      auto it = workerThroughput.find(identity);
+      if (it == workerThroughput.end()) continue;
+      sum += it->second;
+      ++n;
+    }
+    return n > 0 ? sum / n : 0.0;
+  };
+  // Scaled batches may exceed the base size, so widen the task budget accordingly.
+  const size_t maxBatchScale = costAware ? 4 : 1;
+
   auto isUserInterrupted = []() {
     if (gIpcSigIntRequested != 0) return true;
     return (gROOT && gROOT->IsInterrupted());
@@ -1071,6 +1526,116 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
       outstandingMessages -= dec;
       inFlightMessagesPerWorker.erase(it);
     }
+    sentMessages.erase(identity);
+    lastAckTime.erase(identity);
+    workerThroughput.erase(identity);
+    for (auto loserIt = speculativeLosers.begin(); loserIt != speculativeLosers.end();) {
+      loserIt = (loserIt->second == identity) ? speculativeLosers.erase(loserIt) : std::next(loserIt);
+    }
+  };
+  // Ids accepted from a worker are reported to the checkpoint handler once the worker
+  // marks an ACK/ACKB with "C", i.e. after its output file holds them durably.
+  auto recordCheckpointable = [&](const std::string & identity, size_t taskId) {
+    if (!fCheckpointHandler) return;
+    const bool mapped = fIpcSession->hasCurrentDefIds && taskId < fIpcSession->currentDefIds.size();
+    fIpcSession->uncheckpointedIds[identity].push_back(mapped ? fIpcSession->currentDefIds[taskId]
+                                                              : static_cast<Long64_t>(taskId));
+  };
+  auto reportCheckpoint = [&](const std::vector<std::string> & ackFrames, const std::string & identity) {
+    if (!fCheckpointHandler || ackFrames.size() < 4 || ackFrames[3] != "C") return;
+    auto workerIt = fIpcSession->identityToWorker.find(identity);
+    auto idsIt    = fIpcSession->uncheckpointedIds.find(identity);
+    if (workerIt == fIpcSession->identityToWorker.end() || idsIt == fIpcSession->uncheckpointedIds.end()) return;
+    fCheckpointHandler(workerIt->second, idsIt->second);
+    idsIt->second.clear();
+  };
+  // Bookkeeping when a task is acknowledged by `winner`: other owners of a
+  // speculated task become losers whose late ACK and output are discarded.
+  auto resolveSpeculation = [&](size_t taskId, const std::string & winner,
+                                const std::vector<std::string> & owners) {
+    auto winnerIt = fIpcSession->identityToWorker.find(winner);
+    if (winnerIt != fIpcSession->identityToWorker.end()) {
+      auto dupIt = fLastSpeculativeDuplicates.find(winnerIt->second);
+      if (dupIt != fLastSpeculativeDuplicates.end()) dupIt->second.erase(taskId);
+    }
+    if (speculation && !speculatedTasks.count(taskId)) {
+      auto startIt = taskDispatchTime.find(taskId);
+      if (startIt != taskDispatchTime.end()) {
+        completedTaskSecs.push_back(
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - startIt->second).count());
+      }
+    }
+    taskDispatchTime.erase(taskId);
+    if (owners.size() < 2) return;
+
+    fIpcSession->workerTaskHistory[winner].Insert(taskId);
+    for (const auto & loser : owners) {
+      if (loser == winner) continue;
+      speculativeLosers.emplace(taskId, loser);
+      auto historyIt = fIpcSession->workerTaskHistory.find(loser);
+      if (historyIt != fIpcSession->workerTaskHistory.end()) historyIt->second.Erase(taskId);
+      auto loserIdxIt = fIpcSession->identityToWorker.find(loser);
+      if (loserIdxIt != fIpcSession->identityToWorker.end()) {
+        fLastSpeculativeDuplicates[loserIdxIt->second].insert(taskId);
+      }
+    }
+    NLogInfo("NDimensionalExecutor::IPC: speculated task %zu finished first on worker '%s'", taskId, winner.c_str());
+  };
+  // Duplicate stragglers onto idle workers once all tasks have been dispatched.
+  auto speculateStragglers = [&]() {
+    if (!speculation || hasMore || fIpcSession->taskStateManager.HasPending() ||
+        completedTaskSecs.size() < speculationMinSamples) {
+      return;
+    }
+    std::vector<std::string> idleWorkers;
+    for (const auto & identity : fIpcSession->workerIdentityVec) {
+      if (fIpcSession->failedTcpWorkers.count(identity) || inFlightMessagesPerWorker.count(identity)) continue;
+      idleWorkers.push_back(identity);
+    }
+    if (idleWorkers.empty()) return;
+
+    std::vector<double> samples(completedTaskSecs);
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    const double threshold = speculationFactor * samples[samples.size() / 2];
+    const auto   now       = std::chrono::steady_clock::now();
+
+    std::vector<std::pair<double, size_t>> stragglers;
+    for (const size_t taskId : fIpcSession->taskStateManager.GetRunningTasks()) {
+      if (speculatedTasks.count(taskId)) continue;
+      auto startIt = taskDispatchTime.find(taskId);
+      if (startIt == taskDispatchTime.end()) continue;
+      const double elapsed = std::chrono::duration<double>(now - startIt->second).count();
+      if (elapsed > threshold) stragglers.emplace_back(elapsed, taskId);
+    }
+    std::sort(stragglers.rbegin(), stragglers.rend());
+
+    for (const auto & straggler : stragglers) {
+      if (idleWorkers.empty()) break;
+      const size_t     taskId = straggler.second;
+      std::vector<int> coords;
+      if (!fIpcSession->taskStateManager.GetTaskPayload(taskId, coords)) continue;
+      auto idleIt = std::find_if(idleWorkers.begin(), idleWorkers.end(), [&](const std::string & w) {
+        return !fIpcSession->taskStateManager.IsTaskOwner(taskId, w);
+      });
+      if (idleIt == idleWorkers.end()) continue;
+      const std::string identity = *idleIt;
+      if (!NDimensionalIpcRunner::SendFrames(fIpcSession->router,
+                                             {identity, "TASK",
+                                              NDimensionalIpcRunner::EncodeTaskId(taskId, WorkerProtocol(identity)),
+                                              NDimensionalIpcRunner::EncodeCoords(coords, WorkerProtocol(identity))})) {
+        NLogWarning("NDimensionalExecutor::IPC: failed to send speculative TASK %zu to worker '%s'", taskId,
+                    identity.c_str());
+        continue;
+      }
+      idleWorkers.erase(idleIt);
+      fIpcSession->taskStateManager.AddSpeculativeOwner(identity, taskId);
+      speculatedTasks.insert(taskId);
+      fIpcSession->workerLastActivity[identity] = std::chrono::steady_clock::now();
+      ++outstandingMessages;
+      ++inFlightMessagesPerWorker[identity];
+      NLogInfo("NDimensionalExecutor::IPC: speculating task %zu (running %.1fs, median %.1fs) on idle worker '%s'",
+               taskId, straggler.first, threshold / speculationFactor, identity.c_str());
+    }
   };
   auto detectInactiveTcpWorkers = [&]() {
     if (!fIpcSession->isTcp) return;
@@ -1098,7 +1663,7 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
         continue;
       }
 
-      const bool hasPendingTasks = !fIpcSession->taskStateManager.GetWorkerTasks(identity).empty();
+      const bool hasPendingTasks = fIpcSession->taskStateManager.WorkerTaskCount(identity) > 0;
       if (hasPendingTasks || inactiveSecs >= tcpWorkerTimeoutSec * 2) {
         inactiveWorkers.push_back(identity);
       }
@@ -1208,6 +1773,7 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
     // Allow multiple batches to be in flight for better parallelism
     // Each worker can have up to this many batches pending
     const size_t maxInFlightMessages = std::max<size_t>(4, fIpcSession->workerIdentityVec.size());
+    const size_t maxOutstandingTasks = maxInFlightMessages * effectiveBatchSize * maxBatchScale;
 
     while ((hasMore || fIpcSession->taskStateManager.HasPending()) && outstandingMessages < maxInFlightMessages && firstError.empty()) {
       if (fIpcSession->workerIdentityVec.empty()) break; // no workers yet — wait
@@ -1216,8 +1782,29 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
       size_t workerSlot = dispatchMessageId % fIpcSession->workerIdentityVec.size();
       std::string identity = fIpcSession->workerIdentityVec[workerSlot];
       
+      if (costAware) {
+        // Prefer the least-loaded eligible worker; round-robin order breaks ties.
+        bool   foundCandidate = false;
+        size_t bestInFlight   = std::numeric_limits<size_t>::max();
+        for (size_t k = 0; k < fIpcSession->workerIdentityVec.size(); ++k) {
+          const std::string & candidate =
+              fIpcSession->workerIdentityVec[(dispatchMessageId + k) % fIpcSession->workerIdentityVec.size()];
+          if (fIpcSession->isTcp && fIpcSession->failedTcpWorkers.count(candidate)) continue;
+          const auto   inFlightIt     = inFlightMessagesPerWorker.find(candidate);
+          const size_t workerInFlight = (inFlightIt != inFlightMessagesPerWorker.end()) ? inFlightIt->second : 0;
+          if (fIpcSession->isTcp && workerInFlight >= tcpMaxInFlightPerWorker) continue;
+          if (workerInFlight < bestInFlight) {
+            bestInFlight   = workerInFlight;
+            identity       = candidate;
+            foundCandidate = true;
+          }
+        }
+        if (!foundCandidate) {
+          break;
+        }
+      }
       // In TCP mode, skip failed workers and find next available worker
-      if (fIpcSession->isTcp) {
+      else if (fIpcSession->isTcp) {
         size_t attempts = 0;
         bool   foundCandidate = false;
         while (attempts < fIpcSession->workerIdentityVec.size()) {
@@ -1243,8 +1830,16 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
       std::vector<std::pair<size_t, std::vector<int>>> batchTasks;
       const size_t nw              = fIpcSession->workerIdentityVec.size();
       const size_t remainingTasks  = (nextTaskId < totalTasks) ? (totalTasks - nextTaskId) : 0;
-      const size_t adaptiveBatchSize = std::max<size_t>(
+      size_t adaptiveBatchSize = std::max<size_t>(
           1, std::min(effectiveBatchSize, std::max<size_t>(1, (remainingTasks + nw - 1) / nw)));
+      if (costAware) {
+        // Faster workers get proportionally larger batches (never more than their fair share of what is left).
+        auto         rateIt   = workerThroughput.find(identity);
+        const size_t maxBatch = std::max<size_t>(
+            1, std::min(effectiveBatchSize * maxBatchScale, std::max<size_t>(1, (remainingTasks + nw - 1) / nw)));
+        adaptiveBatchSize = ScaleBatchByThroughput(
+            adaptiveBatchSize, rateIt != workerThroughput.end() ? rateIt->second : 0.0, meanThroughput(), maxBatch);
+      }
       batchTasks.reserve(adaptiveBatchSize);
 
       // First, dispatch redistributed (pending) tasks from failed workers
@@ -1255,7 +1850,7 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
         redistPerBatch = std::max<size_t>(1, adaptiveBatchSize / fIpcSession->workerIdentityVec.size());
       }
       size_t redistAdded = 0;
-      while (fIpcSession->taskStateManager.HasPending() && outstanding < maxInFlightMessages * effectiveBatchSize && 
+      while (fIpcSession->taskStateManager.HasPending() && outstanding < maxOutstandingTasks && 
              batchTasks.size() < adaptiveBatchSize && redistAdded < redistPerBatch) {
         size_t            taskId = 0;
         std::vector<int>  coords;
@@ -1263,7 +1858,7 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
           break;
         }
         batchTasks.emplace_back(taskId, coords);
-        fIpcSession->workerTaskHistory[identity].insert(taskId);
+        fIpcSession->workerTaskHistory[identity].Insert(taskId);
         ++redistAdded;
         ++outstanding;
 
@@ -1278,8 +1873,11 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
       }
 
       // Then, dispatch new tasks if space available
-      while (hasMore && outstanding < maxInFlightMessages * effectiveBatchSize && batchTasks.size() < adaptiveBatchSize) {
-        fIpcSession->taskStateManager.AddPending(nextTaskId, fCurrentCoords);
+      while (hasMore && outstanding < maxOutstandingTasks && batchTasks.size() < adaptiveBatchSize) {
+        // Task ids are linear indices; with cost estimates they are handed out in LPT order.
+        const size_t newTaskId = dispatchOrder.empty() ? nextTaskId : dispatchOrder[nextTaskId];
+        if (!dispatchOrder.empty()) DecodeLinearIndex(newTaskId, fCurrentCoords);
+        fIpcSession->taskStateManager.AddPending(newTaskId, fCurrentCoords);
         size_t            taskId = 0;
         std::vector<int>  payload;
         if (!fIpcSession->taskStateManager.ClaimNextPendingForWorker(identity, taskId, payload)) {
@@ -1287,11 +1885,14 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
           break;
         }
         batchTasks.emplace_back(taskId, payload);
-        fIpcSession->workerTaskHistory[identity].insert(taskId);
+        fIpcSession->workerTaskHistory[identity].Insert(taskId);
         ++nextTaskId;
         ++outstanding;
 
-        if (!Increment()) {
+        if (!dispatchOrder.empty()) {
+          hasMore = nextTaskId < totalTasks;
+        }
+        else if (!Increment()) {
           hasMore = false;
         }
 
@@ -1320,9 +1921,10 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
         fIpcSession->workerLastActivity[identity] = std::chrono::steady_clock::now();
       }
 
+      const int protocol = WorkerProtocol(identity);
       if (batchTasks.size() == 1) {
-        const std::string taskId = std::to_string(batchTasks[0].first);
-        const std::string coords = NDimensionalIpcRunner::SerializeCoords(batchTasks[0].second);
+        const std::string taskId = NDimensionalIpcRunner::EncodeTaskId(batchTasks[0].first, protocol);
+        const std::string coords = NDimensionalIpcRunner::EncodeCoords(batchTasks[0].second, protocol);
         if (!NDimensionalIpcRunner::SendFrames(fIpcSession->router, {identity, "TASK", taskId, coords})) {
           if (fIpcSession->isTcp) {
             // TCP worker likely disconnected - mark for redistribution
@@ -1341,12 +1943,8 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
         }
       }
       else {
-        std::ostringstream payload;
-        for (size_t i = 0; i < batchTasks.size(); ++i) {
-          if (i != 0) payload << ';';
-          payload << batchTasks[i].first << ':' << NDimensionalIpcRunner::SerializeCoords(batchTasks[i].second);
-        }
-        if (!NDimensionalIpcRunner::SendFrames(fIpcSession->router, {identity, "TASKB", payload.str()})) {
+        const std::string payload = NDimensionalIpcRunner::EncodeTaskBatch(batchTasks, protocol);
+        if (!NDimensionalIpcRunner::SendFrames(fIpcSession->router, {identity, "TASKB", payload})) {
           if (fIpcSession->isTcp) {
             // TCP worker likely disconnected - mark for redistribution
             NLogWarning("Failed to send TASKB to TCP worker '%s', marking as failed", identity.c_str());
@@ -1366,8 +1964,23 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
       ++dispatchMessageId;
       ++outstandingMessages;
       ++inFlightMessagesPerWorker[identity];
+      if (costAware) {
+        SentMessage message{std::chrono::steady_clock::now(), 0.0, {}};
+        message.taskIds.reserve(batchTasks.size());
+        for (const auto & task : batchTasks) {
+          message.work += taskWork(task.first);
+          message.taskIds.push_back(task.first);
+        }
+        sentMessages[identity].push_back(std::move(message));
+      }
+      if (speculation) {
+        const auto sentAt = std::chrono::steady_clock::now();
+        for (const auto & task : batchTasks) taskDispatchTime[task.first] = sentAt;
+      }
     }
 
+    speculateStragglers();
+
     // Clean up any TCP workers that failed during send attempts
     if (fIpcSession->isTcp && !fIpcSession->failedTcpWorkers.empty()) {
       std::vector<std::string> workersToRemove;
@@ -1482,6 +2095,7 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
     // task ACKs from active workers are never dropped.
     if (fIpcSession->isTcp && frames.size() >= 2 && frames[1] == "READY") {
       const std::string & lateId = frames[0];
+      NoteWorkerReady(frames);
       fIpcSession->seenWorkerIdentities.insert(lateId);
       if (!fIpcSession->identityToWorker.count(lateId) && !pendingInitWorkers.count(lateId)) {
         const std::string prefix    = "wk_";
@@ -1490,11 +2104,7 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
           size_t workerIdx = std::numeric_limits<size_t>::max();
           try { workerIdx = std::stoul(lateId.substr(prefixLen)); } catch (...) {}
           if (workerIdx < fIpcSession->maxWorkers) {
-            const std::string sessionId = std::to_string(getpid());
-            if (NDimensionalIpcRunner::SendFrames(fIpcSession->router,
-                                                  {lateId, "INIT", std::to_string(workerIdx), sessionId,
-                                                   fIpcSession->jobDir, fIpcSession->treeName,
-                                                   fIpcSession->tmpDir, fIpcSession->tmpResultsDir})) {
+            if (NDimensionalIpcRunner::SendFrames(fIpcSession->router, BuildInitFrames(lateId, workerIdx))) {
               pendingInitWorkers[lateId] = workerIdx;
               NLogDebug("NDimensionalExecutor: late worker '%s' sent INIT, awaiting ACK", lateId.c_str());
             }
@@ -1530,7 +2140,7 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
                  id.c_str(), idx, fIpcSession->workerIdentityVec.size());
         // Log in-flight task distribution across all workers so the startup imbalance is visible
         for (const auto & wid : fIpcSession->workerIdentityVec) {
-          const size_t inFlight = fIpcSession->taskStateManager.GetWorkerTasks(wid).size();
+          const size_t inFlight = fIpcSession->taskStateManager.WorkerTaskCount(wid);
           NLogInfo("NDimensionalExecutor: in-flight distribution: worker '%s' has %zu pending task(s)", wid.c_str(), inFlight);
         }
         sendCatchup(id);
@@ -1606,6 +2216,11 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
       continue;
     }
 
+    if (HandleResultFrames(frames)) {
+      lastProgress = std::chrono::steady_clock::now();
+      continue;
+    }
+
     if (frames.size() < 3) {
       // A 2-frame ACK that isn't a pending-init reply is unexpected.
       if (frames.size() == 2 && frames[1] == "ACK")
@@ -1623,18 +2238,30 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
         continue;
       }
       size_t taskId = 0;
-      try {
-        taskId = static_cast<size_t>(std::stoull(frames[2]));
-      }
-      catch (...) {
+      if (!NDimensionalIpcRunner::DecodeTaskId(frames[2], WorkerProtocol(workerIdentity), taskId)) {
         firstError = "Malformed IPC task id received from worker.";
         break;
       }
 
-      // Accept ACK only from the worker that currently owns this task.
+      // Accept ACK only from a worker that currently owns this task.
       // Late/stale ACKs (after replay/reassignment) must not terminate execution.
-      const std::string taskOwner = fIpcSession->taskStateManager.GetTaskWorker(taskId);
-      if (taskOwner != workerIdentity) {
+      if (!fIpcSession->taskStateManager.IsTaskOwner(taskId, workerIdentity)) {
+        const std::string taskOwner = fIpcSession->taskStateManager.GetTaskWorker(taskId);
+        if (speculativeLosers.erase(std::make_pair(taskId, workerIdentity)) > 0) {
+          // Losing copy of a speculated task: only release its message slot.
+          if (outstandingMessages > 0) --outstandingMessages;
+          auto inFlightIt = inFlightMessagesPerWorker.find(workerIdentity);
+          if (inFlightIt != inFlightMessagesPerWorker.end()) {
+            if (inFlightIt->second > 0) --inFlightIt->second;
+            if (inFlightIt->second == 0) inFlightMessagesPerWorker.erase(inFlightIt);
+          }
+          if (fIpcSession->isTcp) {
+            fIpcSession->workerLastActivity[workerIdentity] = std::chrono::steady_clock::now();
+          }
+          NLogDebug("NDimensionalExecutor::IPC: discarding late ACK for speculated task %zu from worker '%s'", taskId,
+                    workerIdentity.c_str());
+          continue;
+        }
         if (fIpcSession->taskStateManager.IsDone(taskId)) {
           NLogDebug("NDimensionalExecutor::IPC: ignoring duplicate ACK for already-done task %zu from worker '%s'",
                     taskId, workerIdentity.c_str());
@@ -1647,11 +2274,14 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
       }
 
       // Mark task as done using TaskStateManager
+      const std::vector<std::string> taskOwners = fIpcSession->taskStateManager.GetTaskWorkers(taskId);
       if (!fIpcSession->taskStateManager.MarkDone(taskId)) {
         NLogWarning("NDimensionalExecutor::IPC: ignoring ACK for non-running task %zu from worker '%s'",
                     taskId, workerIdentity.c_str());
         continue;
       }
+      resolveSpeculation(taskId, workerIdentity, taskOwners);
+      recordCheckpointable(workerIdentity, taskId);
       {
         auto workerIt = fIpcSession->identityToWorker.find(workerIdentity);
         if (workerIt != fIpcSession->identityToWorker.end()) {
@@ -1683,6 +2313,7 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
         if (inFlightIt->second > 0) --inFlightIt->second;
         if (inFlightIt->second == 0) inFlightMessagesPerWorker.erase(inFlightIt);
       }
+      recordMessageAck(workerIdentity);
       ++acked;
       lastProgress = std::chrono::steady_clock::now();
       const size_t activeWorkersNow = fIpcSession->workerIdentityVec.size();
@@ -1701,6 +2332,7 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
                   fIpcSession->taskStateManager.DoneCount());
         nextSchedulerLogAck += 200;
       }
+      reportCheckpoint(frames, workerIdentity);
       continue;
     }
 
@@ -1725,24 +2357,24 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
         if (inFlightIt->second > 0) --inFlightIt->second;
         if (inFlightIt->second == 0) inFlightMessagesPerWorker.erase(inFlightIt);
       }
+      recordMessageAck(workerIdentity);
 
-      std::stringstream ackStream(frames[2]);
-      std::string       ackToken;
-      while (std::getline(ackStream, ackToken, ',')) {
-        if (ackToken.empty()) continue;
-        size_t ackTaskId = 0;
-        try {
-          ackTaskId = static_cast<size_t>(std::stoull(ackToken));
-        }
-        catch (...) {
-          firstError = "Malformed IPC ACKB task id received from worker.";
-          break;
-        }
+      std::vector<size_t> ackTaskIds;
+      if (!NDimensionalIpcRunner::DecodeTaskIds(frames[2], WorkerProtocol(workerIdentity), ackTaskIds)) {
+        firstError = "Malformed IPC ACKB task id received from worker.";
+        break;
+      }
+      for (const size_t ackTaskId : ackTaskIds) {
 
-        // Accept ACKB token only from the worker that currently owns this task.
+        // Accept ACKB token only from a worker that currently owns this task.
         // Late/stale ACKB tokens (after replay/reassignment) are ignored.
-        const std::string taskOwner = fIpcSession->taskStateManager.GetTaskWorker(ackTaskId);
-        if (taskOwner != workerIdentity) {
+        if (!fIpcSession->taskStateManager.IsTaskOwner(ackTaskId, workerIdentity)) {
+          const std::string taskOwner = fIpcSession->taskStateManager.GetTaskWorker(ackTaskId);
+          if (speculativeLosers.erase(std::make_pair(ackTaskId, workerIdentity)) > 0) {
+            NLogDebug("NDimensionalExecutor::IPC: discarding late ACKB token for speculated task %zu from worker '%s'",
+                      ackTaskId, workerIdentity.c_str());
+            continue;
+          }
           if (fIpcSession->taskStateManager.IsDone(ackTaskId)) {
             NLogDebug(
                 "NDimensionalExecutor::IPC: ignoring duplicate ACKB token for already-done task %zu from worker '%s'",
@@ -1756,11 +2388,14 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
         }
 
         // Mark task as done using TaskStateManager
+        const std::vector<std::string> taskOwners = fIpcSession->taskStateManager.GetTaskWorkers(ackTaskId);
         if (!fIpcSession->taskStateManager.MarkDone(ackTaskId)) {
           NLogWarning("NDimensionalExecutor::IPC: ignoring ACKB token for non-running task %zu from worker '%s'",
                       ackTaskId, workerIdentity.c_str());
           continue;
         }
+        resolveSpeculation(ackTaskId, workerIdentity, taskOwners);
+        recordCheckpointable(workerIdentity, ackTaskId);
         {
           auto workerIt = fIpcSession->identityToWorker.find(workerIdentity);
           if (workerIt != fIpcSession->identityToWorker.end()) {
@@ -1806,6 +2441,7 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
       if (!firstError.empty()) {
         break;
       }
+      reportCheckpoint(frames, workerIdentity);
       continue;
     }
 
@@ -1842,6 +2478,77 @@ size_t NDimensionalExecutor::ExecuteCurrentBoundsProcessIpc(const std::string &
   return acked;
 }
 
+void NDimensionalExecutor::RequestLiveWorkers(const std::string & cmd, const std::string & reply,
+                                              const std::function<std::vector<std::string>(size_t)> & framesFor,
+                                              int timeoutSec)
+{
+  if (!fIpcSession) {
+    throw std::runtime_error("No active IPC session.");
+  }
+  if (fIpcSession->isTcp) {
+    throw std::runtime_error(cmd + " is supported only for forked IPC workers.");
+  }
+
+  std::set<std::string> pending;
+  for (const auto & kv : fIpcSession->identityToWorker) {
+    std::vector<std::string> frames{kv.first, cmd};
+    if (framesFor) {
+      for (auto & f : framesFor(kv.second)) frames.push_back(std::move(f));
+    }
+    if (!NDimensionalIpcRunner::SendFrames(fIpcSession->router, frames)) {
+      throw std::runtime_error("Failed to send " + cmd + " to worker '" + kv.first + "'.");
+    }
+    pending.insert(kv.first);
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSec);
+  while (!pending.empty()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      throw std::runtime_error("Timeout waiting for " + reply + " from " + std::to_string(pending.size()) +
+                               " worker(s).");
+    }
+    for (const auto & identity : pending) {
+      const size_t idx = fIpcSession->identityToWorker.at(identity);
+      int          status = 0;
+      if (idx < fIpcSession->childPids.size() && fIpcSession->childPids[idx] > 0 &&
+          waitpid(fIpcSession->childPids[idx], &status, WNOHANG) == fIpcSession->childPids[idx]) {
+        throw std::runtime_error("Worker '" + identity + "' exited while waiting for " + reply + ".");
+      }
+    }
+
+    std::vector<std::string> frames;
+    if (!NDimensionalIpcRunner::ReceiveFrames(fIpcSession->router, frames)) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+      throw std::runtime_error("Failed to receive " + reply + " from workers.");
+    }
+    if (frames.size() < 2) continue;
+    if (frames[1] == reply) {
+      pending.erase(frames[0]);
+      NLogDebug("NDimensionalExecutor::%s: Worker '%s' replied %s (%zu pending)", cmd.c_str(), frames[0].c_str(),
+                reply.c_str(), pending.size());
+    }
+    else if (frames[1] == "ERR") {
+      throw std::runtime_error("Worker '" + frames[0] + "' failed " + cmd + ": " +
+                               (frames.size() >= 4 ? frames[3] : std::string("unknown error")));
+    }
+    else {
+      NLogDebug("NDimensionalExecutor::%s: Ignoring '%s' from worker '%s'", cmd.c_str(), frames[1].c_str(),
+                frames[0].c_str());
+    }
+  }
+}
+
+void NDimensionalExecutor::FlushProcessIpc(int timeoutSec)
+{
+  RequestLiveWorkers("FLUSH", "FLUSHED", nullptr, timeoutSec);
+}
+
+void NDimensionalExecutor::ReconfigureProcessIpc(const std::function<std::vector<std::string>(size_t)> & framesFor,
+                                                 int timeoutSec)
+{
+  RequestLiveWorkers("RECONFIGURE", "RECONFIGURED", framesFor, timeoutSec);
+}
+
 void NDimensionalExecutor::FinishProcessIpc(bool abort)
 {
   if (!fIpcSession) {
@@ -1881,10 +2588,13 @@ void NDimensionalExecutor::FinishProcessIpc(bool abort)
     const size_t      nWorkers    = fIpcSession->identityToWorker.size();
     std::set<std::string> doneWorkers;
     std::set<std::string> shutdownWorkers;
+    auto markDone = [&](const std::string & workerIdentity) {
+      auto it = fIpcSession->identityToWorker.find(workerIdentity);
+      if (it == fIpcSession->identityToWorker.end() || !doneWorkers.insert(workerIdentity).second) return;
+      if (fWorkerDoneCallback) fWorkerDoneCallback(it->second);
+    };
     for (const auto & workerIdentity : fIpcSession->earlyDoneWorkers) {
-      if (fIpcSession->identityToWorker.count(workerIdentity)) {
-        doneWorkers.insert(workerIdentity);
-      }
+      markDone(workerIdentity);
     }
     const auto        doneDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(doneTimeoutSec);
     auto lastStopRetry = std::chrono::steady_clock::now();
@@ -1956,12 +2666,14 @@ void NDimensionalExecutor::FinishProcessIpc(bool abort)
       }
       std::vector<std::string> frames;
       if (!NDimensionalIpcRunner::ReceiveFrames(fIpcSession->router, frames) || frames.size() < 2) continue;
+      if (HandleResultFrames(frames)) {
+        // Workers stream their output lists after STOP, before DONE.
+        continue;
+      }
       if (frames[1] == "DONE") {
         const std::string & workerIdentity = frames[0];
-        if (fIpcSession->identityToWorker.count(workerIdentity)) {
-          doneWorkers.insert(workerIdentity);
-        }
-        
+        markDone(workerIdentity);
+
         NLogDebug("NDimensionalExecutor::FinishProcessIpc: Worker '%s' sent DONE (%zu/%zu)", workerIdentity.c_str(),
                   doneWorkers.size(), nWorkers);
       } else if (frames[1] == "SHUTDOWN") {
@@ -2041,5 +2753,8 @@ void NDimensionalExecutor::FinishProcessIpc(bool abort)
 template void NDimensionalExecutor::ExecuteParallel<NGnThreadData>(
     const std::function<void(const std::vector<int> & coords, NGnThreadData & thread_object)> & func,
     std::vector<NGnThreadData> &                                                                  thread_objects);
+template void NDimensionalExecutor::ExecuteParallel<NThreadData>(
+    const std::function<void(const std::vector<int> & coords, NThreadData & thread_object)> & func,
+    std::vector<NThreadData> &                                                                thread_objects);
 
 } // namespace Ndmspc
@@ -26,6 +26,8 @@
 
 namespace Ndmspc {
 
+class NTaskCostModel;
+
 /// @brief Execution progress metrics for IPC-based distributed processing
 struct ExecutionProgress {
   size_t tasksAcked{0};     ///< Tasks completed and ACKed by workers
@@ -35,6 +37,12 @@ struct ExecutionProgress {
   size_t activeWorkers{0};  ///< Number of workers currently active
 };
 
+/// @brief Scheduling strategy used by NDimensionalExecutor::ExecuteParallel
+enum class ParallelScheduler {
+  kQueue,       ///< Single shared queue, one task per coordinate (default)
+  kWorkStealing ///< Per-thread deques of linear-index chunks with stealing
+};
+
 ///
 /// \class NDimensionalExecutor
 /// \brief Executes a function over all points in an N-dimensional space, optionally in parallel.
@@ -81,6 +89,163 @@ class NDimensionalExecutor {
   void ExecuteParallel(const std::function<void(const std::vector<int> & coords, TObject & thread_object)> & func,
                        std::vector<TObject> & thread_objects);
 
+  /**
+   * @brief Select the scheduler used by ExecuteParallel.
+   * @param scheduler Scheduling strategy.
+   * @param chunkSize Number of consecutive points per work-stealing chunk (0 = automatic).
+   */
+  void SetParallelScheduler(ParallelScheduler scheduler, size_t chunkSize = 0)
+  {
+    fScheduler = scheduler;
+    fChunkSize = chunkSize;
+  }
+
+  /**
+   * @brief Returns the scheduler used by ExecuteParallel.
+   * @return Scheduling strategy.
+   */
+  ParallelScheduler GetParallelScheduler() const { return fScheduler; }
+
+  /**
+   * @brief Parse a scheduler name ("queue", "steal"/"worksteal"/"work-stealing").
+   * @param name Scheduler name (case-insensitive).
+   * @param scheduler Output scheduler, untouched when name is not recognized.
+   * @return True if the name was recognized.
+   */
+  static bool ParseParallelScheduler(const std::string & name, ParallelScheduler & scheduler);
+
+  /**
+   * @brief Returns the total number of points in the N-dimensional space.
+   * @return Product of all dimension extents.
+   */
+  size_t GetTotalPoints() const;
+
+  /**
+   * @brief Convert a linear index into coordinates (last dimension varies fastest, same order as Execute).
+   * @param index Linear index in [0, GetTotalPoints()).
+   * @param coords Output coordinates, resized to Dimensions().
+   */
+  void DecodeLinearIndex(size_t index, std::vector<int> & coords) const;
+
+  /**
+   * @brief Set per-task cost estimates for the next ExecuteCurrentBoundsProcessIpc call.
+   *
+   * Costs are indexed by linear task index. When the size matches the number of
+   * tasks, new tasks are dispatched longest-first (LPT). Negative or non-finite
+   * entries mark unknown costs. The estimates are consumed by the execution.
+   * @param costs Estimated cost of each task (e.g. wall time in seconds).
+   */
+  void SetTaskCosts(const std::vector<double> & costs) { fTaskCosts = costs; }
+
+  /**
+   * @brief Returns the per-task cost estimates set for the next IPC execution.
+   * @return Cost estimates indexed by linear task index.
+   */
+  const std::vector<double> & GetTaskCosts() const { return fTaskCosts; }
+
+  /**
+   * @brief Set per-task coordinates for the next ExecuteCurrentBoundsProcessIpc call.
+   *
+   * With NDMSPC_IPC_COST_AWARE the costs observed from ACKs are learned per coordinate
+   * (see NTaskCostModel). Callers running over a list of bins pass the bin coordinates here,
+   * otherwise the linear task coordinates are used. Consumed by the execution.
+   * @param coords Coordinates of each task, indexed by linear task index.
+   */
+  void SetTaskCoords(std::vector<std::vector<int>> coords) { fTaskCoords = std::move(coords); }
+
+  /**
+   * @brief Check if cost-aware IPC dispatch is enabled (NDMSPC_IPC_COST_AWARE).
+   * @return True when enabled.
+   */
+  static bool IsCostAware();
+
+  /**
+   * @brief Callback receiving results streamed by a TCP worker.
+   *
+   * Arguments are the worker index, the frame kind ("RESULT" for a chunk of
+   * entries, "RESULTO" for the final output lists) and the payload. Returns
+   * false if the payload could not be stored.
+   */
+  using ResultHandler = std::function<bool(size_t, const std::string &, const std::string &)>;
+
+  /**
+   * @brief Enable result streaming for TCP workers started by StartProcessIpc.
+   *
+   * Workers send their entries in chunks over the ROUTER/DEALER channel instead
+   * of copying result files; each chunk is passed to `handler` and acknowledged
+   * with RACK. Must be called before StartProcessIpc.
+   * @param chunkEntries Maximum entries per chunk (0 disables streaming).
+   * @param window Maximum chunks a worker may have unacknowledged (backpressure).
+   * @param handler Callback storing the received payloads.
+   */
+  void SetResultStreaming(size_t chunkEntries, size_t window, ResultHandler handler)
+  {
+    fResultStreamChunk  = chunkEntries;
+    fResultStreamWindow = window;
+    fResultHandler      = std::move(handler);
+  }
+
+  /**
+   * @brief Callback receiving a worker index and the definition ids (task ids when no
+   * definition ids are set) that its output file holds durably after a checkpoint.
+   */
+  using CheckpointHandler = std::function<void(size_t, const std::vector<Long64_t> &)>;
+
+  /**
+   * @brief Set a callback invoked when an IPC worker reports a checkpoint of its output.
+   *
+   * Workers checkpoint only when NGnThreadData::SetCheckpointInterval() is set. A checkpoint
+   * marker on a stale ACK is skipped; its ids are then reported with the next one.
+   * @param handler Function receiving the worker index and the newly checkpointed ids.
+   */
+  void SetCheckpointHandler(CheckpointHandler handler) { fCheckpointHandler = std::move(handler); }
+
+  /**
+   * @brief Set a callback invoked when a TCP worker reports DONE in FinishProcessIpc.
+   *
+   * Lets the caller start merging a worker's output while other workers are
+   * still finishing. The callback runs on the supervisor thread.
+   * @param callback Function receiving the worker index.
+   */
+  void SetWorkerDoneCallback(std::function<void(size_t)> callback) { fWorkerDoneCallback = std::move(callback); }
+
+  /**
+   * @brief Get the mean of the known task costs.
+   * @param costs Cost per task; negative/non-finite costs are unknown.
+   * @param nKnown Optional output: number of known costs.
+   * @return Mean known cost, 0 when no cost is known.
+   */
+  static double GetMeanKnownCost(const std::vector<double> & costs, size_t * nKnown = nullptr);
+
+  /**
+   * @brief Build a longest-processing-time-first dispatch order.
+   * @param costs Cost per task; unknown (negative/non-finite) costs are treated as `fallback`.
+   * @param fallback Cost of unknown tasks; negative uses GetMeanKnownCost().
+   * @return Task indices sorted by descending cost (ties keep ascending index order).
+   */
+  static std::vector<size_t> BuildLptOrder(const std::vector<double> & costs, double fallback = -1.0);
+
+  /**
+   * @brief Re-sort the tasks not dispatched yet longest-first.
+   * @param order Dispatch order; entries from `from` on are re-sorted.
+   * @param from Position of the first task not dispatched yet.
+   * @param costs Known cost per task; unknown (negative/non-finite) costs are estimated by `model`.
+   * @param coords Coordinates of each task used by `model`.
+   * @param model Costs observed in the current run.
+   */
+  static void ReorderByEstimatedCost(std::vector<size_t> & order, size_t from, const std::vector<double> & costs,
+                                     const std::vector<std::vector<int>> & coords, const NTaskCostModel & model);
+
+  /**
+   * @brief Scale a batch size by the relative throughput of a worker.
+   * @param baseBatch Batch size for a worker of average speed.
+   * @param workerRate Measured throughput of the worker (work units per second).
+   * @param meanRate Mean throughput over all measured workers.
+   * @param maxBatch Upper limit for the returned batch size.
+   * @return Batch size in [1, maxBatch]; baseBatch when no measurement is available.
+   */
+  static size_t ScaleBatchByThroughput(size_t baseBatch, double workerRate, double meanRate, size_t maxBatch);
+
   /**
    * @brief Execute fixed-contract processing in multiple child processes over IPC.
    * @param workerObjects Worker objects (NThreadData-derived) used by child processes.
@@ -121,6 +286,33 @@ class NDimensionalExecutor {
    */
   void   FinishProcessIpc(bool abort = false);
 
+  /**
+   * @brief Check whether an IPC session is active.
+   * @return True between StartProcessIpc() and FinishProcessIpc().
+   */
+  bool IsProcessIpcActive() const { return fIpcSession != nullptr; }
+
+  /**
+   * @brief Finish the current job on forked IPC workers but keep them running.
+   *
+   * Every live worker runs its end function, writes and closes its output file
+   * and replies FLUSHED. The session stays open so the workers can be reused via
+   * ReconfigureProcessIpc(). IPC/fork mode only; throws on timeout or worker failure.
+   * @param timeoutSec Maximum time to wait for all workers.
+   */
+  void FlushProcessIpc(int timeoutSec = 60);
+
+  /**
+   * @brief Reconfigure live forked IPC workers for a new job.
+   *
+   * Sends RECONFIGURE followed by `framesFor(workerIndex)` to every live worker and
+   * waits until each one replied RECONFIGURED. Throws on timeout or worker failure.
+   * @param framesFor Builds the payload frames for a worker index.
+   * @param timeoutSec Maximum time to wait for all workers.
+   */
+  void ReconfigureProcessIpc(const std::function<std::vector<std::string>(size_t)> & framesFor,
+                             int timeoutSec = 60);
+
   /**
    * @brief Get indices of workers that have registered (TCP mode).
    * @return Set of registered worker indices.
@@ -139,6 +331,18 @@ class NDimensionalExecutor {
    */
   const std::unordered_map<size_t, size_t> & GetLastWorkerTaskCounts() const { return fLastWorkerTaskCounts; }
 
+  /**
+   * @brief Get tasks whose output on a worker is a duplicate from speculative re-execution.
+   *
+   * When a speculated task is acknowledged by one owner, the other owners' results
+   * for it must be dropped during merge.
+   * @return Mapping worker index -> task ids (linear indices) executed by a losing owner in the last run.
+   */
+  const std::unordered_map<size_t, std::set<size_t>> & GetLastSpeculativeDuplicates() const
+  {
+    return fLastSpeculativeDuplicates;
+  }
+
   /**
    * @brief Returns the number of dimensions.
    * @return Number of dimensions.
@@ -162,6 +366,15 @@ class NDimensionalExecutor {
   std::vector<int> fMinBounds;     ///< Minimum bounds for each dimension
   std::vector<int> fMaxBounds;     ///< Maximum bounds for each dimension
   std::vector<int> fCurrentCoords; ///< Current coordinates during iteration
+  ParallelScheduler fScheduler{ParallelScheduler::kQueue}; ///< Scheduler used by ExecuteParallel
+  size_t            fChunkSize{0};                         ///< Work-stealing chunk size (0 = automatic)
+  std::vector<double> fTaskCosts;                          ///< Per-task cost estimates for the next IPC execution
+  std::vector<std::vector<int>> fTaskCoords;               ///< Per-task coordinates for the next IPC execution
+  size_t              fResultStreamChunk{0};               ///< Entries per streamed result chunk (0 = disabled)
+  size_t              fResultStreamWindow{1};              ///< Unacknowledged result chunks allowed per worker
+  ResultHandler       fResultHandler;                      ///< Receiver of streamed worker results
+  std::function<void(size_t)> fWorkerDoneCallback;        ///< Called for each worker reporting DONE (TCP)
+  CheckpointHandler   fCheckpointHandler;                  ///< Receiver of checkpointed ids (IPC)
 
   /**
    * @brief Increment the current coordinates to the next point in the N-dimensional space.
@@ -169,6 +382,24 @@ class NDimensionalExecutor {
    */
   bool Increment();
 
+  /**
+   * @brief Increment the given coordinates to the next point in the N-dimensional space.
+   * @param coords Coordinates to increment in place.
+   * @return True if increment was successful, false if end reached.
+   */
+  bool Increment(std::vector<int> & coords) const;
+
+  /// Shared-queue implementation of ExecuteParallel (one boxed task per coordinate).
+  template <typename TObject>
+  void ExecuteParallelQueue(const std::function<void(const std::vector<int> & coords, TObject & thread_object)> & func,
+                            std::vector<TObject> & thread_objects);
+
+  /// Work-stealing implementation of ExecuteParallel (per-thread deques of index ranges).
+  template <typename TObject>
+  void ExecuteParallelWorkStealing(
+      const std::function<void(const std::vector<int> & coords, TObject & thread_object)> & func,
+      std::vector<TObject> &                                                                thread_objects);
+
   /// Sends INIT to a newly-connected TCP worker, waits for ACK, and registers
   /// it in identityToWorker / workerIdentityVec.
   bool InitTcpWorker(const std::string & identity);
@@ -178,6 +409,24 @@ class NDimensionalExecutor {
   /// and env vars.
   bool HandleBootstrap(const std::string & identity);
 
+  /// Builds the INIT message for a TCP worker (identity, "INIT", index, session, dirs, streaming settings,
+  /// task framing version).
+  std::vector<std::string> BuildInitFrames(const std::string & identity, size_t workerIdx) const;
+
+  /// Records the task framing version a worker announced in its READY message (absent: text framing).
+  void NoteWorkerReady(const std::vector<std::string> & frames);
+
+  /// Returns the task framing version negotiated with a worker.
+  int WorkerProtocol(const std::string & identity) const;
+
+  /// Sends `cmd` to all live forked workers and waits until each one replied with `reply`.
+  void RequestLiveWorkers(const std::string & cmd, const std::string & reply,
+                          const std::function<std::vector<std::string>(size_t)> & framesFor, int timeoutSec);
+
+  /// Passes a RESULT/RESULTO message to the result handler and acknowledges it with RACK.
+  /// Returns false if the frames are not a result message.
+  bool HandleResultFrames(const std::vector<std::string> & frames);
+
   /// Centralized worker failure handling: recovers tasks, removes worker, updates state.
   /// Returns the count of tasks redistributed to the pending queue.
   size_t HandleWorkerFailure(const std::string & failedIdentity,
@@ -191,6 +440,7 @@ class NDimensionalExecutor {
   std::set<size_t>            fRegisteredWorkerIndices; ///< Worker indices that completed registration (TCP mode)
   std::set<size_t>            fLastDoneWorkerIndices;   ///< Worker indices that reported DONE in the last IPC run
   std::unordered_map<size_t, size_t> fLastWorkerTaskCounts; ///< Last ExecuteCurrentBoundsProcessIpc completed-task count by worker index
+  std::unordered_map<size_t, std::set<size_t>> fLastSpeculativeDuplicates; ///< Worker index -> task ids whose output lost a speculation race
 };
 
 
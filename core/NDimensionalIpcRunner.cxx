@@ -1,9 +1,12 @@
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
+#include <cstdint>
 #include <cstring>
 #include <deque>
 #include <iomanip>
 #include <sstream>
+#include <stdexcept>
 #include <signal.h>
 #include <sys/wait.h>
 #include <thread>
@@ -26,39 +29,39 @@ void WorkerSignalHandler(int)
   gWorkerInterrupted = 1;
 }
 
-std::string SerializeTaskIds(const std::vector<std::string> & taskIds)
+// Fixed-width little-endian helpers for the v2 task framing.
+void AppendLE(std::string & out, uint64_t value, size_t nBytes)
 {
-  std::ostringstream oss;
-  for (size_t i = 0; i < taskIds.size(); ++i) {
-    if (i != 0) oss << ',';
-    oss << taskIds[i];
+  for (size_t i = 0; i < nBytes; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
   }
-  return oss.str();
 }
 
-bool ParseTaskBatchPayload(const std::string & payload, std::vector<std::pair<std::string, std::vector<int>>> & tasks)
+bool ReadLE(const std::string & in, size_t & pos, size_t nBytes, uint64_t & value)
 {
-  tasks.clear();
-  std::stringstream batchStream(payload);
-  std::string       taskToken;
-  while (std::getline(batchStream, taskToken, ';')) {
-    if (taskToken.empty()) continue;
-    size_t sep = taskToken.find(':');
-    if (sep == std::string::npos || sep == 0 || sep + 1 >= taskToken.size()) {
-      return false;
-    }
-    const std::string taskId   = taskToken.substr(0, sep);
-    const std::string coords   = taskToken.substr(sep + 1);
-    std::vector<int>  parsedCoords;
-    std::stringstream coordStream(coords);
-    std::string       coordToken;
-    while (std::getline(coordStream, coordToken, ',')) {
-      if (coordToken.empty()) continue;
-      parsedCoords.push_back(std::stoi(coordToken));
-    }
-    tasks.emplace_back(taskId, std::move(parsedCoords));
+  if (pos + nBytes > in.size()) return false;
+  value = 0;
+  for (size_t i = 0; i < nBytes; ++i) {
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(in[pos + i])) << (8 * i);
   }
-  return !tasks.empty();
+  pos += nBytes;
+  return true;
+}
+
+void AppendCoordsLE(std::string & out, const std::vector<int> & coords)
+{
+  for (int c : coords) AppendLE(out, static_cast<uint32_t>(c), 4);
+}
+
+bool ReadCoordsLE(const std::string & in, size_t & pos, size_t nDims, std::vector<int> & coords)
+{
+  coords.resize(nDims);
+  for (size_t d = 0; d < nDims; ++d) {
+    uint64_t raw = 0;
+    if (!ReadLE(in, pos, 4, raw)) return false;
+    coords[d] = static_cast<int>(static_cast<int32_t>(static_cast<uint32_t>(raw)));
+  }
+  return true;
 }
 } // namespace
 
@@ -119,6 +122,210 @@ std::string NDimensionalIpcRunner::SerializeIds(const std::vector<Long64_t> & id
   return oss.str();
 }
 
+int NDimensionalIpcRunner::GetProtocolVersion()
+{
+  int version = kProtocolVersion;
+  if (const char * env = gSystem->Getenv("NDMSPC_IPC_PROTOCOL")) {
+    try {
+      const int requested = std::stoi(env);
+      if (requested < 1) throw std::invalid_argument("version must be >= 1");
+      version = std::min(requested, kProtocolVersion);
+    }
+    catch (...) {
+      NLogWarning("NDimensionalIpcRunner: Invalid NDMSPC_IPC_PROTOCOL='%s', using default=%d", env, kProtocolVersion);
+    }
+  }
+  return version;
+}
+
+int NDimensionalIpcRunner::ParseProtocolVersion(const std::vector<std::string> & frames, size_t index)
+{
+  if (index >= frames.size() || frames[index].empty()) return 1;
+  try {
+    return std::max(1, std::min(std::stoi(frames[index]), kProtocolVersion));
+  }
+  catch (...) {
+    return 1;
+  }
+}
+
+std::string NDimensionalIpcRunner::EncodeTaskId(size_t taskId, int protocol)
+{
+  if (protocol < 2) return std::to_string(taskId);
+  std::string out;
+  AppendLE(out, taskId, 8);
+  return out;
+}
+
+bool NDimensionalIpcRunner::DecodeTaskId(const std::string & data, int protocol, size_t & taskId)
+{
+  if (protocol < 2) {
+    try {
+      taskId = static_cast<size_t>(std::stoull(data));
+      return true;
+    }
+    catch (...) {
+      return false;
+    }
+  }
+  size_t   pos   = 0;
+  uint64_t value = 0;
+  if (data.size() != 8 || !ReadLE(data, pos, 8, value)) return false;
+  taskId = static_cast<size_t>(value);
+  return true;
+}
+
+std::string NDimensionalIpcRunner::EncodeCoords(const std::vector<int> & coords, int protocol)
+{
+  if (protocol < 2) return SerializeCoords(coords);
+  std::string out;
+  out.reserve(coords.size() * 4);
+  AppendCoordsLE(out, coords);
+  return out;
+}
+
+bool NDimensionalIpcRunner::DecodeCoords(const std::string & data, int protocol, std::vector<int> & coords)
+{
+  if (protocol < 2) {
+    try {
+      coords = ParseCoords(data);
+      return true;
+    }
+    catch (...) {
+      return false;
+    }
+  }
+  if (data.size() % 4 != 0) return false;
+  size_t pos = 0;
+  return ReadCoordsLE(data, pos, data.size() / 4, coords);
+}
+
+std::string NDimensionalIpcRunner::EncodeTaskBatch(const std::vector<std::pair<size_t, std::vector<int>>> & tasks,
+                                                   int protocol)
+{
+  if (protocol < 2) {
+    std::ostringstream payload;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      if (i != 0) payload << ';';
+      payload << tasks[i].first << ':' << SerializeCoords(tasks[i].second);
+    }
+    return payload.str();
+  }
+
+  // Layout: u32 nDims, then runs of (u64 firstId, u32 count, nDims x i32 first coords).
+  // Task k of a run has id firstId+k and the first coordinates with the last one advanced by k.
+  std::string  out;
+  const size_t nDims = tasks.empty() ? 0 : tasks.front().second.size();
+  AppendLE(out, nDims, 4);
+  size_t i = 0;
+  while (i < tasks.size()) {
+    size_t j = i + 1;
+    while (j < tasks.size() && tasks[j].first == tasks[j - 1].first + 1 && tasks[j].second.size() == nDims &&
+           nDims > 0 &&
+           std::equal(tasks[j].second.begin(), tasks[j].second.end() - 1, tasks[i].second.begin()) &&
+           tasks[j].second.back() == tasks[j - 1].second.back() + 1 && j - i < UINT32_MAX) {
+      ++j;
+    }
+    AppendLE(out, tasks[i].first, 8);
+    AppendLE(out, j - i, 4);
+    AppendCoordsLE(out, tasks[i].second);
+    i = j;
+  }
+  return out;
+}
+
+bool NDimensionalIpcRunner::DecodeTaskBatch(const std::string & payload, int protocol,
+                                            std::vector<std::pair<size_t, std::vector<int>>> & tasks)
+{
+  tasks.clear();
+  if (protocol < 2) {
+    std::stringstream batchStream(payload);
+    std::string       taskToken;
+    while (std::getline(batchStream, taskToken, ';')) {
+      if (taskToken.empty()) continue;
+      size_t sep = taskToken.find(':');
+      if (sep == std::string::npos || sep == 0 || sep + 1 >= taskToken.size()) {
+        return false;
+      }
+      size_t           taskId = 0;
+      std::vector<int> coords;
+      if (!DecodeTaskId(taskToken.substr(0, sep), 1, taskId) || !DecodeCoords(taskToken.substr(sep + 1), 1, coords)) {
+        return false;
+      }
+      tasks.emplace_back(taskId, std::move(coords));
+    }
+    return !tasks.empty();
+  }
+
+  size_t   pos   = 0;
+  uint64_t nDims = 0;
+  if (!ReadLE(payload, pos, 4, nDims)) return false;
+  while (pos < payload.size()) {
+    uint64_t         firstId = 0;
+    uint64_t         count   = 0;
+    std::vector<int> coords;
+    if (!ReadLE(payload, pos, 8, firstId) || !ReadLE(payload, pos, 4, count) || count == 0 ||
+        !ReadCoordsLE(payload, pos, static_cast<size_t>(nDims), coords)) {
+      return false;
+    }
+    if (count > 1 && nDims == 0) return false;
+    for (uint64_t k = 0; k < count; ++k) {
+      tasks.emplace_back(static_cast<size_t>(firstId + k), coords);
+      if (nDims > 0) ++coords.back();
+    }
+  }
+  return !tasks.empty();
+}
+
+std::string NDimensionalIpcRunner::EncodeTaskIds(const std::vector<size_t> & taskIds, int protocol)
+{
+  if (protocol < 2) {
+    std::ostringstream oss;
+    for (size_t i = 0; i < taskIds.size(); ++i) {
+      if (i != 0) oss << ',';
+      oss << taskIds[i];
+    }
+    return oss.str();
+  }
+
+  // Layout: runs of (u64 firstId, u32 count) covering consecutive ids.
+  std::string out;
+  size_t      i = 0;
+  while (i < taskIds.size()) {
+    size_t j = i + 1;
+    while (j < taskIds.size() && taskIds[j] == taskIds[j - 1] + 1 && j - i < UINT32_MAX) ++j;
+    AppendLE(out, taskIds[i], 8);
+    AppendLE(out, j - i, 4);
+    i = j;
+  }
+  return out;
+}
+
+bool NDimensionalIpcRunner::DecodeTaskIds(const std::string & payload, int protocol, std::vector<size_t> & taskIds)
+{
+  taskIds.clear();
+  if (protocol < 2) {
+    std::stringstream ackStream(payload);
+    std::string       ackToken;
+    while (std::getline(ackStream, ackToken, ',')) {
+      if (ackToken.empty()) continue;
+      size_t taskId = 0;
+      if (!DecodeTaskId(ackToken, 1, taskId)) return false;
+      taskIds.push_back(taskId);
+    }
+    return true;
+  }
+
+  size_t pos = 0;
+  while (pos < payload.size()) {
+    uint64_t firstId = 0;
+    uint64_t count   = 0;
+    if (!ReadLE(payload, pos, 8, firstId) || !ReadLE(payload, pos, 4, count) || count == 0) return false;
+    for (uint64_t k = 0; k < count; ++k) taskIds.push_back(static_cast<size_t>(firstId + k));
+  }
+  return true;
+}
+
 int NDimensionalIpcRunner::WorkerLoop(const std::string & endpoint, size_t workerIndex, NThreadData * worker)
 {
   std::ostringstream threadName;
@@ -152,7 +359,10 @@ int NDimensionalIpcRunner::WorkerLoop(const std::string & endpoint, size_t worke
     return 1;
   }
 
-  if (!SendFrames(dealer, {"READY"})) {
+  // Forked workers run the same build as the supervisor; READY announces the framing
+  // version so the supervisor encodes tasks for this worker accordingly.
+  const int protocol = GetProtocolVersion();
+  if (!SendFrames(dealer, {"READY", std::to_string(protocol)})) {
     zmq_close(dealer);
     zmq_ctx_term(ctx);
     return 1;
@@ -160,14 +370,14 @@ int NDimensionalIpcRunner::WorkerLoop(const std::string & endpoint, size_t worke
 
   NLogPrint("Worker %zu: connected to %s, ready for tasks", workerIndex, endpoint.c_str());
 
-  int rc = TaskLoop(dealer, workerIndex, worker);
+  int rc = TaskLoop(dealer, workerIndex, worker, protocol);
 
   zmq_close(dealer);
   zmq_ctx_term(ctx);
   return rc;
 }
 
-int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadData * worker)
+int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadData * worker, int protocol)
 {
   // Install signal handlers for Ctrl+C/SIGTERM.
   gWorkerInterrupted = 0;
@@ -187,6 +397,7 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
   bool   stopRequested = false;
   bool   stopRequestedAbort = false;
   bool   shutdownSent = false;
+  bool   jobFlushed   = false;
   size_t tasksProcessed = 0;
   size_t lastReportedProgress = 0;
   const bool showWorkerProgress = []() {
@@ -213,6 +424,33 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
   // by the normal command loop (e.g. queued TASK/TASKB while finishing a batch).
   std::deque<std::vector<std::string>> deferredFrames;
 
+  // Result streaming (TCP): entries written by the worker are sent to the supervisor
+  // in RESULT chunks; at most `streamWindow` chunks may wait for a RACK at a time.
+  auto *       gnStreamWorker = dynamic_cast<NGnThreadData *>(worker);
+  const bool   streamResults  = gnStreamWorker && gnStreamWorker->IsResultStreaming();
+  const size_t streamWindow   = streamResults ? gnStreamWorker->GetResultStreamWindow() : 0;
+  size_t       streamSeq      = 0;
+  size_t       streamUnacked  = 0;
+  bool         streamFailed   = false;
+
+  // Checkpointing (IPC): the worker output is made durable at most every `checkpointInterval`
+  // seconds; the ACK sent right after carries a trailing "C" frame so the supervisor can
+  // record all tasks acknowledged so far as recoverable.
+  const double checkpointInterval =
+      (gnStreamWorker && !streamResults) ? gnStreamWorker->GetCheckpointInterval() : 0.0;
+  auto lastCheckpoint  = std::chrono::steady_clock::now();
+  auto checkpointIfDue = [&]() -> bool {
+    if (checkpointInterval <= 0) return false;
+    const auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - lastCheckpoint).count() < checkpointInterval) return false;
+    lastCheckpoint = now;
+    if (!gnStreamWorker->Checkpoint()) {
+      NLogWarning("Worker %zu: checkpoint of the output failed", workerIndex);
+      return false;
+    }
+    return true;
+  };
+
   auto notifyShutdown = [&](const std::string & reason) {
     if (shutdownSent) return;
     SendFrames(dealer, {"SHUTDOWN", reason, std::to_string(tasksProcessed)});
@@ -259,6 +497,54 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
     return false;
   };
 
+  // Block until at most `maxUnacked` streamed chunks are unacknowledged. Frames other
+  // than RACK are queued for the command loop; an abort STOP ends the wait.
+  auto waitStreamCredit = [&](size_t maxUnacked, int timeoutSec) -> bool {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSec);
+    while (streamUnacked > maxUnacked) {
+      if (gWorkerInterrupted) return false;
+      if (timeoutSec > 0 && std::chrono::steady_clock::now() > deadline) {
+        NLogError("Worker %zu: timeout waiting for supervisor to acknowledge %zu result chunk(s)", workerIndex,
+                  streamUnacked);
+        return false;
+      }
+      std::vector<std::string> reply;
+      if (!ReceiveFrames(dealer, reply)) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+        return false;
+      }
+      if (reply.empty()) continue;
+      if (reply[0] == "RACK") {
+        if (streamUnacked > 0) --streamUnacked;
+        continue;
+      }
+      if (reply[0] == "STOP" && reply.size() >= 2 && reply[1] == "abort") {
+        aborted = true;
+        notifyShutdown("abort");
+        NLogPrint("Worker %zu: received abort from supervisor, stopping ...", workerIndex);
+        return false;
+      }
+      deferredFrames.emplace_back(std::move(reply));
+    }
+    return true;
+  };
+  auto sendStreamChunks = [&](bool flush) -> bool {
+    if (!streamResults) return true;
+    while (gnStreamWorker->HasStreamChunk(flush)) {
+      if (!waitStreamCredit(streamWindow - 1, 0)) return false;
+      if (!SendFrames(dealer, {"RESULT", std::to_string(streamSeq++), gnStreamWorker->TakeStreamChunk()})) {
+        return false;
+      }
+      ++streamUnacked;
+    }
+    return true;
+  };
+  auto handleStreamFailure = [&]() {
+    streamFailed = true;
+    if (gWorkerInterrupted && !aborted) handleLocalInterrupt();
+    if (!aborted) finishedOk = false;
+  };
+
   while (true) {
     // Check for Ctrl+C
     if (gWorkerInterrupted) {
@@ -324,6 +610,46 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
       finishedOk = false;
       break;
     }
+    if (cmd == "RACK") {
+      if (streamUnacked > 0) --streamUnacked;
+      continue;
+    }
+    if (cmd == "FLUSH") {
+      // Persistent pool: finish the current job but keep the process for the next one.
+      auto * gnWorker = dynamic_cast<NGnThreadData *>(worker);
+      if (!gnWorker || streamResults) {
+        finishedOk = false;
+        break;
+      }
+      if (!jobFlushed) {
+        gnWorker->ExecuteEndFunction();
+        if (gnWorker->GetHnSparseBase()) gnWorker->GetHnSparseBase()->Close(true);
+        jobFlushed = true;
+      }
+      SendFrames(dealer, {"FLUSHED", std::to_string(tasksProcessed)});
+      continue;
+    }
+    if (cmd == "RECONFIGURE") {
+      auto * gnWorker = dynamic_cast<NGnThreadData *>(worker);
+      if (!gnWorker || frames.size() < 3) {
+        SendFrames(dealer, {"ERR", "0", "invalid RECONFIGURE"});
+        finishedOk = false;
+        break;
+      }
+      if (!jobFlushed && gnWorker->GetHnSparseBase()) {
+        // Reconfigured without a FLUSH: the previous job is discarded.
+        gnWorker->GetHnSparseBase()->Close(false);
+      }
+      if (!gnWorker->Reconfigure(frames[1], frames[2])) {
+        SendFrames(dealer, {"ERR", "0", "reconfigure failed"});
+        finishedOk = false;
+        break;
+      }
+      jobFlushed     = false;
+      tasksProcessed = 0;
+      SendFrames(dealer, {"RECONFIGURED"});
+      continue;
+    }
     if (cmd != "TASK" && cmd != "TASKB") {
       finishedOk = false;
       break;
@@ -337,9 +663,13 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
           break;
         }
 
-        const std::string taskId = frames[1];
-        errTaskId = taskId;
-        std::vector<int> coords = ParseCoords(frames[2]);
+        size_t           taskId = 0;
+        std::vector<int> coords;
+        if (!DecodeTaskId(frames[1], protocol, taskId) || !DecodeCoords(frames[2], protocol, coords)) {
+          finishedOk = false;
+          break;
+        }
+        errTaskId = std::to_string(taskId);
         ++tasksProcessed;
         if (showWorkerProgress) {
           NLogPrint("Worker %zu: processing tasks [done: %zu]", workerIndex, tasksProcessed);
@@ -351,7 +681,14 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
           lastReportedProgress = tasksProcessed;
         }
         worker->Process(coords);
-        if (!SendFrames(dealer, {"ACK", taskId})) {
+        // Results of a task must reach the supervisor before its ACK.
+        if (!sendStreamChunks(true)) {
+          handleStreamFailure();
+          break;
+        }
+        std::vector<std::string> ackFrames{"ACK", EncodeTaskId(taskId, protocol)};
+        if (checkpointIfDue()) ackFrames.push_back("C");
+        if (!SendFrames(dealer, ackFrames)) {
           finishedOk = false;
           break;
         }
@@ -362,13 +699,13 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
           break;
         }
 
-        std::vector<std::pair<std::string, std::vector<int>>> batchTasks;
-        if (!ParseTaskBatchPayload(frames[1], batchTasks)) {
+        std::vector<std::pair<size_t, std::vector<int>>> batchTasks;
+        if (!DecodeTaskBatch(frames[1], protocol, batchTasks)) {
           finishedOk = false;
           break;
         }
 
-        std::vector<std::string> ackedTaskIds;
+        std::vector<size_t> ackedTaskIds;
         ackedTaskIds.reserve(batchTasks.size());
         tasksProcessed += batchTasks.size();
         if (showWorkerProgress) {
@@ -382,13 +719,20 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
         }
         for (const auto & task : batchTasks) {
           if (checkAbort()) { break; }
-          errTaskId = task.first;
+          errTaskId = std::to_string(task.first);
           worker->Process(task.second);
           ackedTaskIds.push_back(task.first);
+          if (!sendStreamChunks(false)) break;
         }
 
+        if (!sendStreamChunks(true)) {
+          handleStreamFailure();
+          break;
+        }
         if (!ackedTaskIds.empty()) {
-          if (!SendFrames(dealer, {"ACKB", SerializeTaskIds(ackedTaskIds)})) {
+          std::vector<std::string> ackFrames{"ACKB", EncodeTaskIds(ackedTaskIds, protocol)};
+          if (checkpointIfDue()) ackFrames.push_back("C");
+          if (!SendFrames(dealer, ackFrames)) {
             finishedOk = false;
             break;
           }
@@ -415,7 +759,8 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
     }
   }
 
-  if (auto * gnWorker = dynamic_cast<NGnThreadData *>(worker)) {
+  auto * gnWorker = jobFlushed ? nullptr : dynamic_cast<NGnThreadData *>(worker);
+  if (gnWorker) {
     // Capture local tmp file path before closing (storage object path is cleared after Close).
     std::string localTmpFile;
     if (gnWorker->GetHnSparseBase() && gnWorker->GetHnSparseBase()->GetStorageTree()) {
@@ -432,13 +777,37 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
     } else {
       NLogDebug("Worker %zu finished processing, executing end function and closing file if open ...", workerIndex);
       gnWorker->ExecuteEndFunction();
-      if (gnWorker->GetHnSparseBase()) {
+      if (streamResults) {
+        // Entries were already streamed; send the output lists last and wait until the
+        // supervisor has stored everything, since the local file is discarded.
+        int doneTimeoutSec = 60;
+        if (const char * env = gSystem->Getenv("NDMSPC_TCP_DONE_TIMEOUT_SEC")) {
+          try {
+            doneTimeoutSec = std::max(5, std::stoi(env));
+          }
+          catch (...) {
+          }
+        }
+        bool streamed = sendStreamChunks(true);
+        if (streamed) {
+          streamed = SendFrames(dealer, {"RESULTO", std::to_string(streamSeq++), gnWorker->SerializeOutputs()});
+          if (streamed) ++streamUnacked;
+        }
+        if (!streamed || !waitStreamCredit(0, doneTimeoutSec)) {
+          NLogError("Worker %zu: failed to stream results to supervisor", workerIndex);
+          handleStreamFailure();
+        }
+        if (gnWorker->GetHnSparseBase()) {
+          gnWorker->GetHnSparseBase()->Close(false);
+        }
+      }
+      else if (gnWorker->GetHnSparseBase()) {
         gnWorker->GetHnSparseBase()->Close(true);
       }
 
       // TCP mode: copy local result file to shared results dir so supervisor can merge.
       const std::string & resultsFilename = gnWorker->GetResultsFilename();
-      if (!resultsFilename.empty()) {
+      if (!streamResults && !resultsFilename.empty()) {
         if (!localTmpFile.empty() && localTmpFile != resultsFilename) {
           const std::string resultsDir = std::string(gSystem->GetDirName(resultsFilename.c_str()));
           NUtils::CreateDirectory(resultsDir);
@@ -456,13 +825,13 @@ int NDimensionalIpcRunner::TaskLoop(void * dealer, size_t workerIndex, NThreadDa
     // so it must be kept for the supervisor to merge.
     const std::string & resultsFilenameForDelete = gnWorker->GetResultsFilename();
     const bool hasDistinctResultsFile = !resultsFilenameForDelete.empty() && resultsFilenameForDelete != localTmpFile;
-    if (!localTmpFile.empty() && hasDistinctResultsFile) {
+    if (!localTmpFile.empty() && (hasDistinctResultsFile || streamResults)) {
       NLogPrint("Worker %zu: removing local tmp file '%s'", workerIndex, localTmpFile.c_str());
       gSystem->Unlink(localTmpFile.c_str());
     }
   }
 
-  if (!aborted) {
+  if (!aborted && !streamFailed) {
     // Signal master that this worker has finished writing its file.
     // For TCP mode, master waits for this DONE before starting to merge.
     // For IPC (fork) mode, master uses WaitForChildProcesses instead; the DONE
@@ -2,6 +2,7 @@
 #define Ndmspc_NDimensionalIpcRunner_H
 
 #include <string>
+#include <utility>
 #include <vector>
 #include <sys/types.h>
 #include <Rtypes.h>
@@ -55,6 +56,85 @@ class NDimensionalIpcRunner {
    */
   static std::string SerializeIds(const std::vector<Long64_t> & ids);
 
+  /// Highest task framing version understood by this build.
+  /// Version 1 is the comma-separated text framing; version 2 sends fixed-width
+  /// little-endian task ids, packed int32 coordinates and range-encoded batches.
+  static constexpr int kProtocolVersion = 2;
+
+  /**
+   * @brief Task framing version offered by this process.
+   * @return `kProtocolVersion`, capped by `NDMSPC_IPC_PROTOCOL` when set.
+   */
+  static int GetProtocolVersion();
+
+  /**
+   * @brief Read a framing version from an optional frame.
+   * @param frames Received frames.
+   * @param index Index of the version frame.
+   * @return Parsed version clamped to [1, kProtocolVersion], or 1 if the frame is absent or invalid.
+   */
+  static int ParseProtocolVersion(const std::vector<std::string> & frames, size_t index);
+
+  /**
+   * @brief Encode a task id for a TASK or ACK frame.
+   * @param taskId Task id.
+   * @param protocol Negotiated framing version.
+   * @return Decimal text (v1) or 8 little-endian bytes (v2).
+   */
+  static std::string EncodeTaskId(size_t taskId, int protocol);
+
+  /**
+   * @brief Decode a task id encoded by `EncodeTaskId`.
+   * @return False if the payload is malformed.
+   */
+  static bool DecodeTaskId(const std::string & data, int protocol, size_t & taskId);
+
+  /**
+   * @brief Encode the coordinates of a single TASK frame.
+   * @param coords Task coordinates.
+   * @param protocol Negotiated framing version.
+   * @return Comma-separated text (v1) or packed little-endian int32 values (v2).
+   */
+  static std::string EncodeCoords(const std::vector<int> & coords, int protocol);
+
+  /**
+   * @brief Decode coordinates encoded by `EncodeCoords`.
+   * @return False if the payload is malformed.
+   */
+  static bool DecodeCoords(const std::string & data, int protocol, std::vector<int> & coords);
+
+  /**
+   * @brief Encode a TASKB payload.
+   *
+   * In v2, consecutive ids whose last coordinate also advances by one are
+   * sent as a single run (first id, count, first coordinates).
+   * @param tasks Task ids with their coordinates.
+   * @param protocol Negotiated framing version.
+   * @return Encoded payload.
+   */
+  static std::string EncodeTaskBatch(const std::vector<std::pair<size_t, std::vector<int>>> & tasks, int protocol);
+
+  /**
+   * @brief Decode a TASKB payload encoded by `EncodeTaskBatch`.
+   * @return False if the payload is malformed or empty.
+   */
+  static bool DecodeTaskBatch(const std::string & payload, int protocol,
+                              std::vector<std::pair<size_t, std::vector<int>>> & tasks);
+
+  /**
+   * @brief Encode the task ids of an ACKB payload.
+   * @param taskIds Acknowledged task ids.
+   * @param protocol Negotiated framing version.
+   * @return Comma-separated text (v1) or (first id, count) runs (v2).
+   */
+  static std::string EncodeTaskIds(const std::vector<size_t> & taskIds, int protocol);
+
+  /**
+   * @brief Decode an ACKB payload encoded by `EncodeTaskIds`.
+   * @return False if the payload is malformed.
+   */
+  static bool DecodeTaskIds(const std::string & payload, int protocol, std::vector<size_t> & taskIds);
+
   /**
    * @brief Entry point for a worker process or thread.
    * @param endpoint Endpoint string to connect to (ipc:// or tcp://).
@@ -69,9 +149,10 @@ class NDimensionalIpcRunner {
    * @param dealer ZeroMQ DEALER socket used by the worker.
    * @param workerIndex Worker index.
    * @param worker Pointer to `NThreadData` representing the worker.
+   * @param protocol Task framing version agreed with the supervisor.
    * @return 0 on clean exit, non-zero on error.
    */
-  static int  TaskLoop(void * dealer, size_t workerIndex, NThreadData * worker);
+  static int  TaskLoop(void * dealer, size_t workerIndex, NThreadData * worker, int protocol = 1);
 
   /**
    * @brief Wait for a set of child PIDs to exit up to a timeout.
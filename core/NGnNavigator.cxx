@@ -1,5 +1,8 @@
 #include <cstddef>
+#include <deque>
+#include <list>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <iostream>
 #include "TAxis.h"
@@ -16,6 +19,7 @@
 #include <TBufferJSON.h>
 #include <TGClient.h>
 #include <TPaveText.h>
+#include <TTimer.h>
 
 #include "Buttons.h"
 #include "NBinningDef.h"
@@ -33,6 +37,21 @@ ClassImp(Ndmspc::NGnNavigator);
 /// \endcond
 
 namespace Ndmspc {
+
+/// Lazy build state shared by all navigators of one hierarchy (owned by the root)
+struct NGnNavigatorCache {
+  using Position = std::list<NGnNavigator *>::iterator;
+  std::string                                   baseName;       ///< Base name of navigators
+  size_t                                        maxNodes{0};    ///< Maximum built nodes (0 = unlimited)
+  int                                           prefetch{0};    ///< Distance of prefetched neighbours
+  std::list<NGnNavigator *>                     nodes;          ///< Built nodes, most recently used first
+  std::unordered_map<NGnNavigator *, Position>  positions;      ///< Position of node in nodes
+  std::deque<std::pair<NGnNavigator *, size_t>> queue;          ///< Children (parent, index) to prefetch
+  TTimer *                                      timer{nullptr}; ///< Builds queued children from event loop
+
+  ~NGnNavigatorCache() { delete timer; }
+};
+
 NGnNavigator::NGnNavigator(const char * name, const char * title, std::vector<std::string> objectTypes)
     : TNamed(name, title), fObjectTypes(objectTypes)
 {
@@ -50,6 +69,9 @@ NGnNavigator::NGnNavigator(const char * name, const char * title, std::vector<st
 }
 NGnNavigator::~NGnNavigator()
 {
+  // Stop prefetching before the children are deleted
+  delete fCache;
+  fCache = nullptr;
   if (fProjection) {
     fProjection->SetDirectory(nullptr);
     delete fProjection;
@@ -163,19 +185,8 @@ NGnNavigator * NGnNavigator::Reshape(NBinningDef * binningDef, std::vector<std::
 
   NLogTrace("NGnNavigator::Reshape: Reshaping navigator for level=%d levels=%zu", level, levels.size());
   TH1::AddDirectory(kFALSE);
-  NTreeBranch * branch = fGnTree->GetStorageTree()->GetBranch("_outputPoint");
-  if (!branch) {
-    // fallback to old branch name for backward compatibility
-    branch = fGnTree->GetStorageTree()->GetBranch("outputPoint");
-  }
-  int outputPointStatus = 0;
-  if (branch) {
-    outputPointStatus = branch->GetBranchStatus();
-    branch->SetBranchStatus(0); // Disable the _outputPoint branch to avoid memory issues with large trees
-  }
   fNLevels = levels.size();
   fLevel   = level;
-  // NBinningDef * binningDef = fGnTree->GetBinning()->GetDefinition(binningName);
 
   NGnNavigator * current = parent;
   if (current == nullptr) {
@@ -188,573 +199,651 @@ NGnNavigator * NGnNavigator::Reshape(NBinningDef * binningDef, std::vector<std::
     current->SetLevels(levels);
     current->SetGnTree(fGnTree);
   }
-  // current->Print();
-  // return current;
-
-  if (level < levels.size()) {
-    NLogTrace("NGnNavigator::Reshape: levels[%d]=%s...", level, NUtils::GetCoordsString(levels[level]).c_str());
-
-    // Generate projection histogram
-
-    // loop for every bin in the current level
-
-    std::vector<int> minsBin;
-    std::vector<int> maxsBin;
-    for (auto & idx : levels[level]) {
-      NLogTrace("NGnNavigator::Reshape: [B%d] Axis %d: %s", level, idx,
-                binningDef->GetContent()->GetAxis(idx)->GetName());
-      // int minBase = 0, maxBase = 0;
-      // NUtils::GetAxisRangeInBase(GetAxis(idx), 1, GetAxis(idx)->GetNbins(), fBinning->GetAxes()[idx], minBase,
-      // maxBase); ranges[idx] = {minBase, maxBase};            // Set the ranges for the axis
-      minsBin.push_back(1);                                                  // Get the minimum bin edge);
-      maxsBin.push_back(binningDef->GetContent()->GetAxis(idx)->GetNbins()); // Get the maximum bin edge);
-      NLogTrace("NGnNavigator::Reshape: [B%d] Axis %d: %s bins=[%d,%d]", level, idx,
-                binningDef->GetContent()->GetAxis(idx)->GetName(), minsBin.back(), maxsBin.back());
-    }
-
-    NDimensionalExecutor executorBin(minsBin, maxsBin);
-    auto                 loop_task_bin = [this, current, binningDef, levels, level, ranges,
-                                          rangesBase](const std::vector<int> & coords) {
-      NLogTrace("NGnNavigator::Reshape: [B%d] Processing coordinates: coords=%s levels=%s", level,
-                NUtils::GetCoordsString(coords, -1).c_str(), NUtils::GetCoordsString(levels[level]).c_str());
-      NLogTrace("NGnNavigator::Reshape: [L%d] Generating %zuD histogram %s with ranges: %s", level,
-                levels[level].size(), NUtils::GetCoordsString(levels[level]).c_str(), ranges.size() == 0 ? "[]" : "");
-
-      std::vector<int> axesIds = levels[level];
-      ///////// Make projection histogram /////////
-      // THnSparse * hns   = nullptr;
-      Int_t nDims = axesIds.size();
-      auto  dims  = std::make_unique<Int_t[]>(nDims);
-      // Int_t       dims[nDims];
-      for (int i = 0; i < nDims; i++) {
-        dims[i] = axesIds[i];
+  current->fBinningDef = binningDef;
+  current->fRanges     = ranges;
+  current->fRangesBase = rangesBase;
+
+  if (level >= levels.size()) {
+    NLogTrace("NGnNavigator::Reshape: Reached the end of levels, level=%d", level);
+    current->fMaterialized = true;
+    return current;
+  }
+
+  // NDMSPC_NAVIGATOR_LAZY: build children when they are reached by GetChild() (default 1, 0 builds all up front)
+  // NDMSPC_NAVIGATOR_CACHE_SIZE: maximum number of built navigators kept, least recently used are released
+  //                              (default 256, 0 = unlimited)
+  // NDMSPC_NAVIGATOR_PREFETCH: distance in bins of neighbours of selected cell built from event loop
+  //                            (default 1, 0 = disabled)
+  Long64_t lazy = 1, cacheSize = 256, prefetch = 1;
+  for (auto [envName, value] : {std::make_pair("NDMSPC_NAVIGATOR_LAZY", &lazy),
+                                std::make_pair("NDMSPC_NAVIGATOR_CACHE_SIZE", &cacheSize),
+                                std::make_pair("NDMSPC_NAVIGATOR_PREFETCH", &prefetch)}) {
+    const char * env = gSystem->Getenv(envName);
+    try {
+      if (env) *value = std::stoll(std::string(env));
+    }
+    catch (...) {
+      NLogWarning("%s invalid: '%s'", envName, env);
+    }
+  }
+  if (current->GetParent() == nullptr) {
+    delete current->fCache;
+    current->fCache           = new NGnNavigatorCache();
+    current->fCache->baseName = GetName();
+    // Nodes on the path to the selected one are never released
+    current->fCache->maxNodes = lazy > 0 && cacheSize > 0 ? std::max<size_t>(cacheSize, levels.size() + 1) : 0;
+    current->fCache->prefetch = lazy > 0 ? static_cast<int>(std::max<Long64_t>(prefetch, 0)) : 0;
+  }
+
+  if (!current->Materialize()) {
+    NLogError("NGnNavigator::Reshape: Failed to build navigator for level %d !!!", level);
+  }
+  else if (lazy <= 0) {
+    current->BuildAll();
+  }
+
+  NLogTrace("NGnNavigator::Reshape: =========== Reshaping navigator for level %d DONE ================", level);
+
+  if (level == 0) {
+    NLogInfo("NGnNavigator::Reshape: Reshaping navigator DONE%s.", lazy > 0 ? " (children are built on demand)" : "");
+    // print exported axes from indexes from levels
+    for (size_t l = 0; l < levels.size(); l++) {
+      std::string axesStr = "";
+      for (auto & a : levels[l]) {
+        TAxis * axis = binningDef->GetAxis(a);
+        axesStr += TString::Format("%d('%s') ", a, axis->GetName()).Data();
       }
-      THnSparse * hnsIn = binningDef->GetContent();
+      NLogInfo("  Level %zu axes: %s", l, axesStr.c_str());
+    }
+  }
 
-      NUtils::SetAxisRanges(hnsIn, ranges); // Set the ranges for the axes
-      // hns = static_cast<THnSparse *>(hnsIn->ProjectionND(axesIds.size(), dims.get(), "O"));
-      // if (!hns) {
-      //   NLogError("NGnNavigator::Reshape: Projection failed for level %d !!!", level);
-      //   return;
-      // }
+  // current->Print("");
+
+  return current;
+}
+
+bool NGnNavigator::Materialize()
+{
+  ///
+  /// Build projection of the node and, on the last level, objects and parameters of its cells
+  ///
+  fMaterialized = true;
+  if (fBinningDef == nullptr || fLevel >= fNLevels) return true;
+
+  std::vector<int> axesIds = GetRoot()->GetLevels()[fLevel];
+  NLogTrace("NGnNavigator::Materialize: [L%d] Generating %zuD histogram %s with ranges: %s", fLevel, axesIds.size(),
+            NUtils::GetCoordsString(axesIds).c_str(), fRanges.size() == 0 ? "[]" : "");
+
+  TH1::AddDirectory(kFALSE);
+  ///////// Make projection histogram /////////
+  Int_t       nDims = axesIds.size();
+  THnSparse * hnsIn = fBinningDef->GetContent();
+
+  NUtils::SetAxisRanges(hnsIn, fRanges); // Set the ranges for the axes
+
+  std::string name  = "";
+  std::string title = "";
+  for (auto & axisId : axesIds) {
+    TAxis * a = hnsIn->GetAxis(axisId);
+    title += std::string(a->GetName()) + " vs ";
+    name += TString::Format("%s-", a->GetName()).Data();
+  }
+  name = name.substr(0, name.size() - 1);    // Remove last "_"
+  if (name.empty()) name = "hns_proj";       // default name
+  title = title.substr(0, title.size() - 4); // Remove last " vs "
+  if (fRanges.size() > 0) title += " for ranges: ";
+  for (const auto & [axisId, range] : fRangesBase) {
+    TAxis * a = hnsIn->GetAxis(axisId);
+    if (a->IsAlphanumeric()) {
+      title += TString::Format("%s[%s]", a->GetName(), a->GetBinLabel(range[0]));
+    }
+    else {
+      title += TString::Format("%s[%.2f,%.2f]", a->GetName(), a->GetBinLowEdge(range[0]), a->GetBinUpEdge(range[1]));
+    }
+  }
 
-      //   // int nCells = h->GetNcells();
-      //   // h->SetMinimum(0);
-      //   // h->SetStats(kFALSE);
-      std::string name  = "";
-      std::string title = "";
-      for (auto & axisId : axesIds) {
-        TAxis * a = hnsIn->GetAxis(axisId);
-        title += std::string(a->GetName()) + " vs ";
-        name += TString::Format("%s-", a->GetName()).Data();
+  TH1 * hProj = nullptr;
+  if (nDims == 1) {
+    hProj = hnsIn->Projection(axesIds[0]);
+    hProj->SetDirectory(nullptr); // detach from gDirectory; navigator owns this histogram
+    // set name from hnsIn
+    TAxis * axisIn0   = hnsIn->GetAxis(axesIds[0]);
+    TAxis * axisProjX = hProj->GetXaxis();
+    axisProjX->SetName(axisIn0->GetName());
+    // apply lables from hnsIn to hProj
+    if (axisIn0->IsAlphanumeric()) {
+      for (int b = 1; b <= hProj->GetNbinsX(); b++) {
+        axisProjX->SetBinLabel(b, axisIn0->GetBinLabel(b));
       }
-      name = name.substr(0, name.size() - 1);    // Remove last "_"
-      if (name.empty()) name = "hns_proj";       // default name
-      title = title.substr(0, title.size() - 4); // Remove last " vs "
-      if (ranges.size() > 0) title += " for ranges: ";
-      for (const auto & [axisId, range] : rangesBase) {
-        // NLogDebug("XX Axis '%s' range: [%d, %d]", GetAxis(axisId)->GetName(), range[0], range[1]);
-        TAxis * a = hnsIn->GetAxis(axisId);
-        if (a->IsAlphanumeric()) {
-          title += TString::Format("%s[%s]", a->GetName(), a->GetBinLabel(range[0]));
-        }
-        else {
-          title +=
-              TString::Format("%s[%.2f,%.2f]", a->GetName(), a->GetBinLowEdge(range[0]), a->GetBinUpEdge(range[1]));
-        }
+    }
+  }
+  else if (nDims == 2) {
+    // TODO: Check the order of axes is really correct
+    hProj = hnsIn->Projection(axesIds[1], axesIds[0]);
+    hProj->SetDirectory(nullptr); // detach from gDirectory; navigator owns this histogram
+    TAxis * axisIn1   = hnsIn->GetAxis(axesIds[0]);
+    TAxis * axisIn0   = hnsIn->GetAxis(axesIds[1]);
+    TAxis * axisProjX = hProj->GetXaxis();
+    TAxis * axisProjY = hProj->GetYaxis();
+    axisProjX->SetName(axisIn1->GetName());
+    axisProjY->SetName(axisIn0->GetName());
+    // apply lables from hnsIn to hProj
+    if (axisIn1->IsAlphanumeric()) {
+      for (int b = 1; b <= hProj->GetNbinsX(); b++) {
+        axisProjX->SetBinLabel(b, axisIn1->GetBinLabel(b));
       }
-      // hns->SetTitle(title.c_str());
-      // // hns is only needed to derive name/title strings; delete it now to
-      // // avoid leaking one THnSparse per bin iteration.
-      // delete hns;
-      // hns = nullptr;
-      // hns->Print();
-
-      // TODO: Handle it via NGnSparseObject
-      // if (obj->GetHnSparse() == nullptr) {
-      //   NLogDebug("NGnNavigator::Reshape: Setting histogram '%s' ...", hns->GetTitle());
-      //   obj->SetHnSparse(hns);
-      // }
+    }
 
-      int   indexInProj = -1;
-      TH1 * hProj       = nullptr;
-      // if (level < 3) {
-      if (nDims == 1) {
-        hProj = hnsIn->Projection(axesIds[0]);
-        hProj->SetDirectory(nullptr); // detach from gDirectory; navigator owns this histogram
-        // set name from hnsIn
-        TAxis * axisIn0   = hnsIn->GetAxis(axesIds[0]);
-        TAxis * axisProjX = hProj->GetXaxis();
-        axisProjX->SetName(axisIn0->GetName());
-        // apply lables from hnsIn to hProj
-        if (axisIn0->IsAlphanumeric()) {
-          for (int b = 1; b <= hProj->GetNbinsX(); b++) {
-            axisProjX->SetBinLabel(b, axisIn0->GetBinLabel(b));
-          }
-        }
-        indexInProj = hProj->FindFixBin(axisProjX->GetBinCenter(coords[0]));
+    if (axisIn0->IsAlphanumeric()) {
+      for (int b = 1; b <= hProj->GetNbinsY(); b++) {
+        axisProjY->SetBinLabel(b, axisIn0->GetBinLabel(b));
       }
-      else if (nDims == 2) {
-        // TODO: Check the order of axes is really correct
-        hProj = hnsIn->Projection(axesIds[1], axesIds[0]);
-        hProj->SetDirectory(nullptr); // detach from gDirectory; navigator owns this histogram
-        TAxis * axisIn1   = hnsIn->GetAxis(axesIds[0]);
-        TAxis * axisIn0   = hnsIn->GetAxis(axesIds[1]);
-        TAxis * axisProjX = hProj->GetXaxis();
-        TAxis * axisProjY = hProj->GetYaxis();
-        axisProjX->SetName(axisIn1->GetName());
-        axisProjY->SetName(axisIn0->GetName());
-        // apply lables from hnsIn to hProj
-        if (axisIn1->IsAlphanumeric()) {
-          for (int b = 1; b <= hProj->GetNbinsX(); b++) {
-            axisProjX->SetBinLabel(b, axisIn1->GetBinLabel(b));
-          }
-        }
-
-        if (axisIn0->IsAlphanumeric()) {
-          for (int b = 1; b <= hProj->GetNbinsY(); b++) {
-            axisProjY->SetBinLabel(b, axisIn0->GetBinLabel(b));
-          }
-        }
-        indexInProj = hProj->FindFixBin(axisProjX->GetBinCenter(coords[0]), axisProjY->GetBinCenter(coords[1]));
+    }
+  }
+  else if (nDims == 3) {
+    hProj = hnsIn->Projection(axesIds[0], axesIds[1], axesIds[2]);
+    hProj->SetDirectory(nullptr); // detach from gDirectory; navigator owns this histogram
+    TAxis * axisIn0   = hnsIn->GetAxis(axesIds[0]);
+    TAxis * axisIn1   = hnsIn->GetAxis(axesIds[1]);
+    TAxis * axisIn2   = hnsIn->GetAxis(axesIds[2]);
+    TAxis * axisProjX = hProj->GetXaxis();
+    TAxis * axisProjY = hProj->GetYaxis();
+    TAxis * axisProjZ = hProj->GetZaxis();
+    axisProjX->SetName(axisIn0->GetName());
+    axisProjY->SetName(axisIn1->GetName());
+    axisProjZ->SetName(axisIn2->GetName());
+    // apply lables from hnsIn to hProj
+    if (axisIn0->IsAlphanumeric()) {
+      for (int b = 1; b <= hProj->GetNbinsX(); b++) {
+        axisProjX->SetBinLabel(b, axisIn0->GetBinLabel(b));
       }
-      else if (nDims == 3) {
-        hProj = hnsIn->Projection(axesIds[0], axesIds[1], axesIds[2]);
-        hProj->SetDirectory(nullptr); // detach from gDirectory; navigator owns this histogram
-        TAxis * axisIn0   = hnsIn->GetAxis(axesIds[0]);
-        TAxis * axisIn1   = hnsIn->GetAxis(axesIds[1]);
-        TAxis * axisIn2   = hnsIn->GetAxis(axesIds[2]);
-        TAxis * axisProjX = hProj->GetXaxis();
-        TAxis * axisProjY = hProj->GetYaxis();
-        TAxis * axisProjZ = hProj->GetZaxis();
-        axisProjX->SetName(axisIn0->GetName());
-        axisProjY->SetName(axisIn1->GetName());
-        axisProjZ->SetName(axisIn2->GetName());
-        // apply lables from hnsIn to hProj
-        if (axisIn0->IsAlphanumeric()) {
-          for (int b = 1; b <= hProj->GetNbinsX(); b++) {
-            axisProjX->SetBinLabel(b, axisIn0->GetBinLabel(b));
-          }
-        }
+    }
 
-        if (axisIn1->IsAlphanumeric()) {
-          for (int b = 1; b <= hProj->GetNbinsY(); b++) {
-            axisProjY->SetBinLabel(b, axisIn1->GetBinLabel(b));
-          }
-        }
-        if (axisIn2->IsAlphanumeric()) {
-          for (int b = 1; b <= hProj->GetNbinsZ(); b++) {
-            axisProjZ->SetBinLabel(b, axisIn2->GetBinLabel(b));
-          }
-        }
-        indexInProj = hProj->FindFixBin(axisProjX->GetBinCenter(coords[0]), axisProjY->GetBinCenter(coords[1]),
-                                        axisProjZ->GetBinCenter(coords[2]));
-      }
-      else {
-        NLogError("NGnNavigator::Reshape: Cannot project THnSparse with %d dimensions", nDims);
-        return;
+    if (axisIn1->IsAlphanumeric()) {
+      for (int b = 1; b <= hProj->GetNbinsY(); b++) {
+        axisProjY->SetBinLabel(b, axisIn1->GetBinLabel(b));
       }
-      if (!hProj) {
-        NLogError("NGnNavigator::Reshape: Projection failed for level %d !!!", level);
-        return;
+    }
+    if (axisIn2->IsAlphanumeric()) {
+      for (int b = 1; b <= hProj->GetNbinsZ(); b++) {
+        axisProjZ->SetBinLabel(b, axisIn2->GetBinLabel(b));
       }
-
-      hProj->SetName(name.c_str());
-      hProj->SetTitle(title.c_str());
-      // Increase all bin contents by 1 to avoid empty bins
-      double content;
-      int    dim = hProj->GetDimension();
-      if (dim == 1) {
-        for (int x = 1; x <= hProj->GetNbinsX(); ++x) {
-          content = hProj->GetBinContent(x);
-          if (content > 0) {
-            hProj->SetBinContent(x, content + 1.0);
-          }
-        }
+    }
+  }
+  else {
+    NLogError("NGnNavigator::Materialize: Cannot project THnSparse with %d dimensions", nDims);
+    NUtils::SetAxisRanges(hnsIn, std::vector<std::vector<int>>{});
+    return false;
+  }
+  if (!hProj) {
+    NLogError("NGnNavigator::Materialize: Projection failed for level %d !!!", fLevel);
+    NUtils::SetAxisRanges(hnsIn, std::vector<std::vector<int>>{});
+    return false;
+  }
+
+  hProj->SetName(name.c_str());
+  hProj->SetTitle(title.c_str());
+  // Increase all bin contents by 1 to avoid empty bins
+  double content;
+  int    dim = hProj->GetDimension();
+  if (dim == 1) {
+    for (int x = 1; x <= hProj->GetNbinsX(); ++x) {
+      content = hProj->GetBinContent(x);
+      if (content > 0) {
+        hProj->SetBinContent(x, content + 1.0);
       }
-      else if (dim == 2) {
-        for (int x = 1; x <= hProj->GetNbinsX(); ++x) {
-          for (int y = 1; y <= hProj->GetNbinsY(); ++y) {
-            content = hProj->GetBinContent(x, y);
-            if (content > 0) {
-              hProj->SetBinContent(x, y, content + 1.0);
-            }
-          }
+    }
+  }
+  else if (dim == 2) {
+    for (int x = 1; x <= hProj->GetNbinsX(); ++x) {
+      for (int y = 1; y <= hProj->GetNbinsY(); ++y) {
+        content = hProj->GetBinContent(x, y);
+        if (content > 0) {
+          hProj->SetBinContent(x, y, content + 1.0);
         }
       }
-      else if (dim == 3) {
-        for (int x = 1; x <= hProj->GetNbinsX(); ++x) {
-          for (int y = 1; y <= hProj->GetNbinsY(); ++y) {
-            for (int z = 1; z <= hProj->GetNbinsZ(); ++z) {
-              content = hProj->GetBinContent(x, y, z);
-              if (content > 0) {
-                hProj->SetBinContent(x, y, z, content + 1.0);
-              }
-            }
+    }
+  }
+  else if (dim == 3) {
+    for (int x = 1; x <= hProj->GetNbinsX(); ++x) {
+      for (int y = 1; y <= hProj->GetNbinsY(); ++y) {
+        for (int z = 1; z <= hProj->GetNbinsZ(); ++z) {
+          content = hProj->GetBinContent(x, y, z);
+          if (content > 0) {
+            hProj->SetBinContent(x, y, z, content + 1.0);
           }
         }
       }
+    }
+  }
 
-      // Handle special THnSparse reserved first cell without looping: use
-      // GetBinContent(0, coords) which fills coords for the linear bin 0.
-      {
-        Int_t   nd         = hnsIn->GetNdimensions();
-        Int_t * firstCoord = new Int_t[nd];
-        // Double_t firstVal =
-        content = hnsIn->GetBinContent(0, firstCoord); // fills firstCoord
-        // If bin 0 exists (firstVal may be 0.0), map its coordinates to projection
-        // bin indices and increment that projection bin by +1.
-        if (firstCoord) {
-          if (nDims == 1) {
-            int bx = firstCoord[axesIds[0]];
-            if (content < 0.5 && bx >= 1 && bx <= hProj->GetNbinsX())
-              hProj->SetBinContent(bx, hProj->GetBinContent(bx) + 1.0);
-          }
-          else if (nDims == 2) {
-            int bx = firstCoord[axesIds[0]];
-            int by = firstCoord[axesIds[1]];
-            if (content < 0.5 && bx >= 1 && bx <= hProj->GetNbinsX() && by >= 1 && by <= hProj->GetNbinsY())
-              hProj->SetBinContent(bx, by, hProj->GetBinContent(bx, by) + 1.0);
-          }
-          else if (nDims == 3) {
-            int bx = firstCoord[axesIds[0]];
-            int by = firstCoord[axesIds[1]];
-            int bz = firstCoord[axesIds[2]];
-            if (content < 0.5 && bx >= 1 && bx <= hProj->GetNbinsX() && by >= 1 && by <= hProj->GetNbinsY() &&
-                bz >= 1 && bz <= hProj->GetNbinsZ())
-              hProj->SetBinContent(bx, by, bz, hProj->GetBinContent(bx, by, bz) + 1.0);
-          }
-        }
-        delete[] firstCoord;
-      }
+  // Handle special THnSparse reserved first cell without looping: use
+  // GetBinContent(0, coords) which fills coords for the linear bin 0.
+  {
+    Int_t   nd         = hnsIn->GetNdimensions();
+    Int_t * firstCoord = new Int_t[nd];
+    content            = hnsIn->GetBinContent(0, firstCoord); // fills firstCoord
+    // If bin 0 exists (firstVal may be 0.0), map its coordinates to projection
+    // bin indices and increment that projection bin by +1.
+    if (nDims == 1) {
+      int bx = firstCoord[axesIds[0]];
+      if (content < 0.5 && bx >= 1 && bx <= hProj->GetNbinsX())
+        hProj->SetBinContent(bx, hProj->GetBinContent(bx) + 1.0);
+    }
+    else if (nDims == 2) {
+      int bx = firstCoord[axesIds[0]];
+      int by = firstCoord[axesIds[1]];
+      if (content < 0.5 && bx >= 1 && bx <= hProj->GetNbinsX() && by >= 1 && by <= hProj->GetNbinsY())
+        hProj->SetBinContent(bx, by, hProj->GetBinContent(bx, by) + 1.0);
+    }
+    else if (nDims == 3) {
+      int bx = firstCoord[axesIds[0]];
+      int by = firstCoord[axesIds[1]];
+      int bz = firstCoord[axesIds[2]];
+      if (content < 0.5 && bx >= 1 && bx <= hProj->GetNbinsX() && by >= 1 && by <= hProj->GetNbinsY() && bz >= 1 &&
+          bz <= hProj->GetNbinsZ())
+        hProj->SetBinContent(bx, by, bz, hProj->GetBinContent(bx, by, bz) + 1.0);
+    }
+    delete[] firstCoord;
+  }
 
-      NLogTrace("NGnNavigator::Reshape: [L%d] Projection histogram '%s' for coords=%s index=%d", level,
-                hProj->GetTitle(), NUtils::GetCoordsString(coords, -1).c_str(), indexInProj);
-      //
-      // hProj->SetMinimum(0);
-      // hProj->SetStats(kFALSE);
-      // hProj->Draw();
-      // gPad->ModifiedUpdate();
-      // gSystem->Sleep(1000);
-      // }
-      // hProj->Print();
-      // hProj->Draw("colz text");
-      // `current` is shared across all bin iterations at this level. The
-      // projection is identical for every iteration (ranges are fixed), so
-      // only store it once.  Subsequent iterations delete the duplicate and
-      // reuse the already-stored pointer so that `nCells` below stays valid.
-      if (current->GetProjection() == nullptr) {
-        current->SetProjection(hProj);
-      }
-      else {
-        delete hProj;
-        hProj = current->GetProjection();
-      }
-      //////// End of projection histogram ////////
-
-      std::map<int, std::vector<int>> rangesTmp     = ranges;
-      std::map<int, std::vector<int>> rangesBaseTmp = rangesBase;
-      for (auto & kv : rangesBaseTmp) {
-        std::vector<int> range = rangesTmp[kv.first];
-        NLogTrace("NGnNavigator::Reshape: [L%d]   Axis %d[%s]: rangeBase=%s range=%s", level, kv.first,
-                  hnsIn->GetAxis(kv.first)->GetName(), NUtils::GetCoordsString(kv.second).c_str(),
-                  NUtils::GetCoordsString(range).c_str());
-      }
-      int minBase = 0, maxBase = 0;
-      int i = 0;
-      for (auto & c : coords) {
-        // NLogDebug("Coordinate: %d v=%d axis=%d", i, coords[i], axes[i]);
-        NUtils::GetAxisRangeInBase(hnsIn->GetAxis(axesIds[i]), c, c, binningDef->GetBinning()->GetAxes()[axesIds[i]],
-                                   minBase, maxBase);
-        NLogTrace("NGnNavigator::Reshape: Axis %d: minBase=%d maxBase=%d", axesIds[i], minBase, maxBase);
-        rangesTmp[axesIds[i]]     = {c, c};             // Set the range for the first axis
-        rangesBaseTmp[axesIds[i]] = {minBase, maxBase}; // Set the range for the first axis
-        i++;
-      }
+  if (fProjection) delete fProjection;
+  fProjection = hProj;
+  //////// End of projection histogram ////////
 
-      if (hProj == nullptr) {
-        NLogError("NGnNavigator::Reshape: Projection histogram is null for level %d !!!", level);
-        return;
-      }
+  size_t nCells = hProj->GetNcells();
+  if (fLevel + 1 < fNLevels) {
+    // Children are built when they are reached by GetChild()
+    if (fChildren.size() != nCells) SetChildrenSize(nCells);
+  }
+  else {
+    FillCells();
+  }
 
-      size_t nCells = hProj->GetNcells();
-
-      // NGnNavigator * o = fParent->GetChild(indexInProj);
-      NGnNavigator * currentChild = current->GetChild(indexInProj);
-      if (currentChild == nullptr) {
-        NLogTrace("NGnNavigator::Reshape: [L%d] Creating new child for index %d nCells=%d ...", level, indexInProj,
-                  nCells);
-        std::string childName = TString::Format("%s_L%zu_C%d", GetName(), level + 1, indexInProj).Data();
-        currentChild          = new NGnNavigator(childName.c_str(), childName.c_str());
-        currentChild->SetLevel(level + 1);
-        currentChild->SetNLevels(levels.size());
-        currentChild->SetParent(current);
-        currentChild->SetGnTree(fGnTree);
-        // o = new NGnNavigator(hns->GetListOfAxes());
-        // if (fParent->GetChildren().size() != nCells) fParent->SetChildrenSize(nCells);
-        // fParent->SetChild(o, indexInProj); // Set the child at the index
-        // fParent = o;
-        // INFO: it was moved down
-        // if (current->GetChildren().size() != nCells) current->SetChildrenSize(nCells);
-        // current->SetChild(currentChild, indexInProj); // Set the child at the index
-        // currentChild->Print();
-      }
-      else {
-        NLogError("NGnNavigator::Reshape: [L%d] Using existing child for index %d [NOT OK] ...", level, indexInProj);
-      }
+  std::vector<std::vector<int>> rangesEmpty;
+  NUtils::SetAxisRanges(hnsIn, rangesEmpty); // Reset the ranges for the axes
+  NLogTrace("NGnNavigator::Materialize: [L%d] Projection histogram '%s' with %zu cells built", fLevel,
+            hProj->GetTitle(), nCells);
+  return true;
+}
 
-      // currentChild->Print();
-      // return;
-
-      if (level == levels.size() - 1) {
-        NLogTrace("NGnNavigator::Reshape: [L%d] Filling projections from all branches %s for ranges:", level,
-                  NUtils::GetCoordsString(levels[level]).c_str());
-        for (auto & kv : rangesBaseTmp) {
-          std::vector<int> range = rangesTmp[kv.first];
-          NLogTrace("NGnNavigator::Reshape: [L%d]   Axis %d ['%s']: rangeBase=%s range=%s", level, kv.first,
-                    binningDef->GetContent()->GetAxis(kv.first)->GetName(), NUtils::GetCoordsString(kv.second).c_str(),
-                    NUtils::GetCoordsString(range).c_str());
-          // rangesTmp[kv.first] = range;
+void NGnNavigator::FillCells()
+{
+  ///
+  /// Fill objects and parameters of all cells from the entries of the tree (last level only)
+  ///
+  std::vector<std::string> outputPointBranches = fGnTree->GetStorageTree()->GetOutputPointBranchNames();
+  if (outputPointBranches.empty()) {
+    // fallback to old branch name for backward compatibility
+    outputPointBranches.push_back("outputPoint");
+  }
+  // Disable the output point branches to avoid memory issues with large trees
+  std::vector<std::pair<NTreeBranch *, int>> outputPointStatus;
+  for (const auto & name : outputPointBranches) {
+    NTreeBranch * branch = fGnTree->GetStorageTree()->GetBranch(name);
+    if (!branch) continue;
+    outputPointStatus.emplace_back(branch, branch->GetBranchStatus());
+    branch->SetBranchStatus(0);
+  }
+
+  std::vector<int> axesIds = GetRoot()->GetLevels()[fLevel];
+  THnSparse *      hnsIn   = fBinningDef->GetContent();
+  size_t           nCells  = fProjection->GetNcells();
+
+  // loop for every bin in the current level
+  std::vector<int> minsBin;
+  std::vector<int> maxsBin;
+  for (auto & idx : axesIds) {
+    minsBin.push_back(1);                               // Get the minimum bin edge);
+    maxsBin.push_back(fBinningDef->GetAxis(idx)->GetNbins()); // Get the maximum bin edge);
+  }
+
+  // Entries of all cells are collected first, so one read-ahead covers the whole level
+  std::vector<std::pair<std::vector<int>, std::vector<int>>> cells; // coords and entries of cells with entries
+  NDimensionalExecutor executorBin(minsBin, maxsBin);
+  auto                 collect_task_bin = [this, axesIds, hnsIn, &cells](const std::vector<int> & coords) {
+    std::map<int, std::vector<int>> rangesTmp;
+    std::map<int, std::vector<int>> rangesBaseTmp;
+    GetCellRanges(coords, rangesTmp, rangesBaseTmp);
+    NLogTrace("NGnNavigator::FillCells: [L%d] Collecting entries from all branches %s for coords=%s", fLevel,
+              NUtils::GetCoordsString(axesIds).c_str(), NUtils::GetCoordsString(coords, -1).c_str());
+
+    Long64_t linBin = 0;
+    NUtils::SetAxisRanges(hnsIn, rangesTmp); // Set the ranges for the axes
+    std::unique_ptr<ROOT::Internal::THnBaseBinIter> iter{hnsIn->CreateIter(true /*use axis range*/)};
+    std::vector<int>                                linBins;
+
+    // loop over all bins in the sparse
+    while ((linBin = iter->Next()) >= 0) {
+      NLogTrace("NGnNavigator::FillCells: [L%d]   Found bin %lld [%lld]", fLevel, linBin, fBinningDef->GetId(linBin));
+      linBins.push_back(fBinningDef->GetId(linBin));
+    }
+    if (linBins.empty()) {
+      NLogTrace("NGnNavigator::FillCells: [L%d] No bins found for the given ranges, skipping ...", fLevel);
+      return; // No bins found, nothing to process
+    }
+    cells.emplace_back(coords, std::move(linBins));
+  };
+  executorBin.Execute(collect_task_bin);
+
+  // Opt-in (NDMSPC_READAHEAD): entries of the level are read ahead, in the order of cells, while objects are
+  // processed
+  NStorageTree *        storage = fGnTree->GetStorageTree();
+  std::vector<Long64_t> entries;
+  for (const auto & cell : cells) entries.insert(entries.end(), cell.second.begin(), cell.second.end());
+  if (entries.size() > 1) storage->StartReadAhead(entries);
+
+  for (const auto & [coords, linBins] : cells) {
+    const int indexInProj =
+        fProjection->GetBin(coords[0], coords.size() > 1 ? coords[1] : 0, coords.size() > 2 ? coords[2] : 0);
+
+    std::map<int, std::vector<int>> rangesTmp;
+    std::map<int, std::vector<int>> rangesBaseTmp;
+    GetCellRanges(coords, rangesTmp, rangesBaseTmp);
+    NLogTrace("NGnNavigator::FillCells: Branch object Point coordinates: %s",
+              NUtils::GetCoordsString(linBins, -1).c_str());
+    SetNCells(nCells);
+
+    for (int lb : linBins) {
+      fGnTree->GetEntry(lb);
+      for (auto & [key, val] : fGnTree->GetStorageTree()->GetBranchesMap()) {
+        if (val.GetBranchStatus() == 0) {
+          NLogTrace("NGnNavigator::FillCells: [L%d] Branch '%s' is disabled, skipping ...", fLevel, key.c_str());
+          continue; // Skip disabled branches
         }
-        // Get projectiosn histograms from all branches
-
-        // Int_t *  cCoords = new Int_t[hns->GetNdimensions()];
-        Long64_t linBin = 0;
+        NLogTrace("NGnNavigator::FillCells: [L%d] Processing branch '%s' with %zu objects to loop ...", fLevel,
+                  key.c_str(), linBins.size());
+
+        TString className = val.GetObjectClassName();
+        if (className.BeginsWith("TList")) {
+          NLogTrace("[L%d] Branch '%s' is a TList, getting object at index %d ...", fLevel, key.c_str(),
+                    indexInProj);
+          TList * list = dynamic_cast<TList *>(val.GetObject());
+          // get list of object names
+          std::vector<std::string> objNames;
+          for (int i = 0; i < list->GetEntries(); i++) {
+            TObject * o = list->At(i);
+            objNames.push_back(o->GetName());
+          }
 
-        // hns->Print("all");
-        NUtils::SetAxisRanges(hnsIn, rangesTmp); // Set the ranges for the axes
-        std::unique_ptr<ROOT::Internal::THnBaseBinIter> iter{hnsIn->CreateIter(true /*use axis range*/)};
-        std::vector<int>                                linBins;
+          NLogTrace("[L%d] Branch '%s' TList contains %d objects: %s", fLevel, key.c_str(), list->GetEntries(),
+                    NUtils::GetCoordsString(objNames).c_str());
 
-        // loop over all bins in the sparse
+          bool isValid = true;
+          for (auto & name : objNames) {
+            TH1 * hProjTmp = dynamic_cast<TH1 *>(list->FindObject(name.c_str()));
+            if (hProjTmp == nullptr) {
+              NLogTrace("NGnNavigator::FillCells::Warning Branch '%s' TList does not contain '%s' as TH1 !!!",
+                        key.c_str(), name.c_str());
+              isValid = false;
 
-        while ((linBin = iter->Next()) >= 0) {
-          NLogTrace("NGnNavigator::Reshape: [L%d]   Found bin %lld [%lld]", level, linBin, binningDef->GetId(linBin));
-          linBins.push_back(binningDef->GetId(linBin));
-        }
-        if (linBins.empty()) {
-          NLogTrace("NGnNavigator::Reshape: [L%d] No bins found for the given ranges, skipping ...", level);
-          // continue;
-          return; // No bins found, nothing to process
-        }
-        //     // bool skipBin = false; // Skip bin if no bins are found
-        NLogTrace("NGnNavigator::Reshape: Branch object Point coordinates: %s",
-                  NUtils::GetCoordsString(linBins, -1).c_str());
-        current->SetNCells(nCells);
-
-        for (int lb : linBins) {
-          fGnTree->GetEntry(lb);
-          for (auto & [key, val] : fGnTree->GetStorageTree()->GetBranchesMap()) {
-            if (val.GetBranchStatus() == 0) {
-              NLogTrace("NGnNavigator::Reshape: [L%d] Branch '%s' is disabled, skipping ...", level, key.c_str());
-              continue; // Skip disabled branches
+              continue;
             }
-            NLogTrace("NGnNavigator::Reshape: [L%d] Processing branch '%s' with %zu objects to loop ...", level,
-                      key.c_str(), linBins.size());
-
-            // if (obj->GetParent()->GetObjectContentMap()[key].size() != nCells)
-            //   obj->GetParent()->ResizeObjectContentMap(key, nCells);
-
-            //           if (skipBin) continue; // Skip processing if the previous bin was skipped
-
-            ///
-            /// Handle THnSparse branch object
-            ///
-            // obj->GetParent()->SetNCells(nCells);
-            // fParent->SetNCells(nCells);
-            TString className = val.GetObjectClassName();
-            if (className.BeginsWith("THnSparse")) {
-              // // if (obj->GetParent()->GetObjectContentMap()[key].size() != nCells)
-              // //   obj->GetParent()->ResizeObjectContentMap(key, nCells);
-              // // TODO: Make it configurable
-              // int projectionAxis = 0;
-              //
-              // TH1 * hProjTmp = nullptr;
-              // // loop over all linBins
-              // for (int lb : linBins) {
-              //   fGnTree->GetEntry(lb);
-              //   if (hProjTmp == nullptr) {
-              //     hProjTmp = ProjectionFromObject(key, projectionAxis, rangesBaseTmp);
-              //     // NLogDebug("AAAA %.0f", hProjTmp ? hProjTmp->GetEntries() : 0);
-              //   }
-              //   else {
-              //     TH1 * temp = ProjectionFromObject(key, projectionAxis, rangesBaseTmp);
-              //     // NLogDebug("BBBB %.0f", temp ? temp->GetEntries() : 0);
-              //     if (temp) {
-              //       hProjTmp->Add(temp);
-              //       delete temp; // Delete the temporary histogram to avoid memory leaks
-              //     }
-              //   }
-              // }
-              // if (!hProjTmp) {
-              //   // skipBin = true; // Skip bin if no histogram is created
-              //   continue;
-              // }
-              // // generate histogram title from axis base ranges
-              // std::string title = "Projection of " + key + " ";
-              // for (const auto & [axis, range] : rangesBaseTmp) {
-              //   TAxis * a = fBinning->GetAxes()[axis];
-              //
-              //   title +=
-              //       TString::Format("%s[%.2f,%.2f]", a->GetName(), a->GetBinLowEdge(range[0]),
-              //       a->GetBinUpEdge(range[1]));
-              // }
-              // hProjTmp->SetTitle(title.c_str());
-              // NLogTrace("[L%d] Projection histogram '%s' for branch '%s' storing with indexInProj=%d,
-              //                entries = % .0f ",
-              //                          level,
-              //                hProjTmp->GetTitle(), key.c_str(), indexInProj, hProjTmp->GetEntries());
-              // obj->GetParent()->SetObject(key, hProjTmp, indexInProj);
-              // // hProjTmp->Draw();
-              // // gPad->Update();
-              // // gPad->Modified();
-              // // gSystem->ProcessEvents();
-              // // TODO: We may to set entries from projection histogram to the bin content of mapping file
+            if (TMath::IsNaN(hProjTmp->GetEntries()) || TMath::IsNaN(hProjTmp->GetSumOfWeights())) {
+              NLogWarning("NGnNavigator::FillCells: Branch '%s' '%s' histogram is nan !!!", key.c_str(), name.c_str());
+              isValid = false;
+              continue;
             }
-            else if (className.BeginsWith("TList")) {
-              NLogTrace("[L%d] Branch '%s' is a TList, getting object at index %d ...", level, key.c_str(),
-                        indexInProj);
-              TList * list = dynamic_cast<TList *>(val.GetObject());
-              // list->Print();
-              // get list of object names
-              std::vector<std::string> objNames;
-              for (int i = 0; i < list->GetEntries(); i++) {
-                TObject * o = list->At(i);
-                objNames.push_back(o->GetName());
-              }
-              // remove "results" histogram
-              // objNames.erase(std::remove(objNames.begin(), objNames.end(), "_params"), objNames.end());
-
-              NLogTrace("[L%d] Branch '%s' TList contains %d objects: %s", level, key.c_str(), list->GetEntries(),
-                        NUtils::GetCoordsString(objNames).c_str());
-
-              // std::vector<std::string> possibleNames = {"hPeak", "hBgNorm", "unlikepm_proj_0"};
-
-              // current->SetObjectNames(objNames);
-              bool isValid = true;
-              for (auto & name : objNames) {
-                TH1 * hProjTmp = dynamic_cast<TH1 *>(list->FindObject(name.c_str()));
-                if (hProjTmp == nullptr) {
-                  NLogTrace("NGnNavigator::Reshape::Warning Branch '%s' TList does not contain '%s' as TH1 !!!",
-                            key.c_str(), name.c_str());
-                  isValid = false;
-
-                  continue;
-                }
-                if (TMath::IsNaN(hProjTmp->GetEntries()) || TMath::IsNaN(hProjTmp->GetSumOfWeights())) {
-                  NLogWarning("NGnNavigator::Reshape: Branch '%s' '%s' histogram is nan !!!", key.c_str(),
-
-                              name.c_str());
-                  isValid = false;
-                  continue;
-                }
-                NLogTrace(
-                    "[L%d] Histogram name='%s' title='%s' for branch '%s' storing with indexInProj=%d, entries=%.0f",
-                    level, name.c_str(), hProjTmp->GetTitle(), key.c_str(), indexInProj, hProjTmp->GetEntries());
-                // if (obj->GetParent()->GetObjectContentMap()[name].size() != nCells)
-                //   obj->GetParent()->ResizeObjectContentMap(name, nCells);
-                // // obj->GetParent()->SetObject(key, hProjTmp, indexInProj);
-                // obj->GetParent()->SetObject(name, hProjTmp, indexInProj);
-                // if (fParent->GetObjectContentMap()[name].size() != nCells) fParent->ResizeObjectContentMap(name,
-                // nCells); fParent->SetObject(name, hProjTmp, indexInProj);
-                if (current->GetObjectContentMap()[name].size() != nCells)
-                  current->ResizeObjectContentMap(name, nCells);
-                // Clone the histogram so the navigator owns it independently of the TTree branch
-                // buffer. ROOT clears TList branch objects on every GetEntry() call, which would
-                // leave the stored pointer dangling if we don't clone here.
-                TH1 * hClone = (TH1 *)hProjTmp->Clone();
-                hClone->SetDirectory(nullptr);
-                current->SetObject(name, hClone, indexInProj);
-              }
-              if (isValid == false) {
-                NLogTrace("NGnNavigator::Reshape::Warning: Branch '%s' TList does not contain any valid histograms !!!",
-                          key.c_str());
-                continue;
-              }
-            }
-            else if (className.BeginsWith("Ndmspc::NParameters")) {
-
-              NParameters * parameters = dynamic_cast<NParameters *>(val.GetObject());
-              if (parameters) {
-                TH1 * hParams = parameters->GetHisto();
-                if (hParams) {
-                  // hParams->Print("all");
-                  NLogTrace("[L%d] Branch '%s' Point contains '_params' histogram with %.0f entries ...", level,
-                            key.c_str(), hParams->GetEntries());
-                  // loop over bin labels
-                  for (int b = 1; b <= hParams->GetNbinsX(); b++) {
-
-                    std::string binLabel = hParams->GetXaxis()->GetBinLabel(b);
-                    double      binValue = hParams->GetBinContent(b);
-                    double      binError = hParams->GetBinError(b);
-                    NLogTrace("[L%d]   Bin %d[%s] = %e indexInProj=%d", level, b, binLabel.c_str(), binValue,
-                              indexInProj);
-                    // // check if binlabel is "mass"
-                    // if (binLabel.compare("mass") == 0) {
-                    //   NLogInfo("[L%d]   Checking bin 'mass' = %f ...", level, binValue);
-                    //   if (binValue < 1.015 || binValue > 1.025) {
-                    //     NLogInfo("[L%d]   Skipping bin 'mass' with value %f ...", level, binValue);
-                    //     continue;
-                    //   }
-                    // }
-                    // obj->GetParent()->SetParameter(binLabel, binValue, indexInProj);
-                    // fParent->SetParameter(binLabel, binValue, indexInProj);
-                    current->SetParameter(binLabel, binValue, indexInProj);
-                    current->SetParameterError(binLabel, binError, indexInProj);
-                    NLogTrace("[L%d]   Stored parameter '%s' = %e +/- %e at indexInProj=%d", level, binLabel.c_str(),
-                              binValue, binError, indexInProj);
-                  }
-                }
-              }
-              else {
-                NLogWarning("NGnNavigator::Reshape: Branch '%s' Point parameters object is null !!!", key.c_str());
+            NLogTrace("[L%d] Histogram name='%s' title='%s' for branch '%s' storing with indexInProj=%d, entries=%.0f",
+                      fLevel, name.c_str(), hProjTmp->GetTitle(), key.c_str(), indexInProj, hProjTmp->GetEntries());
+            if (fObjectContentMap[name].size() != nCells) ResizeObjectContentMap(name, nCells);
+            // Clone the histogram so the navigator owns it independently of the TTree branch
+            // buffer. ROOT clears TList branch objects on every GetEntry() call, which would
+            // leave the stored pointer dangling if we don't clone here.
+            TH1 * hClone = (TH1 *)hProjTmp->Clone();
+            hClone->SetDirectory(nullptr);
+            SetObject(name, hClone, indexInProj);
+          }
+          if (isValid == false) {
+            NLogTrace("NGnNavigator::FillCells::Warning: Branch '%s' TList does not contain any valid histograms !!!",
+                      key.c_str());
+            continue;
+          }
+        }
+        else if (className.BeginsWith("Ndmspc::NParameters")) {
+
+          NParameters * parameters = dynamic_cast<NParameters *>(val.GetObject());
+          if (parameters) {
+            TH1 * hParams = parameters->GetHisto();
+            if (hParams) {
+              NLogTrace("[L%d] Branch '%s' Point contains '_params' histogram with %.0f entries ...", fLevel,
+                        key.c_str(), hParams->GetEntries());
+              // loop over bin labels
+              for (int b = 1; b <= hParams->GetNbinsX(); b++) {
+
+                std::string binLabel = hParams->GetXaxis()->GetBinLabel(b);
+                double      binValue = hParams->GetBinContent(b);
+                double      binError = hParams->GetBinError(b);
+                SetParameter(binLabel, binValue, indexInProj);
+                SetParameterError(binLabel, binError, indexInProj);
+                NLogTrace("[L%d]   Stored parameter '%s' = %e +/- %e at indexInProj=%d", fLevel, binLabel.c_str(),
+                          binValue, binError, indexInProj);
               }
             }
-            else {
-              NLogWarning("NGnNavigator::Reshape: Branch '%s' has unsupported class '%s' !!! Skipping ...", key.c_str(),
-                          className.Data());
-            }
+          }
+          else {
+            NLogWarning("NGnNavigator::FillCells: Branch '%s' Point parameters object is null !!!", key.c_str());
           }
         }
-
-        // Reshape(binningDef, levels, level + 1, rangesTmp, rangesBaseTmp, currentChild);
-        // return;
+        else {
+          NLogWarning("NGnNavigator::FillCells: Branch '%s' has unsupported class '%s' !!! Skipping ...", key.c_str(),
+                      className.Data());
+        }
       }
-      if (current->GetChildren().size() != nCells) current->SetChildrenSize(nCells);
-      current->SetChild(currentChild, indexInProj); // Set the child at the index
-      // execute next child
-      Reshape(binningDef, levels, level + 1, rangesTmp, rangesBaseTmp, currentChild);
-    };
-    executorBin.Execute(loop_task_bin);
+    }
+
+    // Cells with entries get an (empty) navigator of the level below
+    if (fChildren.size() != nCells) SetChildrenSize(nCells);
+    if (fChildren[indexInProj] == nullptr) {
+      NGnNavigator * child = NewChild(indexInProj, rangesTmp, rangesBaseTmp);
+      child->fMaterialized = true;
+    }
   }
-  else {
-    NLogTrace("NGnNavigator::Reshape: Reached the end of levels, level=%d", level);
-    std::vector<std::vector<int>> rangesEmpty;
-    NUtils::SetAxisRanges(binningDef->GetContent(), rangesEmpty); // Set the ranges for the axes
+  storage->StopReadAhead();
 
-    return current;
+  for (auto & [branch, status] : outputPointStatus) branch->SetBranchStatus(status);
+}
+
+void NGnNavigator::GetCellRanges(const std::vector<int> & coords, std::map<int, std::vector<int>> & ranges,
+                                 std::map<int, std::vector<int>> & rangesBase) const
+{
+  ///
+  /// Returns content and base axis ranges of a cell of the projection
+  ///
+  std::vector<int> axesIds = GetRoot()->GetLevels()[fLevel];
+
+  ranges     = fRanges;
+  rangesBase = fRangesBase;
+  int minBase = 0, maxBase = 0;
+  for (size_t i = 0; i < coords.size() && i < axesIds.size(); i++) {
+    NUtils::GetAxisRangeInBase(fBinningDef->GetAxis(axesIds[i]), coords[i], coords[i],
+                               fBinningDef->GetBinning()->GetAxes()[axesIds[i]], minBase, maxBase);
+    NLogTrace("NGnNavigator::GetCellRanges: Axis %d: minBase=%d maxBase=%d", axesIds[i], minBase, maxBase);
+    ranges[axesIds[i]]     = {coords[i], coords[i]};
+    rangesBase[axesIds[i]] = {minBase, maxBase};
   }
+}
 
-  NLogTrace("NGnNavigator::Reshape: =========== Reshaping navigator for level %d DONE ================", level);
+NGnNavigator * NGnNavigator::NewChild(size_t index, const std::map<int, std::vector<int>> & ranges,
+                                      const std::map<int, std::vector<int>> & rangesBase)
+{
+  ///
+  /// Create (not built) child navigator of a cell
+  ///
+  NGnNavigatorCache * cache     = GetRoot()->fCache;
+  std::string         childName = TString::Format("%s_L%zu_C%zu", cache ? cache->baseName.c_str() : GetName(),
+                                                  fLevel + 1, index)
+                              .Data();
+  NLogTrace("NGnNavigator::NewChild: [L%d] Creating new child '%s' for index %zu ...", fLevel, childName.c_str(),
+            index);
+  NGnNavigator * child = new NGnNavigator(childName.c_str(), childName.c_str());
+  child->SetLevel(fLevel + 1);
+  child->SetNLevels(fNLevels);
+  child->SetGnTree(fGnTree);
+  child->fBinningDef = fBinningDef;
+  child->fRanges     = ranges;
+  child->fRangesBase = rangesBase;
+  SetChild(child, index);
+  return child;
+}
 
-  if (level == 0) {
-    NLogInfo("NGnNavigator::Reshape: Reshaping navigator DONE.");
-    // print exported axes from indexes from levels
-    for (size_t l = 0; l < levels.size(); l++) {
-      std::string axesStr = "";
-      for (auto & a : levels[l]) {
-        TAxis * axis = binningDef->GetContent()->GetAxis(a);
-        axesStr += TString::Format("%d('%s') ", a, axis->GetName()).Data();
-      }
-      NLogInfo("  Level %zu axes: %s", l, axesStr.c_str());
+NGnNavigator * NGnNavigator::BuildChild(size_t index, bool prefetch)
+{
+  ///
+  /// Returns child at given index, builds it on first access
+  ///
+  if (!fMaterialized) {
+    if (!Materialize()) return nullptr;
+    Touch();
+  }
+  if (index >= fChildren.size()) return nullptr;
+
+  NGnNavigator * child = fChildren[index];
+  if (child == nullptr && fBinningDef && fLevel + 1 < fNLevels && fProjection) {
+    // Only cells inside of the projection have children
+    Int_t bx = 0, by = 0, bz = 0;
+    fProjection->GetBinXYZ(index, bx, by, bz);
+    std::vector<int> coords{bx, by, bz};
+    coords.resize(fProjection->GetDimension());
+    const TAxis * axes[3] = {fProjection->GetXaxis(), fProjection->GetYaxis(), fProjection->GetZaxis()};
+    for (size_t i = 0; i < coords.size(); i++) {
+      if (coords[i] < 1 || coords[i] > axes[i]->GetNbins()) return nullptr;
     }
+    std::map<int, std::vector<int>> ranges;
+    std::map<int, std::vector<int>> rangesBase;
+    GetCellRanges(coords, ranges, rangesBase);
+    child = NewChild(index, ranges, rangesBase);
   }
+  if (child == nullptr) return nullptr;
 
-  if (branch) branch->SetBranchStatus(outputPointStatus);
+  if (!child->fMaterialized) child->Materialize();
+  child->Touch();
+  if (prefetch) SchedulePrefetch(index);
+  return child;
+}
 
-  // current->Print("");
+void NGnNavigator::BuildAll()
+{
+  ///
+  /// Build the whole hierarchy below the navigator
+  ///
+  for (size_t i = 0; i < fChildren.size(); i++) {
+    NGnNavigator * child = BuildChild(i, false);
+    if (child && child->GetLevel() < fNLevels) child->BuildAll();
+  }
+}
 
-  return current;
+void NGnNavigator::Release()
+{
+  ///
+  /// Release projection, objects and parameters of the node (children are kept)
+  ///
+  NLogTrace("NGnNavigator::Release: Releasing navigator '%s' ...", GetName());
+  if (fProjection) {
+    fProjection->SetDirectory(nullptr);
+    delete fProjection;
+    fProjection = nullptr;
+  }
+  for (auto & [key, vec] : fObjectContentMap) {
+    for (TObject * obj : vec) {
+      delete obj;
+    }
+  }
+  fObjectContentMap.clear();
+  fParameterContentMap.clear();
+  fParameterErrorContentMap.clear();
+  fMaterialized = false;
+}
+
+void NGnNavigator::Touch()
+{
+  ///
+  /// Mark node as recently used and release least recently used nodes over the limit
+  ///
+  NGnNavigator *      root  = GetRoot();
+  NGnNavigatorCache * cache = root->fCache;
+  if (cache == nullptr || root == this || fLevel >= fNLevels) return;
+
+  // Ancestors are moved in front of the node, so descendants are always released before their ancestors
+  for (NGnNavigator * node = this; node != root; node = node->GetParent()) {
+    auto it = cache->positions.find(node);
+    if (it != cache->positions.end()) {
+      cache->nodes.splice(cache->nodes.begin(), cache->nodes, it->second);
+    }
+    else {
+      cache->positions[node] = cache->nodes.insert(cache->nodes.begin(), node);
+    }
+  }
+  while (cache->maxNodes > 0 && cache->nodes.size() > cache->maxNodes) {
+    NGnNavigator * node = cache->nodes.back();
+    cache->nodes.pop_back();
+    cache->positions.erase(node);
+    node->Release();
+  }
+}
+
+void NGnNavigator::SchedulePrefetch(size_t index)
+{
+  ///
+  /// Queue neighbours of selected cell to be built from the event loop
+  ///
+  NGnNavigatorCache * cache = GetRoot()->fCache;
+  if (cache == nullptr || cache->prefetch <= 0 || fProjection == nullptr || fLevel + 1 >= fNLevels) return;
+
+  // Neighbours of the previous selection are not needed anymore
+  cache->queue.clear();
+  Int_t c[3] = {0, 0, 0};
+  fProjection->GetBinXYZ(index, c[0], c[1], c[2]);
+  const TAxis * axes[3] = {fProjection->GetXaxis(), fProjection->GetYaxis(), fProjection->GetZaxis()};
+  for (Int_t d = 0; d < fProjection->GetDimension(); d++) {
+    for (Int_t delta = -cache->prefetch; delta <= cache->prefetch; delta++) {
+      Int_t n[3] = {c[0], c[1], c[2]};
+      n[d] += delta;
+      if (delta == 0 || n[d] < 1 || n[d] > axes[d]->GetNbins()) continue;
+      const size_t neighbour = fProjection->GetBin(n[0], n[1], n[2]);
+      if (neighbour < fChildren.size() && fChildren[neighbour] && fChildren[neighbour]->fMaterialized) continue;
+      cache->queue.emplace_back(this, neighbour);
+    }
+  }
+  if (cache->queue.empty()) return;
+  if (cache->timer == nullptr) cache->timer = new TTimer(GetRoot(), 10);
+  cache->timer->TurnOn();
+}
+
+size_t NGnNavigator::Prefetch(size_t n)
+{
+  ///
+  /// Build up to n queued neighbours now
+  ///
+  NGnNavigatorCache * cache = GetRoot()->fCache;
+  if (cache == nullptr) return 0;
+  size_t done = 0;
+  while (done < n && !cache->queue.empty()) {
+    auto [parent, index] = cache->queue.front();
+    cache->queue.pop_front();
+    parent->BuildChild(index, false);
+    done++;
+  }
+  if (cache->queue.empty() && cache->timer) cache->timer->TurnOff();
+  return done;
+}
+
+Bool_t NGnNavigator::HandleTimer(TTimer * /*timer*/)
+{
+  ///
+  /// Build one queued neighbour per tick of the event loop
+  ///
+  Prefetch(1);
+  return kTRUE;
+}
+
+size_t NGnNavigator::GetNMaterialized() const
+{
+  ///
+  /// Returns number of built navigators kept below the root
+  ///
+  NGnNavigatorCache * cache = GetRoot()->fCache;
+  return cache ? cache->nodes.size() : 0;
 }
 
 void NGnNavigator::Export(const std::string & filename, std::vector<std::string> objectNames, const std::string & wsUrl,
@@ -834,7 +923,7 @@ void NGnNavigator::Export(const std::string & filename, std::vector<std::string>
   }
 }
 
-void NGnNavigator::ExportToJson(json & j, NGnNavigator * obj, std::vector<std::string> objectNames)
+void NGnNavigator::ExportToJson(json & j, NGnNavigator * obj, std::vector<std::string> objectNames, bool builtOnly)
 {
   ///
   /// Export NGnNavigator to JSON object
@@ -1012,11 +1101,18 @@ void NGnNavigator::ExportToJson(json & j, NGnNavigator * obj, std::vector<std::s
   std::map<std::string, double> paramMinGlobal;
   std::map<std::string, double> paramMaxGlobal;
   bool                          firstChild = true;
-  for (const auto & child : obj->GetChildren()) {
+  for (size_t i = 0; i < obj->GetChildren().size(); i++) {
+    // Children not built yet are built now (and may be released again after export), unless only built ones
+    // are exported
+    NGnNavigator * child = nullptr;
+    if (!builtOnly)
+      child = obj->BuildChild(i, false);
+    else if (obj->fChildren[i] && obj->fChildren[i]->IsMaterialized())
+      child = obj->fChildren[i];
     json childJson;
     if (child != nullptr) {
       try {
-        ExportToJson(childJson, child, objectNames);
+        ExportToJson(childJson, child, objectNames, builtOnly);
       }
       catch (...) {
         NLogWarning("NGnNavigator::ExportJson: Exception in recursive ExportToJson for child.");
@@ -1131,7 +1227,7 @@ void NGnNavigator::Print(Option_t * option) const
     for (size_t l = 0; l < fLevels.size(); l++) {
       std::string axesStr = "";
       for (auto & a : fLevels[l]) {
-        TAxis * axis = binningDef->GetContent()->GetAxis(a);
+        TAxis * axis = binningDef->GetAxis(a);
         axesStr += TString::Format("%d('%s') ", a, axis->GetName()).Data();
       }
       NLogInfo("  Level %zu axes: %s", l, axesStr.c_str());
@@ -1162,6 +1258,28 @@ void NGnNavigator::Print(Option_t * option) const
   }
 }
 
+std::string NGnNavigator::GetCacheKey() const
+{
+  ///
+  /// Get key identifying cells shown by navigator
+  ///
+  std::string key;
+  if (fGnTree && fGnTree->GetBinning()) {
+    NBinning * binning = fGnTree->GetBinning();
+    for (const auto & name : binning->GetDefinitionNames()) {
+      if (binning->GetDefinition(name) == fBinningDef) {
+        key = name;
+        break;
+      }
+    }
+  }
+  key += "/" + json(GetRoot()->GetLevels()).dump() + "/";
+  for (const auto & [axisId, range] : fRangesBase) {
+    key += TString::Format("%d[%d,%d]", axisId, range[0], range[1]).Data();
+  }
+  return key;
+}
+
 json NGnNavigator::GetInfoJson() const
 {
   ///
@@ -1344,7 +1462,7 @@ void NGnNavigator::ExecuteEvent(Int_t event, Int_t px, Int_t py)
               "level=%d nLevels=%d",
               gPad->GetName(), binx, biny, x_user, y_user, content, fLevel, fNLevels);
 
-    int nDimensions = fGnTree->GetBinning()->GetDefinition()->GetContent()->GetNdimensions();
+    int nDimensions = fGnTree->GetBinning()->GetDefinition()->GetNdimensions();
 
     Int_t index = fProjection->FindFixBin(fProjection->GetXaxis()->GetBinCenter(binx),
                                           fProjection->GetYaxis()->GetBinCenter(biny));
@@ -1440,10 +1558,10 @@ void NGnNavigator::ExecuteEvent(Int_t event, Int_t px, Int_t py)
 NGnNavigator * NGnNavigator::GetChild(size_t index) const
 {
   ///
-  /// Returns child object at given index
+  /// Returns child object at given index (built on first access)
   ///
   NLogTrace("NGnNavigator::GetChild: index=%d, size=%zu", index, fChildren.size());
-  return (index < fChildren.size()) ? fChildren[index] : nullptr;
+  return const_cast<NGnNavigator *>(this)->BuildChild(index, true);
 }
 
 void NGnNavigator::SetChild(NGnNavigator * child, int index)
@@ -1464,9 +1582,10 @@ NGnNavigator * NGnNavigator::GetChild(std::vector<std::vector<size_t>> coords) c
   ///
 
   NGnNavigator * next;
+  if (!fMaterialized && !const_cast<NGnNavigator *>(this)->Materialize()) return nullptr;
 
   NBinningDef * binningDef    = fGnTree->GetBinning()->GetDefinition();
-  THnSparse *   hnsObjContent = binningDef->GetContent();
+  THnSparse *   hnsObjContent = binningDef->GetContentTemplate(); // only axis ranges are set
 
   std::vector<std::vector<int>> ranges;
   NGnNavigator *                root = GetRoot();
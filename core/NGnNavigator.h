@@ -9,6 +9,8 @@
 #include "NGnTree.h"
 namespace Ndmspc {
 
+struct NGnNavigatorCache;
+
 /**
  * @class NGnNavigator
  * @brief Navigator object for managing hierarchical data structures and projections.
@@ -17,6 +19,13 @@ namespace Ndmspc {
  * in a hierarchical tree structure. Supports projections, children/parent relationships,
  * and integration with NBinningDef and NGnTree.
  *
+ * Reshape() builds only the root. Children with their projections (and, on the last level, the
+ * objects and parameters of the cells) are built when GetChild() reaches them. At most
+ * NDMSPC_NAVIGATOR_CACHE_SIZE built navigators (default 256, 0 = unlimited) are kept; the least
+ * recently used are released and rebuilt on next access. Neighbours of the selected cell
+ * (NDMSPC_NAVIGATOR_PREFETCH bins, default 1, 0 = disabled) are built from the event loop.
+ * NDMSPC_NAVIGATOR_LAZY=0 builds the whole hierarchy in Reshape().
+ *
  * @author Martin Vala <mvala@cern.ch>
  */
 class NGnNavigator : public TNamed {
@@ -76,8 +85,9 @@ class NGnNavigator : public TNamed {
    * @param j JSON object to fill.
    * @param obj Navigator object to export.
    * @param objectNames Names of objects to export.
+   * @param builtOnly Export only children which are already built (others are null), nothing is projected.
    */
-  void ExportToJson(json & j, NGnNavigator * obj, std::vector<std::string> objectNames);
+  void ExportToJson(json & j, NGnNavigator * obj, std::vector<std::string> objectNames, bool builtOnly = false);
 
   /**
    * @brief Print navigator information.
@@ -166,7 +176,7 @@ class NGnNavigator : public TNamed {
 
   /**
    * @brief Get vector of child navigators.
-   * @return Vector of NGnNavigator pointers.
+   * @return Vector of NGnNavigator pointers (nullptr for children not built yet, use GetChild()).
    */
   std::vector<NGnNavigator *> GetChildren() const { return fChildren; }
 
@@ -177,7 +187,7 @@ class NGnNavigator : public TNamed {
   void SetChildrenSize(size_t n) { fChildren.resize(n); }
 
   /**
-   * @brief Get child navigator at index.
+   * @brief Get child navigator at index, building it on first access.
    * @param index Child index.
    * @return Pointer to child NGnNavigator.
    */
@@ -445,6 +455,41 @@ class NGnNavigator : public TNamed {
    */
   void SetLastHoverBin(size_t b) { fLastHoverBin = b; }
 
+  /**
+   * @brief Get key identifying cells shown by navigator.
+   *
+   * Built from binning definition, axes of levels and base axis ranges, so navigators of different
+   * Reshape() calls showing the same cells have the same key (used to cache serialized payloads).
+   * @return Key string.
+   */
+  std::string GetCacheKey() const;
+
+  /**
+   * @brief Check if projection and objects of navigator are built.
+   * @return True if built.
+   */
+  bool IsMaterialized() const { return fMaterialized; }
+
+  /**
+   * @brief Get number of built navigators kept below the root.
+   * @return Number of navigators.
+   */
+  size_t GetNMaterialized() const;
+
+  /**
+   * @brief Build queued neighbours of the selected cell now.
+   * @param n Maximum number of neighbours to build.
+   * @return Number of queued neighbours processed.
+   */
+  size_t Prefetch(size_t n = 1);
+
+  /**
+   * @brief Build one queued neighbour (prefetch timer of the root).
+   * @param timer Timer.
+   * @return Always true.
+   */
+  virtual Bool_t HandleTimer(TTimer * timer) override;
+
   // /**
   //  * @brief Open navigator from file.
   //  * @param filename File name.
@@ -465,6 +510,35 @@ class NGnNavigator : public TNamed {
   // static NGnNavigator * Open(TTree * tree, const std::string & branches = "", TFile * file = nullptr);
 
   private:
+  /// Builds projection of the navigator and, on the last level, objects and parameters of its cells.
+  bool Materialize();
+
+  /// Fills objects and parameters of all cells from the tree entries (last level only).
+  void FillCells();
+
+  /// Returns content and base axis ranges of a projection cell.
+  void GetCellRanges(const std::vector<int> & coords, std::map<int, std::vector<int>> & ranges,
+                     std::map<int, std::vector<int>> & rangesBase) const;
+
+  /// Creates (not built) child navigator of a cell.
+  NGnNavigator * NewChild(size_t index, const std::map<int, std::vector<int>> & ranges,
+                          const std::map<int, std::vector<int>> & rangesBase);
+
+  /// Returns child at index, building it on first access. Neighbours are queued for prefetch if requested.
+  NGnNavigator * BuildChild(size_t index, bool prefetch);
+
+  /// Builds the whole hierarchy below the navigator.
+  void BuildAll();
+
+  /// Releases projection, objects and parameters (children are kept and rebuilt on access).
+  void Release();
+
+  /// Marks navigator and its ancestors as recently used and releases navigators over the limit.
+  void Touch();
+
+  /// Queues neighbours of the selected cell to be built from the event loop.
+  void SchedulePrefetch(size_t index);
+
   NGnTree *                                     fGnTree{nullptr};            ///<! Pointer to the NGnTree
   std::vector<std::string>                      fObjectNames{};              ///< Object names
   std::map<std::string, std::vector<TObject *>> fObjectContentMap{};         ///< Object content map
@@ -485,6 +559,12 @@ class NGnNavigator : public TNamed {
   size_t                        fLastIndexSelected{0};  ///< last selected index in the object
   Int_t                         fTrigger{kButton1Down}; ///< last triggered event
 
+  NBinningDef *                   fBinningDef{nullptr}; ///<! Binning definition the navigator is built from
+  std::map<int, std::vector<int>> fRanges{};            ///<! Content axis ranges of the navigator
+  std::map<int, std::vector<int>> fRangesBase{};        ///<! Base axis ranges of the navigator
+  bool                            fMaterialized{false}; ///<! Projection and objects are built
+  NGnNavigatorCache *             fCache{nullptr};      ///<! Lazy build state (root only)
+
   /// \cond CLASSIMP
   ClassDefOverride(NGnNavigator, 2);
   /// \endcond;
@@ -0,0 +1,59 @@
+#include <stdexcept>
+#include "NDimensionalExecutor.h"
+#include "NLogger.h"
+#include "NGnProcessSession.h"
+
+/// \cond CLASSIMP
+ClassImp(Ndmspc::NGnProcessSession);
+/// \endcond
+
+namespace Ndmspc {
+
+NGnProcessSession::NGnProcessSession() : TObject() {}
+
+NGnProcessSession::~NGnProcessSession()
+{
+  ///
+  /// Destructor
+  ///
+  Close();
+}
+
+bool NGnProcessSession::IsActive() const
+{
+  return fExecutor && fExecutor->IsProcessIpcActive();
+}
+
+void NGnProcessSession::Adopt(std::unique_ptr<NDimensionalExecutor> executor, size_t nProcesses)
+{
+  ///
+  /// Take ownership of a started executor
+  ///
+  Close();
+  fExecutor   = std::move(executor);
+  fNProcesses = nProcesses;
+}
+
+std::string NGnProcessSession::NextJob()
+{
+  return "s" + std::to_string(fNJobs++);
+}
+
+void NGnProcessSession::Close(bool abort)
+{
+  ///
+  /// Stop all workers and release the pool
+  ///
+  if (!fExecutor) return;
+  NLogDebug("NGnProcessSession::Close: Stopping %zu worker(s) after %zu job(s) ...", fNProcesses, fNJobs);
+  try {
+    fExecutor->FinishProcessIpc(abort);
+  }
+  catch (const std::exception & ex) {
+    NLogWarning("NGnProcessSession::Close: %s", ex.what());
+  }
+  fExecutor.reset();
+  fNProcesses = 0;
+}
+
+} // namespace Ndmspc
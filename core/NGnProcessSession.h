@@ -0,0 +1,88 @@
+#ifndef Ndmspc_NGnProcessSession_H
+#define Ndmspc_NGnProcessSession_H
+#include <memory>
+#include <string>
+#include <TObject.h>
+
+namespace Ndmspc {
+
+class NDimensionalExecutor;
+
+/**
+ * @class NGnProcessSession
+ * @brief Persistent pool of forked IPC workers shared by several NGnTree::Process calls.
+ *
+ * Attach the session with NGnTree::SetProcessSession() before calling Process().
+ * The first Process call forks the workers as usual; instead of stopping them at
+ * the end, the session keeps them alive. Later Process calls (also on other
+ * NGnTree objects) reconfigure the running workers with the new function,
+ * binning and output file through a RECONFIGURE message, which avoids paying
+ * for fork, ROOT initialisation and macro loading on every step.
+ *
+ * Only the IPC (fork) execution mode uses the session; thread and TCP modes
+ * ignore it. Each job carries the macro load generation of the supervisor
+ * (NUtils::GetMacroLoadGeneration()); when macros were opened after the workers
+ * were forked, they refuse the job and the pool is restarted. Code loaded by other
+ * means should be announced with NUtils::BumpMacroLoadGeneration().
+ *
+ * @author Martin Vala <mvala@cern.ch>
+ */
+class NGnProcessSession : public TObject {
+  public:
+  NGnProcessSession();
+  virtual ~NGnProcessSession();
+
+  /**
+   * @brief Check whether the session has running workers.
+   * @return True if workers are alive and can be reconfigured.
+   */
+  bool IsActive() const;
+
+  /**
+   * @brief Number of worker processes in the running pool.
+   * @return Process count (0 if not active).
+   */
+  size_t GetNProcesses() const { return fNProcesses; }
+
+  /**
+   * @brief Number of jobs run by this session so far.
+   * @return Job count.
+   */
+  size_t GetNJobs() const { return fNJobs; }
+
+  /**
+   * @brief Executor driving the pool (nullptr if not active).
+   * @return Pointer to the executor owned by this session.
+   */
+  NDimensionalExecutor * GetExecutor() const { return fExecutor.get(); }
+
+  /**
+   * @brief Take ownership of a started executor.
+   * @param executor Executor after StartProcessIpc().
+   * @param nProcesses Number of processes it started.
+   */
+  void Adopt(std::unique_ptr<NDimensionalExecutor> executor, size_t nProcesses);
+
+  /**
+   * @brief Start bookkeeping for the next job.
+   * @return Job tag, unique within the session, used to separate job output directories.
+   */
+  std::string NextJob();
+
+  /**
+   * @brief Stop all workers and release the pool.
+   * @param abort If true, abort running tasks.
+   */
+  void Close(bool abort = false);
+
+  private:
+  std::unique_ptr<NDimensionalExecutor> fExecutor;      //!< Executor owning the IPC session
+  size_t                                fNProcesses{0}; ///< Number of processes in the pool
+  size_t                                fNJobs{0};      ///< Number of jobs started
+
+  /// \cond CLASSIMP
+  ClassDef(NGnProcessSession, 1);
+  /// \endcond;
+};
+} // namespace Ndmspc
+#endif
@@ -2,7 +2,14 @@
 #include <NStorageTree.h>
 #include <TROOT.h>
 #include <TCanvas.h>
+#include <TDirectory.h>
+#include <TBufferFile.h>
+#include <cstdint>
+#include <cstring>
+#include <future>
 #include <mutex>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "THnSparse.h"
 #include "NBinningPoint.h"
 #include "NLogger.h"
@@ -14,8 +21,64 @@ ClassImp(Ndmspc::NGnThreadData);
 /// \endcond
 
 namespace Ndmspc {
+
+namespace {
+// Streamed chunks are sent early once they grow beyond this size, even when the
+// configured number of entries was not reached yet.
+constexpr size_t kStreamChunkMaxBytes = 16 * 1024 * 1024;
+
+// Blobs inside a streamed payload are prefixed with their 32-bit length.
+void AppendBlob(std::string & out, const TBufferFile & buf)
+{
+  const uint32_t len = static_cast<uint32_t>(buf.Length());
+  out.append(reinterpret_cast<const char *>(&len), sizeof(len));
+  out.append(buf.Buffer(), len);
+}
+
+bool NextBlob(const std::string & in, size_t & pos, const char *& data, uint32_t & len)
+{
+  if (pos + sizeof(len) > in.size()) return false;
+  std::memcpy(&len, in.data() + pos, sizeof(len));
+  pos += sizeof(len);
+  if (pos + len > in.size()) return false;
+  data = in.data() + pos;
+  pos += len;
+  return true;
+}
+
+// A persistent worker forked before the job functions were emitted (e.g. a lazily emitted lambda)
+// must not jump to them; only the start of the function is checked.
+constexpr size_t kFuncProbeBytes = 16;
+
+bool IsMapped(uintptr_t address, size_t size)
+{
+  const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t begin    = address & ~(pageSize - 1);
+  // msync() fails with ENOMEM for ranges which are not mapped
+  return msync(reinterpret_cast<void *>(begin), address + size - begin, MS_ASYNC) == 0;
+}
+} // namespace
+
 NGnThreadData::NGnThreadData() : NThreadData() {}
 NGnThreadData::~NGnThreadData() {}
+
+void NGnThreadData::ReleaseJob()
+{
+  ///
+  /// Delete objects of the previous job of a persistent worker (its storage must already be closed)
+  ///
+  if (fHnSparseBase) {
+    delete fHnSparseBase->GetInput();
+    fHnSparseBase->SetInput(nullptr);
+    // The clone made by Init() holds its own copies of the binning and the storage tree
+    fHnSparseBase->SetOwnsBinning(true);
+    fHnSparseBase->SetOwnsTreeStorage(true);
+    SafeDelete(fHnSparseBase);
+  }
+  if (fOwnsBiningSource) SafeDelete(fBiningSource);
+  fBiningSource     = nullptr;
+  fOwnsBiningSource = false;
+}
 bool NGnThreadData::Init(size_t id, NGnProcessFuncPtr func, NGnBeginFuncPtr funcBegin, NGnEndFuncPtr endFunc,
                          NGnTree * ngnt, NBinning * binningIn, NGnTree * input, const std::string & filename,
                          const std::string & treename)
@@ -114,8 +177,8 @@ bool NGnThreadData::Init(size_t id, NGnProcessFuncPtr func, NGnBeginFuncPtr func
   for (const auto & name : fHnSparseBase->GetBinning()->GetDefinitionNames()) {
     NBinningDef * def = fHnSparseBase->GetBinning()->GetDefinition(name);
     if (def) {
-      def->GetContent()->Reset();
-      def->GetIds().clear();
+      def->ResetContent();
+      def->ClearIds();
     }
   }
 
@@ -123,6 +186,8 @@ bool NGnThreadData::Init(size_t id, NGnProcessFuncPtr func, NGnBeginFuncPtr func
     NLogTrace("NGnThreadData::Init: Setting input NGnTree for thread %zu '%s'", id,
               input->GetStorageTree()->GetFileName().c_str());
     std::string branches = NUtils::Join(input->GetStorageTree()->GetBrancheNames(true), ',');
+    // The clone carries its own copy of the input description, which is replaced by the opened input
+    delete fHnSparseBase->GetInput();
     fHnSparseBase->SetInput(NGnTree::Open(input->GetStorageTree()->GetFileName(), branches)); // Set the input NGnTree
   }
 
@@ -213,7 +278,7 @@ void NGnThreadData::Process(const std::vector<int> & coords)
       monitorWorkers = fCfg["_ndmspc"]["workerCount"].get<int>();
     }
     fResourceMonitor = new NResourceMonitor();
-    fResourceMonitor->Initialize(binningDef->GetContent(), monitorWorkers);
+    fResourceMonitor->Initialize(binningDef->GetContentTemplate(), monitorWorkers);
     fHnSparseBase->GetOutput()->Add(fResourceMonitor->GetHnSparse());
   }
 
@@ -257,7 +322,7 @@ void NGnThreadData::Process(const std::vector<int> & coords)
         NUtils::GetCoordsString(NUtils::ArrayToVector(point->GetCoords(), point->GetNDimensionsContent())).c_str());
 
     if (!fIsPureCopy) {
-      ts->GetBranch("_outputPoint")->SetAddress(outputPoint); // Set the output list as branch address
+      ts->SetOutputPoint(outputPoint); // Set the output list objects as branch addresses
     }
     //
     // ts->Fill(point, nullptr, false, {}, false);
@@ -267,7 +332,29 @@ void NGnThreadData::Process(const std::vector<int> & coords)
       // NLogDebug("NGnThreadData::Process: Thread %zu: Filled %d bytes for coordinates %s entry=%lld",
       //                GetAssignedIndex(), bytes, NUtils::GetCoordsString(coords).c_str(), entry);
 
-      fHnSparseBase->GetBinning()->GetDefinition()->GetIds().push_back(entry);
+      fHnSparseBase->GetBinning()->GetDefinition()->AddId(entry);
+      if (fStreamChunkEntries > 0) {
+        // Serialize the entry exactly as it was written to the local tree.
+        std::vector<std::pair<std::string, TObject *>> branchObjects;
+        for (auto & kv : ts->GetBranchesMap()) {
+          if (kv.second.GetBranchStatus() == 0 || kv.second.GetObject() == nullptr) continue;
+          branchObjects.emplace_back(kv.first, kv.second.GetObject());
+        }
+        if (fStreamChunkCount == 0) {
+          TBufferFile header(TBuffer::kWrite);
+          header.WriteTString(fHnSparseBase->GetBinning()->GetCurrentDefinitionName().c_str());
+          AppendBlob(fStreamChunk, header);
+        }
+        TBufferFile buf(TBuffer::kWrite);
+        buf.WriteLong64(entry);
+        buf.WriteInt(static_cast<Int_t>(branchObjects.size()));
+        for (const auto & bo : branchObjects) {
+          buf.WriteTString(bo.first.c_str());
+          buf.WriteObject(bo.second);
+        }
+        AppendBlob(fStreamChunk, buf);
+        fStreamChunkCount++;
+      }
       // NLogInfo("Entry number in storage tree: %lld", point->GetEntryNumber());
       // fHnSparseBase->GetBinning()->GetDefinition()->GetIds().push_back(point->GetEntryNumber());
     }
@@ -326,216 +413,478 @@ void NGnThreadData::SyncCurrentDefinitionIds(const std::vector<Long64_t> & ids)
   // (e.g., even-indexed entries when onlyOddPoints=true) and corrupt the merge step.
   if (fHnSparseBase && fHnSparseBase->GetBinning()) {
     if (auto * def = fHnSparseBase->GetBinning()->GetDefinition()) {
-      def->GetIds().clear();
+      def->ClearIds();
     }
   }
   // Keep per-worker lookup IDs local; do not mutate shared source binning.
   fCurrentDefinitionIds = ids;
 }
 
-Long64_t NGnThreadData::Merge(TCollection * list)
+bool NGnThreadData::HasStreamChunk(bool flush) const
+{
+  if (fStreamChunkCount == 0) return false;
+  return flush || fStreamChunkCount >= fStreamChunkEntries || fStreamChunk.size() >= kStreamChunkMaxBytes;
+}
+
+bool NGnThreadData::Checkpoint()
 {
   ///
-  /// Merge function
+  /// Flush the worker output so that a restarted run can reuse the entries written so far
   ///
-  Long64_t nmerged = 0;
+  NStorageTree * ts = fHnSparseBase ? fHnSparseBase->GetStorageTree() : nullptr;
+  if (!ts) return false;
+  return ts->Checkpoint();
+}
 
-  NLogTrace("NGnThreadData::Merge: BEGIN ------------------------------------------------");
-  NLogTrace("NGnThreadData::Merge: Merging thread data from %zu threads ...", list->GetEntries());
+std::string NGnThreadData::TakeStreamChunk()
+{
+  std::string chunk;
+  chunk.swap(fStreamChunk);
+  fStreamChunkCount = 0;
+  return chunk;
+}
 
-  NStorageTree *                 ts = nullptr;
-  std::map<std::string, TList *> listOutputs;
+std::string NGnThreadData::SerializeOutputs() const
+{
+  std::string payload;
+  if (!fHnSparseBase) return payload;
+  for (auto & kv : fHnSparseBase->GetOutputs()) {
+    if (!kv.second || kv.second->IsEmpty()) continue;
+    TBufferFile buf(TBuffer::kWrite);
+    buf.WriteTString(kv.first.c_str());
+    buf.WriteObject(kv.second);
+    AppendBlob(payload, buf);
+  }
+  return payload;
+}
 
-  auto queueOutputListForMerge = [this, &listOutputs](const std::string & key, TList * src) {
-    if (!src || src->IsEmpty()) return;
+std::string NGnThreadData::SerializeJob(NGnProcessFuncPtr func, NGnBeginFuncPtr beginFunc, NGnEndFuncPtr endFunc,
+                                       NGnTree * ngnt, NBinning * binningIn, const std::string & treename,
+                                       const json & cfg)
+{
+  TBufferFile buf(TBuffer::kWrite);
+  buf.WriteULong64(NUtils::GetMacroLoadGeneration());
+  for (uintptr_t address : {reinterpret_cast<uintptr_t>(func), reinterpret_cast<uintptr_t>(beginFunc),
+                            reinterpret_cast<uintptr_t>(endFunc)}) {
+    buf.WriteULong64(address);
+  }
+  buf.WriteObject(ngnt);
+  buf.WriteObject(binningIn);
+  buf.WriteTString(treename.c_str());
+  buf.WriteTString(cfg.dump().c_str());
+  return std::string(buf.Buffer(), buf.Length());
+}
 
-    NLogTrace("NGnThreadData::Merge: Queuing output list '%s' with %d objects", key.c_str(), src->GetEntries());
-    if (listOutputs.find(key) == listOutputs.end()) {
-      listOutputs[key] = new TList();
-    }
+bool NGnThreadData::Reconfigure(const std::string & filename, const std::string & job)
+{
+  ///
+  /// Re-initialize a persistent worker for a new job
+  ///
+  TBufferFile buf(TBuffer::kRead, job.size(), const_cast<char *>(job.data()), kFALSE);
+  ULong64_t   generation = 0;
+  ULong64_t   funcs[3]   = {0, 0, 0};
+  buf.ReadULong64(generation);
+  for (int i = 0; i < 3; ++i) buf.ReadULong64(funcs[i]);
+  // Failing here makes the supervisor restart the workers, which then see the new code
+  if (generation != NUtils::GetMacroLoadGeneration()) {
+    NLogWarning("NGnThreadData::Reconfigure: [%zu] Macros were loaded after the worker was started (generation "
+                "%llu -> %llu) !!!",
+                GetAssignedIndex(), NUtils::GetMacroLoadGeneration(), generation);
+    return false;
+  }
+  for (int i = 0; i < 3; ++i) {
+    if (funcs[i] == 0 || IsMapped(funcs[i], kFuncProbeBytes)) continue;
+    NLogWarning("NGnThreadData::Reconfigure: [%zu] Function 0x%llx is not loaded in the worker !!!",
+                GetAssignedIndex(), funcs[i]);
+    return false;
+  }
+  auto *  ngnt      = static_cast<NGnTree *>(buf.ReadObject(NGnTree::Class()));
+  auto *  binningIn = static_cast<NBinning *>(buf.ReadObject(NBinning::Class()));
+  TString treename, cfg;
+  buf.ReadTString(treename);
+  buf.ReadTString(cfg);
+  if (!ngnt || !binningIn) {
+    NLogError("NGnThreadData::Reconfigure: [%zu] Failed to decode job description !!!", GetAssignedIndex());
+    if (ngnt) delete ngnt->GetInput();
+    delete ngnt;
+    delete binningIn;
+    return false;
+  }
 
-    if (fHnSparseBase->GetOutput(key)->IsEmpty()) {
-      // Seed merged output once; remaining contributor lists are merged below.
-      fHnSparseBase->GetOutput(key)->AddAll(src);
-    }
-    else {
-      listOutputs[key]->Add(src);
-    }
-  };
+  FlushDeferredDeletes();
+  ReleaseJob();
+  fNProcessed = 0;
+  fProcessedBinIds.clear();
+  fCurrentDefinitionIds.clear();
+  fDuplicateBinIds.clear();
+  fResultsFilename.clear();
 
-  // TList * listOut         = new TList();
-  TList * listTreeStorage = new TList();
+  try {
+    SetCfg(json::parse(cfg.Data()));
+  }
+  catch (const std::exception & e) {
+    NLogError("NGnThreadData::Reconfigure: [%zu] Invalid configuration: %s", GetAssignedIndex(), e.what());
+    delete ngnt->GetInput();
+    delete ngnt;
+    delete binningIn;
+    return false;
+  }
 
-  for (auto obj : *list) {
-    if (obj->IsA() == NGnThreadData::Class()) {
-      NGnThreadData * hnsttd = (NGnThreadData *)obj;
-      NLogDebug("NGnThreadData::Merge: Merging thread %zu processed %lld ...", hnsttd->GetAssignedIndex(),
-                hnsttd->GetNProcessed());
-      ts = hnsttd->GetHnSparseBase()->GetStorageTree();
-      if (!ts) {
-        NLogError("NGnThreadData::Merge: Storage tree is not set in NGnTree !!!");
-        continue;
-      }
-      // hnsttd->Print();
+  NLogDebug("NGnThreadData::Reconfigure: [%zu] New job writing to '%s'", GetAssignedIndex(), filename.c_str());
+  // Init() clones the tree description, so the decoded copy is not needed afterwards.
+  // The decoded binning stays in use as the binning source of this job.
+  fOwnsBiningSource = true;
+
+  const bool rc = Init(GetAssignedIndex(), reinterpret_cast<NGnProcessFuncPtr>(static_cast<uintptr_t>(funcs[0])),
+                       reinterpret_cast<NGnBeginFuncPtr>(static_cast<uintptr_t>(funcs[1])),
+                       reinterpret_cast<NGnEndFuncPtr>(static_cast<uintptr_t>(funcs[2])), ngnt, binningIn,
+                       ngnt->GetInput(), filename, treename.Data());
+  delete ngnt->GetInput();
+  delete ngnt;
+  return rc;
+}
 
-      for (auto & kv : hnsttd->GetHnSparseBase()->GetOutputs()) {
-        NLogTrace("NGnThreadData::Merge: Found in-memory output list '%s' with %d objects", kv.first.c_str(),
-                  kv.second ? kv.second->GetEntries() : 0);
-        queueOutputListForMerge(kv.first, kv.second);
-      }
+Long64_t NGnThreadData::AppendStreamedResults(const std::string & payload)
+{
+  ///
+  /// Append entries streamed by a remote worker, mirroring what Process() did on the worker
+  ///
+  if (!fHnSparseBase || !fBiningSource) {
+    NLogError("NGnThreadData::AppendStreamedResults: Thread data is not initialized !!!");
+    return -1;
+  }
+  fHasStreamedResults = true;
 
-      // if (fOutput == nullptr) {
-      //   fOutput = hnsttd->GetOutput();
-      // }
-      // else {
-      //   listOut->Add(hnsttd->GetOutput());
-      // }
-
-      const std::string mergeFilename =
-        hnsttd->GetResultsFilename().empty() ? ts->GetFileName() : hnsttd->GetResultsFilename();
-      NGnTree * hnsb = NGnTree::Open(mergeFilename);
-      if (!hnsb) {
-        NLogError("NGnThreadData::Merge: Failed to open NGnTree from file '%s' !!!", mergeFilename.c_str());
-        continue;
-      }
+  size_t       pos  = 0;
+  const char * data = nullptr;
+  uint32_t     len  = 0;
+  if (!NextBlob(payload, pos, data, len)) return payload.empty() ? 0 : -1;
 
-      // In IPC/process mode worker-side output lists live in the worker files,
-      // not in parent in-memory worker objects. Merge these lists explicitly.
-      for (auto & kv : hnsb->GetOutputs()) {
-        NLogTrace("NGnThreadData::Merge: Found file output list '%s' with %d objects from '%s'", kv.first.c_str(),
-                  kv.second ? kv.second->GetEntries() : 0, mergeFilename.c_str());
-        queueOutputListForMerge(kv.first, kv.second);
-      }
+  TString defName;
+  {
+    TBufferFile header(TBuffer::kRead, len, const_cast<char *>(data), kFALSE);
+    header.ReadTString(defName);
+  }
+  if (fHnSparseBase->GetBinning()->GetCurrentDefinitionName() != defName.Data()) {
+    // Late chunk of a speculative loser from an already finished definition.
+    NLogDebug("NGnThreadData::AppendStreamedResults: [%zu] Dropping chunk for definition '%s' (current '%s')",
+              GetAssignedIndex(), defName.Data(), fHnSparseBase->GetBinning()->GetCurrentDefinitionName().c_str());
+    return 0;
+  }
 
-      // hnsb->Print();
-      listTreeStorage->Add(hnsb->GetStorageTree());
+  NStorageTree *  ts       = fHnSparseBase->GetStorageTree();
+  NBinningPoint * point    = fHnSparseBase->GetBinning()->GetPoint();
+  Long64_t        nEntries = 0;
+  point->SetTreeStorage(ts);
+  while (pos < payload.size()) {
+    if (!NextBlob(payload, pos, data, len)) {
+      NLogError("NGnThreadData::AppendStreamedResults: [%zu] Truncated chunk payload", GetAssignedIndex());
+      return -1;
+    }
+    TBufferFile buf(TBuffer::kRead, len, const_cast<char *>(data), kFALSE);
+    Long64_t    entry     = -1;
+    Int_t       nBranches = 0;
+    buf.ReadLong64(entry);
+    buf.ReadInt(nBranches);
+    std::vector<std::pair<std::string, TObject *>> branchObjects;
+    for (Int_t i = 0; i < nBranches; ++i) {
+      TString name;
+      buf.ReadTString(name);
+      branchObjects.emplace_back(name.Data(), buf.ReadObject(TObject::Class()));
+    }
 
-      // TODO: check if needed
-      // fHnSparseBase->GetBinning()->GetDefinition()->GetContent()->Add(
-      //     hnsb->GetBinning()->GetDefinition()->GetContent());
-      nmerged++;
+    if (fProcessedBinIds.insert(entry).second) {
+      fBiningSource->GetContent()->GetBinContent(entry, point->GetCoords());
+      point->RecalculateStorageCoords(entry, false);
+
+      std::vector<std::pair<NTreeBranch *, TObject *>> previous;
+      for (const auto & bo : branchObjects) {
+        if (!bo.second) continue;
+        NTreeBranch * b = ts->GetBranch(bo.first);
+        if (!b) {
+          ts->AddBranch(bo.first, nullptr, bo.second->ClassName());
+          b = ts->GetBranch(bo.first);
+        }
+        previous.emplace_back(b, b->GetObject());
+        b->SetAddress(bo.second);
+      }
+      if (ts->Fill(point, nullptr, false, {}, false) > 0) {
+        fHnSparseBase->GetBinning()->GetDefinition()->AddId(entry);
+        nEntries++;
+      }
+      // Keep supervisor-owned objects (e.g. parameters) attached to their branches.
+      for (auto & p : previous) p.first->SetAddress(p.second);
+    }
+    else {
+      NLogDebug("NGnThreadData::AppendStreamedResults: [%zu] Entry %lld already appended, skipping ...",
+                GetAssignedIndex(), entry);
     }
+    for (auto & bo : branchObjects) delete bo.second;
   }
+  NLogTrace("NGnThreadData::AppendStreamedResults: [%zu] Appended %lld entries", GetAssignedIndex(), nEntries);
+  return nEntries;
+}
 
+bool NGnThreadData::AddStreamedOutputs(const std::string & payload)
+{
+  if (!fHnSparseBase) return false;
+  fHasStreamedResults = true;
+
+  size_t       pos  = 0;
+  const char * data = nullptr;
+  uint32_t     len  = 0;
+  while (pos < payload.size()) {
+    if (!NextBlob(payload, pos, data, len)) {
+      NLogError("NGnThreadData::AddStreamedOutputs: [%zu] Truncated output payload", GetAssignedIndex());
+      return false;
+    }
+    TBufferFile buf(TBuffer::kRead, len, const_cast<char *>(data), kFALSE);
+    TString     key;
+    buf.ReadTString(key);
+    TList * src = dynamic_cast<TList *>(buf.ReadObject(TList::Class()));
+    if (!src) {
+      NLogError("NGnThreadData::AddStreamedOutputs: [%zu] Cannot decode output list '%s'", GetAssignedIndex(),
+                key.Data());
+      return false;
+    }
+    src->SetOwner(kTRUE);
+    TList * target = fHnSparseBase->GetOutput(key.Data());
+    // A worker sends its outputs once, at the end; replace what the supervisor-side copy holds.
+    target->Delete();
+    TObject * obj = nullptr;
+    while ((obj = src->First())) {
+      src->Remove(obj);
+      target->Add(obj);
+    }
+    delete src;
+  }
+  return true;
+}
 
-  // for (const auto & name : fBiningSource->GetDefinitionNames()) {
-  //   auto binningDef = fBiningSource->GetDefinition(name);
-  //   if (!binningDef) {
-  //     NLogError("NGnThreadData::Merge: Binning definition '%s' not found in NGnTree !!!", name.c_str());
-  //     continue;
-  //   }
-  //   // add ids from fBiningSource to binningDef
-  //   // binningDef->GetIds().insert(binningDef->GetIds().end(), fBiningSource->GetDefinition(name)->GetIds().begin(),
-  //   //                             fBiningSource->GetDefinition(name)->GetIds().end());
-  //   NLogDebug("NGnThreadData::Merge: BEFORE Final IDs in definition '%s': %s", name.c_str(),
-  //             NUtils::GetCoordsString(binningDef->GetIds(), -1).c_str());
-  // }
+Long64_t NGnThreadData::Merge(TCollection * list)
+{
+  ///
+  /// Merge function
+  ///
+  NLogTrace("NGnThreadData::Merge: Merging thread data from %zu threads ...", list->GetEntries());
 
+  MergeBegin();
+  for (auto obj : *list) {
+    if (obj->IsA() == NGnThreadData::Class()) {
+      MergeAdd((NGnThreadData *)obj);
+    }
+  }
+  return MergeEnd();
+}
+
+void NGnThreadData::MergeBegin()
+{
+  ///
+  /// Prepare the merge target; workers can be added with MergeAdd() as soon as they finish
+  ///
+  NLogTrace("NGnThreadData::Merge: BEGIN ------------------------------------------------");
+  fMergeOutputs.clear();
+  fMergeSources.clear();
+  fMergeCount = 0;
 
   // FIXME: Fix this properly [it should be ok now]
   fHnSparseBase->GetBinning()->GetContent()->Reset();
-  // Print hnsb binning definition ids
   for (const auto & name : fBiningSource->GetDefinitionNames()) {
     NBinningDef * targetBinningDef = fBiningSource->GetDefinition(name);
     for (auto id : targetBinningDef->GetIds()) {
       NBinningPoint point(fHnSparseBase->GetBinning());
       fBiningSource->GetContent()->GetBinContent(id, point.GetCoords());
       Long64_t bin = fHnSparseBase->GetBinning()->GetContent()->GetBin(point.GetCoords());
-      NLogTrace("NGnThreadData::Merge: [%s] Adding def_id=%lld to content_bin=%lld",name.c_str(), id, bin);
+      NLogTrace("NGnThreadData::Merge: [%s] Adding def_id=%lld to content_bin=%lld", name.c_str(), id, bin);
       fHnSparseBase->GetBinning()->GetContent()->SetBinContent(bin, id);
     }
-    // fHnSparseBase->GetBinning()->GetDefinition(name)->Print();
   }
   // FIXME: End
-  NLogDebug("NGnThreadData::Merge: Total entries to merge: %lld", nmerged);
+  fHnSparseBase->GetStorageTree()->SetBinning(fHnSparseBase->GetBinning()); // Update binning to the merged one
+}
 
-  for (const auto & name : fHnSparseBase->GetBinning()->GetDefinitionNames()) {
-    auto binningDef = fHnSparseBase->GetBinning()->GetDefinition(name);
-    if (!binningDef) {
-      NLogError("NGnThreadData::Merge: Binning definition '%s' not found in NGnTree !!!", name.c_str());
-      continue;
-    }
-    // add ids from fBiningSource to binningDef
-    // binningDef->GetIds().insert(binningDef->GetIds().end(), fBiningSource->GetDefinition(name)->GetIds().begin(),
-    //                             fBiningSource->GetDefinition(name)->GetIds().end());
-    NLogTrace("NGnThreadData::Merge: Final IDs in definition '%s': %s", name.c_str(),
-              NUtils::GetCoordsString(binningDef->GetIds(), -1).c_str());
+bool NGnThreadData::MergeAdd(NGnThreadData * hnsttd)
+{
+  ///
+  /// Open a finished worker's output, queue its output lists and index its tree entries
+  ///
+  if (!hnsttd) return false;
+  NLogDebug("NGnThreadData::Merge: Merging thread %zu processed %lld ...", hnsttd->GetAssignedIndex(),
+            hnsttd->GetNProcessed());
+  NStorageTree * ts = hnsttd->GetHnSparseBase()->GetStorageTree();
+  if (!ts) {
+    NLogError("NGnThreadData::Merge: Storage tree is not set in NGnTree !!!");
+    return false;
   }
 
-  // fHnSparseBase->GetBinning()->GetContent()->Projection(5)->Print("all");
-  // NLogDebug("Not ready to merge, exiting ...");
-  // return 0;
+  // Workers may be added in any order (e.g. as they report DONE). Contributors are
+  // keyed by worker index so that MergeEnd() reduces them in a fixed order.
+  const size_t order = 2 * hnsttd->GetAssignedIndex();
+  for (auto & kv : hnsttd->GetHnSparseBase()->GetOutputs()) {
+    if (!kv.second || kv.second->IsEmpty()) continue;
+    NLogTrace("NGnThreadData::Merge: Found in-memory output list '%s' with %d objects", kv.first.c_str(),
+              kv.second->GetEntries());
+    fMergeOutputs[kv.first].emplace_back(order, kv.second);
+  }
 
-  NLogTrace("NGnThreadData::Merge: Merging %d storage trees ...", listTreeStorage->GetEntries());
-  // fHnSparseBase->GetBinning()->GetPoint()->Reset();
-  // fHnSparseBase->GetBinning()->GetDefinition("default")->Print();
-  // fHnSparseBase->GetBinning()->GetDefinition("b2")->Print();
-  fHnSparseBase->GetStorageTree()->SetBinning(fHnSparseBase->GetBinning()); // Update binning to the merged one
-  fHnSparseBase->GetStorageTree()->Merge(listTreeStorage);
-  // NLogDebug("Not ready to merge after Storage merge, exiting ...");
-  // return 0;
-
-  // loop over all output lists and merge them
-  for (auto & kv : listOutputs) {
-    // Diagnostics: print object names already present in the seeded target list.
-    {
-      std::vector<std::string> targetNames;
-      TList *                  targetOut = fHnSparseBase->GetOutput(kv.first);
-      if (targetOut) {
-        TObject * o = nullptr;
-        TIter     nextTarget(targetOut);
-        while ((o = nextTarget())) {
-          targetNames.push_back(o->GetName() ? o->GetName() : "");
-        }
-      }
-      NLogDebug("NGnThreadData::Merge: Output '%s' target has %zu object(s) before merge: %s", kv.first.c_str(),
-                targetNames.size(), NUtils::GetCoordsString(targetNames).c_str());
+  const std::string mergeFilename =
+      hnsttd->GetResultsFilename().empty() ? ts->GetFileName() : hnsttd->GetResultsFilename();
+  return MergeAddFile(mergeFilename, order + 1, {}, hnsttd->GetDuplicateBinIds());
+}
+
+bool NGnThreadData::MergeAddFile(const std::string & filename, size_t order, const std::set<Long64_t> & keepIds,
+                                 const std::set<Long64_t> & skipIds)
+{
+  ///
+  /// Open an output file, queue its output lists and index its tree entries
+  ///
+  NGnTree * hnsb = NGnTree::Open(filename);
+  if (!hnsb) {
+    NLogError("NGnThreadData::Merge: Failed to open NGnTree from file '%s' !!!", filename.c_str());
+    return false;
+  }
+  if (!skipIds.empty()) {
+    NLogDebug("NGnThreadData::Merge: Skipping %zu speculative duplicate entries from '%s'", skipIds.size(),
+              filename.c_str());
+    hnsb->GetStorageTree()->SetMergeSkipIds(skipIds);
+  }
+  if (!keepIds.empty()) {
+    NLogDebug("NGnThreadData::Merge: Keeping %zu checkpointed entries from '%s'", keepIds.size(), filename.c_str());
+    hnsb->GetStorageTree()->SetMergeKeepIds(keepIds);
+  }
+
+  // In IPC/process mode worker-side output lists live in the worker files,
+  // not in parent in-memory worker objects. Merge these lists explicitly.
+  for (auto & kv : hnsb->GetOutputs()) {
+    if (!kv.second || kv.second->IsEmpty()) continue;
+    NLogTrace("NGnThreadData::Merge: Found file output list '%s' with %d objects from '%s'", kv.first.c_str(),
+              kv.second->GetEntries(), filename.c_str());
+    fMergeOutputs[kv.first].emplace_back(order, kv.second);
+  }
+
+  fMergeSources.emplace_back();
+  if (fHnSparseBase->GetStorageTree()->BuildMergeIndex(hnsb->GetStorageTree(), fMergeSources.back()) < 0) {
+    NLogError("NGnThreadData::Merge: Failed to index entries of '%s' !!!", filename.c_str());
+    fMergeSources.pop_back();
+    hnsb->GetStorageTree()->Close(false);
+    return false;
+  }
+  fMergeCount++;
+  return true;
+}
+
+void NGnThreadData::MergeOutputList(const std::string & key, std::vector<std::pair<size_t, TList *>> & contributors)
+{
+  ///
+  /// Merge queued contributor lists into the output list 'key' by pairwise tree reduction
+  ///
+
+  std::stable_sort(contributors.begin(), contributors.end(),
+                   [](const auto & a, const auto & b) { return a.first < b.first; });
+
+  // Seed merged output once with the first contributor; the remaining ones are reduced into it.
+  TList * targetOut = fHnSparseBase->GetOutput(key);
+  size_t  first     = 0;
+  if (targetOut->IsEmpty() && !contributors.empty()) {
+    targetOut->AddAll(contributors.front().second);
+    first = 1;
+  }
+
+  // Diagnostics: print object names already present in the seeded target list.
+  {
+    std::vector<std::string> targetNames;
+    TObject *                o = nullptr;
+    TIter                    nextTarget(targetOut);
+    while ((o = nextTarget())) {
+      targetNames.push_back(o->GetName() ? o->GetName() : "");
     }
+    NLogDebug("NGnThreadData::Merge: Output '%s' target has %zu object(s) before merge: %s", key.c_str(),
+              targetNames.size(), NUtils::GetCoordsString(targetNames).c_str());
+  }
 
-    // Diagnostics: summarize every contributor list for this binning.
-    {
-      std::vector<std::string> contributorSummary;
-      if (kv.second) {
-        TIter nextList(kv.second);
-        while (auto * obj = nextList()) {
-          TList * src = dynamic_cast<TList *>(obj);
-          if (!src) continue;
-          std::vector<std::string> srcNames;
-          TIter                    nextObj(src);
-          while (auto * so = nextObj()) {
-            srcNames.push_back(so->GetName() ? so->GetName() : "");
-          }
-          contributorSummary.push_back(
-              TString::Format("[%d]%s", src->GetEntries(), NUtils::GetCoordsString(srcNames).c_str()).Data());
-        }
+  // Diagnostics: summarize every contributor list for this binning.
+  std::vector<TList *> lists{targetOut};
+  {
+    std::vector<std::string> contributorSummary;
+    for (size_t i = first; i < contributors.size(); ++i) {
+      TList * src = contributors[i].second;
+      lists.push_back(src);
+      std::vector<std::string> srcNames;
+      TIter                    nextObj(src);
+      while (auto * so = nextObj()) {
+        srcNames.push_back(so->GetName() ? so->GetName() : "");
       }
-      NLogDebug("NGnThreadData::Merge: Output '%s' has %zu contributor list(s): %s", kv.first.c_str(),
-                contributorSummary.size(), NUtils::GetCoordsString(contributorSummary).c_str());
+      contributorSummary.push_back(
+          TString::Format("[%d]%s", src->GetEntries(), NUtils::GetCoordsString(srcNames).c_str()).Data());
     }
+    NLogDebug("NGnThreadData::Merge: Output '%s' has %zu contributor list(s): %s", key.c_str(),
+              contributorSummary.size(), NUtils::GetCoordsString(contributorSummary).c_str());
+  }
 
-    if (kv.second && !kv.second->IsEmpty()) {
-      NLogTrace("NGnThreadData::Merge: Merging output list '%s' with %d objects", kv.first.c_str(),
-                kv.second->GetEntries() + 1);
-      fHnSparseBase->GetOutput(kv.first)->Merge(kv.second);
-      // fHnSparseBase->GetOutput(kv.first)->Print();
-    }
+  if (lists.size() > 1) {
+    NLogTrace("NGnThreadData::Merge: Merging output list '%s' from %zu lists", key.c_str(), lists.size());
+    NUtils::MergeListsPairwise(lists);
+  }
 
-    // Diagnostics: print final merged object names per binning.
-    {
-      std::vector<std::string> mergedNames;
-      TList *                  mergedOut = fHnSparseBase->GetOutput(kv.first);
-      if (mergedOut) {
-        TObject * o = nullptr;
-        TIter     nextMerged(mergedOut);
-        while ((o = nextMerged())) {
-          mergedNames.push_back(o->GetName() ? o->GetName() : "");
-        }
+  // Diagnostics: print final merged object names per binning.
+  {
+    std::vector<std::string> mergedNames;
+    TList *                  mergedOut = fHnSparseBase->GetOutput(key);
+    if (mergedOut) {
+      TObject * o = nullptr;
+      TIter     nextMerged(mergedOut);
+      while ((o = nextMerged())) {
+        mergedNames.push_back(o->GetName() ? o->GetName() : "");
       }
-      NLogInfo("NGnThreadData::Merge: Output '%s' merged to %zu object(s): %s", kv.first.c_str(), mergedNames.size(),
-               NUtils::GetCoordsString(mergedNames).c_str());
     }
+    NLogInfo("NGnThreadData::Merge: Output '%s' merged to %zu object(s): %s", key.c_str(), mergedNames.size(),
+             NUtils::GetCoordsString(mergedNames).c_str());
+  }
+}
+
+Long64_t NGnThreadData::MergeEnd()
+{
+  ///
+  /// Write the indexed entries in content order and merge the output lists
+  ///
+  NLogDebug("NGnThreadData::Merge: Total entries to merge: %lld", fMergeCount);
+
+  for (const auto & name : fHnSparseBase->GetBinning()->GetDefinitionNames()) {
+    auto binningDef = fHnSparseBase->GetBinning()->GetDefinition(name);
+    if (!binningDef) {
+      NLogError("NGnThreadData::Merge: Binning definition '%s' not found in NGnTree !!!", name.c_str());
+      continue;
+    }
+    NLogTrace("NGnThreadData::Merge: Final IDs in definition '%s': %s", name.c_str(),
+              NUtils::GetCoordsString(binningDef->GetIds(), -1).c_str());
+  }
+
+  // Output lists of different definitions are independent: merge them concurrently
+  // with each other and with the tree write below. GetOutput() may insert into the
+  // outputs map, so create all target lists before starting the tasks.
+  for (auto & kv : fMergeOutputs) fHnSparseBase->GetOutput(kv.first);
+  std::vector<std::future<void>> outputMerges;
+  outputMerges.reserve(fMergeOutputs.size());
+  // TH1::Merge and the tree write share gROOT and the TClass tables, and every task needs its own gDirectory.
+  // Without ROOT thread safety the merges are deferred and run one by one after the tree write.
+  const std::launch policy = NUtils::IsThreadSafetyEnabled() ? std::launch::async : std::launch::deferred;
+  if (!fMergeOutputs.empty() && policy == std::launch::deferred) {
+    NLogDebug("NGnThreadData::MergeEnd: ROOT thread safety is not enabled, merging output lists sequentially");
+  }
+  for (auto & kv : fMergeOutputs) {
+    outputMerges.push_back(std::async(policy, [this, &kv]() {
+      TDirectory::TContext context(nullptr); // merged histograms must not be attached to the output file
+      MergeOutputList(kv.first, kv.second);
+    }));
   }
 
+  NLogTrace("NGnThreadData::Merge: Merging %zu storage trees ...", fMergeSources.size());
+  fHnSparseBase->GetStorageTree()->MergeIndexed(fMergeSources);
+  fMergeSources.clear();
+
+  for (auto & f : outputMerges) f.get();
+  fMergeOutputs.clear();
+
   // Loop over binning definitions and merge their contents
   fHnSparseBase->GetStorageTree()->SetEnabledBranches({}, 0);
   for (const auto & name : fHnSparseBase->GetBinning()->GetDefinitionNames()) {
@@ -544,23 +893,15 @@ Long64_t NGnThreadData::Merge(TCollection * list)
       NLogError("NGnThreadData::Merge: Binning definition '%s' not found in NGnTree !!!", name.c_str());
       continue;
     }
-    // binningDef->Print();
     // Recalculate binningDef content based on ids
-    binningDef->GetContent()->Reset();
+    binningDef->ResetContent();
     for (auto id : binningDef->GetIds()) {
       fHnSparseBase->GetEntry(id, false);
-      Long64_t bin = binningDef->GetContent()->GetBin(fHnSparseBase->GetBinning()->GetPoint()->GetStorageCoords());
-      binningDef->GetContent()->SetBinContent(bin, id);
-      // binningDef->GetIds().push_back(id);
-      NLogTrace("NGnThreadData::Merge: -> Setting content bin %lld to id %lld", bin, id);
+      binningDef->SetContentAt(fHnSparseBase->GetBinning()->GetPoint()->GetStorageCoords(), id);
+      NLogTrace("NGnThreadData::Merge: -> Setting content to id %lld", id);
     }
   }
 
-  // // print all definitions
-  // for (const auto & name : fHnSparseBase->GetBinning()->GetDefinitionNames()) {
-  //   fHnSparseBase->GetBinning()->GetDefinition(name)->Print();
-  // }
-
   if (fHnSparseBase->GetInput()) {
     fHnSparseBase->GetInput()->Close(false);
   }
@@ -571,11 +912,7 @@ Long64_t NGnThreadData::Merge(TCollection * list)
   fHnSparseBase->GetBinning()->SetCurrentDefinitionName(fHnSparseBase->GetBinning()->GetDefinitionNames().front());
 
   NLogTrace("NGnThreadData::Merge: END ------------------------------------------------");
-
-  /// \cond CLASSIMP
-  // NLogError("NGnThreadData::Merge: Not implemented !!!");
-  /// \endcond;
-  return nmerged;
+  return fMergeCount;
 }
 
 void NGnThreadData::ExecuteBeginFunction()
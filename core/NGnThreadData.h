@@ -4,6 +4,8 @@
 // #include "NStorageTree.h"
 #include "NGnTree.h"
 #include "NThreadData.h"
+#include <algorithm>
+#include <set>
 #include <unordered_set>
 
 namespace Ndmspc {
@@ -106,6 +108,124 @@ class NGnThreadData : public NThreadData {
    */
   const std::string & GetResultsFilename() const { return fResultsFilename; }
 
+  /**
+   * @brief Mark a global bin id whose entry in this worker's output is a duplicate.
+   *
+   * Used for speculative re-execution: the losing copy's entry is skipped on merge.
+   * @param id Global bin id.
+   */
+  void AddDuplicateBinId(Long64_t id) { fDuplicateBinIds.insert(id); }
+
+  /**
+   * @brief Get global bin ids whose entries are skipped when merging this worker's output.
+   * @return Set of global bin ids.
+   */
+  const std::set<Long64_t> & GetDuplicateBinIds() const { return fDuplicateBinIds; }
+
+  /**
+   * @brief Enable result streaming on a worker (TCP mode).
+   *
+   * Every entry written by Process() is also serialized into an in-memory chunk
+   * which TaskLoop sends to the supervisor instead of copying the result file.
+   * @param chunkEntries Maximum number of entries per chunk (0 disables streaming).
+   * @param window Maximum number of chunks sent but not yet acknowledged by the supervisor.
+   */
+  void SetResultStreaming(size_t chunkEntries, size_t window)
+  {
+    fStreamChunkEntries = chunkEntries;
+    fStreamWindow       = std::max<size_t>(1, window);
+  }
+
+  /**
+   * @brief Set the minimum time between checkpoints of the worker output (IPC mode).
+   * @param seconds Interval in seconds (0 disables checkpointing).
+   */
+  void SetCheckpointInterval(double seconds) { fCheckpointInterval = seconds; }
+
+  /**
+   * @brief Get the minimum time between checkpoints.
+   * @return Interval in seconds (0 if checkpointing is disabled).
+   */
+  double GetCheckpointInterval() const { return fCheckpointInterval; }
+
+  /**
+   * @brief Make all entries written so far durable in the worker output file.
+   * @return True on success.
+   */
+  bool Checkpoint();
+
+  /**
+   * @brief Get the maximum number of unacknowledged streamed chunks.
+   * @return Backpressure window in chunks.
+   */
+  size_t GetResultStreamWindow() const { return fStreamWindow; }
+
+  /**
+   * @brief Check if result streaming is enabled on this worker.
+   * @return True if streaming is enabled.
+   */
+  bool IsResultStreaming() const { return fStreamChunkEntries > 0; }
+
+  /**
+   * @brief Check if a streamed result chunk is ready to be sent.
+   * @param flush When true, any non-empty chunk is reported as ready.
+   * @return True if TakeStreamChunk() should be called.
+   */
+  bool HasStreamChunk(bool flush) const;
+
+  /**
+   * @brief Take the pending result chunk and reset the chunk buffer.
+   * @return Serialized chunk payload (empty if nothing is pending).
+   */
+  std::string TakeStreamChunk();
+
+  /**
+   * @brief Serialize all output lists of this worker.
+   * @return Serialized payload understood by AddStreamedOutputs().
+   */
+  std::string SerializeOutputs() const;
+
+  /**
+   * @brief Append a result chunk received from a streaming worker to this object's storage tree.
+   * @param payload Chunk produced by TakeStreamChunk() on the worker.
+   * @return Number of appended entries, or -1 on decoding error.
+   */
+  Long64_t AppendStreamedResults(const std::string & payload);
+
+  /**
+   * @brief Add output lists received from a streaming worker to this object's in-memory outputs.
+   * @param payload Payload produced by SerializeOutputs() on the worker.
+   * @return True on success.
+   */
+  bool AddStreamedOutputs(const std::string & payload);
+
+  /**
+   * @brief Check if this supervisor-side object received its results by streaming.
+   * @return True if at least one chunk or output payload was received.
+   */
+  bool HasStreamedResults() const { return fHasStreamedResults; }
+
+  /**
+   * @brief Serialize a job description for Reconfigure() on a persistent worker.
+   *
+   * Function pointers are sent as addresses together with the macro load generation of the
+   * supervisor (NUtils::GetMacroLoadGeneration()), so a worker forked before further macros
+   * were loaded refuses the job in Reconfigure() and the pool is restarted.
+   * @return Serialized job payload.
+   */
+  static std::string SerializeJob(NGnProcessFuncPtr func, NGnBeginFuncPtr beginFunc, NGnEndFuncPtr endFunc,
+                                  NGnTree * ngnt, NBinning * binningIn, const std::string & treename,
+                                  const json & cfg);
+
+  /**
+   * @brief Re-initialize a persistent worker for a new job instead of respawning it.
+   * @param filename Output file of the new job.
+   * @param job Payload produced by SerializeJob().
+   * @return True on success, false also when the macro load generation differs or the job functions
+   * are not loaded in this worker. The previous job's objects are deleted once the job is decoded.
+   */
+  bool Reconfigure(const std::string & filename, const std::string & job);
+
   /**
    * @brief Checks if the object is a pure copy.
    * @return True if the object is a pure copy, false otherwise.
@@ -157,19 +277,74 @@ class NGnThreadData : public NThreadData {
    */
   virtual Long64_t Merge(TCollection * list);
 
+  /**
+   * @brief Start an incremental merge into this object.
+   *
+   * Equivalent to Merge(list) split into MergeBegin(), one MergeAdd() per
+   * worker (e.g. as soon as it reports DONE) and MergeEnd().
+   */
+  void MergeBegin();
+
+  /**
+   * @brief Add a finished worker to the merge started by MergeBegin().
+   *
+   * Opens the worker output once, queues its output lists and indexes its tree
+   * entries by target bin.
+   * @param data Worker thread data.
+   * @return True if the worker output was added.
+   */
+  bool MergeAdd(NGnThreadData * data);
+
+  /**
+   * @brief Add an output file to the merge started by MergeBegin().
+   *
+   * Used for worker files of an interrupted run that are resumed from a checkpoint.
+   * @param filename Output file.
+   * @param order Merge order of the file's output lists.
+   * @param keepIds If not empty, only entries with these global ids are merged.
+   * @param skipIds Entries with these global ids are not merged.
+   * @return True if the file was added.
+   */
+  bool MergeAddFile(const std::string & filename, size_t order, const std::set<Long64_t> & keepIds,
+                    const std::set<Long64_t> & skipIds = {});
+
+  /**
+   * @brief Finish the merge: write all indexed entries and merge output lists.
+   * @return Number of merged workers.
+   */
+  Long64_t MergeEnd();
+
   private:
+  /// Deletes the objects of the previous job before a persistent worker is reconfigured.
+  void ReleaseJob();
+
+  /// Merges the queued contributor lists of one output key into the target output list.
+  void MergeOutputList(const std::string & key, std::vector<std::pair<size_t, TList *>> & contributors);
+
   NGnProcessFuncPtr          fProcessFunc{nullptr};  ///< Function pointer to the processing function
   NGnBeginFuncPtr            fBeginFunc{nullptr};    ///< Function pointer to the begin function
   NGnEndFuncPtr              fEndFunc{nullptr};      ///< Function pointer to the end function
   NGnTree *                  fHnSparseBase{nullptr}; ///< Pointer to the base class
   Long64_t                   fNProcessed{0};         ///< Number of processed entries
   NBinning *                 fBiningSource{nullptr}; ///< Pointer to the source binning (from the original NGnTree)
+  bool                       fOwnsBiningSource{false}; //!< True when fBiningSource was decoded by Reconfigure()
   json                       fCfg{};                 ///< Configuration object
   bool                       fIsPureCopy{false};     ///< Flag indicating pure copy mode
   std::string                fResultsFilename{};     ///< Shared-FS path to copy result to after Close(true) (TCP mode)
   std::vector<Long64_t>      fCurrentDefinitionIds;  ///< Worker-local override for current definition id mapping
   std::unordered_set<Long64_t> fProcessedBinIds{};  //!< Set of already-processed global bin IDs (duplicate guard)
+  std::set<Long64_t>         fDuplicateBinIds{};     //!< Global bin IDs whose entries lost a speculation race
   std::vector<TObject *>     fDeferredDeletes;       //!< Objects deferred for single-threaded deletion
+  size_t                     fStreamChunkEntries{0}; //!< Entries per streamed chunk (0 = streaming disabled)
+  size_t                     fStreamWindow{1};       //!< Unacknowledged chunks allowed in flight
+  std::string                fStreamChunk{};         //!< Serialized entries waiting to be sent
+  size_t                     fStreamChunkCount{0};   //!< Number of entries in fStreamChunk
+  bool                       fHasStreamedResults{false}; //!< Supervisor side: results arrived by streaming
+  double                     fCheckpointInterval{0}; //!< Seconds between output checkpoints (0 = disabled)
+  /// Output lists queued for merge per definition, tagged with their worker order
+  std::map<std::string, std::vector<std::pair<size_t, TList *>>> fMergeOutputs{}; //!
+  std::vector<NStorageMergeIndex> fMergeSources{};   //!< Indexed worker trees added to the merge
+  Long64_t                   fMergeCount{0};         //!< Number of workers added to the merge
 
   /// \cond CLASSIMP
   ClassDef(NGnThreadData, 1);
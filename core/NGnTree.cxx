@@ -1,13 +1,21 @@
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <ctime>
+#include <map>
+#include <memory>
+#include <numeric>
 #include <numbers>
 #include <set>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <unordered_set>
 #include <vector>
 #include "TAxis.h"
 #include <TDirectory.h>
+#include <TFile.h>
 #include <TObject.h>
 #include <TList.h>
 #include <TROOT.h>
@@ -18,6 +26,7 @@
 #include <TMap.h>
 #include <TObjString.h>
 #include <TTree.h>
+#include <TTreeCloner.h>
 #include <TBufferJSON.h>
 #include <sys/poll.h>
 #include <zmq.h>
@@ -25,10 +34,16 @@
 #include "NStorageTree.h"
 #include "NBinning.h"
 #include "NBinningDef.h"
+#include "NBinningPoint.h"
+#include "NBulkProjection.h"
+#include "NCheckpointJournal.h"
 #include "NDimensionalExecutor.h"
 #include "NDimensionalIpcRunner.h"
+#include "NGnProcessSession.h"
 #include "NGnThreadData.h"
 #include "NLogger.h"
+#include "NMetrics.h"
+#include "NResourceMonitor.h"
 #include "NTreeBranch.h"
 #include "NUtils.h"
 #include "NStorageTree.h"
@@ -41,6 +56,296 @@ ClassImp(Ndmspc::NGnTree);
 
 namespace Ndmspc {
 
+namespace {
+/// Per-task wall time of the scheduled ids taken from the resource monitor of a
+/// previous run (outputs/<definition>/resource_monitor). Unknown bins get -1.
+/// Returns an empty vector when no usable history is found.
+std::vector<double> BuildTaskCostsFromHistory(TFile * historyFile, const std::string & defName, NBinning * binning,
+                                              const std::vector<Long64_t> & ids)
+{
+  std::vector<double> costs;
+  if (!historyFile || !binning) return costs;
+
+  TDirectory * dir     = historyFile->GetDirectory("outputs");
+  TList *      outputs = dir ? dynamic_cast<TList *>(dir->Get(defName.c_str())) : nullptr;
+  if (!outputs) {
+    NLogWarning("NGnTree::Process: No outputs for definition '%s' in cost history '%s'", defName.c_str(),
+                historyFile->GetName());
+    return costs;
+  }
+  outputs->SetOwner(kTRUE);
+
+  std::map<std::vector<int>, double> times;
+  THnSparse *   monitor = dynamic_cast<THnSparse *>(outputs->FindObject("resource_monitor"));
+  NBinningDef * def     = binning->GetDefinition(defName);
+  bool          valid   = monitor && def && monitor->GetNdimensions() == def->GetNdimensions() + 2;
+  for (Int_t d = 0; valid && d < def->GetNdimensions(); ++d) {
+    valid = (monitor->GetAxis(d + 1)->GetNbins() == def->GetAxis(d)->GetNbins());
+  }
+  if (!valid) {
+    NLogWarning("NGnTree::Process: Resource monitor for definition '%s' in cost history '%s' is missing or does not "
+                "match the current binning, ignoring it",
+                defName.c_str(), historyFile->GetName());
+  }
+  else {
+    NResourceMonitor::GetTimeByCoords(monitor, times);
+  }
+  delete outputs;
+  if (times.empty()) return costs;
+
+  costs.assign(ids.size(), -1.0);
+  size_t           nMatched = 0;
+  std::vector<int> key(def->GetNdimensions());
+  NBinningPoint    point(binning);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    binning->GetContent()->GetBinContent(ids[i], point.GetCoords());
+    if (!point.RecalculateStorageCoords(ids[i], false)) continue;
+    for (size_t d = 0; d < key.size(); ++d) key[d] = point.GetStorageCoords()[d];
+    auto it = times.find(key);
+    if (it == times.end()) continue;
+    costs[i] = it->second;
+    ++nMatched;
+  }
+  NLogInfo("NGnTree::Process: Cost history for definition '%s': %zu/%zu tasks matched", defName.c_str(), nMatched,
+           ids.size());
+  if (nMatched == 0) costs.clear();
+  return costs;
+}
+
+/// Storage coordinates of the definition bins with the given ids, in the order of the ids.
+std::vector<std::vector<int>> BuildTaskCoords(const std::string & defName, NBinning * binning,
+                                              const std::vector<Long64_t> & ids)
+{
+  std::vector<std::vector<int>> coords;
+  NBinningDef *                 def = binning ? binning->GetDefinition(defName) : nullptr;
+  if (!def) return coords;
+
+  const size_t  nDims = def->GetNdimensions();
+  NBinningPoint point(binning);
+  coords.assign(ids.size(), std::vector<int>(nDims, 0));
+  for (size_t i = 0; i < ids.size(); ++i) {
+    binning->GetContent()->GetBinContent(ids[i], point.GetCoords());
+    if (!point.RecalculateStorageCoords(ids[i], false)) continue;
+    for (size_t d = 0; d < nDims; ++d) coords[i][d] = point.GetStorageCoords()[d];
+  }
+  return coords;
+}
+
+/// Source file of a fast clone import, filled by ScanImportSources().
+struct ImportSource {
+  std::string                                            fileName;    ///< Source file
+  std::unique_ptr<NBinning>                              binning;     ///< Binning stored with the source tree
+  Long64_t                                               nEntries{0}; ///< Number of tree entries
+  std::vector<std::tuple<std::string, std::string, int>> branches;    ///< Branch name, class and split level
+  bool                                                   ok{false};   ///< Source was read
+};
+
+/// Reads binning and branch layout of all sources, one file at a time per thread.
+void ScanImportSources(std::vector<ImportSource> & sources, const std::string & treeName)
+{
+  // Files are opened concurrently only with ROOT thread safety, which is not enabled here
+  const size_t nThreads = NUtils::IsThreadSafetyEnabled()
+                              ? std::min<size_t>(sources.size(), std::max(1u, ROOT::GetThreadPoolSize()))
+                              : 1;
+
+  std::atomic<size_t> next{0};
+  auto                scan = [&sources, &treeName, &next]() {
+    for (size_t i = next++; i < sources.size(); i = next++) {
+      ImportSource & s = sources[i];
+      if (gSystem->AccessPathName(s.fileName.c_str())) {
+        NLogDebug("NGnTree::Import: Source '%s' does not exist, skipping ...", s.fileName.c_str());
+        continue;
+      }
+      std::unique_ptr<TFile> file(TFile::Open(s.fileName.c_str()));
+      TTree *        tree    = file && !file->IsZombie() ? file->Get<TTree>(treeName.c_str()) : nullptr;
+      NBinning *     binning = tree ? dynamic_cast<NBinning *>(tree->GetUserInfo()->At(0)) : nullptr;
+      NStorageTree * storage = tree ? dynamic_cast<NStorageTree *>(tree->GetUserInfo()->At(1)) : nullptr;
+      if (!binning || !storage) {
+        NLogError("NGnTree::Import: Cannot read tree '%s' with binning from '%s'", treeName.c_str(),
+                  s.fileName.c_str());
+        continue;
+      }
+      tree->GetUserInfo()->Remove(binning);
+      s.binning.reset(binning);
+      s.nEntries = tree->GetEntries();
+      for (const auto & kv : storage->GetBranchesMap()) {
+        TBranch * branch = tree->GetBranch(kv.first.c_str());
+        s.branches.emplace_back(kv.first, kv.second.GetObjectClassName(), branch ? branch->GetSplitLevel() : -1);
+      }
+      s.ok = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < nThreads; ++i) threads.emplace_back(scan);
+  scan();
+  for (auto & t : threads) t.join();
+  NLogDebug("NGnTree::Import: Scanned %zu sources using %zu threads", sources.size(), nThreads);
+}
+
+/// Imports the sources of NGnTree::Import() by copying their compressed baskets (TTree fast cloning).
+/// Each source is copied as a whole, so only the binning content and the definition are rebuilt.
+/// Returns 1 when imported, 0 when the sources cannot be fast cloned (no entry was written) and -1
+/// on error.
+int ImportFastClone(NGnTree * ngnt, const json & cfg)
+{
+  NStorageTree * ts      = ngnt->GetStorageTree();
+  TTree *        outTree = ts ? ts->GetTree() : nullptr;
+  NBinning *     binning = ngnt->GetBinning();
+  NBinningDef *  def     = binning ? binning->GetDefinition("default") : nullptr;
+  if (!outTree || !outTree->GetCurrentFile() || !def) {
+    NLogWarning("NGnTree::Import: Fast clone needs a file based output tree with the 'default' definition");
+    return 0;
+  }
+
+  const std::string              basedir  = cfg["basedir"].get<std::string>();
+  const std::string              fileName = cfg["filename"].get<std::string>();
+  const int                      nDirAxes = cfg["nDirAxes"].get<int>();
+  const std::vector<std::string> headers  = cfg["headers"].get<std::vector<std::string>>();
+
+  // Source file of every bin of the definition
+  THnSparse *                   content = binning->GetContent();
+  const Long64_t                nBins   = content->GetNbins();
+  std::vector<ImportSource>     sources;
+  std::map<std::string, size_t> sourceIds;
+  std::vector<size_t>           binSources(nBins);
+  NBinningPoint                 point(binning);
+  for (Long64_t bin = 0; bin < nBins; ++bin) {
+    point.SetPointContentFromLinearIndex(bin);
+    std::string name = basedir + "/";
+    for (const auto & header : headers) name += point.GetBinLabel(header) + "/";
+    name += fileName;
+    auto it = sourceIds.find(name);
+    if (it == sourceIds.end()) {
+      it = sourceIds.emplace(name, sources.size()).first;
+      sources.emplace_back();
+      sources.back().fileName = name;
+    }
+    binSources[bin] = it->second;
+  }
+
+  ScanImportSources(sources, outTree->GetName());
+
+  const Int_t          nSourceDims = content->GetNdimensions() - 3 * nDirAxes;
+  const ImportSource * first       = nullptr;
+  for (const auto & s : sources) {
+    if (!s.ok) continue;
+    if (s.binning->GetContent()->GetNdimensions() != nSourceDims) {
+      NLogWarning("NGnTree::Import: Binning of '%s' does not match the imported binning", s.fileName.c_str());
+      return 0;
+    }
+    if (!first) {
+      first = &s;
+    }
+    else if (s.branches != first->branches) {
+      NLogWarning("NGnTree::Import: Branches of '%s' differ from '%s'", s.fileName.c_str(), first->fileName.c_str());
+      return 0;
+    }
+  }
+  if (!first) {
+    NLogWarning("NGnTree::Import: No source could be read");
+    return 0;
+  }
+
+  // Tree entry n of a source is its content bin n. Sources are copied as a whole, so their entries
+  // have to follow the definition bins without gaps.
+  std::vector<Long64_t> bins;
+  std::vector<size_t>   order;
+  std::vector<Long64_t> nextEntry(sources.size(), 0);
+  for (Long64_t bin = 0; bin < nBins; ++bin) {
+    const size_t i = binSources[bin];
+    if (!sources[i].ok) continue;
+    content->GetBinContent(bin, point.GetCoords());
+    const Long64_t entry = sources[i].binning->GetContent()->GetBin(&point.GetCoords()[3 * nDirAxes], kFALSE);
+    if (entry < 0) continue;
+    if (entry != nextEntry[i] || (entry > 0 && order.back() != i)) {
+      NLogWarning("NGnTree::Import: Entries of '%s' do not follow the imported binning", sources[i].fileName.c_str());
+      return 0;
+    }
+    if (entry == 0) order.push_back(i);
+    nextEntry[i]++;
+    bins.push_back(bin);
+  }
+  for (size_t i = 0; i < sources.size(); ++i) {
+    if (sources[i].ok && nextEntry[i] != sources[i].nEntries) {
+      NLogWarning("NGnTree::Import: '%s' has %lld entries outside of the imported binning",
+                  sources[i].fileName.c_str(), sources[i].nEntries - nextEntry[i]);
+      return 0;
+    }
+  }
+
+  // Fast cloning needs the same branch layout in the output tree
+  for (const auto & [name, className, splitLevel] : first->branches) {
+    if (!ts->GetBranch(name)) ts->AddBranch(name, nullptr, className);
+    TBranch * branch = outTree->GetBranch(name.c_str());
+    if (!branch || branch->GetSplitLevel() != splitLevel) {
+      NLogWarning("NGnTree::Import: Branch '%s' with split level %d cannot be fast cloned", name.c_str(), splitLevel);
+      return 0;
+    }
+  }
+
+  // Every source is checked before the binning is changed, so a layout the cloner rejects falls back to the
+  // entry by entry import. Cloners are built again for copying, as they take the output entries at construction.
+  for (const size_t i : order) {
+    const ImportSource &   s = sources[i];
+    std::unique_ptr<TFile> file(TFile::Open(s.fileName.c_str()));
+    TTree *                tree = file ? file->Get<TTree>(outTree->GetName()) : nullptr;
+    if (!tree) {
+      NLogWarning("NGnTree::Import: Cannot read tree '%s' from '%s'", outTree->GetName(), s.fileName.c_str());
+      return 0;
+    }
+    TTreeCloner cloner(tree, outTree, "fast", TTreeCloner::kNoWarnings);
+    if (!cloner.IsValid()) {
+      NLogWarning("NGnTree::Import: Cannot fast clone '%s': %s", s.fileName.c_str(), cloner.GetWarning());
+      return 0;
+    }
+  }
+
+  // Content and definition keep only the copied bins, in the order of the copied entries
+  std::unique_ptr<THnSparse> allBins((THnSparse *)content->Clone());
+  content->Reset();
+  def->ResetContent();
+  def->ClearIds();
+  def->ReserveIds(bins.size());
+  for (const Long64_t bin : bins) {
+    allBins->GetBinContent(bin, point.GetCoords());
+    const Long64_t id = point.Fill(true);
+    point.RecalculateStorageCoords(id, false);
+    def->SetContentAt(point.GetStorageCoords(), id);
+    def->AddId(id);
+  }
+
+  const Long64_t totBytes = outTree->GetTotBytes();
+  for (const size_t i : order) {
+    const ImportSource &   s = sources[i];
+    std::unique_ptr<TFile> file(TFile::Open(s.fileName.c_str()));
+    TTree *                tree = file ? file->Get<TTree>(outTree->GetName()) : nullptr;
+    if (!tree) {
+      NLogError("NGnTree::Import: Cannot read tree '%s' from '%s'", outTree->GetName(), s.fileName.c_str());
+      return -1;
+    }
+    TTreeCloner cloner(tree, outTree, "fast", TTreeCloner::kNoWarnings);
+    if (!cloner.IsValid()) {
+      NLogError("NGnTree::Import: Cannot fast clone '%s': %s", s.fileName.c_str(), cloner.GetWarning());
+      return -1;
+    }
+    outTree->SetEntries(outTree->GetEntries() + tree->GetEntries());
+    if (!cloner.Exec()) {
+      NLogError("NGnTree::Import: Copying baskets from '%s' failed", s.fileName.c_str());
+      return -1;
+    }
+    NLogInfo("NGnTree::Import: Copied %lld entries from '%s'", tree->GetEntries(), s.fileName.c_str());
+  }
+  ts->SetBranchAddresses();
+
+  NMetrics::Add(NMetrics::kTreeEntriesWritten, outTree->GetEntries());
+  NMetrics::Add(NMetrics::kTreeEntriesCloned, outTree->GetEntries());
+  NMetrics::Add(NMetrics::kTreeBytesWritten, outTree->GetTotBytes() - totBytes);
+  NLogInfo("NGnTree::Import: Fast cloned %lld entries from %zu files", outTree->GetEntries(), order.size());
+  return 1;
+}
+} // namespace
+
 std::string NGnTree::BuildObjectPath(const json & cfg, const json & objCfg, const NBinningPoint * point)
 {
   std::string objPath = "";
@@ -488,6 +793,7 @@ NGnTree::~NGnTree()
   }
   SafeDelete(fNavigator);
   SafeDelete(fParameters);
+  SafeDelete(fBulkProjection);
 }
 void NGnTree::Print(Option_t * option) const
 {
@@ -558,6 +864,101 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const json & cfg, std::string binn
   return true;
 }
 
+std::string NGnTree::GetExecutionMode(size_t * nProcessesOut, int nThreads)
+{
+  ///
+  /// Returns execution mode selected by Process() from NDMSPC_EXECUTION_MODE and the number of processes
+  ///
+  if (nThreads < 1) {
+    // Number of threads NUtils::EnableMT() sets up in Process()
+    nThreads = 1;
+    if (const char * envThreads = gSystem->Getenv("ROOT_MAX_THREADS")) {
+      try {
+        nThreads = std::max(1, std::stoi(envThreads));
+      }
+      catch (...) {
+        nThreads = 1;
+      }
+    }
+  }
+
+  std::string  executionMode = "thread";
+  const char * envMode       = gSystem->Getenv("NDMSPC_EXECUTION_MODE");
+  const bool   modeExplicit  = (envMode && envMode[0] != '\0');
+  if (modeExplicit) {
+    executionMode = envMode;
+  }
+
+  std::string normalizedMode = executionMode;
+  std::transform(normalizedMode.begin(), normalizedMode.end(), normalizedMode.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  if (normalizedMode == "process") normalizedMode = "ipc";
+
+  bool   useProcessIpc       = (normalizedMode == "ipc" || normalizedMode == "tcp");
+  bool   useTcp              = (normalizedMode == "tcp");
+  size_t nProcesses          = static_cast<size_t>(nThreads);
+  bool   ndmspcNProcExplicit = false;
+
+  if (const char * envNdmspcNProc = gSystem->Getenv("NDMSPC_MAX_PROCESSES")) {
+    ndmspcNProcExplicit = true;
+    try {
+      nProcesses = std::max<size_t>(1, static_cast<size_t>(std::stoll(envNdmspcNProc)));
+    }
+    catch (...) {
+      NLogWarning("NGnTree::GetExecutionMode: Invalid NDMSPC_MAX_PROCESSES='%s', using default=%zu", envNdmspcNProc,
+                  nProcesses);
+    }
+  }
+  else if (const char * envNProc = gSystem->Getenv("ROOT_MAX_THREADS")) {
+    // Backward-compatible fallback when NDMSPC_MAX_PROCESSES is not set.
+    try {
+      nProcesses = std::max<size_t>(1, static_cast<size_t>(std::stoll(envNProc)));
+    }
+    catch (...) {
+      NLogWarning("NGnTree::GetExecutionMode: Invalid ROOT_MAX_THREADS='%s', using default=%zu", envNProc,
+                  nProcesses);
+    }
+  }
+
+  // Keep explicit NDMSPC_EXECUTION_MODE settings authoritative.
+  // If mode is not explicitly set, default to local IPC for multi-process runs.
+  if (modeExplicit) {
+    if (normalizedMode == "thread") {
+      useProcessIpc = false;
+      useTcp        = false;
+    }
+    else if (normalizedMode == "tcp") {
+      useProcessIpc = true;
+      useTcp        = true;
+    }
+    else if (normalizedMode == "ipc") {
+      useProcessIpc = true;
+      useTcp        = false;
+    }
+    else {
+      NLogWarning("NGnTree::GetExecutionMode: Unknown NDMSPC_EXECUTION_MODE='%s', falling back to auto mode "
+                  "selection.",
+                  executionMode.c_str());
+      useProcessIpc = (nProcesses > 1);
+      useTcp        = false;
+    }
+  }
+  else if (nProcesses > 1) {
+    useProcessIpc = true;
+    useTcp        = false;
+  }
+
+  if (ndmspcNProcExplicit && !useProcessIpc && nProcesses > 1) {
+    NLogWarning(
+        "NGnTree::GetExecutionMode: NDMSPC_MAX_PROCESSES=%zu is set, but NDMSPC_EXECUTION_MODE=thread disables IPC.",
+        nProcesses);
+  }
+
+  if (nProcessesOut) *nProcessesOut = nProcesses;
+  if (!useProcessIpc) return "thread";
+  return useTcp ? "tcp" : "ipc";
+}
+
 bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & defNames, const json & cfg,
                       NBinning * binningIn, NGnBeginFuncPtr beginFunc, NGnEndFuncPtr endFunc)
 {
@@ -605,11 +1006,14 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
     int timeoutMs = 1000;
     zmq_setsockopt(dealer, ZMQ_RCVTIMEO, &timeoutMs, sizeof(timeoutMs));
     zmq_connect(dealer, workerEndpoint);
-    Ndmspc::NDimensionalIpcRunner::SendFrames(dealer, {"READY"});
+    // Announce the task framing this worker understands; the supervisor confirms the version in INIT.
+    Ndmspc::NDimensionalIpcRunner::SendFrames(
+        dealer, {"READY", std::to_string(Ndmspc::NDimensionalIpcRunner::GetProtocolVersion())});
 
     // Wait for INIT
     const auto initDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
     bool       initOk       = false;
+    int        protocol     = 1;
     while (!initOk) {
       std::vector<std::string> frames;
       if (!Ndmspc::NDimensionalIpcRunner::ReceiveFrames(dealer, frames)) {
@@ -619,7 +1023,8 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
         }
         break;
       }
-      // INIT frames: "INIT", workerIdx, sessionId, resultsDir, treeName[, tmpDir, tmpResultsDir]
+      // INIT frames: "INIT", workerIdx, sessionId, resultsDir, treeName[, tmpDir, tmpResultsDir[, streamChunk,
+      // streamWindow[, protocol]]]
       if (frames.size() >= 1 && frames[0] == "STOP") {
         NLogPrint("NGnTree::Process: Worker received STOP before INIT — session already finished, exiting.");
 
@@ -657,11 +1062,35 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
           if (tmpDirEnv && tmpDirEnv[0] != '\0') gSystem->Setenv("NDMSPC_TMP_RESULTS_DIR", tmpDirEnv);
         }
 
+        // Result streaming: a non-zero chunk size means entries are sent over the socket
+        size_t streamChunk  = 0;
+        size_t streamWindow = 1;
+        if (frames.size() >= 9) {
+          try {
+            streamChunk  = static_cast<size_t>(std::stoull(frames[7]));
+            streamWindow = static_cast<size_t>(std::stoull(frames[8]));
+          }
+          catch (...) {
+            NLogWarning("NGnTree::Process: Invalid result streaming settings '%s,%s' in INIT, streaming disabled",
+                        frames[7].c_str(), frames[8].c_str());
+            streamChunk = 0;
+          }
+        }
+
+        // Task framing: supervisors without binary framing send no version frame
+        protocol = Ndmspc::NDimensionalIpcRunner::ParseProtocolVersion(frames, 9);
+
         // Local work file — always on this machine's NDMSPC_TMP_DIR
         const char *      localTmpEnv = gSystem->Getenv("NDMSPC_TMP_DIR");
         const std::string localBase   = localTmpEnv ? localTmpEnv : "/tmp";
-        const std::string localFile =
+        std::string       localFile =
             localBase + "/.ndmspc/tmp/" + sessionId + "/" + std::to_string(workerIndex) + "/" + storagePostfix;
+        if (streamChunk > 0) {
+          // The supervisor writes streamed entries to the plain path; keep this scratch file
+          // apart so workers on the supervisor host do not clobber it.
+          localFile = localBase + "/.ndmspc/tmp/" + sessionId + "/" + std::to_string(workerIndex) + "/w" +
+                      std::to_string(gSystem->GetPid()) + "/" + storagePostfix;
+        }
 
         // Results file — on shared FS; supervisor reads from here to merge
         const std::string resultsFile = initResultsDir + "/" + std::to_string(workerIndex) + "/" + storagePostfix;
@@ -674,8 +1103,13 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
           zmq_ctx_term(ctx);
           return false;
         }
+        if (streamChunk > 0) {
+          workerData.SetResultStreaming(streamChunk, streamWindow);
+          NLogInfo("NGnTree::Process: Worker %zu streams results (chunk=%zu entries, window=%zu)", workerIndex,
+                   streamChunk, streamWindow);
+        }
         // If results dir differs from local dir, tell TaskLoop to copy after Close(true)
-        if (resultsFile != localFile) {
+        else if (resultsFile != localFile) {
           workerData.SetResultsFilename(resultsFile);
         }
         workerData.SetCfg(cfg);
@@ -690,7 +1124,7 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
       return false;
     }
 
-    Ndmspc::NDimensionalIpcRunner::TaskLoop(dealer, workerIndex, &workerData);
+    Ndmspc::NDimensionalIpcRunner::TaskLoop(dealer, workerIndex, &workerData, protocol);
     zmq_close(dealer);
     zmq_ctx_term(ctx);
     gROOT->SetBatch(batch);
@@ -703,75 +1137,10 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
   int nThreads = ROOT::GetThreadPoolSize(); // Get the number of threads to use
   if (nThreads < 1) nThreads = 1;
 
-  std::string  executionMode = "thread";
-  const char * envMode       = gSystem->Getenv("NDMSPC_EXECUTION_MODE");
-  const bool   modeExplicit  = (envMode && envMode[0] != '\0');
-  if (modeExplicit) {
-    executionMode = envMode;
-  }
-
-  std::string normalizedMode = executionMode;
-  std::transform(normalizedMode.begin(), normalizedMode.end(), normalizedMode.begin(),
-                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-  if (normalizedMode == "process") normalizedMode = "ipc";
-
-  bool   useProcessIpc       = (normalizedMode == "ipc" || normalizedMode == "tcp");
-  bool   useTcp              = (normalizedMode == "tcp");
-  size_t nProcesses          = static_cast<size_t>(nThreads);
-  bool   ndmspcNProcExplicit = false;
-
-  if (const char * envNdmspcNProc = gSystem->Getenv("NDMSPC_MAX_PROCESSES")) {
-    ndmspcNProcExplicit = true;
-    try {
-      nProcesses = std::max<size_t>(1, static_cast<size_t>(std::stoll(envNdmspcNProc)));
-    }
-    catch (...) {
-      NLogWarning("NGnTree::Process: Invalid NDMSPC_MAX_PROCESSES='%s', using default=%zu", envNdmspcNProc, nProcesses);
-    }
-  }
-  else if (const char * envNProc = gSystem->Getenv("ROOT_MAX_THREADS")) {
-    // Backward-compatible fallback when NDMSPC_MAX_PROCESSES is not set.
-    try {
-      nProcesses = std::max<size_t>(1, static_cast<size_t>(std::stoll(envNProc)));
-    }
-    catch (...) {
-      NLogWarning("NGnTree::Process: Invalid ROOT_MAX_THREADS='%s', using default=%zu", envNProc, nProcesses);
-    }
-  }
-
-  // Keep explicit NDMSPC_EXECUTION_MODE settings authoritative.
-  // If mode is not explicitly set, default to local IPC for multi-process runs.
-  if (modeExplicit) {
-    if (normalizedMode == "thread") {
-      useProcessIpc = false;
-      useTcp        = false;
-    }
-    else if (normalizedMode == "tcp") {
-      useProcessIpc = true;
-      useTcp        = true;
-    }
-    else if (normalizedMode == "ipc") {
-      useProcessIpc = true;
-      useTcp        = false;
-    }
-    else {
-      NLogWarning("NGnTree::Process: Unknown NDMSPC_EXECUTION_MODE='%s', falling back to auto mode selection.",
-                  executionMode.c_str());
-      useProcessIpc = (nProcesses > 1);
-      useTcp        = false;
-    }
-  }
-  else if (nProcesses > 1) {
-    useProcessIpc  = true;
-    useTcp         = false;
-    executionMode  = "ipc";
-    normalizedMode = "ipc";
-  }
-
-  if (ndmspcNProcExplicit && normalizedMode == "thread" && nProcesses > 1) {
-    NLogWarning("NGnTree::Process: NDMSPC_MAX_PROCESSES=%zu is set, but NDMSPC_EXECUTION_MODE=thread disables IPC.",
-                nProcesses);
-  }
+  size_t            nProcesses    = 1;
+  const std::string executionMode = GetExecutionMode(&nProcesses, nThreads);
+  const bool        useProcessIpc = (executionMode != "thread");
+  const bool        useTcp        = (executionMode == "tcp");
 
   const size_t workerObjectCount =
       useProcessIpc ? std::max(static_cast<size_t>(nThreads), nProcesses) : static_cast<size_t>(nThreads);
@@ -825,6 +1194,17 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
 
   std::string jobDir = tmpDir + "/.ndmspc/tmp/" + std::to_string(gSystem->GetPid());
 
+  // Persistent worker pool (IPC/fork only): each job of the session gets its own directory.
+  NGnProcessSession * session = (useProcessIpc && !useTcp) ? fProcessSession : nullptr;
+  if (session) {
+    if (session->IsActive() && session->GetNProcesses() != nProcesses) {
+      NLogInfo("NGnTree::Process: Worker pool has %zu process(es) but %zu are requested, restarting it",
+               session->GetNProcesses(), nProcesses);
+      session->Close();
+    }
+    jobDir += "/" + session->NextJob();
+  }
+
   // Results dir: when NDMSPC_TMP_RESULTS_DIR equals NDMSPC_TMP_DIR (or is unset),
   // reuse jobDir so that localTmpFile == resultsFilename — no copy or delete needed.
   const char * resultsDirEnv = gSystem->Getenv("NDMSPC_TMP_RESULTS_DIR");
@@ -838,6 +1218,37 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
   const bool  sameDir    = resultsDirBase.empty() || resultsDirBase == tmpDir;
   std::string resultsDir = sameDir ? jobDir : (resultsDirBase + "/" + std::to_string(gSystem->GetPid()));
 
+  // Result streaming (TCP): workers send their entries over the socket and the supervisor
+  // writes them to the local per-worker files, so no shared results directory is needed.
+  bool   streamResults = false;
+  size_t streamChunk   = 16;
+  size_t streamWindow  = 4;
+  if (useTcp) {
+    if (const char * env = gSystem->Getenv("NDMSPC_RESULT_STREAMING")) {
+      std::string value(env);
+      std::transform(value.begin(), value.end(), value.begin(),
+                     [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+      streamResults = (value == "1" || value == "true" || value == "yes" || value == "on");
+    }
+    if (const char * env = gSystem->Getenv("NDMSPC_RESULT_STREAM_CHUNK")) {
+      try {
+        streamChunk = std::max<size_t>(1, static_cast<size_t>(std::stoull(env)));
+      }
+      catch (...) {
+        NLogWarning("NGnTree::Process: Invalid NDMSPC_RESULT_STREAM_CHUNK='%s', using default=%zu", env, streamChunk);
+      }
+    }
+    if (const char * env = gSystem->Getenv("NDMSPC_RESULT_STREAM_WINDOW")) {
+      try {
+        streamWindow = std::max<size_t>(1, static_cast<size_t>(std::stoull(env)));
+      }
+      catch (...) {
+        NLogWarning("NGnTree::Process: Invalid NDMSPC_RESULT_STREAM_WINDOW='%s', using default=%zu", env,
+                    streamWindow);
+      }
+    }
+  }
+
   std::string filePrefix = jobDir;
   for (size_t i = 0; i < threadDataVector.size(); ++i) {
     std::string filename = filePrefix + "/" + std::to_string(i) + "/" + storagePostfix;
@@ -848,7 +1259,7 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
       return false;
     }
     threadDataVector[i].SetCfg(cfgRuntime); // Set configuration to binning point
-    if (useTcp) {
+    if (useTcp && !streamResults) {
       // Tell the merge step where workers will deposit their finished files.
       // When resultsDir == jobDir (NDMSPC_TMP_RESULTS_DIR unset) the paths are
       // identical so no copy or delete is needed — handled in TaskLoop.
@@ -874,7 +1285,8 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
   };
 
   std::vector<Ndmspc::NThreadData *>            processWorkers;
-  std::unique_ptr<Ndmspc::NDimensionalExecutor> ipcExecutor;
+  std::unique_ptr<Ndmspc::NDimensionalExecutor> ipcExecutorOwned;
+  Ndmspc::NDimensionalExecutor *                ipcExecutor = nullptr;
   std::unordered_set<Long64_t>                  processedDefinitionIds;
   std::map<std::string, std::vector<Long64_t>>  originalDefinitionIdsMap;
 
@@ -887,12 +1299,125 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
     originalDefinitionIdsMap[defName] = def->GetIds();
   }
 
+  // Checkpoint/resume (IPC/fork only): workers periodically make their output files durable
+  // and the supervisor journals which definition ids each file holds. A resumed run merges
+  // the journaled entries of the interrupted run and schedules only the remaining ids.
+  auto envFlag = [](const char * name) {
+    const char * env = gSystem->Getenv(name);
+    if (!env) return false;
+    std::string value(env);
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value == "1" || value == "true" || value == "yes" || value == "on";
+  };
+  const bool                                resume     = envFlag("NDMSPC_RESUME");
+  bool                                      checkpoint = resume || envFlag("NDMSPC_CHECKPOINT");
+  std::unique_ptr<NCheckpointJournal>       journal;
+  std::vector<int>                          journalFileIndex;
+  std::map<std::string, std::set<Long64_t>> resumedFiles;
+  if (checkpoint && (!useProcessIpc || useTcp)) {
+    NLogWarning("NGnTree::Process: Checkpointing is supported only in IPC mode, disabling it");
+    checkpoint = false;
+  }
+  if (checkpoint) {
+    double interval = 30;
+    if (const char * env = gSystem->Getenv("NDMSPC_CHECKPOINT_INTERVAL")) {
+      try {
+        interval = std::stod(env);
+        if (interval <= 0) throw std::invalid_argument("interval");
+      }
+      catch (...) {
+        interval = 30;
+        NLogWarning("NGnTree::Process: Invalid NDMSPC_CHECKPOINT_INTERVAL='%s', using default=%.0f s", env, interval);
+      }
+    }
+    const char *      envJournal = gSystem->Getenv("NDMSPC_CHECKPOINT_FILE");
+    const std::string journalPath =
+        (envJournal && envJournal[0] != '\0')
+            ? std::string(envJournal)
+            : NCheckpointJournal::DefaultPath(fTreeStorage ? fTreeStorage->GetFileName() : "", tmpDir);
+    journal = std::make_unique<NCheckpointJournal>(journalPath);
+
+    if (resume && journal->Load()) {
+      // Each id is taken from the first file that holds it; files that are gone are skipped.
+      for (const auto & kv : journal->GetFileIds()) {
+        if (gSystem->AccessPathName(kv.first.c_str())) {
+          NLogWarning("NGnTree::Process: Checkpointed file '%s' is missing, its entries will be reprocessed",
+                      kv.first.c_str());
+          continue;
+        }
+        std::set<Long64_t> keep;
+        for (const auto id : kv.second) {
+          if (processedDefinitionIds.insert(id).second) keep.insert(id);
+        }
+        if (!keep.empty()) resumedFiles.emplace(kv.first, std::move(keep));
+      }
+      NLogInfo("NGnTree::Process: Resuming from '%s': %zu entries in %zu file(s) are already done",
+               journalPath.c_str(), processedDefinitionIds.size(), resumedFiles.size());
+      if (!resumedFiles.empty()) {
+        // Checkpoints hold tree entries only; output lists are written when a worker finishes its job
+        NLogWarning("NGnTree::Process: Output lists (e.g. resource monitor) of the interrupted workers are not "
+                    "checkpointed, merged outputs miss the contributions of the %zu resumed file(s)",
+                    resumedFiles.size());
+      }
+    }
+    else if (resume) {
+      NLogWarning("NGnTree::Process: No checkpoint journal '%s' found, processing from scratch", journalPath.c_str());
+    }
+
+    if (!journal->Rewrite(resumedFiles)) {
+      NLogError("NGnTree::Process: Cannot write checkpoint journal '%s', exiting ...", journalPath.c_str());
+      return false;
+    }
+    for (auto & data : threadDataVector) {
+      journalFileIndex.push_back(journal->AddFile(data.GetHnSparseBase()->GetStorageTree()->GetFileName()));
+      data.SetCheckpointInterval(interval);
+    }
+    NLogInfo("NGnTree::Process: Checkpointing worker outputs every %.0f s to '%s'", interval, journalPath.c_str());
+  }
+
+  // Optional per-bin wall time of a previous run, used for LPT ordering of IPC/TCP tasks.
+  std::unique_ptr<TFile> costHistoryFile;
+  if (useProcessIpc) {
+    const char * envCostHistory = gSystem->Getenv("NDMSPC_COST_HISTORY");
+    if (envCostHistory && envCostHistory[0] != '\0') {
+      TDirectory::TContext context; // keep gDirectory pointing to where it was
+      costHistoryFile.reset(TFile::Open(envCostHistory));
+      if (!costHistoryFile || costHistoryFile->IsZombie()) {
+        NLogWarning("NGnTree::Process: Cannot open cost history '%s', using default task order", envCostHistory);
+        costHistoryFile.reset();
+      }
+    }
+  }
+
   if (useProcessIpc) {
     processWorkers.reserve(threadDataVector.size());
     for (size_t i = 0; i < threadDataVector.size(); ++i) {
       processWorkers.push_back(&threadDataVector[i]);
     }
-    ipcExecutor = std::make_unique<Ndmspc::NDimensionalExecutor>(std::vector<int>{0}, std::vector<int>{0});
+    if (session && session->IsActive()) {
+      // Reuse the running workers: send them the new job instead of forking again.
+      ipcExecutor           = session->GetExecutor();
+      const std::string job = NGnThreadData::SerializeJob(func, beginFunc, endFunc, this, binningIn,
+                                                          fTreeStorage->GetTree()->GetName(), cfgRuntime);
+      try {
+        ipcExecutor->ReconfigureProcessIpc([&](size_t idx) {
+          return std::vector<std::string>{filePrefix + "/" + std::to_string(idx) + "/" + storagePostfix, job};
+        });
+        NLogInfo("NGnTree::Process: Reusing %zu persistent worker process(es) for job %zu",
+                 session->GetNProcesses(), session->GetNJobs());
+      }
+      catch (const std::exception & ex) {
+        NLogWarning("NGnTree::Process: Failed to reconfigure persistent workers (%s), restarting them", ex.what());
+        session->Close(/*abort=*/true);
+        ipcExecutor = nullptr;
+      }
+    }
+  }
+
+  if (useProcessIpc && !ipcExecutor) {
+    ipcExecutorOwned = std::make_unique<Ndmspc::NDimensionalExecutor>(std::vector<int>{0}, std::vector<int>{0});
+    ipcExecutor      = ipcExecutorOwned.get();
     if (useTcp) {
       const char * tcpPort           = gSystem->Getenv("NDMSPC_TCP_PORT");
       std::string  tcpEndpoint       = std::string("tcp://0.0.0.0:") + (tcpPort ? tcpPort : "5555");
@@ -904,6 +1429,17 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
           resultsDirBaseAbs = launchCwd + "/" + resultsDirBaseAbs;
         }
       }
+      if (streamResults) {
+        NLogInfo("NGnTree::Process: Streaming worker results (chunk=%zu entries, window=%zu)", streamChunk,
+                 streamWindow);
+        ipcExecutor->SetResultStreaming(
+            streamChunk, streamWindow,
+            [&threadDataVector](size_t idx, const std::string & kind, const std::string & payload) {
+              if (idx >= threadDataVector.size()) return false;
+              if (kind == "RESULTO") return threadDataVector[idx].AddStreamedOutputs(payload);
+              return threadDataVector[idx].AppendStreamedResults(payload) >= 0;
+            });
+      }
       const char * macroParams = gSystem->Getenv("NDMSPC_MACRO_PARAMS");
       // Auto-detect the macro to send to workers: explicit SetWorkerMacro() takes
       // priority; otherwise fall back to NDMSPC_MACRO set by ndmspc-run.
@@ -917,9 +1453,23 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
     }
     else {
       ipcExecutor->StartProcessIpc(processWorkers, nProcesses);
+      if (session) session->Adopt(std::move(ipcExecutorOwned), nProcesses);
     }
   }
 
+  if (ipcExecutor) {
+    // Always (re)set: a persistent executor must not keep a handler of a previous call.
+    Ndmspc::NDimensionalExecutor::CheckpointHandler checkpointHandler;
+    if (journal) {
+      checkpointHandler = [&](size_t idx, const std::vector<Long64_t> & ids) {
+        if (idx >= journalFileIndex.size() || !journal->AddIds(journalFileIndex[idx], ids)) {
+          NLogWarning("NGnTree::Process: Failed to journal %zu checkpointed entries of worker %zu", ids.size(), idx);
+        }
+      };
+    }
+    ipcExecutor->SetCheckpointHandler(std::move(checkpointHandler));
+  }
+
   try {
     for (auto & name : defNames) {
       auto binningDef = binningIn->GetDefinition(name);
@@ -953,7 +1503,7 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
                     name.c_str());
         // Keep full definition membership even when all entries overlap with
         // previously processed definitions.
-        binningIn->GetDefinition(name)->GetIds() = originalDefinitionIdsMap[name];
+        binningIn->GetDefinition(name)->SetIds(originalDefinitionIdsMap[name]);
         continue;
       }
 
@@ -984,6 +1534,28 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
       }
 
       Ndmspc::NDimensionalExecutor executorMT(mins, maxs);
+      // Scheduler and chunk size are read independently, the chunk size applies to work stealing only
+      Ndmspc::ParallelScheduler scheduler = executorMT.GetParallelScheduler();
+      if (const char * envScheduler = gSystem->Getenv("NDMSPC_THREAD_SCHEDULER")) {
+        if (!Ndmspc::NDimensionalExecutor::ParseParallelScheduler(envScheduler, scheduler)) {
+          NLogWarning("NGnTree::Process: Unknown NDMSPC_THREAD_SCHEDULER='%s', using 'queue'", envScheduler);
+        }
+      }
+      size_t chunkSize = 0;
+      if (const char * envChunk = gSystem->Getenv("NDMSPC_THREAD_CHUNK_SIZE")) {
+        try {
+          chunkSize = static_cast<size_t>(std::stoull(envChunk));
+        }
+        catch (...) {
+          NLogWarning("NGnTree::Process: Invalid NDMSPC_THREAD_CHUNK_SIZE='%s', using automatic chunk size",
+                      envChunk);
+        }
+        if (chunkSize > 0 && scheduler != Ndmspc::ParallelScheduler::kWorkStealing) {
+          NLogWarning("NGnTree::Process: NDMSPC_THREAD_CHUNK_SIZE=%zu is used only with NDMSPC_THREAD_SCHEDULER=steal",
+                      chunkSize);
+        }
+      }
+      executorMT.SetParallelScheduler(scheduler, chunkSize);
 
       if (!useProcessIpc) {
         // Disable ROOT's RecursiveRemove during the parallel phase.
@@ -1000,8 +1572,22 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
         Bool_t prevBatch = gROOT->IsBatch();
         gROOT->SetBatch(kTRUE);
 
+        // Inputs of bulk projections are scanned once for all cells, points take their histograms
+        const bool bulk = fBulkProjection && fBulkProjection->GetNInputs() > 0 &&
+                          fBulkProjection->Fill(binningIn, scheduledDefinitionIds);
+        for (auto & td : threadDataVector) {
+          td.GetHnSparseBase()->GetBinning()->GetPoint()->SetBulkProjection(bulk ? fBulkProjection : nullptr);
+        }
+
         executorMT.ExecuteParallel<Ndmspc::NGnThreadData>(task, threadDataVector);
 
+        if (bulk) {
+          for (auto & td : threadDataVector) {
+            td.GetHnSparseBase()->GetBinning()->GetPoint()->SetBulkProjection(nullptr);
+          }
+          fBulkProjection->Clear();
+        }
+
         // Restore both flags before flushing deferred deletes, so each object's destructor
         // properly calls gROOT->RecursiveRemove and removes itself from ROOT's global lists.
         // This prevents dangling pointers that would crash the RecursiveRemove cascade
@@ -1020,7 +1606,20 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
         }
       }
       else {
+        if (fBulkProjection && fBulkProjection->GetNInputs() > 0) {
+          NLogWarning("NGnTree::Process: Bulk projections are used only in thread mode, points of '%s' are "
+                      "projected one by one",
+                      name.c_str());
+        }
         ipcExecutor->SetBounds(mins, maxs);
+        if (costHistoryFile) {
+          ipcExecutor->SetTaskCosts(
+              BuildTaskCostsFromHistory(costHistoryFile.get(), name, binningIn, scheduledDefinitionIds));
+        }
+        // Tasks run over the definition ids, costs observed in this run are learned per bin
+        if (NDimensionalExecutor::IsCostAware()) {
+          ipcExecutor->SetTaskCoords(BuildTaskCoords(name, binningIn, scheduledDefinitionIds));
+        }
         // Capture final active worker count reported by the IPC executor so
         // we can deterministically rebuild per-worker counters for only the
         // workers that actually connected.
@@ -1037,14 +1636,26 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
             });
         processedEntries = acked;
 
+        // Entries produced by the losing copy of a speculated task are dropped on merge.
+        for (const auto & kv : ipcExecutor->GetLastSpeculativeDuplicates()) {
+          if (kv.first >= threadDataVector.size()) continue;
+          for (const size_t taskId : kv.second) {
+            if (taskId < scheduledDefinitionIds.size()) {
+              threadDataVector[kv.first].AddDuplicateBinId(scheduledDefinitionIds[taskId]);
+            }
+          }
+        }
+
         // Child processes update their own worker-object copies. Rebuild parent-side
         // per-worker counters from real ACK ownership reported by the IPC executor.
         const auto & workerTaskCounts = ipcExecutor->GetLastWorkerTaskCounts();
         for (size_t i = 0; i < threadDataVector.size(); ++i) {
           threadDataVector[i].SetNProcessed(0);
+          // Streamed entries were appended to this supervisor-side object and are kept.
+          if (threadDataVector[i].HasStreamedResults()) continue;
           auto * workerDef = threadDataVector[i].GetHnSparseBase()->GetBinning()->GetDefinition(name);
           if (workerDef) {
-            workerDef->GetIds().clear();
+            workerDef->ClearIds();
           }
         }
 
@@ -1064,19 +1675,19 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
         Printf("Finished processing binning definition '%s'. Post-processing results ...", name.c_str());
       // Update hnsbBinningIn with the processed ids
       NLogDebug("NGnTree::Process: [BEGIN] ------------------------------------------------");
-      binningIn->GetDefinition(name)->GetIds().clear();
+      binningIn->GetDefinition(name)->ClearIds();
       for (size_t i = 0; i < threadDataVector.size(); ++i) {
         NLogDebug("NGnTree::Process: -> Thread %zu processed %lld entries", i, threadDataVector[i].GetNProcessed());
       }
       if (useProcessIpc) {
         // Keep full definition membership (including overlaps) while scheduling
         // only non-overlapping ids for execution.
-        binningIn->GetDefinition(name)->GetIds() = originalDefinitionIdsMap[name];
+        binningIn->GetDefinition(name)->SetIds(originalDefinitionIdsMap[name]);
       }
       else {
         // In thread mode the worker-collected list contains only scheduled ids.
         // Restore the full source definition list so overlapping membership is preserved.
-        binningIn->GetDefinition(name)->GetIds() = originalDefinitionIdsMap[name];
+        binningIn->GetDefinition(name)->SetIds(originalDefinitionIdsMap[name]);
       }
       // Do not prune ids from other definitions.
       // Binning definitions may overlap by design, and order-dependent pruning
@@ -1086,10 +1697,14 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
     }
   }
   catch (const std::exception & ex) {
-    if (ipcExecutor) {
+    if (session && ipcExecutor) {
+      session->Close(/*abort=*/true);
+    }
+    else if (ipcExecutor) {
       ipcExecutor->FinishProcessIpc(/*abort=*/true);
-      ipcExecutor.reset();
     }
+    ipcExecutor = nullptr;
+    ipcExecutorOwned.reset();
 
     TString what(ex.what());
     if (what.Contains("Interrupted by user")) {
@@ -1109,12 +1724,51 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
   auto                                      end_par      = std::chrono::high_resolution_clock::now();
   std::chrono::duration<double, std::milli> par_duration = end_par - start_par_job;
 
+  // The merge target is prepared up front so that TCP workers can be added to
+  // the merge as soon as they report DONE, while others are still finishing.
+  Ndmspc::NGnThreadData * outputData = new Ndmspc::NGnThreadData();
+  outputData->Init(0, func, nullptr, nullptr, this, binningIn);
+  outputData->SetCfg(cfgRuntime);
+  // outputData->Init(0, func, this);
+  outputData->MergeBegin();
+
+  std::set<size_t> mergedWorkers;
+  auto             addToMerge = [&](Ndmspc::NGnThreadData & data) {
+    if (!mergedWorkers.insert(data.GetAssignedIndex()).second) return;
+    if (data.HasStreamedResults()) {
+      // Output lists stay in memory and are merged from there; write only the tree.
+      NLogTrace("NGnTree::Process: Closing streamed results of worker %zu with write", data.GetAssignedIndex());
+      data.GetHnSparseBase()->GetStorageTree()->Close(true);
+    }
+    // Always trust actual processed-count first.
+    // Some late-join/finish-ordering paths can make the registered-worker set
+    // incomplete even though a worker processed tasks.
+    if (data.GetNProcessed() == 0 && !data.HasStreamedResults()) {
+      NLogInfo("NGnTree::Process: Skipping worker %zu — processed 0 tasks", data.GetAssignedIndex());
+      return;
+    }
+    NLogTrace("NGnTree::Process: Adding thread data %zu to merge ...", data.GetAssignedIndex());
+    outputData->MergeAdd(&data);
+  };
+
   if (ipcExecutor) {
+    if (useTcp) {
+      ipcExecutor->SetWorkerDoneCallback([&](size_t idx) {
+        if (idx < threadDataVector.size()) addToMerge(threadDataVector[idx]);
+      });
+    }
     try {
-      ipcExecutor->FinishProcessIpc();
+      if (session) {
+        // Workers write their files and stay alive for the next job of the session.
+        ipcExecutor->FlushProcessIpc();
+      }
+      else {
+        ipcExecutor->FinishProcessIpc();
+      }
     }
     catch (const std::exception & ex) {
       NLogError("NGnTree::Process: Finalization failed before merge: %s", ex.what());
+      if (session) session->Close(/*abort=*/true);
       return false;
     }
   }
@@ -1149,32 +1803,33 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
 
   NLogDebug("NGnTree::Process: Merging %zu results ...", threadDataVector.size());
   if (!NLogger::GetConsoleOutput()) {
-    Printf("NGnTree::Process: merge start (%zu workers)", threadDataVector.size());
+    Printf("NGnTree::Process: merge start (%zu workers, %zu already added)", threadDataVector.size(),
+           mergedWorkers.size());
   }
-  const auto              mergeStart = std::chrono::high_resolution_clock::now();
-  TList *                 mergeList  = new TList();
-  Ndmspc::NGnThreadData * outputData = new Ndmspc::NGnThreadData();
-  outputData->Init(0, func, nullptr, nullptr, this, binningIn);
-  outputData->SetCfg(cfgRuntime);
-  // outputData->Init(0, func, this);
+  const auto mergeStart = std::chrono::high_resolution_clock::now();
 
   for (auto & data : threadDataVector) {
-    // Always trust actual processed-count first.
-    // Some late-join/finish-ordering paths can make the registered-worker set
-    // incomplete even though a worker processed tasks.
+    if (mergedWorkers.count(data.GetAssignedIndex())) continue;
     if (filterByDone && doneWorkers.find(data.GetAssignedIndex()) == doneWorkers.end()) {
       NLogInfo("NGnTree::Process: Skipping worker %zu — did not report DONE", data.GetAssignedIndex());
       continue;
     }
-    if (data.GetNProcessed() == 0) {
-      NLogInfo("NGnTree::Process: Skipping worker %zu — processed 0 tasks", data.GetAssignedIndex());
-      continue;
+    addToMerge(data);
+  }
+
+  // Entries checkpointed by an interrupted run are merged after the current workers.
+  size_t resumedOrder = 2 * threadDataVector.size();
+  for (const auto & kv : resumedFiles) {
+    NLogInfo("NGnTree::Process: Adding %zu checkpointed entries from '%s' to merge ...", kv.second.size(),
+             kv.first.c_str());
+    if (!outputData->MergeAddFile(kv.first, resumedOrder, kv.second)) {
+      NLogError("NGnTree::Process: Failed to merge checkpointed file '%s', exiting ...", kv.first.c_str());
+      return false;
     }
-    NLogTrace("NGnTree::Process: Adding thread data %zu to merge list ...", data.GetAssignedIndex());
-    mergeList->Add(&data);
+    resumedOrder += 2;
   }
 
-  Long64_t   nmerged  = outputData->Merge(mergeList);
+  Long64_t   nmerged  = outputData->MergeEnd();
   const auto mergeEnd = std::chrono::high_resolution_clock::now();
   if (!NLogger::GetConsoleOutput()) {
     const auto mergeSec = std::chrono::duration_cast<std::chrono::duration<double>>(mergeEnd - mergeStart).count();
@@ -1182,7 +1837,6 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
   }
   if (nmerged <= 0) {
     NLogError("NGnTree::Process: Failed to merge thread data, exiting ...");
-    delete mergeList;
     return false;
   }
   NLogInfo("NGnTree::Process: Merged %lld outputs successfully", nmerged);
@@ -1210,7 +1864,7 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
       NLogError("NGnTree::Process: Failed to restore definition '%s' after merge", name.c_str());
       return false;
     }
-    mergedDef->GetIds() = idsIt->second;
+    mergedDef->SetIds(idsIt->second);
   }
 
   for (size_t i = 0; i < defNames.size(); i++) {
@@ -1221,11 +1875,11 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
       NLogError("NGnTree::Process: Binning definition '%s' not found in NGnTree !!!", name.c_str());
       return false;
     }
-    sort(def->GetIds().begin(), def->GetIds().end());
+    def->SortIds();
     // outputData->GetHnSparseBase()->GetBinning()->GetDefinition(name)->GetIds() = def->GetIds();
 
     // Modify content in binning definitions based on def->GetIds()
-    def->GetContent()->Reset();
+    def->ResetContent();
     for (auto id : def->GetIds()) {
       if (id < 0 || id >= def->GetBinning()->GetContent()->GetNbins()) {
         NLogWarning("NGnTree::Process: Skipping invalid id=%lld in definition '%s' (content nbins=%lld)", id,
@@ -1240,9 +1894,8 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
                     id, name.c_str());
         continue;
       }
-      Long64_t bin = def->GetContent()->GetBin(point.GetStorageCoords());
-      NLogTrace("NGnThreadData::Merge: [%s] Adding def_id=%lld to content_bin=%lld", name.c_str(), id, bin);
-      def->GetContent()->SetBinContent(bin, id);
+      NLogTrace("NGnThreadData::Merge: [%s] Adding def_id=%lld to content", name.c_str(), id);
+      def->SetContentAt(point.GetStorageCoords(), id);
 
       if (mergedContentIds.insert(id).second) {
         mergedContentCoords.emplace_back(id, NUtils::ArrayToVector(point.GetCoords(), point.GetNDimensionsContent()));
@@ -1305,6 +1958,15 @@ bool NGnTree::Process(NGnProcessFuncPtr func, const std::vector<std::string> & d
     }
   }
 
+  if (journal) {
+    // The run is complete: the journal and the files of interrupted runs are no longer needed.
+    journal->Remove();
+    for (const auto & kv : resumedFiles) {
+      gSystem->Unlink(kv.first.c_str());
+      gSystem->Unlink(gSystem->GetDirName(kv.first.c_str()).Data());
+    }
+  }
+
   if (!NLogger::GetConsoleOutput()) {
     NLogPrint("NGnTree::Process: cleanup start (%s)", jobDir.c_str());
   } else {
@@ -1335,13 +1997,49 @@ TList * NGnTree::GetOutput(std::string name)
   if (name.empty()) {
     name = fBinning->GetCurrentDefinitionName();
   }
-  if (fOutputs.find(name) == fOutputs.end()) {
+  if (fOutputs.find(name) == fOutputs.end() && !LoadOutput(name)) {
     fOutputs[name] = new TList();
     fOutputs[name]->SetName(name.c_str());
   }
   return fOutputs[name];
 }
 
+std::map<std::string, TList *> NGnTree::GetOutputs() const
+{
+  ///
+  /// Get all output lists
+  ///
+
+  const std::set<std::string> pending = fPendingOutputs;
+  for (const auto & name : pending) {
+    LoadOutput(name);
+  }
+  return fOutputs;
+}
+
+TList * NGnTree::LoadOutput(const std::string & name) const
+{
+  ///
+  /// Read output list from the opened file
+  ///
+
+  // The directory is looked up in the open storage file, which may have been closed meanwhile
+  TFile *      file = fTreeStorage ? fTreeStorage->GetFile() : nullptr;
+  TDirectory * dir  = file ? file->GetDirectory("outputs") : nullptr;
+  if (fPendingOutputs.erase(name) == 0 || dir == nullptr) return nullptr;
+
+  TObject * obj = dir->Get(name.c_str());
+  TList *   l   = dynamic_cast<TList *>(obj);
+  if (!l) {
+    delete obj;
+    return nullptr;
+  }
+  fOutputs[name] = l;
+  NLogDebug("NGnTree::LoadOutput: Imported output list for binning '%s' with %d object(s)", name.c_str(),
+            l->GetEntries());
+  return l;
+}
+
 NGnTree * NGnTree::Open(const std::string & filename, const std::string & branches, const std::string & treename)
 {
   ///
@@ -1383,21 +2081,19 @@ NGnTree * NGnTree::Open(TTree * tree, const std::string & branches, TFile * file
     return nullptr;
   }
 
-  std::map<std::string, TList *> outputs;
-  TDirectory *                   dir = nullptr;
+  // Output lists are only listed here and read on first GetOutput()
+  std::set<std::string> outputNames;
+  TDirectory *          dir = nullptr;
   if (file) {
-    dir    = (TDirectory *)file->Get("outputs");
-    auto l = dir->GetListOfKeys();
-    for (auto kv : *l) {
-      TObject * obj = dir->Get(kv->GetName());
-      if (!obj) continue;
-      TList * l = dynamic_cast<TList *>(obj);
-      if (!l) continue;
-      outputs[l->GetName()] = l;
-      NLogDebug("Imported output list for binning '%s' with %d object(s) from file '%s'", l->GetName(), l->GetEntries(),
-                file->GetName());
+    dir = (TDirectory *)file->Get("outputs");
+  }
+  if (dir) {
+    for (auto key : *dir->GetListOfKeys()) {
+      outputNames.insert(key->GetName());
     }
+    NLogDebug("NGnTree::Open: Found %zu output list(s) in file '%s'", outputNames.size(), file->GetName());
   }
+
   // TDirectory * dir = (TDirectory *)tree->GetUserInfo()->FindObject("outputs");
   // if (dir) {
   //   dir->Print();
@@ -1423,7 +2119,7 @@ NGnTree * NGnTree::Open(TTree * tree, const std::string & branches, TFile * file
   }
   // Set all branches to be read
   hnstStorageTree->SetBranchAddresses();
-  ngnt->SetOutputs(outputs);
+  ngnt->fPendingOutputs = outputNames;
 
   NGnNavigator * nav = new NGnNavigator();
   nav->SetGnTree(ngnt);
@@ -1446,6 +2142,15 @@ void NGnTree::SetNavigator(NGnNavigator * navigator)
   fNavigator = navigator;
 }
 
+NBulkProjection * NGnTree::GetBulkProjection()
+{
+  ///
+  /// Returns bulk projections used by Process()
+  ///
+  if (!fBulkProjection) fBulkProjection = new NBulkProjection();
+  return fBulkProjection;
+}
+
 bool NGnTree::Close(bool write)
 {
   ///
@@ -1457,6 +2162,10 @@ bool NGnTree::Close(bool write)
     return false;
   }
 
+  // Outputs still in the file are needed for writing and cannot be read once it is closed
+  if (write) GetOutputs();
+  fPendingOutputs.clear();
+
   return fTreeStorage->Close(write, fOutputs);
 }
 
@@ -1546,12 +2255,15 @@ void NGnTree::Play(int timeout, std::string binning, std::vector<int> outputPoin
   binningDef->Print();
   bdContent->Reset();
 
+  // Opt-in (NDMSPC_READAHEAD): read the next entries while the current one is drawn
+  fTreeStorage->StartReadAhead(ids);
+
   // loop over all ids and print them
   for (auto id : ids) {
     // for (int id = 0; id < GetEntries(); id++) {
     GetEntry(id);
     fBinning->GetPoint()->Print();
-    TList * l = (TList *)fTreeStorage->GetBranch("_outputPoint")->GetObject();
+    TList * l = fTreeStorage->GetOutputPoint();
     if (!l || l->IsEmpty()) {
       NLogWarning("NGnTree::Play: No 'outputPoint' for entry %lld !!!", id);
       continue;
@@ -1631,6 +2343,7 @@ void NGnTree::Play(int timeout, std::string binning, std::vector<int> outputPoin
     if (timeout > 0) gSystem->Sleep(timeout);
     NLogInfo("%d", id);
   }
+  fTreeStorage->StopReadAhead();
 
   NLogInfo("Creating animation gif from %s/ndmspc_play_*.png ...", annimationTempDir.c_str());
   gSystem->Exec(
@@ -1729,7 +2442,7 @@ TList * NGnTree::Projection(const json & cfg, std::string binningName)
     return nullptr;
   }
 
-  binningDef->GetIds() = ids;
+  binningDef->SetIds(ids);
 
   // NUtils::SetAxisRanges(, std::vector<std::vector<int>> ranges)
   Process(processFunc, cfg);
@@ -1768,7 +2481,7 @@ std::string NGnTree::ExportResourceStatistics(std::string binningName)
     binningName = fBinning->GetCurrentDefinitionName();
   }
 
-  THnSparse * hns = (THnSparse *)fOutputs[binningName]->FindObject("resource_monitor");
+  THnSparse * hns = (THnSparse *)GetOutput(binningName)->FindObject("resource_monitor");
   if (!hns) {
     NLogError("NGnTree::ExportResourceStatistics: Resource monitor THnSparse not found in outputs for binning '%s' !!!",
               binningName.c_str());
@@ -1844,7 +2557,8 @@ bool NGnTree::InitParameters(const std::vector<std::string> & paramNames)
 }
 
 NGnTree * NGnTree::Import(const std::string & findPath, const std::string & fileName,
-                          const std::vector<std::string> & headers, const std::string & outputFile, bool close)
+                          const std::vector<std::string> & headers, const std::string & outputFile, bool close,
+                          bool fastClone)
 {
   ///
   /// Import NGnTree from mutiple files in the given path
@@ -1887,6 +2601,26 @@ NGnTree * NGnTree::Import(const std::string & findPath, const std::string & file
   cfg["filename"] = fileName;
   cfg["nDirAxes"] = nDirAxes;
   cfg["headers"]  = headers;
+
+  if (fastClone) {
+    int rc = ImportFastClone(ngnt, cfg);
+    if (rc < 0) {
+      NLogError("NGnTree::Import: Fast clone import failed !!!");
+      ngnt->Close(false);
+      delete ngnt;
+      return nullptr;
+    }
+    if (rc > 0) {
+      if (close) {
+        ngnt->Close(true);
+        delete ngnt;
+        ngnt = NGnTree::Open(outputFile.c_str());
+      }
+      return ngnt;
+    }
+    NLogWarning("NGnTree::Import: Sources cannot be fast cloned, importing entry by entry ...");
+  }
+
   // cfg["ndmspc"]["shared"]["currentFileName"]  = "";
   Ndmspc::NGnProcessFuncPtr processFunc = [](Ndmspc::NBinningPoint * point, TList * /*output*/, TList * outputPoint,
                                              int /*threadId*/) {
@@ -1920,6 +2654,14 @@ NGnTree * NGnTree::Import(const std::string & findPath, const std::string & file
         return;
       }
       point->SetTempObject("file", ngnt);
+      // Opt-in (NDMSPC_READAHEAD): entries of the source are read ahead in tree order, entries requested out of
+      // order are read directly
+      Long64_t nEntries = ngnt->GetStorageTree()->GetEntries();
+      if (nEntries > 1) {
+        std::vector<Long64_t> entries(nEntries);
+        std::iota(entries.begin(), entries.end(), 0);
+        ngnt->GetStorageTree()->StartReadAhead(entries);
+      }
     }
 
     int         nDirAxes  = cfg["nDirAxes"].get<int>();
@@ -1972,6 +2714,7 @@ NGnTree * NGnTree::Import(const std::string & findPath, const std::string & file
     NGnTree * ngnt = (NGnTree *)point->GetTempObject("file");
     if (ngnt) {
       NLogDebug("NGnTree::Import: Closing last file '%s' ...", ngnt->GetStorageTree()->GetFileName().c_str());
+      ngnt->GetStorageTree()->StopReadAhead();
       // ngnt->Close(false);
       // delete ngnt;
       point->SetTempObject("file", nullptr);
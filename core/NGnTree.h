@@ -6,6 +6,7 @@
 #include <TH2.h>
 #include <TH3.h>
 #include <TObject.h>
+#include <set>
 #include <vector>
 #include "NBinning.h"
 #include "NParameters.h"
@@ -71,7 +72,9 @@ using NGnEndFuncPtr = void (*)(Ndmspc::NBinningPoint *, int);
  *
  * @author Martin Vala <mvala@cern.ch>
  */
+class NBulkProjection;
 class NGnNavigator;
+class NGnProcessSession;
 class NGnTree : public TObject {
   public:
   /**
@@ -173,12 +176,16 @@ class NGnTree : public TObject {
 
   /**
    * @brief Get outputs map.
+   *
+   * Reads all output lists of an opened file that were not loaded yet.
    * @return Map of output names to TList pointers.
    */
-  std::map<std::string, TList *> GetOutputs() const { return fOutputs; }
+  std::map<std::string, TList *> GetOutputs() const;
 
   /**
    * @brief Get output list by name.
+   *
+   * Output lists of an opened file are read on first access.
    * @param name Output name (optional).
    * @return Pointer to TList.
    */
@@ -188,7 +195,11 @@ class NGnTree : public TObject {
    * @brief Set outputs map.
    * @param outputs Map of output names to TList pointers.
    */
-  void SetOutputs(std::map<std::string, TList *> outputs) { fOutputs = outputs; }
+  void SetOutputs(std::map<std::string, TList *> outputs)
+  {
+    fOutputs = outputs;
+    fPendingOutputs.clear();
+  }
 
   /**
    * @brief Get pointer to input NGnTree.
@@ -202,6 +213,18 @@ class NGnTree : public TObject {
    */
   void SetInput(NGnTree * input) { fInput = input; }
 
+  /**
+   * @brief Set whether the binning is deleted together with this tree.
+   * @param owns True to take ownership of the binning.
+   */
+  void SetOwnsBinning(bool owns) { fOwnsBinning = owns; }
+
+  /**
+   * @brief Set whether the storage tree is deleted together with this tree.
+   * @param owns True to take ownership of the storage tree.
+   */
+  void SetOwnsTreeStorage(bool owns) { fOwnsTreeStorage = owns; }
+
   /**
    * @brief Returns the navigator associated with this tree.
    * @return Pointer to the NGnNavigator instance.
@@ -294,6 +317,45 @@ class NGnTree : public TObject {
    */
   void SetWorkerMacro(const std::string & macroList) { fWorkerMacroList = macroList; }
 
+  /**
+   * @brief Use a persistent worker pool for Process() in IPC mode.
+   *
+   * The same session can be attached to several NGnTree objects; workers forked by
+   * the first Process() call are reconfigured for the following ones.
+   *
+   * @param session Worker pool (not owned, nullptr disables reuse).
+   */
+  void SetProcessSession(NGnProcessSession * session) { fProcessSession = session; }
+
+  /**
+   * @brief Get the persistent worker pool used by Process().
+   * @return Pointer to the session (nullptr if not set).
+   */
+  NGnProcessSession * GetProcessSession() const { return fProcessSession; }
+
+  /**
+   * @brief Execution mode Process() selects from NDMSPC_EXECUTION_MODE and NDMSPC_MAX_PROCESSES.
+   *
+   * Lets callers skip work only used in one mode, e.g. loading inputs for GetBulkProjection()
+   * outside of thread mode.
+   * @param nProcesses If not nullptr, set to the number of worker processes.
+   * @param nThreads ROOT threads; values below 1 use what Process() sets up (ROOT_MAX_THREADS or 1).
+   * @return "thread", "ipc" or "tcp".
+   */
+  static std::string GetExecutionMode(size_t * nProcesses = nullptr, int nThreads = -1);
+
+  /**
+   * @brief Get bulk projections prepared by Process() for every binning definition.
+   *
+   * Inputs added here are projected to all cells of a definition in one pass before its points
+   * are processed; the process function takes them via NBinningPoint::TakeProjection(). Only
+   * used in thread execution mode, other modes leave TakeProjection() returning nullptr, so add
+   * inputs only when GetExecutionMode() returns "thread".
+   *
+   * @return Pointer to NBulkProjection (created on first call, owned by this instance).
+   */
+  NBulkProjection * GetBulkProjection();
+
   /**
    * @brief Project tree data using configuration and binning name.
    * @param cfg JSON configuration object.
@@ -382,16 +444,24 @@ class NGnTree : public TObject {
    * Searches for the file in the given path, using the provided headers, and imports the NGnTree.
    * Optionally, the imported tree can be saved to a specified output file.
    *
+   * With fastClone the sources are scanned in parallel (when ROOT thread safety is enabled, see
+   * NUtils::IsThreadSafetyEnabled()) and their compressed baskets are copied
+   * without deserializing the branch objects (TTree fast cloning); only the binning and the
+   * definition are rewritten. Sources whose entries or branches do not allow it are imported
+   * entry by entry.
+   *
    * @param findPath The directory path to search for the file.
    * @param fileName The name of the file to import.
    * @param headers A vector of header strings to use during import.
    * @param outFileName The output file name to save the imported tree (default: "/tmp/ngnt_imported.root").
   * @param close If true, close the file after import when saving to outFileName (default: true).
+   * @param fastClone If true, copy baskets of the source trees instead of their objects (default: false).
    * @return A pointer to the imported NGnTree object, or nullptr on failure.
    */
   static NGnTree * Import(const std::string & findPath, const std::string & fileName,
                           const std::vector<std::string> & headers,
-                          const std::string &              outFileName = "/tmp/ngnt_imported.root", bool close = true);
+                          const std::string &              outFileName = "/tmp/ngnt_imported.root", bool close = true,
+                          bool                             fastClone = false);
 
   /**
    * @brief Helper: build object path string from configuration and a binning point.
@@ -405,7 +475,7 @@ class NGnTree : public TObject {
   protected:
   NBinning *                     fBinning{nullptr};     ///< Binning object
   NStorageTree *                 fTreeStorage{nullptr}; ///< Tree storage
-  std::map<std::string, TList *> fOutputs;              ///< Outputs
+  mutable std::map<std::string, TList *> fOutputs;      ///< Outputs (lists of an opened file are read on first use)
   NGnTree *                      fInput{nullptr};       ///< Input NGnTree for processing
   NGnNavigator *                 fNavigator{nullptr};   ///<! Navigator object
   NParameters *                  fParameters{nullptr};  ///< Parameters object
@@ -413,6 +483,12 @@ class NGnTree : public TObject {
   bool                           fOwnsTreeStorage{true};///< True when fTreeStorage is owned by this instance
   bool                           fIsPureCopy{false};    ///< Flag indicating pure copy mode
   std::string                    fWorkerMacroList;      ///< Comma-separated macro paths sent to TCP workers
+  NGnProcessSession *            fProcessSession{nullptr}; ///<! Persistent IPC worker pool (not owned)
+  mutable std::set<std::string>  fPendingOutputs;       ///<! Names of outputs still in the storage file
+  NBulkProjection *              fBulkProjection{nullptr}; ///<! Bulk projections used by Process()
+
+  /// Read output list from the opened file
+  TList * LoadOutput(const std::string & name) const;
 
   /// \cond CLASSIMP
   ClassDefOverride(NGnTree, 1);
@@ -164,4 +164,32 @@ double NResourceMonitor::GetCpuUsage() const
   return usage;
 }
 
+size_t NResourceMonitor::GetTimeByCoords(THnSparse * hns, std::map<std::vector<int>, double> & times)
+{
+  ///
+  /// Collect wall time per binning coordinate (summed over the worker axis)
+  ///
+  times.clear();
+  if (hns == nullptr || hns->GetNdimensions() < 3) {
+    NLogError("NResourceMonitor::GetTimeByCoords: Invalid resource monitor histogram !!!");
+    return 0;
+  }
+
+  const Int_t ndims = hns->GetNdimensions();
+  Int_t       timeBin = hns->GetAxis(ndims - 1)->FindFixBin("time");
+  if (timeBin <= 0) timeBin = 1;
+
+  std::vector<Int_t> coords(ndims);
+  std::vector<int>   key(ndims - 2);
+  for (Long64_t i = 0; i < hns->GetNbins(); ++i) {
+    const double value = hns->GetBinContent(i, coords.data());
+    if (coords[ndims - 1] != timeBin || !std::isfinite(value)) continue;
+    for (Int_t d = 0; d < ndims - 2; ++d) key[d] = coords[d + 1];
+    times[key] += value;
+  }
+
+  NLogTrace("NResourceMonitor::GetTimeByCoords: Found timing for %zu coordinates", times.size());
+  return times.size();
+}
+
 } // namespace Ndmspc
@@ -2,6 +2,8 @@
 #define Ndmspc_NResourceMonitor_H
 #include <sys/resource.h>
 #include <chrono>
+#include <map>
+#include <vector>
 #include <TObject.h>
 #include <THnSparse.h>
 
@@ -99,6 +101,14 @@ class NResourceMonitor : public TObject {
    */
   void End();
 
+  /**
+   * @brief Sums the recorded wall time over all workers for every binning coordinate.
+   * @param hns Resource monitor histogram with layout [worker, binning axes..., stat].
+   * @param times Output map from binning (storage) coordinates to wall time in seconds.
+   * @return Number of distinct binning coordinates found.
+   */
+  static size_t GetTimeByCoords(THnSparse * hns, std::map<std::vector<int>, double> & times);
+
   private:
   THnSparse *                                    fHnSparse{nullptr}; ///< THnSparse histogram for resource data
   rusage                                         fUsageStart;        ///< Resource usage at start
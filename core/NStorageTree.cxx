@@ -1,11 +1,22 @@
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <TClass.h>
 #include <TSystem.h>
 #include <TROOT.h>
 #include <TFolder.h>
 #include <TDirectory.h>
+#include <TParameter.h>
 #include "NBinning.h"
 #include "NBinningDef.h"
 #include "NBinningPoint.h"
 #include "NLogger.h"
+#include "NMetrics.h"
 #include "NUtils.h"
 
 #include "NStorageTree.h"
@@ -15,6 +26,84 @@ ClassImp(Ndmspc::NStorageTree);
 /// \endcond
 
 namespace Ndmspc {
+
+/// State shared between NStorageTree and its read-ahead thread
+struct NStorageReadAhead {
+  /// Objects of one prefetched entry
+  struct Item {
+    Long64_t                                       entry{-1}; ///< Tree entry
+    Long64_t                                       bytes{0};  ///< Bytes read
+    std::vector<std::pair<std::string, TObject *>> objects;   ///< Objects per branch
+  };
+  std::vector<Long64_t>   entries;     ///< Entries in reading order
+  size_t                  depth{0};    ///< Maximum number of queued entries
+  size_t                  next{0};     ///< Position of the next entry the consumer takes
+  std::deque<Item>        queue;       ///< Prefetched entries, in order of entries
+  bool                    stop{false}; ///< Set by consumer to end the thread
+  bool                    done{false}; ///< Set by the thread when it ended
+  std::mutex              mutex;       ///< Guards queue, next, stop and done
+  std::condition_variable cv;          ///< Signals queue changes
+  std::thread             thread;      ///< Read-ahead thread
+
+  static void DeleteItem(Item & item)
+  {
+    for (auto & kv : item.objects) NUtils::SafeDeleteObject(kv.second);
+  }
+
+  /// Reads the listed entries from an own handle of the file
+  void Run(const std::string & fileName, const std::string & treeName, const std::vector<std::string> & branches,
+           Long64_t cacheSize)
+  {
+    TFile * file = TFile::Open(fileName.c_str(), "READ");
+    TTree * tree = file && !file->IsZombie() ? file->Get<TTree>(treeName.c_str()) : nullptr;
+    if (tree == nullptr) {
+      NLogWarning("NStorageTree: Read-ahead cannot open tree '%s' in '%s' !!!", treeName.c_str(), fileName.c_str());
+    }
+    else {
+      std::vector<TObject *> objects(branches.size(), nullptr);
+      std::vector<TBranch *> tbranches(branches.size(), nullptr);
+      tree->SetBranchStatus("*", 0);
+      for (size_t i = 0; i < branches.size(); ++i) {
+        tree->SetBranchStatus(NTreeBranch::GetStatusPattern(branches[i]).c_str(), 1);
+        tree->SetBranchAddress(branches[i].c_str(), &objects[i]);
+        tbranches[i] = tree->GetBranch(branches[i].c_str());
+      }
+      auto [minIt, maxIt] = std::minmax_element(entries.begin(), entries.end());
+      tree->SetCacheSize(cacheSize);
+      for (const auto & name : branches) tree->AddBranchToCache(name.c_str(), kTRUE);
+      tree->SetCacheEntryRange(*minIt, *maxIt + 1);
+      tree->StopCacheLearningPhase();
+
+      for (Long64_t entry : entries) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [this] { return stop || queue.size() < depth; });
+          if (stop) break;
+        }
+        Item item;
+        item.entry = entry;
+        for (size_t i = 0; i < branches.size(); ++i) {
+          // A null address makes ROOT allocate a new object, which the item owns from now on
+          objects[i] = nullptr;
+          if (tbranches[i]) item.bytes += tbranches[i]->GetEntry(entry);
+          item.objects.emplace_back(branches[i], objects[i]);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(item));
+        cv.notify_all();
+      }
+      tree->ResetBranchAddresses();
+    }
+    if (file) {
+      file->Close();
+      delete file;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    cv.notify_all();
+  }
+};
+
 NStorageTree::NStorageTree(NBinning * binning) : TObject(), fBinning(binning)
 {
   ///
@@ -27,6 +116,8 @@ NStorageTree::~NStorageTree()
   ///
   /// Destructor
   ///
+  StopReadAhead();
+  ClearOutputPoint();
 }
 
 void NStorageTree::Clear(Option_t * option)
@@ -45,7 +136,10 @@ void NStorageTree::Clear(Option_t * option)
     }
     fTree = nullptr;
   }
+  ClearOutputPoint();
   fBranchesMap.clear();
+  fOutputPointColumns.clear();
+  fEntry    = -1;
   fFileName = "ngnt.root";
   fPrefix.clear();
   fPostfix.clear();
@@ -175,6 +269,22 @@ bool NStorageTree::SetFileTree(TFile * file, TTree * tree)
     fFileName = fFile->GetName();
   }
   fTree = tree;
+
+  // Definition ids written to the index are read on first use; a stale index is ignored
+  TFile *                indexFile = fFile ? fFile : fTree->GetCurrentFile();
+  TDirectory *           index     = indexFile ? indexFile->GetDirectory("index") : nullptr;
+  TParameter<Long64_t> * entries   = index ? index->Get<TParameter<Long64_t>>("_entries") : nullptr;
+  if (index && fBinning) {
+    const bool valid = entries && entries->GetVal() == fTree->GetEntries();
+    if (!valid) {
+      NLogWarning("NStorageTree::SetFileTree: Index of '%s' does not match the tree, rebuilding ids from content ...",
+                  indexFile->GetName());
+    }
+    for (auto & kv : fBinning->GetDefinitions()) {
+      if (kv.second->GetIds().empty()) kv.second->SetIdsDirectory(valid ? index : nullptr);
+    }
+  }
+  delete entries;
   // print prefix and postfix
   return true;
 }
@@ -205,7 +315,14 @@ Long64_t NStorageTree::GetEntry(Long64_t entry, NBinningPoint * point, bool chec
     NLogWarning("NStorageTree::GetEntry: Binning point is nullptr, cannot set point content !!!");
     return 0;
   }
-  Long64_t bytessum = 0;
+  fEntry            = entry;
+  Long64_t bytessum = fReadAhead ? TakeReadAhead(entry) : -1;
+  if (bytessum >= 0) {
+    NMetrics::Add(NMetrics::kTreeBytesRead, bytessum);
+    NMetrics::Tick(NMetrics::kTreeEntriesRead);
+    return bytessum;
+  }
+  bytessum = 0;
 
   for (auto & kv : fBranchesMap) {
     NLogTrace("NStorageTree::GetEntry: Getting content from '%s' branch ...", kv.first.c_str());
@@ -221,17 +338,129 @@ Long64_t NStorageTree::GetEntry(Long64_t entry, NBinningPoint * point, bool chec
     bytessum += kv.second.GetEntry(fTree, entry);
   }
 
-  ProcInfo_t info;
-  gSystem->GetProcInfo(&info);
-  NLogDebug("NStorageTree::GetEntry: [entry=%lld] Bytes read : %.3f MB [RSS]: %ld kB file='%s'", entry,
-            (double)bytessum / (1024 * 1024), info.fMemResident, fFileName.empty() ? "memory" : fFileName.c_str());
-
-  // NLogDebug("NStorageTree::GetEntry: [entry=%lld] Bytes read : %.3f MB  file='%s'", entry,
-  //           (double)bytessum / (1024 * 1024), fFileName.empty() ? "memory" : fFileName.c_str());
+  NMetrics::Add(NMetrics::kTreeBytesRead, bytessum);
+  NMetrics::Tick(NMetrics::kTreeEntriesRead);
+  NLogTrace("NStorageTree::GetEntry: [entry=%lld] Bytes read : %.3f MB file='%s'", entry,
+            (double)bytessum / (1024 * 1024), fFileName.empty() ? "memory" : fFileName.c_str());
 
   return bytessum;
 }
 
+bool NStorageTree::StartReadAhead(const std::vector<Long64_t> & entries, int depth)
+{
+  ///
+  /// Start read-ahead of entries
+  ///
+  StopReadAhead();
+
+  if (depth < 0) {
+    depth              = 0;
+    const char * envRA = gSystem->Getenv("NDMSPC_READAHEAD");
+    try {
+      if (envRA) depth = std::stoi(std::string(envRA));
+    }
+    catch (...) {
+      NLogWarning("NDMSPC_READAHEAD invalid: '%s'", envRA);
+    }
+  }
+  if (depth <= 0 || entries.empty()) return false;
+  if (fTree == nullptr || fFile == nullptr || fFileName.empty()) {
+    NLogTrace("NStorageTree::StartReadAhead: Tree is not stored in a file, read-ahead is not used ...");
+    return false;
+  }
+  if (!NUtils::IsThreadSafetyEnabled()) {
+    NLogWarning("NStorageTree::StartReadAhead: ROOT thread safety is not enabled, read-ahead is not used ...");
+    return false;
+  }
+
+  // NDMSPC_READAHEAD_CACHE_SIZE: TTreeCache size in bytes of the consumer and of the read-ahead tree (default 32 MB)
+  Long64_t     cacheSize    = 32LL * 1024 * 1024;
+  const char * envCacheSize = gSystem->Getenv("NDMSPC_READAHEAD_CACHE_SIZE");
+  try {
+    if (envCacheSize) cacheSize = std::stoll(std::string(envCacheSize));
+  }
+  catch (...) {
+    NLogWarning("NDMSPC_READAHEAD_CACHE_SIZE invalid: '%s'", envCacheSize);
+  }
+
+  std::vector<std::string> branches;
+  for (auto & kv : fBranchesMap) {
+    if (kv.second.GetBranch() == nullptr || kv.second.GetBranchStatus() == 0) continue;
+    branches.push_back(kv.first);
+  }
+  if (branches.empty()) return false;
+
+  // Cache for entries read directly (not in the list or after StopReadAhead())
+  auto [minIt, maxIt] = std::minmax_element(entries.begin(), entries.end());
+  fTree->SetCacheSize(cacheSize);
+  for (const auto & name : branches) fTree->AddBranchToCache(name.c_str(), kTRUE);
+  fTree->SetCacheEntryRange(*minIt, *maxIt + 1);
+  fTree->StopCacheLearningPhase();
+
+  fReadAhead          = new NStorageReadAhead();
+  fReadAhead->entries = entries;
+  fReadAhead->depth   = depth;
+  fReadAhead->thread  = std::thread(&NStorageReadAhead::Run, fReadAhead, fFileName, std::string(fTree->GetName()),
+                                    branches, cacheSize);
+  NLogDebug("NStorageTree::StartReadAhead: Reading %zu entries of %zu branches ahead (depth=%d, cache=%lld bytes) ...",
+            entries.size(), branches.size(), depth, cacheSize);
+  return true;
+}
+
+void NStorageTree::StopReadAhead()
+{
+  ///
+  /// Stop read-ahead
+  ///
+  if (fReadAhead == nullptr) return;
+  {
+    std::lock_guard<std::mutex> lock(fReadAhead->mutex);
+    fReadAhead->stop = true;
+  }
+  fReadAhead->cv.notify_all();
+  if (fReadAhead->thread.joinable()) fReadAhead->thread.join();
+  for (auto & item : fReadAhead->queue) NStorageReadAhead::DeleteItem(item);
+  delete fReadAhead;
+  fReadAhead = nullptr;
+}
+
+Long64_t NStorageTree::TakeReadAhead(Long64_t entry)
+{
+  ///
+  /// Take prefetched entry
+  ///
+  NStorageReadAhead * ra = fReadAhead;
+
+  std::unique_lock<std::mutex> lock(ra->mutex);
+  // Entries skipped by the consumer are dropped; entries not in the list are read directly
+  auto it = std::find(ra->entries.begin() + ra->next, ra->entries.end(), entry);
+  if (it == ra->entries.end()) return -1;
+  const size_t pos = it - ra->entries.begin();
+
+  NStorageReadAhead::Item item;
+  while (ra->next <= pos) {
+    ra->cv.wait(lock, [ra] { return !ra->queue.empty() || ra->done; });
+    if (ra->queue.empty()) return -1;
+    item = std::move(ra->queue.front());
+    ra->queue.pop_front();
+    if (ra->next++ < pos) NStorageReadAhead::DeleteItem(item);
+  }
+  lock.unlock();
+  ra->cv.notify_all();
+
+  for (auto & kv : item.objects) {
+    auto b = fBranchesMap.find(kv.first);
+    if (b == fBranchesMap.end()) {
+      NUtils::SafeDeleteObject(kv.second);
+      continue;
+    }
+    b->second.AdoptObject(kv.second, entry);
+  }
+  NLogTrace("NStorageTree::GetEntry: [entry=%lld] Bytes read ahead : %.3f MB", entry,
+            (double)item.bytes / (1024 * 1024));
+  return item.bytes;
+}
+
 Int_t NStorageTree::Fill(NBinningPoint * point, NStorageTree * hnstIn, bool ignoreFilledCheck,
                          std::vector<std::vector<int>> ranges, bool useProjection)
 {
@@ -248,12 +477,17 @@ Int_t NStorageTree::Fill(NBinningPoint * point, NStorageTree * hnstIn, bool igno
   for (auto & kv : fBranchesMap) {
     NLogTrace("NStorageTree::Fill: Saving content from %s ...", kv.first.c_str());
     if (hnstIn) {
-      THnSparse * in = (THnSparse *)hnstIn->GetBranch(kv.first)->GetObject();
+      // Output point branches are set by SetOutputPoint(), branches without an input object keep their object
+      NTreeBranch * bIn = hnstIn->GetBranch(kv.first);
+      if (bIn == nullptr || bIn->GetBranchStatus() == 0 || bIn->GetObject() == nullptr ||
+          IsOutputPointBranchName(kv.first))
+        continue;
+      THnSparse * in = (THnSparse *)bIn->GetObject();
       if (ranges.size() > 0) {
         NUtils::SetAxisRanges(in, ranges);
       }
       kv.second.Branch(fTree, nullptr);
-      kv.second.SaveEntry(hnstIn->GetBranch(kv.first), useProjection);
+      kv.second.SaveEntry(bIn, useProjection);
     }
     else {
       kv.second.SaveEntry(GetBranch(kv.first), false);
@@ -262,7 +496,7 @@ Int_t NStorageTree::Fill(NBinningPoint * point, NStorageTree * hnstIn, bool igno
 
   Long64_t bin = point->Fill(ignoreFilledCheck);
   if (bin < 0 && ignoreFilledCheck == false) {
-    fBinning->GetDefinition()->GetContent()->SetBinContent(point->GetStorageCoords(), point->GetEntryNumber());
+    fBinning->GetDefinition()->SetContentAt(point->GetStorageCoords(), point->GetEntryNumber());
 
     NLogWarning("Point was already processed, skipping ...");
     // NLogWarning("NStorageTree::Fill: Point was already filled !!!");
@@ -290,14 +524,14 @@ Int_t NStorageTree::Fill(NBinningPoint * point, NStorageTree * hnstIn, bool igno
   }
 
   Long64_t entry = fTree->GetEntries() - 1;
-  fBinning->GetDefinition()->GetContent()->SetBinContent(point->GetStorageCoords(), point->GetEntryNumber());
+  fEntry         = -1; // branch objects hold what was written
+  fBinning->GetDefinition()->SetContentAt(point->GetStorageCoords(), point->GetEntryNumber());
   point->SetEntryNumber(entry);
 
-  ProcInfo_t info;
-  gSystem->GetProcInfo(&info);
-  NLogDebug("NStorageTree::Fill: [entry=%lld] Bytes written : %.3f MB [RSS]: %ld kB file='%s'", entry,
-            (Double_t)nBytes / (1024 * 1024), info.fMemResident,
-            fTree->GetCurrentFile() ? fTree->GetCurrentFile()->GetName() : "memory");
+  NMetrics::Add(NMetrics::kTreeBytesWritten, nBytes);
+  NMetrics::Tick(NMetrics::kTreeEntriesWritten);
+  NLogTrace("NStorageTree::Fill: [entry=%lld] Bytes written : %.3f MB file='%s'", entry,
+            (Double_t)nBytes / (1024 * 1024), fTree->GetCurrentFile() ? fTree->GetCurrentFile()->GetName() : "memory");
 
   return nBytes;
 }
@@ -307,6 +541,7 @@ bool NStorageTree::Close(bool write, std::map<std::string, TList *> outputs)
   ///
   /// Close
   ///
+  StopReadAhead();
 
   if (write) {
 
@@ -315,9 +550,15 @@ bool NStorageTree::Close(bool write, std::map<std::string, TList *> outputs)
       return false;
     }
 
+    ClearCheckpointInfo();
     TList * userInfo = fTree->GetUserInfo();
     if (fBinning) {
-      userInfo->Add(fBinning->Clone());
+      // Definition ids are written to the index, so Open() does not read them with the binning
+      NBinning * binning = (NBinning *)fBinning->Clone();
+      if (fFile) {
+        for (auto & kv : binning->GetDefinitions()) kv.second->ClearIds();
+      }
+      userInfo->Add(binning);
     }
     else {
       NLogError("NStorageTree::Close: Binning is not present, cannot store binning in user info !!! "
@@ -331,7 +572,7 @@ bool NStorageTree::Close(bool write, std::map<std::string, TList *> outputs)
       fFile->cd();
       // fFile->Print();
 
-      fFile->mkdir("outputs");
+      fFile->mkdir("outputs", "", kTRUE);
       fFile->cd("outputs");
       for (auto & kv : outputs) {
         if (kv.second && !kv.second->IsEmpty()) {
@@ -341,6 +582,15 @@ bool NStorageTree::Close(bool write, std::map<std::string, TList *> outputs)
                     kv.second->GetEntries());
         }
       }
+      fFile->mkdir("index", "", kTRUE);
+      fFile->cd("index");
+      for (auto & kv : fBinning->GetDefinitions()) {
+        gDirectory->WriteObject(&kv.second->GetIds(), kv.first.c_str(), "overwrite");
+      }
+      TParameter<Long64_t> entries("_entries", fTree->GetEntries());
+      entries.Write("_entries", TObject::kOverwrite);
+      NLogTrace("NStorageTree::Close: Index of %zu definition(s) was written", fBinning->GetDefinitions().size());
+
       fFile->cd();
       fTree->Write("", TObject::kOverwrite);
       fFile->Close();
@@ -348,6 +598,7 @@ bool NStorageTree::Close(bool write, std::map<std::string, TList *> outputs)
     }
   }
   else {
+    ClearCheckpointInfo();
     if (fFile) {
       // Remove 'this' from TTree's UserInfo before deleting the file.
       // TTree is owned by TFile; when SafeDelete(fFile) triggers ~TFile -> ~TTree,
@@ -361,6 +612,9 @@ bool NStorageTree::Close(bool write, std::map<std::string, TList *> outputs)
     }
   }
 
+  if (fBinning) {
+    for (auto & kv : fBinning->GetDefinitions()) kv.second->DetachIdsDirectory();
+  }
   SafeDelete(fFile);
   // gROOT->GetListOfFiles()->Remove(fFile); // Remove file from ROOT file list to prevent it from being closed
   fFile = nullptr;
@@ -368,6 +622,231 @@ bool NStorageTree::Close(bool write, std::map<std::string, TList *> outputs)
   return true;
 }
 
+bool NStorageTree::Checkpoint()
+{
+  ///
+  /// Store binning and storage info and autosave the tree so the file survives a crash
+  ///
+  if (!fTree || !fFile || !fBinning) {
+    return false;
+  }
+
+  ClearCheckpointInfo();
+  TList * userInfo = fTree->GetUserInfo();
+  fCheckpointInfo.push_back(fBinning->Clone());
+  fCheckpointInfo.push_back(Clone());
+  for (auto * obj : fCheckpointInfo) userInfo->Add(obj);
+
+  TDirectory::TContext context(fFile);
+  // NGnTree::Open() expects the outputs directory; output lists are only written by Close(true).
+  fFile->mkdir("outputs", "", kTRUE);
+  fTree->AutoSave("SaveSelf FlushBaskets");
+  fFile->Flush();
+  NLogTrace("NStorageTree::Checkpoint: %lld entries saved to '%s'", fTree->GetEntries(), fFile->GetName());
+  return true;
+}
+
+void NStorageTree::ClearCheckpointInfo()
+{
+  if (fTree && fTree->GetUserInfo()) {
+    for (auto * obj : fCheckpointInfo) fTree->GetUserInfo()->Remove(obj);
+  }
+  for (auto * obj : fCheckpointInfo) delete obj;
+  fCheckpointInfo.clear();
+}
+
+void NStorageTree::SetOutputPoint(TList * outputPoint)
+{
+  ///
+  /// Set output point list
+  ///
+  if (fTree == nullptr) {
+    NLogError("NStorageTree::SetOutputPoint: Tree is not initialized !!! Run 'NStorageTree::InitTree(...)' first !!!");
+    return;
+  }
+  if (GetBranch("_outputPoint") == nullptr) AddBranch("_outputPoint", nullptr, "TList");
+
+  if (!fOutputPointLayoutSet && outputPoint) {
+    fOutputPointLayoutSet = true;
+    // Columns are chosen only for a new tree, entries filled before keep their layout
+    std::string layout = gSystem->Getenv("NDMSPC_OUTPUT_LAYOUT") ? gSystem->Getenv("NDMSPC_OUTPUT_LAYOUT") : "columns";
+    if (layout != "columns" && layout != "list") {
+      NLogWarning("NDMSPC_OUTPUT_LAYOUT invalid: '%s' (use 'columns' or 'list'), using 'columns' ...", layout.c_str());
+      layout = "columns";
+    }
+    if (layout == "columns" && fOutputPointColumns.empty() && fTree->GetEntries() == 0) {
+      for (auto obj : *outputPoint) {
+        if (obj == nullptr) continue;
+        std::string name = obj->GetName();
+        if (!IsOutputPointColumnName(name)) {
+          NLogTrace("NStorageTree::SetOutputPoint: Keeping '%s' in the _outputPoint list ...", name.c_str());
+          continue;
+        }
+        if (name == "_outputPointMissing" || GetBranch(GetOutputPointBranchName(name))) continue;
+        NLogTrace("NStorageTree::SetOutputPoint: Storing '%s' (%s) in its own branch ...", name.c_str(),
+                  obj->ClassName());
+        AddBranch(GetOutputPointBranchName(name), obj, obj->ClassName());
+      }
+    }
+  }
+
+  if (fOutputPointColumns.empty() || outputPoint == nullptr) {
+    GetBranch("_outputPoint")->SetAddress(outputPoint);
+    return;
+  }
+
+  if (fOutputPointRest == nullptr) fOutputPointRest = new TList();
+  fOutputPointRest->Clear("nodelete");
+
+  std::set<std::string> placed;
+  for (auto obj : *outputPoint) {
+    if (obj == nullptr) continue;
+    NTreeBranch * b = GetBranch(GetOutputPointBranchName(obj->GetName()));
+    if (b && !placed.count(obj->GetName()) && b->GetObjectClassName() == obj->ClassName()) {
+      b->SetAddress(obj);
+      placed.insert(obj->GetName());
+      continue;
+    }
+    fOutputPointRest->Add(obj);
+  }
+
+  // Columns need an object in every entry; missing ones get a default object and are listed in the rest
+  std::string missing;
+  for (const auto & name : fOutputPointColumns) {
+    if (placed.count(name)) continue;
+    NTreeBranch * b = GetBranch(GetOutputPointBranchName(name));
+    if (b == nullptr) continue;
+    TObject *& empty = fOutputPointEmpty[name];
+    if (empty == nullptr) {
+      TDirectory::TContext ctx(nullptr); // keep histograms out of the output file
+      TClass *             cl = TClass::GetClass(b->GetObjectClassName().c_str());
+      empty                   = cl ? static_cast<TObject *>(cl->New()) : nullptr;
+    }
+    b->SetAddress(empty);
+    missing += name + ";";
+  }
+  if (!missing.empty()) {
+    if (fOutputPointMissing == nullptr) fOutputPointMissing = new TNamed("_outputPointMissing", "");
+    fOutputPointMissing->SetTitle((";" + missing).c_str());
+    fOutputPointRest->Add(fOutputPointMissing);
+  }
+  GetBranch("_outputPoint")->SetAddress(fOutputPointRest);
+}
+
+TObject * NStorageTree::ReadBranchObject(const std::string & name)
+{
+  ///
+  /// Return branch object of the current entry
+  ///
+  auto it = fBranchesMap.find(name);
+  if (it == fBranchesMap.end()) return nullptr;
+  NTreeBranch & b = it->second;
+  if (fEntry >= 0 && b.GetReadEntry() != fEntry && b.GetBranch()) {
+    NLogTrace("NStorageTree::ReadBranchObject: Reading '%s' for entry %lld ...", name.c_str(), fEntry);
+    // Disabled branches are skipped by GetEntry() only, the tree has to read them here
+    if (fTree->GetBranchStatus(name.c_str()) == 0)
+      fTree->SetBranchStatus(NTreeBranch::GetStatusPattern(name).c_str(), 1);
+    b.GetEntry(fTree, fEntry);
+  }
+  return b.GetObject();
+}
+
+TObject * NStorageTree::GetOutputPointObject(const std::string & name)
+{
+  ///
+  /// Return one output point object of the current entry
+  ///
+  TList * rest = dynamic_cast<TList *>(ReadBranchObject("_outputPoint"));
+  if (std::find(fOutputPointColumns.begin(), fOutputPointColumns.end(), name) == fOutputPointColumns.end()) {
+    return rest ? rest->FindObject(name.c_str()) : nullptr;
+  }
+  TObject * missing = rest ? rest->FindObject("_outputPointMissing") : nullptr;
+  if (missing && std::string(missing->GetTitle()).find(";" + name + ";") != std::string::npos) return nullptr;
+  return ReadBranchObject(GetOutputPointBranchName(name));
+}
+
+TList * NStorageTree::GetOutputPoint()
+{
+  ///
+  /// Return output point list of the current entry
+  ///
+  TList * rest = dynamic_cast<TList *>(ReadBranchObject("_outputPoint"));
+  if (fOutputPointColumns.empty()) return rest;
+
+  if (fOutputPointAll == nullptr) fOutputPointAll = new TList();
+  fOutputPointAll->Clear("nodelete");
+  for (const auto & name : fOutputPointColumns) {
+    TObject * obj = GetOutputPointObject(name);
+    if (obj) fOutputPointAll->Add(obj);
+  }
+  if (rest) {
+    for (auto obj : *rest) {
+      if (obj && std::string(obj->GetName()) != "_outputPointMissing") fOutputPointAll->Add(obj);
+    }
+  }
+  return fOutputPointAll;
+}
+
+bool NStorageTree::IsOutputPointBranchName(const std::string & name)
+{
+  ///
+  /// Check if branch stores the output point list or one of its columns
+  ///
+  const std::string prefix = "_outputPoint_";
+  return name == "_outputPoint" ||
+         (name.size() > prefix.size() + 1 && name.rfind(prefix, 0) == 0 && name.back() == '.');
+}
+
+bool NStorageTree::IsOutputPointColumnName(const std::string & name)
+{
+  ///
+  /// Check if object name can be used in a branch name
+  ///
+  if (name.empty()) return false;
+  return std::all_of(name.begin(), name.end(), [](char c) { return std::isalnum((unsigned char)c) || c == '_'; });
+}
+
+std::vector<std::string> NStorageTree::GetOutputPointBranchNames() const
+{
+  ///
+  /// Return names of output point branches
+  ///
+  std::vector<std::string> names;
+  if (fBranchesMap.count("_outputPoint")) names.push_back("_outputPoint");
+  for (const auto & name : fOutputPointColumns) {
+    if (fBranchesMap.count(GetOutputPointBranchName(name))) names.push_back(GetOutputPointBranchName(name));
+  }
+  return names;
+}
+
+void NStorageTree::ClearOutputPoint()
+{
+  ///
+  /// Delete transient output point objects
+  ///
+  for (const auto & name : fOutputPointColumns) {
+    auto it = fBranchesMap.find(GetOutputPointBranchName(name));
+    if (it != fBranchesMap.end() && fOutputPointEmpty.count(name) && it->second.GetObject() == fOutputPointEmpty[name])
+      it->second.SetObject(nullptr);
+  }
+  for (auto & kv : fOutputPointEmpty) delete kv.second;
+  fOutputPointEmpty.clear();
+  auto rest = fBranchesMap.find("_outputPoint");
+  if (rest != fBranchesMap.end() && rest->second.GetObject() &&
+      (rest->second.GetObject() == fOutputPointRest || rest->second.GetObject() == fOutputPointAll))
+    rest->second.SetObject(nullptr);
+  // The lists do not own their objects, which may be deleted already
+  if (fOutputPointRest) fOutputPointRest->Clear("nodelete");
+  delete fOutputPointRest;
+  fOutputPointRest = nullptr;
+  if (fOutputPointAll) fOutputPointAll->Clear("nodelete");
+  delete fOutputPointAll;
+  fOutputPointAll = nullptr;
+  delete fOutputPointMissing;
+  fOutputPointMissing   = nullptr;
+  fOutputPointLayoutSet = false;
+}
+
 std::vector<std::string> NStorageTree::GetBrancheNames(bool onlyEnabled) const
 {
   ///
@@ -394,7 +873,17 @@ bool NStorageTree::AddBranch(const std::string & name, void * address, const std
     return false;
   }
 
-  fBranchesMap[name] = NTreeBranch(fTree, name, address, className);
+  // Output point columns: scalar parameters are split into columns, other objects are kept whole
+  int splitLevel = 99;
+  if (name != "_outputPoint" && IsOutputPointBranchName(name)) {
+    const std::string prefix = "_outputPoint_";
+    splitLevel               = TString(className.c_str()).BeginsWith("TParameter") ? 99 : 0;
+    std::string objName      = name.substr(prefix.size(), name.size() - prefix.size() - 1);
+    if (std::find(fOutputPointColumns.begin(), fOutputPointColumns.end(), objName) == fOutputPointColumns.end())
+      fOutputPointColumns.push_back(objName);
+  }
+
+  fBranchesMap[name] = NTreeBranch(fTree, name, address, className, splitLevel);
   return true;
 }
 NTreeBranch * NStorageTree::GetBranch(const std::string & name)
@@ -481,7 +970,6 @@ Long64_t NStorageTree::Merge(TCollection * list)
     NLogError("NStorageTree::Merge: List is empty !!!");
     return -1;
   }
-  // return 0;
   if (fTree == nullptr) {
     NLogError("NStorageTree::Merge: Tree is not initialized !!! Run 'NStorageTree::InitTree(...)' first !!!");
     return -1;
@@ -489,164 +977,242 @@ Long64_t NStorageTree::Merge(TCollection * list)
 
   Long64_t nmerged = list->GetEntries();
   NLogTrace("NStorageTree::Merge: Merging %d trees into tree '%s' ...", list->GetEntries(), fTree->GetName());
-  NLogTrace("NStorageTree::Merge: Merging %zu objects via NStorageTree::Merge ...", list->GetEntries());
 
-  // Loop over all binning definitions in the list
+  std::vector<NStorageMergeIndex> sources;
+  TIter                           next(list);
+  NStorageTree *                  obj = nullptr;
+  while ((obj = dynamic_cast<NStorageTree *>(next()))) {
+    if (obj == this) continue;
+    sources.emplace_back();
+    if (BuildMergeIndex(obj, sources.back()) < 0) {
+      NLogError("NStorageTree::Merge: Cannot index '%s', skipping ...", obj->GetFileName().c_str());
+      sources.pop_back();
+      obj->Close(false);
+    }
+  }
+  if (MergeIndexed(sources) < 0) return -1;
+
+  return nmerged;
+}
+
+Long64_t NStorageTree::BuildMergeIndex(NStorageTree * source, NStorageMergeIndex & index) const
+{
+  ///
+  /// Map source entries to target content bins
+  ///
+  index        = NStorageMergeIndex();
+  index.source = source;
+
+  if (!source || !source->GetTree() || !source->GetBinning() || !source->GetBinning()->GetContent()) {
+    NLogError("NStorageTree::BuildMergeIndex: Source tree or its binning is not initialized !!!");
+    return -1;
+  }
+  THnSparse * target = fBinning ? fBinning->GetContent() : nullptr;
+  if (target == nullptr) {
+    NLogError("NStorageTree::BuildMergeIndex: Content is nullptr !!!");
+    return -1;
+  }
+  THnSparse * sourceContent = source->GetBinning()->GetContent();
+  if (sourceContent->GetNdimensions() != target->GetNdimensions()) {
+    NLogError("NStorageTree::BuildMergeIndex: Dimension mismatch between '%s' (%d) and target (%d) !!!",
+              source->GetFileName().c_str(), sourceContent->GetNdimensions(), target->GetNdimensions());
+    return -1;
+  }
+
+  for (auto & name : fBinning->GetDefinitionNames()) {
+    auto * def = source->GetBinning()->GetDefinition(name);
+    if (!def) continue;
+    index.definitionIds.emplace_back(name,
+                                     std::unordered_set<Long64_t>(def->GetIds().begin(), def->GetIds().end()));
+  }
+
+  // Source content bins are created in fill order, so bin i is entry i of the source tree.
+  const Long64_t   nEntries = std::min<Long64_t>(sourceContent->GetNbins(), source->GetTree()->GetEntries());
+  std::vector<int> coords(sourceContent->GetNdimensions());
+  index.entries.reserve(nEntries);
+  for (Long64_t entry = 0; entry < nEntries; ++entry) {
+    sourceContent->GetBinContent(entry, coords.data());
+    Long64_t bin = target->GetBin(coords.data(), false);
+    if (bin < 0) continue;
+    Long64_t id = (Long64_t)target->GetBinContent(bin);
+    if (!source->fMergeKeepIds.empty() && !source->fMergeKeepIds.count(id)) {
+      NLogTrace("NStorageTree::BuildMergeIndex: file='%s' entry=%lld id=%lld is not selected, skipping ...",
+                source->GetFileName().c_str(), entry, id);
+      continue;
+    }
+    if (source->fMergeSkipIds.count(id)) {
+      NLogTrace("NStorageTree::BuildMergeIndex: file='%s' entry=%lld id=%lld is a duplicate, skipping ...",
+                source->GetFileName().c_str(), entry, id);
+      continue;
+    }
+    bool inDefinition = false;
+    for (const auto & kv : index.definitionIds) {
+      if (kv.second.count(id)) {
+        inDefinition = true;
+        break;
+      }
+    }
+    if (!inDefinition) {
+      NLogWarning("NStorageTree::BuildMergeIndex: file='%s' entry=%lld bin=%lld id=%lld but no definition found, "
+                  "skipping ...",
+                  source->GetFileName().c_str(), entry, bin, id);
+      continue;
+    }
+    index.entries.push_back({bin, entry, id});
+  }
+  std::stable_sort(index.entries.begin(), index.entries.end(),
+                   [](const NStorageMergeIndex::Entry & a, const NStorageMergeIndex::Entry & b) { return a.bin < b.bin; });
+
+  NLogTrace("NStorageTree::BuildMergeIndex: Indexed %zu of %lld entries from '%s'", index.entries.size(), nEntries,
+            source->GetFileName().c_str());
+  return static_cast<Long64_t>(index.entries.size());
+}
+
+Long64_t NStorageTree::MergeIndexed(std::vector<NStorageMergeIndex> & sources)
+{
+  ///
+  /// Merge indexed sources in target bin order
+  ///
+  if (fTree == nullptr) {
+    NLogError("NStorageTree::MergeIndexed: Tree is not initialized !!! Run 'NStorageTree::InitTree(...)' first !!!");
+    return -1;
+  }
+
   for (auto & kv : fBinning->GetDefinitions()) {
-    NLogTrace("NStorageTree::Merge: Clearing ids in binning definition '%s' ...", kv.first.c_str());
-    kv.second->GetIds().clear();
+    NLogTrace("NStorageTree::MergeIndexed: Clearing ids in binning definition '%s' ...", kv.first.c_str());
+    kv.second->ClearIds();
   }
 
-  // clear all binning definition contents and ids before merging
-  // for (auto & kv : fBinning->GetDefinitions()) {
-  //   auto binningDefIn = obj->GetBinning()->GetDefinition(kv.first);
-  //   if (binningDefIn) {
-  //     // binningDefIn->GetContent()->Reset();
-  //     // binningDefIn->GetIds().clear();
-  //   }
-  // }
   NBinningPoint * point = fBinning->GetPoint();
 
-  TIter          next(list);
-  NStorageTree * obj     = nullptr;
-  THnSparse *    cSparse = fBinning->GetContent();
-  if (cSparse == nullptr) {
-    NLogError("NHnSparseTree::Merge: Content is nullptr !!! Cannot merge and exiting ...");
-    return 0;
+  // Workers choose output point columns from their own first output point, so the sources may differ.
+  // All branches are added before the first entry (keeping the list order of the columns), a branch
+  // added later would miss the entries filled before.
+  const bool canAddBranches = fTree->GetEntries() == 0;
+  auto       addBranch      = [&](const std::string & name, NStorageTree * source) {
+    if (GetBranch(name)) return;
+    if (!canAddBranches) {
+      NLogWarning("NStorageTree::MergeIndexed: Branch '%s' from '%s' is not in the target tree, skipping it ...",
+                  name.c_str(), source->GetFileName().c_str());
+      return;
+    }
+    AddBranch(name, nullptr, source->GetBranch(name)->GetObjectClassName());
+  };
+  for (auto & src : sources) {
+    for (const auto & name : src.source->GetOutputPointColumns()) {
+      if (src.source->GetBranch(GetOutputPointBranchName(name))) addBranch(GetOutputPointBranchName(name), src.source);
+    }
   }
-  NLogTrace("NStorageTree::Merge: Number of entries in content: %lld", cSparse->GetNbins());
-  Int_t *                                         cCoords = new Int_t[cSparse->GetNdimensions()];
-  Long64_t                                        linBin  = 0;
-  std::unique_ptr<ROOT::Internal::THnBaseBinIter> iter{cSparse->CreateIter(true /*use axis range*/)};
-  while ((linBin = iter->Next()) >= 0) {
-    Double_t         v             = cSparse->GetBinContent(linBin, cCoords);
-    Long64_t         idx           = cSparse->GetBin(cCoords);
-    std::vector<int> cCoordsVector = NUtils::ArrayToVector(cCoords, cSparse->GetNdimensions());
-    std::string      binCoordsStr  = NUtils::GetCoordsString(cCoordsVector, -1);
-    NLogTrace("NStorageTree::Merge: Bin %lld(idx=%lld): %s content=%f", linBin, idx, binCoordsStr.c_str(), v);
-
-    // if (linBin >= cSparse->GetNbins()) break;
-    // continue;
-    NLogTrace("NStorageTree::Merge: BEGIN linBin=%lld ===================================", linBin);
-    bool found = false;
-
-    while ((obj = dynamic_cast<NStorageTree *>(next()))) {
-      if (found) break;
-      if (obj == this || !obj) continue;
-      NLogTrace("NHnSparseTree::Merge: Scanning object '%s' with %lld entries ...", obj->GetFileName().c_str(),
-                obj->GetTree()->GetEntries());
-      // continue;
-      Long64_t binObj = fBinning->GetContent()->GetBin(cCoords, false);
-      if (binObj < 0) {
-        NLogTrace("NStorageTree::Merge: Bin %lld(idx=%lld): %s -> file='%s' binObj=%lld, skipping ...", linBin, idx,
-                  binCoordsStr.c_str(), obj->GetFileName().c_str(), binObj);
-        continue;
+  for (auto & src : sources) {
+    for (auto & kv : src.source->GetBranchesMap()) {
+      if (kv.second.GetBranchStatus() != 0) addBranch(kv.first, src.source);
+    }
+  }
+  // Keep the output point layout of the sources
+  fOutputPointLayoutSet = true;
+
+  // Entries of sources without an object for a branch get a default object
+  std::map<std::string, TObject *> defaults;
+  auto                             defaultObject = [&](const std::string & name, NTreeBranch & b) {
+    TObject *& obj = defaults[name];
+    if (obj == nullptr) {
+      TDirectory::TContext ctx(nullptr); // keep histograms out of the output file
+      TClass *             cl = TClass::GetClass(b.GetObjectClassName().c_str());
+      obj                     = cl ? static_cast<TObject *>(cl->New()) : nullptr;
+    }
+    return obj;
+  };
+
+  // K-way merge over the sorted per-source indices; ties go to the earlier source.
+  using HeapItem = std::pair<Long64_t, size_t>;
+  std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+  std::vector<size_t>                                                          pos(sources.size(), 0);
+  for (size_t i = 0; i < sources.size(); ++i) {
+    if (!sources[i].entries.empty()) heap.emplace(sources[i].entries[0].bin, i);
+  }
+  auto advance = [&](size_t i) {
+    if (++pos[i] < sources[i].entries.size()) heap.emplace(sources[i].entries[pos[i]].bin, i);
+  };
+
+  Long64_t nmerged = 0;
+  while (!heap.empty()) {
+    const HeapItem top = heap.top();
+    heap.pop();
+    while (!heap.empty() && heap.top().first == top.first) {
+      const size_t dup = heap.top().second;
+      heap.pop();
+      NLogTrace("NStorageTree::MergeIndexed: bin=%lld from '%s' already provided by '%s', skipping ...", top.first,
+                sources[dup].source->GetFileName().c_str(), sources[top.second].source->GetFileName().c_str());
+      advance(dup);
+    }
+
+    NStorageMergeIndex &              src = sources[top.second];
+    const NStorageMergeIndex::Entry & e   = src.entries[pos[top.second]];
+    NStorageTree *                    obj = src.source;
+
+    obj->GetEntry(e.entry, obj->GetBinning()->GetPoint(), false);
+    point->SetPointContentFromLinearIndex(e.bin, false);
+
+    std::vector<NBinningDef *> matchedDefinitions;
+    for (const auto & kv : src.definitionIds) {
+      if (!kv.second.count(e.id)) continue;
+      NBinningDef * def = fBinning->GetDefinition(kv.first);
+      if (def) matchedDefinitions.push_back(def);
+    }
+
+    for (auto & kv : fBranchesMap) {
+      if (IsOutputPointBranchName(kv.first)) continue;
+      NTreeBranch * in        = obj->GetBranch(kv.first);
+      TObject *     branchObj = in && in->GetBranchStatus() != 0 ? in->GetObject() : nullptr;
+      if (!branchObj) {
+        if (in && in->GetBranchStatus() != 0)
+          NLogWarning("NStorageTree::MergeIndexed: Branch '%s' object is nullptr in '%s' entry %lld !!!",
+                      kv.first.c_str(), obj->GetFileName().c_str(), e.entry);
+        NLogTrace("NStorageTree::MergeIndexed: Writing default object to branch '%s' ...", kv.first.c_str());
+        branchObj = defaultObject(kv.first, kv.second);
       }
-      NLogTrace("NStorageTree::Merge: binObj=%lld", binObj);
-      Long64_t binGlobal = (Long64_t)fBinning->GetContent()->GetBinContent(binObj);
-      NLogTrace("NStorageTree::Merge: bcObj=%lld", binGlobal);
-      // Long64_t bin = fBinning->GetContent()->GetBin(cCoords, false);
-      Long64_t bin = obj->GetBinning()->GetContent()->GetBin(cCoords, false);
-
-      NLogTrace("NStorageTree::Merge: Bin %lld(idx=%lld): %s -> file='%s' is bin=%lld binGlobal=%lld", linBin, idx,
-                binCoordsStr.c_str(), obj->GetFileName().c_str(), bin, binGlobal);
-      if (bin < 0) {
-        NLogTrace("NStorageTree::Merge: Bin %lld(idx=%lld): %s -> file='%s' bin=%lld, skipping ...", linBin, idx,
-                  binCoordsStr.c_str(), obj->GetFileName().c_str(), bin);
+      if (!branchObj) {
+        NLogWarning("NStorageTree::MergeIndexed: Cannot create default object for branch '%s' !!! Skipping ...",
+                    kv.first.c_str());
         continue;
       }
-
-      NLogTrace("NStorageTree::Merge: bin=%lld obj->GetTree()->GetEntries()=%lld", bin, obj->GetTree()->GetEntries());
-      if (bin < obj->GetTree()->GetEntries()) {
-        // obj->Print();
-        obj->GetEntry(bin, point);
-        // point->SetEntryNumber(bin); // Set the entry number to the linear bin index
-        // point->Print();
-        // // FIXME: check why ids are not filled correctly when merging
-        found = false;
-        std::vector<NBinningDef *> matchedDefinitions;
-        NLogTrace("NHnSparseTree::Merge: Looping over all binning definitions to fill ids ...");
-        for (auto & name : fBinning->GetDefinitionNames()) {
-          // check if id
-          auto binningDefIn = obj->GetBinning()->GetDefinition(name);
-          if (binningDefIn) {
-            NLogTrace("NHnSparseTree::Merge: Checking bin %lld to binning definition '%s' entry %lld  linBin=%d "
-                      "binGlobal=%lld ...",
-                      idx, name.c_str(), point->GetEntryNumber(), linBin, binGlobal);
-
-            // binningDefIn->Print();
-            // check if binGlobal is already in the binningDefIn->GetIds()
-            if (std::find(binningDefIn->GetIds().begin(), binningDefIn->GetIds().end(), binGlobal) ==
-                binningDefIn->GetIds().end()) {
-              // binningDefIn->GetIds().push_back(binGlobal);
-              NLogTrace("***** NHnSparseTree::Merge: Found and added %lld to definition '%s' Skipping", binGlobal,
-                        name.c_str());
-              continue;
-            }
-            else {
-              NLogTrace("***** NHnSparseTree::Merge: ID %lld already exists in definition '%s', Found ...", binGlobal,
-                        name.c_str());
-              found = true;
-            }
-
-            NBinningDef * def = fBinning->GetDefinition(name);
-            if (def) {
-              matchedDefinitions.push_back(def);
-            }
-          }
-        }
-        if (found == false) {
-          NLogWarning("NHnSparseTree::Merge: Bin %lld(idx=%lld): %s -> bin in obj='%s' is bin=%lld binGlobal=%lld "
-                      "but no definition found, skipping ...",
-                      linBin, idx, binCoordsStr.c_str(), obj->GetFileName().c_str(), bin, binGlobal);
-          continue;
-        }
-        // Lopp over all branches in the object
-        for (auto & kv : obj->GetBranchesMap()) {
-          NLogTrace("NHnSparseTree::Merge: Merging branch '%s' ...", kv.first.c_str());
-          if (kv.second.GetBranchStatus() == 0) {
-            NLogTrace("NHnSparseTree::Merge: Branch '%s' is disabled !!! Skipping ...", kv.first.c_str());
-            continue;
-          }
-          // Get the branch object
-          TObject * branchObj = kv.second.GetObject();
-          if (!branchObj) {
-            NLogWarning("NHnSparseTree::Merge: Branch '%s' object is nullptr !!! Skipping ...", kv.first.c_str());
-            continue;
-          }
-
-          NTreeBranch * b = GetBranch(kv.first);
-          if (b == nullptr) {
-            AddBranch(kv.first, kv.second.GetObject(), branchObj->IsA()->GetName());
-            b = GetBranch(kv.first);
-          }
-          // Pass deleteExisting=false: the source branch owns this object and
-          // already deletes it in GetEntry (de404cb). Deleting it here too
-          // would be a use-after-free on macOS's strict allocator.
-          b->SetAddress(branchObj, false); // Set the branch address
-        }
-        // SetPoint(obj->GetPoint()); // Set the point in the current NGnTree
-        // SaveEntry();
-        // fBinning->SetPoint(obj->GetBinning()->GetPoint());
-        Fill(point, obj, true, {}, false);
-        for (auto * def : matchedDefinitions) {
-          def->GetIds().push_back(point->GetEntryNumber());
-        }
-        NLogTrace("NHnSparseTree::Merge: Filling point %s linBin=%d idx=%d entry_number=%d...", binCoordsStr.c_str(),
-                  linBin, idx, point->GetEntryNumber());
-      }
+      // Pass deleteExisting=false: the source branch owns this object and
+      // already deletes it in GetEntry (de404cb). Deleting it here too
+      // would be a use-after-free on macOS's strict allocator.
+      kv.second.SetAddress(branchObj, false);
+    }
+    if (GetBranch("_outputPoint")) {
+      // Objects of the previous entry belong to their source, SetOutputPoint() must not delete them.
+      // Columns the source lacks get a default object and are listed in _outputPointMissing.
+      for (const auto & name : GetOutputPointBranchNames()) GetBranch(name)->SetObject(nullptr);
+      NTreeBranch * in          = obj->GetBranch("_outputPoint");
+      TList *       outputPoint = in && in->GetBranchStatus() != 0 ? obj->GetOutputPoint() : nullptr;
+      TList         empty;
+      SetOutputPoint(outputPoint ? outputPoint : &empty);
+      Fill(point, obj, true, {}, false);
     }
-    NLogTrace("NHnSparseTree::Merge: END linBin=%lld ===================================", linBin);
-    next.Reset(); // Reset the iterator to start from the beginning again
+    else {
+      Fill(point, obj, true, {}, false);
+    }
+    for (auto * def : matchedDefinitions) {
+      def->AddId(point->GetEntryNumber());
+    }
+    NLogTrace("NStorageTree::MergeIndexed: bin=%lld id=%lld <- '%s' entry=%lld -> entry_number=%lld", e.bin, e.id,
+              obj->GetFileName().c_str(), e.entry, point->GetEntryNumber());
+    nmerged++;
+    advance(top.second);
   }
-  // closing all merged files
-  while ((obj = dynamic_cast<NStorageTree *>(next()))) {
-    NLogTrace("NStorageTree::Merge: Closing file '%s' ...", obj->GetFileName().c_str());
-    obj->Close(false);
+
+  // Branch objects belong to the sources closed below, to the defaults or to ClearOutputPoint()
+  for (auto & kv : fBranchesMap) kv.second.SetObject(nullptr);
+  for (auto & kv : defaults) delete kv.second;
+
+  for (auto & src : sources) {
+    NLogTrace("NStorageTree::MergeIndexed: Closing file '%s' ...", src.source->GetFileName().c_str());
+    src.source->Close(false);
   }
-  // Print all definition ids after merging
   for (auto & kv : fBinning->GetDefinitions()) {
-    NLogTrace("NHnSparseTree::Merge: IDs in definition '%s': %s", kv.first.c_str(),
+    NLogTrace("NStorageTree::MergeIndexed: IDs in definition '%s': %s", kv.first.c_str(),
               NUtils::GetCoordsString(kv.second->GetIds(), -1).c_str());
   }
 
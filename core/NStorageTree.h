@@ -3,12 +3,40 @@
 #include <TObject.h>
 #include <TTree.h>
 #include <TFile.h>
+#include <TList.h>
+#include <TNamed.h>
+#include <set>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include "NBinning.h"
 #include "NBinningPoint.h"
 #include "NTreeBranch.h"
 
 namespace Ndmspc {
 
+class NStorageTree;
+struct NStorageReadAhead;
+
+/**
+ * @struct NStorageMergeIndex
+ * @brief Lookup of one merge source built by NStorageTree::BuildMergeIndex.
+ *
+ * Maps every mergeable entry of the source to the target content bin it fills,
+ * so the merge never scans other sources for a bin.
+ */
+struct NStorageMergeIndex {
+  /// One mergeable source entry
+  struct Entry {
+    Long64_t bin;   ///< Target content bin
+    Long64_t entry; ///< Entry in the source tree
+    Long64_t id;    ///< Global bin id (target content value)
+  };
+  NStorageTree *     source{nullptr}; ///< Source storage tree (closed after merge)
+  std::vector<Entry> entries;         ///< Mergeable entries sorted by target bin
+  std::vector<std::pair<std::string, std::unordered_set<Long64_t>>> definitionIds; ///< Source ids per definition
+};
+
 /**
  * @class NStorageTree
  * @brief NDMSPC storage tree object for managing ROOT TTree-based data storage.
@@ -99,6 +127,16 @@ class NStorageTree : public TObject {
    */
   bool Close(bool write = false, std::map<std::string, TList *> outputs = {});
 
+  /**
+   * @brief Make the entries filled so far recoverable from the file.
+   *
+   * Stores the current binning and storage description in the tree user info
+   * and autosaves the tree, so that NGnTree::Open() can read the file even if
+   * the process is killed before Close().
+   * @return True if the checkpoint was written.
+   */
+  bool Checkpoint();
+
   /**
    * @brief Returns the associated TFile object.
    *
@@ -113,6 +151,123 @@ class NStorageTree : public TObject {
    */
   Long64_t Merge(TCollection * list);
 
+  /**
+   * @brief Index a source tree for merging into this tree.
+   *
+   * Reads only the source binning, so it can run as soon as a source becomes
+   * available, before the other sources are known.
+   * @param source Source storage tree.
+   * @param index Output index.
+   * @return Number of indexed entries, or -1 on error.
+   */
+  Long64_t BuildMergeIndex(NStorageTree * source, NStorageMergeIndex & index) const;
+
+  /**
+   * @brief Merge indexed sources into this tree.
+   *
+   * Target bins are written in content order; when several sources provide a
+   * bin, the first source wins. Each source entry is read at most once and,
+   * when the source was filled in bin order, sequentially. Sources are closed.
+   * @param sources Indices created by BuildMergeIndex.
+   * @return Number of merged entries, or -1 on error.
+   */
+  Long64_t MergeIndexed(std::vector<NStorageMergeIndex> & sources);
+
+  /// Read-ahead
+
+  /**
+   * @brief Start reading entries ahead of the consumer.
+   *
+   * Sets up the TTreeCache of the enabled branches for the range of @p entries and starts a thread
+   * that reads the listed entries, in order, through its own handle of the file. Baskets of the next
+   * entries are thus fetched and decompressed while the caller works on the current one. GetEntry()
+   * takes the prefetched objects when it asks for an entry of the list and reads directly otherwise.
+   * At most @p depth entries are held in memory. Needs ROOT thread safety (see
+   * NUtils::IsThreadSafetyEnabled()), otherwise entries are read directly.
+   * @param entries Entries in the order they will be read.
+   * @param depth Number of entries read ahead; negative uses NDMSPC_READAHEAD (default 0, disabled).
+   * @return True if the read-ahead thread was started.
+   */
+  bool StartReadAhead(const std::vector<Long64_t> & entries, int depth = -1);
+
+  /**
+   * @brief Stop the read-ahead thread and release entries not taken yet.
+   */
+  void StopReadAhead();
+
+  /**
+   * @brief Check if read-ahead is active.
+   * @return True if a read-ahead thread is running.
+   */
+  bool IsReadAhead() const { return fReadAhead != nullptr; }
+
+  /// Output point handling
+
+  /**
+   * @brief Set the output list of the point that is filled next.
+   *
+   * With the column layout (NDMSPC_OUTPUT_LAYOUT=columns, default) every named object of the first
+   * list of a new tree gets its own branch `_outputPoint_<name>`. TParameter objects are split, so
+   * their value is a column of its own; other objects are stored unsplit. Objects of later lists
+   * go to the branch of their name; objects without a branch (new names, other class) stay in the
+   * `_outputPoint` list. With NDMSPC_OUTPUT_LAYOUT=list the whole list goes to `_outputPoint`.
+   * The list keeps ownership of its objects.
+   * @param outputPoint Output list.
+   */
+  void SetOutputPoint(TList * outputPoint);
+
+  /**
+   * @brief Get one object of the output list of the current entry.
+   *
+   * An object with its own branch is read from that branch only (also when the branch is
+   * disabled), so the other objects of the list are not deserialized.
+   * @param name Object name.
+   * @return Pointer to object, nullptr if the entry has no such object.
+   */
+  TObject * GetOutputPointObject(const std::string & name);
+
+  /**
+   * @brief Get the whole output list of the current entry.
+   *
+   * Objects stored in their own branches are added in their original order, followed by the
+   * objects of the `_outputPoint` list. The list is owned by this tree and does not own the objects.
+   * @return Output list, nullptr if the tree has no `_outputPoint` branch.
+   */
+  TList * GetOutputPoint();
+
+  /**
+   * @brief Get names of output point objects stored in their own branches.
+   * @return Object names in list order.
+   */
+  const std::vector<std::string> & GetOutputPointColumns() const { return fOutputPointColumns; }
+
+  /**
+   * @brief Get names of all branches holding output point objects.
+   * @return `_outputPoint` followed by the column branch names.
+   */
+  std::vector<std::string> GetOutputPointBranchNames() const;
+
+  /**
+   * @brief Get branch name of an output point object stored in its own branch.
+   * @param name Object name.
+   * @return Branch name, the trailing '.' prefixes the names of split sub-branches with it.
+   */
+  static std::string GetOutputPointBranchName(const std::string & name) { return "_outputPoint_" + name + "."; }
+
+  /**
+   * @brief Check if an output point object name can be used in a branch name.
+   * @param name Object name.
+   * @return True for non-empty names of letters, digits and '_', other objects stay in the `_outputPoint` list.
+   */
+  static bool IsOutputPointColumnName(const std::string & name);
+
+  /**
+   * @brief Check if a branch stores the output point list or one of its columns.
+   * @param name Branch name.
+   * @return True for `_outputPoint` and `_outputPoint_<name>.` branches.
+   */
+  static bool IsOutputPointBranchName(const std::string & name);
+
   /// Branches handling
 
   /**
@@ -211,18 +366,53 @@ class NStorageTree : public TObject {
    */
   void SetOutputs(TMap * outputs) { fOutputs = outputs; }
 
+  /**
+   * @brief Set global bin ids whose entries are ignored when this tree is merged into another one.
+   * @param ids Set of global bin ids.
+   */
+  void SetMergeSkipIds(const std::set<Long64_t> & ids) { fMergeSkipIds = ids; }
+
+  /**
+   * @brief Restrict merging of this tree to the given global bin ids.
+   * @param ids Set of global bin ids (empty merges all entries).
+   */
+  void SetMergeKeepIds(const std::set<Long64_t> & ids) { fMergeKeepIds = ids; }
+
   protected:
-  std::string                        fFileName{"ngnt.root"}; ///< Current filename
-  TFile *                            fFile{nullptr};         ///<! Current file
-  TTree *                            fTree{nullptr};         ///<! TTree container
-  std::string                        fPrefix{""};            ///< Prefix path
-  std::string                        fPostfix{""};           ///< Postfix path
-  std::map<std::string, NTreeBranch> fBranchesMap;           ///< Branches map
-  TMap *                             fOutputs;               ///<! Output objects map
-  NBinning *                         fBinning{nullptr};      ///< Binning object
+  std::string                        fFileName{"ngnt.root"};       ///< Current filename
+  TFile *                            fFile{nullptr};               ///<! Current file
+  TTree *                            fTree{nullptr};               ///<! TTree container
+  std::string                        fPrefix{""};                  ///< Prefix path
+  std::string                        fPostfix{""};                 ///< Postfix path
+  std::map<std::string, NTreeBranch> fBranchesMap;                 ///< Branches map
+  TMap *                             fOutputs;                     ///<! Output objects map
+  NBinning *                         fBinning{nullptr};            ///< Binning object
+  std::set<Long64_t>                 fMergeSkipIds;                ///<! Global ids skipped when merging this tree
+  std::set<Long64_t>                 fMergeKeepIds;                ///<! If not empty, only these global ids are merged
+  std::vector<TObject *>             fCheckpointInfo;              ///<! User info objects stored by the last Checkpoint()
+  NStorageReadAhead *                fReadAhead{nullptr};          ///<! Read-ahead state
+  Long64_t                           fEntry{-1};                   ///<! Entry read by the last GetEntry()
+  std::vector<std::string>           fOutputPointColumns;          ///< Output point objects with own branch (list order)
+  bool                               fOutputPointLayoutSet{false}; ///<! Output point layout was decided
+  TList *                            fOutputPointRest{nullptr};    ///<! Objects written to the _outputPoint list
+  TList *                            fOutputPointAll{nullptr};     ///<! List assembled by GetOutputPoint()
+  TNamed *                           fOutputPointMissing{nullptr}; ///<! Columns missing in the current output point
+  std::map<std::string, TObject *>   fOutputPointEmpty;            ///<! Objects written for missing columns
+
+  /// Removes and deletes the user info objects stored by Checkpoint().
+  void ClearCheckpointInfo();
+
+  /// Moves the read-ahead objects of an entry to the branches. Returns bytes read or -1 if not prefetched.
+  Long64_t TakeReadAhead(Long64_t entry);
+
+  /// Returns the object of a branch, reading the current entry first if the branch has not read it.
+  TObject * ReadBranchObject(const std::string & name);
+
+  /// Deletes the transient output point lists and default objects.
+  void ClearOutputPoint();
 
   /// \cond CLASSIMP
-  ClassDef(NStorageTree, 1);
+  ClassDef(NStorageTree, 2);
   /// \endcond;
 };
 } // namespace Ndmspc
@@ -0,0 +1,53 @@
+#include "NTaskCostModel.h"
+#include <cmath>
+
+namespace Ndmspc {
+
+NTaskCostModel::NTaskCostModel(const std::vector<int> & minBounds, const std::vector<int> & maxBounds)
+    : fMinBounds(minBounds)
+{
+  fSums.resize(minBounds.size());
+  fCounts.resize(minBounds.size());
+  for (size_t i = 0; i < minBounds.size() && i < maxBounds.size(); ++i) {
+    const size_t extent = maxBounds[i] >= minBounds[i] ? static_cast<size_t>(maxBounds[i] - minBounds[i] + 1) : 0;
+    fSums[i].assign(extent, 0.0);
+    fCounts[i].assign(extent, 0);
+  }
+}
+
+void NTaskCostModel::Add(const std::vector<int> & coords, double cost)
+{
+  if (!std::isfinite(cost) || cost < 0.0) {
+    return;
+  }
+  for (size_t i = 0; i < fSums.size() && i < coords.size(); ++i) {
+    const long bin = static_cast<long>(coords[i]) - fMinBounds[i];
+    if (bin < 0 || static_cast<size_t>(bin) >= fSums[i].size()) {
+      continue;
+    }
+    fSums[i][bin] += cost;
+    ++fCounts[i][bin];
+  }
+  fSum += cost;
+  ++fNObserved;
+}
+
+double NTaskCostModel::Estimate(const std::vector<int> & coords) const
+{
+  if (fNObserved == 0) {
+    return -1.0;
+  }
+  double sum = 0.0;
+  size_t n   = 0;
+  for (size_t i = 0; i < fSums.size() && i < coords.size(); ++i) {
+    const long bin = static_cast<long>(coords[i]) - fMinBounds[i];
+    if (bin < 0 || static_cast<size_t>(bin) >= fSums[i].size() || fCounts[i][bin] == 0) {
+      continue;
+    }
+    sum += fSums[i][bin] / fCounts[i][bin];
+    ++n;
+  }
+  return n > 0 ? sum / n : fSum / fNObserved;
+}
+
+} // namespace Ndmspc
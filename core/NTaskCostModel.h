@@ -0,0 +1,57 @@
+#ifndef N_TASK_COST_MODEL_H
+#define N_TASK_COST_MODEL_H
+
+#include <cstddef>
+#include <vector>
+
+namespace Ndmspc {
+
+/**
+ * @class NTaskCostModel
+ * @brief Estimates costs of tasks not run yet from the costs observed in the current run
+ *
+ * Neighbouring bins usually cost about the same, so every observed cost is added
+ * to the mean of its coordinate along each axis. A task is estimated by the average
+ * of the means of its coordinates which were observed already. Memory is the sum of
+ * the axis extents, independent of the number of tasks.
+ */
+class NTaskCostModel {
+  public:
+  /**
+   * @brief Constructor
+   * @param minBounds Minimum coordinate per axis
+   * @param maxBounds Maximum coordinate per axis (inclusive)
+   */
+  NTaskCostModel(const std::vector<int> & minBounds, const std::vector<int> & maxBounds);
+
+  /**
+   * @brief Add an observed task cost
+   * @param coords Task coordinates
+   * @param cost Observed cost (ignored when negative or not finite)
+   */
+  void Add(const std::vector<int> & coords, double cost);
+
+  /**
+   * @brief Estimate the cost of a task
+   * @param coords Task coordinates
+   * @return Estimated cost, the mean observed cost when no coordinate was observed, or -1 without observations
+   */
+  double Estimate(const std::vector<int> & coords) const;
+
+  /**
+   * @brief Get number of observed costs
+   * @return Number of costs added
+   */
+  size_t GetNObserved() const { return fNObserved; }
+
+  private:
+  std::vector<int>                 fMinBounds;    ///< Minimum coordinate per axis
+  std::vector<std::vector<double>> fSums;         ///< Sum of observed costs per axis and coordinate
+  std::vector<std::vector<size_t>> fCounts;       ///< Number of observed costs per axis and coordinate
+  double                           fSum{0.0};     ///< Sum of all observed costs
+  size_t                           fNObserved{0}; ///< Number of observed costs
+};
+
+} // namespace Ndmspc
+
+#endif // N_TASK_COST_MODEL_H
@@ -0,0 +1,115 @@
+#include "NTaskRangeSet.h"
+#include <algorithm>
+#include <iterator>
+
+namespace Ndmspc {
+
+bool NTaskRangeSet::Insert(TaskId id)
+{
+  return InsertRange(id, id + 1) > 0;
+}
+
+size_t NTaskRangeSet::InsertRange(TaskId first, TaskId last)
+{
+  if (first >= last) {
+    return 0;
+  }
+
+  // Absorb every range that overlaps or touches [first, last)
+  size_t absorbed = 0;
+  auto   it       = fRanges.upper_bound(first);
+  if (it != fRanges.begin()) {
+    auto prev = std::prev(it);
+    if (prev->second >= first) {
+      it = prev;
+    }
+  }
+  while (it != fRanges.end() && it->first <= last) {
+    absorbed += it->second - it->first;
+    first = std::min(first, it->first);
+    last  = std::max(last, it->second);
+    it    = fRanges.erase(it);
+  }
+  fRanges.emplace_hint(it, first, last);
+
+  const size_t added = (last - first) - absorbed;
+  fSize += added;
+  return added;
+}
+
+bool NTaskRangeSet::Erase(TaskId id)
+{
+  auto it = fRanges.upper_bound(id);
+  if (it == fRanges.begin()) {
+    return false;
+  }
+  --it;
+  if (id >= it->second) {
+    return false;
+  }
+
+  const TaskId first = it->first;
+  const TaskId last  = it->second;
+  fRanges.erase(it);
+  if (first < id) fRanges.emplace(first, id);
+  if (id + 1 < last) fRanges.emplace(id + 1, last);
+  --fSize;
+  return true;
+}
+
+bool NTaskRangeSet::Contains(TaskId id) const
+{
+  auto it = fRanges.upper_bound(id);
+  if (it == fRanges.begin()) {
+    return false;
+  }
+  --it;
+  return id < it->second;
+}
+
+bool NTaskRangeSet::PopFront(TaskId & id)
+{
+  if (fRanges.empty()) {
+    return false;
+  }
+  auto it = fRanges.begin();
+  id      = it->first;
+  if (it->first + 1 < it->second) {
+    // Shrink the first range in place by re-inserting its tail
+    const TaskId last = it->second;
+    fRanges.erase(it);
+    fRanges.emplace_hint(fRanges.begin(), id + 1, last);
+  }
+  else {
+    fRanges.erase(it);
+  }
+  --fSize;
+  return true;
+}
+
+std::vector<NTaskRangeSet::TaskId> NTaskRangeSet::ToVector() const
+{
+  std::vector<TaskId> ids;
+  ids.reserve(fSize);
+  for (const auto & range : fRanges) {
+    for (TaskId id = range.first; id < range.second; ++id) ids.push_back(id);
+  }
+  return ids;
+}
+
+std::set<NTaskRangeSet::TaskId> NTaskRangeSet::ToSet() const
+{
+  std::set<TaskId> ids;
+  for (const auto & range : fRanges) {
+    for (TaskId id = range.first; id < range.second; ++id) ids.insert(ids.end(), id);
+  }
+  return ids;
+}
+
+void NTaskRangeSet::Clear()
+{
+  fRanges.clear();
+  fSize = 0;
+}
+
+} // namespace Ndmspc
@@ -0,0 +1,97 @@
+#ifndef N_TASK_RANGE_SET_H
+#define N_TASK_RANGE_SET_H
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace Ndmspc {
+
+/**
+ * @class NTaskRangeSet
+ * @brief Set of task ids stored as disjoint half-open ranges [first, last)
+ *
+ * Task ids handed out by the executor are linear indices, so the ids in one
+ * state (pending, running, done, assigned to a worker) are mostly contiguous.
+ * Storing them as ranges keeps memory proportional to the number of gaps
+ * instead of the number of tasks. Inserting or erasing a single id merges or
+ * splits the neighbouring ranges.
+ */
+class NTaskRangeSet {
+  public:
+  /// @brief Task identifier type
+  using TaskId = size_t;
+  /// @brief Range storage: first id -> one past the last id
+  using RangeMap = std::map<TaskId, TaskId>;
+
+  NTaskRangeSet() = default;
+
+  /**
+   * @brief Insert a single id
+   * @param id Task ID
+   * @return true if the id was not present before
+   */
+  bool Insert(TaskId id);
+
+  /**
+   * @brief Insert all ids in [first, last)
+   * @param first First task ID
+   * @param last One past the last task ID
+   * @return Number of ids that were not present before
+   */
+  size_t InsertRange(TaskId first, TaskId last);
+
+  /**
+   * @brief Erase a single id, splitting its range if needed
+   * @param id Task ID
+   * @return true if the id was present
+   */
+  bool Erase(TaskId id);
+
+  /**
+   * @brief Check whether an id is in the set
+   * @param id Task ID
+   * @return true if present
+   */
+  bool Contains(TaskId id) const;
+
+  /**
+   * @brief Remove and return the lowest id
+   * @param id Output task ID
+   * @return false if the set is empty
+   */
+  bool PopFront(TaskId & id);
+
+  /// Lowest id in the set (the set must not be empty)
+  TaskId Front() const { return fRanges.begin()->first; }
+
+  /// Number of ids in the set
+  size_t Size() const { return fSize; }
+
+  /// True if the set holds no ids
+  bool Empty() const { return fSize == 0; }
+
+  /// Number of disjoint ranges used to store the ids
+  size_t RangeCount() const { return fRanges.size(); }
+
+  /// Stored ranges, ordered by first id
+  const RangeMap & Ranges() const { return fRanges; }
+
+  /// All ids in ascending order
+  std::vector<TaskId> ToVector() const;
+
+  /// All ids as an ordered set
+  std::set<TaskId> ToSet() const;
+
+  /// Remove all ids
+  void Clear();
+
+  private:
+  RangeMap fRanges;  ///< Disjoint, non-adjacent ranges [first, last)
+  size_t   fSize{0}; ///< Total number of ids
+};
+
+} // namespace Ndmspc
+
+#endif // N_TASK_RANGE_SET_H
@@ -8,143 +8,77 @@ void NTaskStateManager::AddPending(TaskId id, const TaskPayload & payload)
   if (TaskExists(id)) {
     throw std::runtime_error("Task " + std::to_string(id) + " already exists in state manager");
   }
-  EnqueuePending(id, payload);
-  fTaskPayloads[id] = payload;
+  fPending.Insert(id);
+  if (!fPayloadResolver) {
+    fTaskPayloads[id] = payload;
+  }
 }
 
 bool NTaskStateManager::AssignToWorker(const WorkerId & worker, TaskId id)
 {
-  if (fPending.empty() || fPendingIds.find(id) == fPendingIds.end()) {
+  if (!fPending.Erase(id)) {
     return false;
   }
-
-  // Find and remove from pending
-  std::queue<std::pair<TaskId, TaskPayload>> tempQueue;
-  bool found = false;
-  
-  while (!fPending.empty()) {
-    auto [taskId, payload] = std::move(fPending.front());
-    fPending.pop();
-    
-    if (taskId == id && !found) {
-      found = true;
-      // Move to running state
-      fRunning[id] = payload;
-      fWorkerToTasks[worker].insert(id);
-      fTaskToWorker[id] = worker;
-      fPendingIds.erase(id);
-    } else {
-      tempQueue.emplace(taskId, payload);
-    }
-  }
-  
-  fPending = std::move(tempQueue);
-  return found;
+  StartOnWorker(worker, id);
+  return true;
 }
 
 bool NTaskStateManager::ClaimNextPendingForWorker(const WorkerId & worker, TaskId & id, TaskPayload & payload)
 {
-  if (fPending.empty()) {
+  if (!fPending.PopFront(id)) {
     return false;
   }
-
-  auto item = std::move(fPending.front());
-  fPending.pop();
-  fPendingIds.erase(item.first);
-
-  id      = item.first;
-  payload = std::move(item.second);
-
-  fRunning[id] = payload;
-  fWorkerToTasks[worker].insert(id);
-  fTaskToWorker[id] = worker;
+  PayloadOf(id, payload);
+  StartOnWorker(worker, id);
   return true;
 }
 
 bool NTaskStateManager::MarkDone(TaskId id)
 {
-  auto it = fRunning.find(id);
-  if (it == fRunning.end()) {
+  if (!fRunning.Erase(id)) {
     return false; // Task not running
   }
-  
+
   // Move from running to done
-  fDone.insert(id);
-  fRunning.erase(it);
-  
-  // Remove from worker assignment
-  auto workerIt = fTaskToWorker.find(id);
-  if (workerIt != fTaskToWorker.end()) {
-    const WorkerId & worker = workerIt->second;
-    fWorkerToTasks[worker].erase(id);
-    if (fWorkerToTasks[worker].empty()) {
-      fWorkerToTasks.erase(worker);
-    }
-    fTaskToWorker.erase(workerIt);
-  }
-  
+  fDone.Insert(id);
+
+  // Remove from worker assignment (all owners when speculated)
+  DetachOwners(id);
+
   return true;
 }
 
 bool NTaskStateManager::MarkFailed(TaskId id)
 {
-  auto it = fRunning.find(id);
-  if (it == fRunning.end()) {
+  if (!fRunning.Erase(id)) {
     return false; // Task not running
   }
-  
+
   // Move from running back to pending
-  TaskPayload payload = it->second;
-  fRunning.erase(it);
-  EnqueuePending(id, payload);
-  
-  // Remove from worker assignment
-  auto workerIt = fTaskToWorker.find(id);
-  if (workerIt != fTaskToWorker.end()) {
-    const WorkerId & worker = workerIt->second;
-    fWorkerToTasks[worker].erase(id);
-    if (fWorkerToTasks[worker].empty()) {
-      fWorkerToTasks.erase(worker);
-    }
-    fTaskToWorker.erase(workerIt);
-  }
-  
+  fPending.Insert(id);
+
+  // Remove from worker assignment (all owners when speculated)
+  DetachOwners(id);
+
   return true;
 }
 
 bool NTaskStateManager::RequeueTask(TaskId id)
 {
   // Running -> pending
-  auto runningIt = fRunning.find(id);
-  if (runningIt != fRunning.end()) {
-    TaskPayload payload = runningIt->second;
-    fRunning.erase(runningIt);
-    EnqueuePending(id, payload);
-
-    auto workerIt = fTaskToWorker.find(id);
-    if (workerIt != fTaskToWorker.end()) {
-      const WorkerId & worker = workerIt->second;
-      auto wkIt = fWorkerToTasks.find(worker);
-      if (wkIt != fWorkerToTasks.end()) {
-        wkIt->second.erase(id);
-        if (wkIt->second.empty()) {
-          fWorkerToTasks.erase(wkIt);
-        }
-      }
-      fTaskToWorker.erase(workerIt);
-    }
+  if (fRunning.Erase(id)) {
+    fPending.Insert(id);
+    DetachOwners(id);
     return true;
   }
 
   // Done -> pending
-  auto doneIt = fDone.find(id);
-  if (doneIt != fDone.end()) {
-    auto payloadIt = fTaskPayloads.find(id);
-    if (payloadIt == fTaskPayloads.end()) {
+  if (fDone.Contains(id)) {
+    if (!fPayloadResolver && fTaskPayloads.find(id) == fTaskPayloads.end()) {
       return false;
     }
-    fDone.erase(doneIt);
-    EnqueuePending(id, payloadIt->second);
+    fDone.Erase(id);
+    fPending.Insert(id);
     return true;
   }
 
@@ -156,50 +90,64 @@ std::set<NTaskStateManager::TaskId> NTaskStateManager::GetWorkerTasks(const Work
 {
   auto it = fWorkerToTasks.find(worker);
   if (it != fWorkerToTasks.end()) {
-    return it->second;
+    return it->second.ToSet();
   }
   return {};
 }
 
+size_t NTaskStateManager::WorkerTaskCount(const WorkerId & worker) const
+{
+  auto it = fWorkerToTasks.find(worker);
+  return it != fWorkerToTasks.end() ? it->second.Size() : 0;
+}
+
 std::pair<NTaskStateManager::TaskId, NTaskStateManager::TaskPayload> NTaskStateManager::GetNextPending()
 {
-  if (fPending.empty()) {
+  if (fPending.Empty()) {
     return {0, {}};
   }
-  
-  auto [taskId, payload] = fPending.front();
+
+  const TaskId taskId = fPending.Front();
+  TaskPayload  payload;
+  PayloadOf(taskId, payload);
   return {taskId, payload};
 }
 
 bool NTaskStateManager::HasPending() const
 {
-  return !fPending.empty();
+  return !fPending.Empty();
 }
 
 std::vector<std::pair<NTaskStateManager::TaskId, NTaskStateManager::TaskPayload>>
 NTaskStateManager::RecoverWorkerTasks(const WorkerId & worker)
 {
   std::vector<std::pair<TaskId, TaskPayload>> recovered;
-  
+
   auto workerIt = fWorkerToTasks.find(worker);
   if (workerIt == fWorkerToTasks.end()) {
     return recovered; // No tasks assigned to this worker
   }
-  
-  const auto & taskIds = workerIt->second;
+
+  const std::vector<TaskId> taskIds = workerIt->second.ToVector();
   for (TaskId id : taskIds) {
-    auto runningIt = fRunning.find(id);
-    if (runningIt != fRunning.end()) {
+    // Speculated task still running on another owner: just drop this one
+    if (ReleaseOwner(id, worker)) {
+      continue;
+    }
+    if (fRunning.Erase(id)) {
       // Move back to pending
-      const TaskPayload & payload = runningIt->second;
-      recovered.emplace_back(id, payload);
-      EnqueuePending(id, payload);
-      fRunning.erase(runningIt);
+      TaskPayload payload;
+      PayloadOf(id, payload);
+      recovered.emplace_back(id, std::move(payload));
+      fPending.Insert(id);
+      DetachOwners(id);
+    }
+    else {
+      fTaskToWorker.erase(id);
     }
-    fTaskToWorker.erase(id);
   }
-  
-  fWorkerToTasks.erase(workerIt);
+
+  fWorkerToTasks.erase(worker);
   return recovered;
 }
 
@@ -209,16 +157,26 @@ bool NTaskStateManager::RemoveTaskFromWorker(const WorkerId & worker, TaskId id)
   if (workerIt == fWorkerToTasks.end()) {
     return false;
   }
-  
-  size_t erased = workerIt->second.erase(id);
-  if (erased > 0) {
-    if (workerIt->second.empty()) {
+
+  if (workerIt->second.Erase(id)) {
+    if (workerIt->second.Empty()) {
       fWorkerToTasks.erase(workerIt);
     }
+    auto extraIt = fExtraOwners.find(id);
+    if (extraIt != fExtraOwners.end() && extraIt->second.erase(worker) > 0) {
+      if (extraIt->second.empty()) fExtraOwners.erase(extraIt);
+      return true;
+    }
     fTaskToWorker.erase(id);
+    // Promote a speculative owner so the task keeps a primary owner
+    if (extraIt != fExtraOwners.end()) {
+      fTaskToWorker[id] = *extraIt->second.begin();
+      extraIt->second.erase(extraIt->second.begin());
+      if (extraIt->second.empty()) fExtraOwners.erase(extraIt);
+    }
     return true;
   }
-  
+
   return false;
 }
 
@@ -231,34 +189,131 @@ NTaskStateManager::WorkerId NTaskStateManager::GetTaskWorker(TaskId id) const
   return {};
 }
 
+bool NTaskStateManager::AddSpeculativeOwner(const WorkerId & worker, TaskId id)
+{
+  if (!fRunning.Contains(id) || IsTaskOwner(id, worker)) {
+    return false;
+  }
+  fExtraOwners[id].insert(worker);
+  fWorkerToTasks[worker].Insert(id);
+  return true;
+}
+
+bool NTaskStateManager::IsTaskOwner(TaskId id, const WorkerId & worker) const
+{
+  auto it = fTaskToWorker.find(id);
+  if (it != fTaskToWorker.end() && it->second == worker) {
+    return true;
+  }
+  auto extraIt = fExtraOwners.find(id);
+  return extraIt != fExtraOwners.end() && extraIt->second.count(worker) > 0;
+}
+
+std::vector<NTaskStateManager::WorkerId> NTaskStateManager::GetTaskWorkers(TaskId id) const
+{
+  std::vector<WorkerId> workers;
+  auto                  it = fTaskToWorker.find(id);
+  if (it != fTaskToWorker.end()) {
+    workers.push_back(it->second);
+  }
+  auto extraIt = fExtraOwners.find(id);
+  if (extraIt != fExtraOwners.end()) {
+    workers.insert(workers.end(), extraIt->second.begin(), extraIt->second.end());
+  }
+  return workers;
+}
+
+bool NTaskStateManager::ReleaseOwner(TaskId id, const WorkerId & worker)
+{
+  if (!fRunning.Contains(id) || !IsTaskOwner(id, worker) || GetTaskWorkers(id).size() < 2) {
+    return false;
+  }
+  return RemoveTaskFromWorker(worker, id);
+}
+
+bool NTaskStateManager::GetTaskPayload(TaskId id, TaskPayload & payload) const
+{
+  if (!TaskExists(id)) {
+    return false;
+  }
+  return PayloadOf(id, payload);
+}
+
+std::vector<NTaskStateManager::TaskId> NTaskStateManager::GetRunningTasks() const
+{
+  return fRunning.ToVector();
+}
+
 bool NTaskStateManager::IsDone(TaskId id) const
 {
-  return fDone.find(id) != fDone.end();
+  return fDone.Contains(id);
 }
 
 void NTaskStateManager::Clear()
 {
-  fPending = std::queue<std::pair<TaskId, TaskPayload>>();
-  fPendingIds.clear();
-  fRunning.clear();
-  fDone.clear();
+  fPending.Clear();
+  fRunning.Clear();
+  fDone.Clear();
   fWorkerToTasks.clear();
   fTaskToWorker.clear();
   fTaskPayloads.clear();
+  fExtraOwners.clear();
 }
 
 bool NTaskStateManager::TaskExists(TaskId id) const
 {
-  return fPendingIds.find(id) != fPendingIds.end() ||
-         fRunning.find(id) != fRunning.end() ||
-         fDone.find(id) != fDone.end() ||
+  return fPending.Contains(id) ||
+         fRunning.Contains(id) ||
+         fDone.Contains(id) ||
          fTaskPayloads.find(id) != fTaskPayloads.end();
 }
 
-void NTaskStateManager::EnqueuePending(TaskId id, const TaskPayload & payload)
+bool NTaskStateManager::PayloadOf(TaskId id, TaskPayload & payload) const
+{
+  if (fPayloadResolver) {
+    fPayloadResolver(id, payload);
+    return true;
+  }
+  auto it = fTaskPayloads.find(id);
+  if (it == fTaskPayloads.end()) {
+    payload.clear();
+    return false;
+  }
+  payload = it->second;
+  return true;
+}
+
+void NTaskStateManager::StartOnWorker(const WorkerId & worker, TaskId id)
 {
-  if (fPendingIds.insert(id).second) {
-    fPending.emplace(id, payload);
+  fRunning.Insert(id);
+  fWorkerToTasks[worker].Insert(id);
+  fTaskToWorker[id] = worker;
+}
+
+void NTaskStateManager::UnassignFromWorker(const WorkerId & worker, TaskId id)
+{
+  auto wkIt = fWorkerToTasks.find(worker);
+  if (wkIt != fWorkerToTasks.end()) {
+    wkIt->second.Erase(id);
+    if (wkIt->second.Empty()) {
+      fWorkerToTasks.erase(wkIt);
+    }
+  }
+}
+
+void NTaskStateManager::DetachOwners(TaskId id)
+{
+  auto workerIt = fTaskToWorker.find(id);
+  if (workerIt != fTaskToWorker.end()) {
+    UnassignFromWorker(workerIt->second, id);
+    fTaskToWorker.erase(workerIt);
+  }
+  auto extraIt = fExtraOwners.find(id);
+  if (extraIt != fExtraOwners.end()) {
+    for (const auto & worker : extraIt->second) {
+      UnassignFromWorker(worker, id);
+    }
+    fExtraOwners.erase(extraIt);
   }
 }
 
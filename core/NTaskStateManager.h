@@ -1,14 +1,14 @@
 #ifndef N_TASK_STATE_MANAGER_H
 #define N_TASK_STATE_MANAGER_H
 
-#include <queue>
+#include <functional>
 #include <set>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 #include <cstddef>
 #include <string>
 #include <utility>
+#include "NTaskRangeSet.h"
 
 namespace Ndmspc {
 
@@ -18,6 +18,12 @@ namespace Ndmspc {
  * 
  * Separates task state management from IPC/worker concerns.
  * Tracks which tasks are assigned to which workers and handles redistribution.
+ * A running task normally has one owner; speculative re-execution may add
+ * further owners, and the first one to finish completes the task.
+ *
+ * Pending, running and done tasks are kept as id ranges (`NTaskRangeSet`).
+ * With a payload resolver the payload is derived from the task id on demand,
+ * so memory stays proportional to the tasks in flight rather than the total.
  */
 class NTaskStateManager {
   public:
@@ -27,10 +33,19 @@ class NTaskStateManager {
   using WorkerId = std::string;
   /// @brief Payload associated with a task (coordinates for NDMSPC)
   using TaskPayload = std::vector<int>;
+  /// @brief Computes the payload of a task from its id
+  using PayloadResolver = std::function<void(TaskId, TaskPayload &)>;
   
   NTaskStateManager() = default;
   ~NTaskStateManager() = default;
   
+  /**
+   * @brief Derive task payloads from ids instead of storing them
+   * @param resolver Function filling the payload of a task id (empty to store payloads again)
+   * @note Set before adding tasks; payloads passed to AddPending are then ignored
+   */
+  void SetPayloadResolver(PayloadResolver resolver) { fPayloadResolver = std::move(resolver); }
+
   /**
    * @brief Add a new task to the pending queue
    * @param id Unique task identifier
@@ -82,9 +97,16 @@ class NTaskStateManager {
    * @return Set of task IDs assigned to this worker
    */
   std::set<TaskId> GetWorkerTasks(const WorkerId & worker) const;
+
+  /**
+   * @brief Get the number of tasks currently assigned to a worker
+   * @param worker Worker identifier
+   * @return Number of running tasks owned by this worker
+   */
+  size_t WorkerTaskCount(const WorkerId & worker) const;
   
   /**
-   * @brief Get the next pending task for dispatch
+   * @brief Get the next pending task (lowest id) for dispatch
    * @return Pair of (TaskId, TaskPayload), or invalid if none pending
    * @note This does NOT assign the task; use AssignToWorker after sending
    */
@@ -118,6 +140,51 @@ class NTaskStateManager {
    * @return Worker ID if task is running, empty string if not running
    */
   WorkerId GetTaskWorker(TaskId id) const;
+
+  /**
+   * @brief Add a speculative owner to a running task (duplicate execution)
+   * @param worker Worker that receives a duplicate of the task
+   * @param id Running task ID
+   * @return true if the owner was added, false if task is not running or worker already owns it
+   */
+  bool AddSpeculativeOwner(const WorkerId & worker, TaskId id);
+
+  /**
+   * @brief Check whether a worker currently owns a running task (primary or speculative)
+   * @param id Task ID
+   * @param worker Worker identifier
+   * @return true if worker is one of the task owners
+   */
+  bool IsTaskOwner(TaskId id, const WorkerId & worker) const;
+
+  /**
+   * @brief Get all workers currently executing a task
+   * @param id Task ID
+   * @return Owners of the running task (primary first), empty if not running
+   */
+  std::vector<WorkerId> GetTaskWorkers(TaskId id) const;
+
+  /**
+   * @brief Drop one owner of a running task that is also executed elsewhere
+   * @param id Task ID
+   * @param worker Worker identifier to drop
+   * @return true if the worker was dropped and the task keeps running on another owner
+   */
+  bool ReleaseOwner(TaskId id, const WorkerId & worker);
+
+  /**
+   * @brief Get the payload stored for a task
+   * @param id Task ID
+   * @param payload Output payload
+   * @return true if the task is known
+   */
+  bool GetTaskPayload(TaskId id, TaskPayload & payload) const;
+
+  /**
+   * @brief Get IDs of all running tasks
+   * @return Running task IDs (unordered)
+   */
+  std::vector<TaskId> GetRunningTasks() const;
   
   /**
    * @brief Check if a task has been completed
@@ -127,37 +194,47 @@ class NTaskStateManager {
   bool IsDone(TaskId id) const;
   
   /// Get number of pending tasks
-  size_t PendingCount() const { return fPending.size(); }
+  size_t PendingCount() const { return fPending.Size(); }
   
   /// Get number of running tasks
-  size_t RunningCount() const { return fRunning.size(); }
+  size_t RunningCount() const { return fRunning.Size(); }
   
   /// Get number of completed tasks
-  size_t DoneCount() const { return fDone.size(); }
+  size_t DoneCount() const { return fDone.Size(); }
   
   /// Get total tasks tracked (pending + running + done)
   size_t TotalCount() const { return PendingCount() + RunningCount() + DoneCount(); }
   
-  /// Clear all state (for reuse or cleanup)
+  /// Clear all state (for reuse or cleanup); the payload resolver is kept
   void Clear();
   
   private:
   // State buckets: tasks flow pending → running → done
-  std::queue<std::pair<TaskId, TaskPayload>> fPending;  ///< Pending tasks not yet dispatched
-  std::unordered_set<TaskId>                fPendingIds; ///< Index of pending task ids
-  std::unordered_map<TaskId, TaskPayload>   fRunning;   ///< Tasks currently assigned to workers
-  std::set<TaskId>                          fDone;      ///< Tasks that have completed successfully
+  NTaskRangeSet fPending; ///< Pending tasks not yet dispatched (claimed lowest id first)
+  NTaskRangeSet fRunning; ///< Tasks currently assigned to workers
+  NTaskRangeSet fDone;    ///< Tasks that have completed successfully
   
   // Mappings for efficient lookup
-  std::unordered_map<WorkerId, std::set<TaskId>> fWorkerToTasks;  ///< Current assignments per worker
-  std::unordered_map<TaskId, WorkerId>           fTaskToWorker;   ///< Reverse mapping task->worker
-  std::unordered_map<TaskId, TaskPayload>        fTaskPayloads;   ///< Stored payloads for recovery
+  std::unordered_map<WorkerId, NTaskRangeSet>    fWorkerToTasks;  ///< Current assignments per worker
+  std::unordered_map<TaskId, WorkerId>           fTaskToWorker;   ///< Reverse mapping task->worker (running tasks only)
+  std::unordered_map<TaskId, TaskPayload>        fTaskPayloads;   ///< Stored payloads (only without a resolver)
+  std::unordered_map<TaskId, std::set<WorkerId>> fExtraOwners;    ///< Speculative owners besides fTaskToWorker
+  PayloadResolver                                fPayloadResolver; ///< Optional id -> payload mapping
   
   /// Check if task exists in any state
   bool TaskExists(TaskId id) const;
 
-  /// Push task into pending queue and pending-id index.
-  void EnqueuePending(TaskId id, const TaskPayload & payload);
+  /// Fill the payload of a known task; false if it cannot be resolved.
+  bool PayloadOf(TaskId id, TaskPayload & payload) const;
+
+  /// Mark a task as running and owned by a worker.
+  void StartOnWorker(const WorkerId & worker, TaskId id);
+
+  /// Remove a single task from a worker's assignment set.
+  void UnassignFromWorker(const WorkerId & worker, TaskId id);
+
+  /// Remove all owners (primary and speculative) of a task.
+  void DetachOwners(TaskId id);
 };
 
 } // namespace Ndmspc
@@ -18,7 +18,8 @@ ClassImp(Ndmspc::NTreeBranch);
 /// \endcond
 
 namespace Ndmspc {
-NTreeBranch::NTreeBranch(TTree * tree, const std::string & name, void * address, const std::string & objClassName)
+NTreeBranch::NTreeBranch(TTree * tree, const std::string & name, void * address, const std::string & objClassName,
+                         int splitLevel)
     : TObject(), fName(name), fObjectClassName(objClassName)
 {
   ///
@@ -26,7 +27,7 @@ NTreeBranch::NTreeBranch(TTree * tree, const std::string & name, void * address,
   ///
   // SetAddress(address);
   if (tree) {
-    Branch(tree, address);
+    Branch(tree, address, splitLevel);
   }
 }
 NTreeBranch::~NTreeBranch()
@@ -37,7 +38,7 @@ NTreeBranch::~NTreeBranch()
   // delete fObject;
   // delete fBranch;
 }
-TBranch * NTreeBranch::Branch(TTree * tree, void * address)
+TBranch * NTreeBranch::Branch(TTree * tree, void * address, int splitLevel)
 {
   ///
   /// Setting up branch
@@ -52,7 +53,7 @@ TBranch * NTreeBranch::Branch(TTree * tree, void * address)
     return fBranch;
   }
   // fBranch = tree->Branch(fName.c_str(), fObjectClassName.c_str(), &address);
-  tree->Branch(fName.c_str(), fObjectClassName.c_str(), &address);
+  tree->Branch(fName.c_str(), fObjectClassName.c_str(), &address, 32000, splitLevel);
   fBranch = tree->GetBranch(fName.c_str());
   return fBranch;
 }
@@ -71,7 +72,8 @@ void NTreeBranch::SetAddress(void * address, bool deleteExisting)
     // so do NOT also call 'delete fObject' here — that would be a double-free.
     fObject = nullptr;
   }
-  fObject = (TObject *)address;
+  fObject    = (TObject *)address;
+  fReadEntry = -1;
   fBranch->SetAddress(&fObject);
 }
 void NTreeBranch::SetBranchAddress(TTree * tree)
@@ -94,7 +96,8 @@ void NTreeBranch::SetBranchAddress(TTree * tree)
     // so do NOT also call 'delete fObject' here — that would be a double-free.
     fObject = nullptr;
   }
-  tree->SetBranchStatus(fName.c_str(), fBranchStatus);
+  fReadEntry = -1;
+  tree->SetBranchStatus(GetStatusPattern(fName).c_str(), fBranchStatus);
   tree->SetBranchAddress(fName.c_str(), &fObject);
   fBranch = tree->GetBranch(fName.c_str());
 }
@@ -129,7 +132,8 @@ Long64_t NTreeBranch::GetEntry(TTree * tree, Long64_t entry)
       NUtils::SafeDeleteTList(lst);
       fObject = nullptr;
     }
-    bytes = fBranch->GetEntry(entry);
+    bytes      = fBranch->GetEntry(entry);
+    fReadEntry = entry;
     // ProcInfo_t info;
     // gSystem->GetProcInfo(&info);
     // NLogDebug("NTreeBranch::GetEntry:[RSS]: %ld kB", info.fMemResident);
@@ -141,6 +145,19 @@ Long64_t NTreeBranch::GetEntry(TTree * tree, Long64_t entry)
 
   return bytes;
 }
+void NTreeBranch::AdoptObject(TObject * obj, Long64_t entry)
+{
+  ///
+  /// Adopt object
+  ///
+  if (fObject && fObject != obj) {
+    NLogTrace("NTreeBranch::AdoptObject: Deleting existing object %p for branch '%s' ...", fObject, fName.c_str());
+    NUtils::SafeDeleteObject(fObject);
+  }
+  fObject    = obj;
+  fReadEntry = entry;
+}
+
 void NTreeBranch::SaveEntry(NTreeBranch * hnstBranchIn, bool useProjection, const std::string projOpt)
 {
   ///
@@ -23,9 +23,10 @@ class NTreeBranch : public TObject {
    * @param name Branch name (optional).
    * @param address Pointer to branch data (optional).
    * @param objClassName Object class name (default: "TObject").
+   * @param splitLevel Split level used when the branch is created (default: 99).
    */
   NTreeBranch(TTree * tree = nullptr, const std::string & name = "", void * address = nullptr,
-              const std::string & objClassName = "TObject");
+              const std::string & objClassName = "TObject", int splitLevel = 99);
 
   /**
    * @brief Destructor.
@@ -90,9 +91,10 @@ class NTreeBranch : public TObject {
    * @brief Create branch in TTree with given address.
    * @param tree Pointer to TTree.
    * @param address Pointer to branch data.
+   * @param splitLevel Split level (default: 99).
    * @return Pointer to created TBranch.
    */
-  TBranch * Branch(TTree * tree, void * address);
+  TBranch * Branch(TTree * tree, void * address, int splitLevel = 99);
 
   /**
    * @brief Set address for branch data.
@@ -113,6 +115,16 @@ class NTreeBranch : public TObject {
    */
   void SetBranchStatus(int status) { fBranchStatus = status; }
 
+  /**
+   * @brief Get pattern for TTree::SetBranchStatus() covering a branch and its split sub-branches.
+   * @param name Branch name.
+   * @return Pattern, branch names ending with '.' get a trailing '*'.
+   */
+  static std::string GetStatusPattern(const std::string & name)
+  {
+    return !name.empty() && name.back() == '.' ? name + "*" : name;
+  }
+
   /**
    * @brief Get entry from TTree.
    * @param tree Pointer to TTree.
@@ -121,6 +133,22 @@ class NTreeBranch : public TObject {
    */
   Long64_t GetEntry(TTree * tree, Long64_t entry);
 
+  /**
+   * @brief Replace current object by an object read elsewhere (e.g. by read-ahead).
+   *
+   * The current object is deleted the same way GetEntry() does it and the branch keeps
+   * reading into the adopted object.
+   * @param obj Object to take ownership of.
+   * @param entry Entry the object was read from (-1 if unknown).
+   */
+  void AdoptObject(TObject * obj, Long64_t entry = -1);
+
+  /**
+   * @brief Get entry currently held in the object.
+   * @return Entry read by the last GetEntry(), -1 if the object was set otherwise.
+   */
+  Long64_t GetReadEntry() const { return fReadEntry; }
+
   /**
    * @brief Save entry to another NTreeBranch.
    * @param hnstIn Pointer to input NTreeBranch.
@@ -135,6 +163,7 @@ class NTreeBranch : public TObject {
   TBranch *   fBranch{nullptr};            ///<! Branch pointer
   TObject *   fObject{nullptr};            ///<! Object pointer
   std::string fObjectClassName{"TObject"}; ///< Object class name
+  Long64_t    fReadEntry{-1};              ///<! Entry held in fObject
 
   /// \cond CLASSIMP
   ClassDef(NTreeBranch, 1);
@@ -7,7 +7,7 @@
 #pragma link C++ nestedclasses;
 #pragma link C++ class Ndmspc::NThreadData + ;
 #pragma link C++ class Ndmspc::NDimensionalExecutor + ;
-#pragma link C++ class Ndmspc::NBinningDef + ;
+#pragma link C++ class Ndmspc::NBinningDef - ;
 #pragma link C++ class Ndmspc::NBinning + ;
 #pragma link C++ class Ndmspc::NBinningPoint + ;
 #pragma link C++ class Ndmspc::NTreeBranch + ;
@@ -16,5 +16,6 @@
 #pragma link C++ class Ndmspc::NResourceMonitor + ;
 #pragma link C++ class Ndmspc::NGnTree + ;
 #pragma link C++ class Ndmspc::NGnThreadData + ;
+#pragma link C++ class Ndmspc::NGnProcessSession + ;
 #pragma link C++ class Ndmspc::NGnNavigator + ;
 #endif
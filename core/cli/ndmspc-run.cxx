@@ -94,6 +94,8 @@ int main(int argc, char ** argv)
 {
   TApplication rootApp("ndmspc-run", 0, nullptr);
   gROOT->SetBatch(kTRUE);
+  // Enabled once here: output merges, read-ahead and import scans only check it (NUtils::IsThreadSafetyEnabled)
+  ROOT::EnableThreadSafety();
 
   CLI::App app{app_description()};
   app.set_version_flag("--version", app_version(), "Print version information and exit");
@@ -107,6 +109,14 @@ int main(int argc, char ** argv)
   std::string workerEndpoint;
   std::string tmpDir;
   std::string tmpResultsDir;
+  std::string threadScheduler;
+  std::string costHistory;
+  bool        costAware = false;
+  bool        speculate = false;
+  bool        streamResults = false;
+  bool        checkpoint = false;
+  bool        resume = false;
+  std::string checkpointInterval;
   size_t      spawnWorkers = 0;
   bool        verbose = false;
 
@@ -132,6 +142,24 @@ int main(int argc, char ** argv)
                  "Local scratch directory for temporary files (NDMSPC_TMP_DIR)");
   app.add_option("--results-dir", tmpResultsDir,
                  "Shared results directory where workers deposit output (NDMSPC_TMP_RESULTS_DIR)");
+  app.add_option("--thread-scheduler", threadScheduler,
+                 "Thread-mode scheduler: queue (shared queue) or steal (work-stealing) (NDMSPC_THREAD_SCHEDULER)")
+     ->check(CLI::IsMember({"queue", "steal"}));
+  app.add_option("--cost-history", costHistory,
+                 "Output file of a previous run; its per-bin timing orders IPC/TCP tasks longest-first (NDMSPC_COST_HISTORY)");
+  app.add_flag("--cost-aware", costAware,
+               "IPC/TCP: dispatch to idle workers first and size batches by measured worker speed (NDMSPC_IPC_COST_AWARE)");
+  app.add_flag("--speculate", speculate,
+               "TCP: duplicate straggler tasks onto idle workers near the end of a definition (NDMSPC_TCP_SPECULATION)");
+  app.add_flag("--stream-results", streamResults,
+               "TCP: workers send results over the socket instead of a shared results dir (NDMSPC_RESULT_STREAMING)");
+  app.add_flag("--checkpoint", checkpoint,
+               "IPC: periodically checkpoint worker outputs so an interrupted run can be resumed (NDMSPC_CHECKPOINT)");
+  app.add_flag("--resume", resume,
+               "IPC: resume an interrupted run from its checkpoint journal, implies --checkpoint; output lists of "
+               "interrupted workers are not restored (NDMSPC_RESUME)");
+  app.add_option("--checkpoint-interval", checkpointInterval,
+                 "Seconds between worker checkpoints (NDMSPC_CHECKPOINT_INTERVAL, default: 30)");
   app.add_flag("-v,--verbose", verbose, "Enable verbose logging");
 
   CLI11_PARSE(app, argc, argv);
@@ -170,6 +198,14 @@ int main(int argc, char ** argv)
   setenvIfEmpty("NDMSPC_TCP_PORT", tcpPort);
   setenvIfEmpty("NDMSPC_TMP_DIR", tmpDir);
   setenvIfEmpty("NDMSPC_TMP_RESULTS_DIR", tmpResultsDir);
+  setenvIfEmpty("NDMSPC_THREAD_SCHEDULER", threadScheduler);
+  setenvIfEmpty("NDMSPC_COST_HISTORY", costHistory);
+  if (costAware) setenvIfEmpty("NDMSPC_IPC_COST_AWARE", "1");
+  if (speculate) setenvIfEmpty("NDMSPC_TCP_SPECULATION", "1");
+  if (streamResults) setenvIfEmpty("NDMSPC_RESULT_STREAMING", "1");
+  if (checkpoint) setenvIfEmpty("NDMSPC_CHECKPOINT", "1");
+  if (resume) setenvIfEmpty("NDMSPC_RESUME", "1");
+  setenvIfEmpty("NDMSPC_CHECKPOINT_INTERVAL", checkpointInterval);
 
   const std::string effectiveMacroParams = gSystem->Getenv("NDMSPC_MACRO_PARAMS") ? gSystem->Getenv("NDMSPC_MACRO_PARAMS") : "";
 
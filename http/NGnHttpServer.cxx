@@ -1,10 +1,13 @@
 #include <TROOT.h>
+#include <TSystem.h>
 #include <sstream>
 #include <set>
 #include <algorithm>
 #include <cctype>
 #include "NGnHttpServer.h"
 #include "NGnHistoryEntry.h"
+#include "NGnPayloadCache.h"
+#include "NBinaryPayload.h"
 #include "NLogger.h"
 
 /// \cond CLASSIMP
@@ -18,6 +21,23 @@ NGnHttpServer::NGnHttpServer(const char * engine, bool ws, int heartbeat_ms) : N
 {
   Ndmspc::gNGnHttpServer = this;
   fWorkspace.SetServer(this);
+
+  // NDMSPC_HTTP_CACHE_SIZE: budget in bytes of serialized payloads shared between requests (default 256 MB, 0 = off)
+  Long64_t     cacheSize    = 256LL * 1024 * 1024;
+  const char * envCacheSize = gSystem->Getenv("NDMSPC_HTTP_CACHE_SIZE");
+  try {
+    if (envCacheSize) cacheSize = std::stoll(std::string(envCacheSize));
+  }
+  catch (...) {
+    NLogWarning("NDMSPC_HTTP_CACHE_SIZE invalid: '%s'", envCacheSize);
+  }
+  fPayloadCache = new NGnPayloadCache(cacheSize > 0 ? cacheSize : 0);
+}
+
+NGnHttpServer::~NGnHttpServer()
+{
+  delete fPayloadCache;
+  if (Ndmspc::gNGnHttpServer == this) Ndmspc::gNGnHttpServer = nullptr;
 }
 
 void NGnHttpServer::Print(Option_t * option) const
@@ -33,6 +53,9 @@ void NGnHttpServer::Print(Option_t * option) const
   for (const auto & obj : fObjectsMap) {
     NLogInfo("  %s -> %p", obj.first.c_str(), obj.second);
   }
+  NLogInfo("Payload cache: %zu payloads %zu/%zu bytes hits=%zu misses=%zu", fPayloadCache->GetEntries(),
+           fPayloadCache->GetBytes(), fPayloadCache->GetMaxBytes(), fPayloadCache->GetHits(),
+           fPayloadCache->GetMisses());
   // print history entries
   fWorkspace.Print(option);
 }
@@ -151,6 +174,7 @@ void NGnHttpServer::ProcessRequest(std::shared_ptr<THttpCallArg> arg)
       }
     }
 
+    fResponseETags.clear();
     fHttpHandlers[fullpath.Data()](method.Data(), in, out, wsOut, fObjectsMap);
 
     if (fUseHistory) {
@@ -173,6 +197,28 @@ void NGnHttpServer::ProcessRequest(std::shared_ptr<THttpCallArg> arg)
       }
     }
 
+    // ETag of cached payloads used by the handler. When requesting client already has them (If-None-Match)
+    // and tells its WebSocket id (X-NDMSPC-WsId), payload is not sent to it again. Other clients always
+    // get the full message.
+    std::string etag;
+    ULong_t     notModifiedWsId = 0;
+    if (!fResponseETags.empty()) {
+      std::string all;
+      for (const auto & e : fResponseETags) all += e;
+      etag = fResponseETags.size() == 1 ? fResponseETags.front() : NGnPayloadCache::ComputeETag(all);
+      arg->AddHeader("ETag", etag.c_str());
+      arg->AddHeader("Access-Control-Expose-Headers", "ETag");
+      out["etag"] = etag;
+      TString ifNoneMatch = arg->GetRequestHeader("If-None-Match");
+      if (ifNoneMatch.Contains(etag.c_str())) {
+        out["notModified"] = true;
+        TString wsId       = arg->GetRequestHeader("X-NDMSPC-WsId");
+        if (wsId.IsDigit()) notModifiedWsId = wsId.Atoll();
+        NLogTrace("Payload for path %s not modified (%s) for client %lu", fullpath.Data(), etag.c_str(),
+                  notModifiedWsId);
+      }
+    }
+
     // Don't broadcast workspace updates in response to DELETE requests
     if (!method.CompareTo("DELETE")) {
       wsOut["workspace"] = nullptr;
@@ -219,6 +265,7 @@ void NGnHttpServer::ProcessRequest(std::shared_ptr<THttpCallArg> arg)
       json wsMessage;
       wsMessage["event"]   = "ngnt";
       wsMessage["payload"] = wsOut["payload"].is_null() ? json::object() : wsOut["payload"];
+      if (!etag.empty()) wsMessage["etag"] = etag;
       // If state is present, include it in the same payload
       if (!wsOut["state"].is_null()) {
         wsMessage["payload"]["state"] = wsOut["state"];
@@ -279,18 +326,23 @@ void NGnHttpServer::ProcessRequest(std::shared_ptr<THttpCallArg> arg)
         }
       }
 
+      // Every client gets the message in the format it asked for (JSON text or binary frame)
       NUtils::RawJsonInjections injections;
-      if (NUtils::CollectRawJsonInjections(wsOut, injections)) {
-        std::string wsMessageStr = NUtils::InjectRawJson(wsMessage, injections);
-        NLogDebug("Broadcasting to WebSocket clients for path %s: %s", fullpath.Data(), wsMessageStr.c_str());
-        if (fNWsHandler) {
-          fNWsHandler->BroadcastUnsafe(wsMessageStr);
+      NUtils::CollectRawJsonInjections(wsOut, injections);
+      NLogDebug("Broadcasting to WebSocket clients for path %s (%zu raw JSON injections)", fullpath.Data(),
+                injections.size());
+      if (fNWsHandler) {
+        fNWsHandler->Broadcast(wsMessage, injections, notModifiedWsId);
+        if (notModifiedWsId > 0) {
+          // Requesting client gets only workspace and state, it has the payload already
+          json notModified = wsMessage;
+          if (wsOut["payload"].is_object()) {
+            for (const auto & item : wsOut["payload"].items()) notModified["payload"].erase(item.key());
+          }
+          notModified["notModified"] = true;
+          fNWsHandler->SendTo(notModifiedWsId, notModified);
         }
       }
-      else {
-        NLogDebug("Broadcasting to WebSocket clients for path %s: %s", fullpath.Data(), wsMessage.dump().c_str());
-        WebSocketBroadcast(wsMessage);
-      }
     }
     else {
       NLogTrace("Skipping WebSocket broadcast for path %s: no payload or workspace changes", fullpath.Data());
@@ -299,6 +351,20 @@ void NGnHttpServer::ProcessRequest(std::shared_ptr<THttpCallArg> arg)
 
   // arg->AddHeader("X-Header", "Test");
   arg->AddHeader("Access-Control-Allow-Origin", GetCors());
+
+  // Clients sending "Accept: application/x-ndmspc-binary; compression=zstd" get binary frame (NBinaryPayload)
+  TString accept = arg->GetRequestHeader("Accept");
+  if (accept.Contains("application/x-ndmspc-binary")) {
+    std::string compression;
+    Ssiz_t      pos = accept.Index("compression=");
+    if (pos != kNPOS) {
+      compression = TString(accept(pos + 12, accept.Length())).Data();
+      compression = compression.substr(0, compression.find_first_of(",; "));
+    }
+    arg->SetContentType("application/x-ndmspc-binary");
+    arg->SetContent(NBinaryPayload::Pack(out, NBinaryPayload::GetCompression(compression)));
+    return;
+  }
   arg->SetContentType("application/json");
   arg->SetContent(out.dump());
   // arg->SetContent("ok");
@@ -322,6 +388,7 @@ void NGnHttpServer::ResetServer()
   ///
   NLogInfo("NGnHttpServer::ResetServer: Clearing history ...");
   ClearHistory();
+  InvalidateCache();
   NLogInfo("NGnHttpServer::ResetServer: Removing remaining input objects ...");
   std::vector<std::string> keys;
   keys.reserve(fObjectsMap.size());
@@ -335,6 +402,34 @@ void NGnHttpServer::ResetServer()
   NLogInfo("NGnHttpServer::ResetServer: Done.");
 }
 
+bool NGnHttpServer::GetCachedPayload(const std::string & key, std::string & payload)
+{
+  ///
+  /// Get cached payload of key
+  ///
+  std::string etag;
+  if (!fPayloadCache->Get(key, payload, &etag)) return false;
+  NLogTrace("NGnHttpServer::GetCachedPayload: Using cached payload '%s' %s", key.c_str(), etag.c_str());
+  fResponseETags.push_back(etag);
+  return true;
+}
+
+void NGnHttpServer::CachePayload(const std::string & key, const std::string & payload)
+{
+  ///
+  /// Cache payload of key
+  ///
+  fResponseETags.push_back(fPayloadCache->Put(key, payload));
+}
+
+void NGnHttpServer::InvalidateCache(const std::string & prefix)
+{
+  ///
+  /// Remove cached payloads with keys starting with prefix
+  ///
+  fPayloadCache->Invalidate(prefix);
+}
+
 bool NGnHttpServer::RemoveInputObject(const std::string & name)
 {
   if (fObjectsMap.find(name) != fObjectsMap.end()) {
@@ -1,5 +1,7 @@
 #ifndef Ndmspc_NGnHttpServer_H
 #define Ndmspc_NGnHttpServer_H
+#include <string>
+#include <vector>
 #include "NLogger.h"
 #include "NHttpServer.h"
 // #include "NGnHistoryEntry.h"
@@ -37,10 +39,12 @@ extern NGnHttpHandlerMap * gNdmspcHttpHandlers;
 ///
 class NGnHistoryEntry;
 class NGnHistory;
+class NGnPayloadCache;
 class NGnHttpServer : public NHttpServer {
 
   public:
   NGnHttpServer(const char * engine = "http:8080", bool ws = true, int heartbeat_ms = 10000);
+  virtual ~NGnHttpServer();
 
   virtual void Print(Option_t * option = "") const override;
   virtual void Clear(Option_t * option = "") override { NHttpServer::Clear(option); }
@@ -68,12 +72,22 @@ class NGnHttpServer : public NHttpServer {
   void                                          SetGroup(const std::string & group) { fGroup = group; }
   const std::string &                           GetGroup() const { return fGroup; }
 
+  /// Get cached payload of key; its ETag is used for the response of current request
+  bool GetCachedPayload(const std::string & key, std::string & payload);
+  /// Cache payload of key; its ETag is used for the response of current request
+  void CachePayload(const std::string & key, const std::string & payload);
+  /// Remove cached payloads with keys starting with prefix (all if empty)
+  void              InvalidateCache(const std::string & prefix = "");
+  NGnPayloadCache * GetPayloadCache() const { return fPayloadCache; }
+
   private:
   std::map<std::string, Ndmspc::NGnHttpFuncPtr> fHttpHandlers;       ///<! HTTP handlers map
   std::map<std::string, TObject *>              fObjectsMap;         ///<! Objects map for handlers
   NGnWorkspace                                  fWorkspace{nullptr}; ///<! Workspace object (TNamed)
   bool fUseHistory{true}; ///<! Flag to indicate whether to use history in processing requests
   std::string fGroup;     ///<! Group prefix for workspace routes
+  NGnPayloadCache *        fPayloadCache{nullptr}; ///<! Serialized payloads shared between requests
+  std::vector<std::string> fResponseETags;         ///<! ETags of cached payloads used by current request
 
   /// \cond CLASSIMP
   ClassDefOverride(NGnHttpServer, 1);
@@ -0,0 +1,107 @@
+#include <iterator>
+#include <TString.h>
+#include "NLogger.h"
+#include "NGnPayloadCache.h"
+
+namespace Ndmspc {
+
+bool NGnPayloadCache::Get(const std::string & key, std::string & payload, std::string * etag)
+{
+  ///
+  /// Get payload of key
+  ///
+  auto it = fIndex.find(key);
+  if (it == fIndex.end()) {
+    fMisses++;
+    return false;
+  }
+  fHits++;
+  fEntries.splice(fEntries.begin(), fEntries, it->second);
+  payload = it->second->payload;
+  if (etag) *etag = it->second->etag;
+  return true;
+}
+
+std::string NGnPayloadCache::Put(const std::string & key, const std::string & payload)
+{
+  ///
+  /// Store payload of key
+  ///
+  std::string etag = ComputeETag(payload);
+  auto        it   = fIndex.find(key);
+  if (it != fIndex.end()) Erase(it->second);
+
+  const size_t bytes = key.size() + payload.size();
+  if (bytes > fMaxBytes) {
+    NLogTrace("NGnPayloadCache::Put: Payload of '%s' (%zu bytes) is over budget %zu, not cached", key.c_str(), bytes,
+              fMaxBytes);
+    return etag;
+  }
+
+  fEntries.push_front({key, payload, etag});
+  fIndex[key] = fEntries.begin();
+  fBytes += bytes;
+  Evict();
+  return etag;
+}
+
+size_t NGnPayloadCache::Invalidate(const std::string & prefix)
+{
+  ///
+  /// Remove payloads with keys starting with prefix
+  ///
+  size_t n = 0;
+  for (auto it = fEntries.begin(); it != fEntries.end();) {
+    auto current = it++;
+    if (current->key.compare(0, prefix.size(), prefix) != 0) continue;
+    Erase(current);
+    n++;
+  }
+  if (n > 0) NLogDebug("NGnPayloadCache::Invalidate: Removed %zu payloads of '%s'", n, prefix.c_str());
+  return n;
+}
+
+void NGnPayloadCache::SetMaxBytes(size_t maxBytes)
+{
+  ///
+  /// Set budget in bytes
+  ///
+  fMaxBytes = maxBytes;
+  Evict();
+}
+
+std::string NGnPayloadCache::ComputeETag(const std::string & content)
+{
+  ///
+  /// Quoted ETag of content
+  ///
+  unsigned long long h = 14695981039346656037ULL;
+  for (unsigned char c : content) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return TString::Format("\"%016llx\"", h).Data();
+}
+
+void NGnPayloadCache::Evict()
+{
+  ///
+  /// Remove least recently used payloads until size fits budget
+  ///
+  while (fBytes > fMaxBytes && !fEntries.empty()) {
+    NLogTrace("NGnPayloadCache::Evict: Removing '%s'", fEntries.back().key.c_str());
+    Erase(std::prev(fEntries.end()));
+  }
+}
+
+void NGnPayloadCache::Erase(std::list<Entry>::iterator it)
+{
+  ///
+  /// Remove payload
+  ///
+  fBytes -= it->key.size() + it->payload.size();
+  fIndex.erase(it->key);
+  fEntries.erase(it);
+}
+
+} // namespace Ndmspc
@@ -0,0 +1,67 @@
+#ifndef Ndmspc_NGnPayloadCache_H
+#define Ndmspc_NGnPayloadCache_H
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace Ndmspc {
+
+///
+/// \class NGnPayloadCache
+/// \brief Serialized payloads shared between HTTP requests.
+///
+/// Handlers store ready to send payloads (e.g. TBufferJSON output of projections) under a key built
+/// from file, binning definition, axes and ranges, so the same cells requested again (by the same or
+/// another client) are not projected and serialized again. Total size of payloads is kept under a
+/// budget by evicting the least recently used ones. Every payload gets an ETag (hash of its content).
+///
+/// Not thread safe, used from the event loop thread processing requests.
+///
+class NGnPayloadCache {
+
+  public:
+  NGnPayloadCache(size_t maxBytes = 0) : fMaxBytes(maxBytes) {}
+
+  /// Get payload (and its ETag) of key, marks it as recently used. Returns false if not cached.
+  bool Get(const std::string & key, std::string & payload, std::string * etag = nullptr);
+  /// Store payload of key (replacing the old one) and returns its ETag. Payloads over budget are not stored.
+  std::string Put(const std::string & key, const std::string & payload);
+  /// Remove payloads with keys starting with prefix (all if empty). Returns number of removed payloads.
+  size_t Invalidate(const std::string & prefix = "");
+
+  /// Set budget in bytes (0 disables cache), evicts payloads over it
+  void   SetMaxBytes(size_t maxBytes);
+  size_t GetMaxBytes() const { return fMaxBytes; }
+  size_t GetBytes() const { return fBytes; }
+  size_t GetEntries() const { return fEntries.size(); }
+  size_t GetHits() const { return fHits; }
+  size_t GetMisses() const { return fMisses; }
+
+  /// Quoted ETag of content (64 bit FNV-1a)
+  static std::string ComputeETag(const std::string & content);
+
+  private:
+  /// Cached payload
+  struct Entry {
+    std::string key;     ///< Key
+    std::string payload; ///< Serialized payload
+    std::string etag;    ///< ETag of payload
+  };
+
+  /// Remove least recently used payloads until size fits budget
+  void Evict();
+  /// Remove payload
+  void Erase(std::list<Entry>::iterator it);
+
+  std::list<Entry>                                            fEntries;     ///< Payloads, most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> fIndex;       ///< Payload of key
+  size_t                                                      fBytes{0};    ///< Size of payloads and keys
+  size_t                                                      fMaxBytes{0}; ///< Budget in bytes
+  size_t                                                      fHits{0};     ///< Number of found payloads
+  size_t                                                      fMisses{0};   ///< Number of missing payloads
+};
+
+} // namespace Ndmspc
+#endif
@@ -111,8 +111,7 @@ bool NHttpServer::WebSocketBroadcast(json message)
 {
   NLogTrace("Broadcasting message to all clients.");
   if (fNWsHandler) {
-    std::string msgStr = message.dump();
-    fNWsHandler->BroadcastUnsafe(msgStr);
+    fNWsHandler->Broadcast(message);
     return true;
   }
   return false;
@@ -1,17 +1,69 @@
 #include "NWsHandler.h"
 #include <THttpCallArg.h>
+#include <TSystem.h>
 #include <TTimer.h>
+#include <algorithm>
 #include <chrono>
+#include <deque>
+#include <iterator>
 #include <unordered_map>
+#include "NBinaryPayload.h"
 #include "NLogger.h"
 #include "NUtils.h"
 // ClassImp(Ndmspc::NWsHandler);
 //
 namespace Ndmspc {
+
+/// Outbound queue of one client
+struct NWsOutQueue {
+  /// Queued message
+  struct Message {
+    std::shared_ptr<const std::string> data;   ///< JSON text or binary frame
+    bool                               binary; ///< Send as binary
+    std::string                        key;    ///< Coalescing key
+  };
+
+  std::mutex          mutex;            ///< Mutex for queue (never held while sending)
+  std::deque<Message> messages;         ///< Queued messages
+  size_t              bytes{0};         ///< Size of queued messages
+  bool                sending{false};   ///< Message is passed to THttpWSHandler and not completed yet
+  bool                draining{false};  ///< Drain() runs in some thread
+  bool                closed{false};    ///< Client is gone, nothing is queued anymore
+  bool                slow{false};      ///< Client is to be disconnected by policy
+  size_t              dropped{0};       ///< Number of dropped messages
+  size_t              coalesced{0};     ///< Number of replaced messages
+};
+
 NWsHandler::NWsHandler(const char * name, const char * title)
     : THttpWSHandler(name, title, kFALSE),
       fServerStartedAt(std::chrono::system_clock::now())
 {
+  // NDMSPC_WS_QUEUE_SIZE, NDMSPC_WS_QUEUE_BYTES: limits of outbound queue per client
+  const char * envQueueSize = gSystem->Getenv("NDMSPC_WS_QUEUE_SIZE");
+  try {
+    Long64_t n = envQueueSize ? std::stoll(std::string(envQueueSize)) : 0;
+    if (n > 0) fQueueSize = n;
+  }
+  catch (...) {
+    NLogWarning("NDMSPC_WS_QUEUE_SIZE invalid: '%s'", envQueueSize);
+  }
+  const char * envQueueBytes = gSystem->Getenv("NDMSPC_WS_QUEUE_BYTES");
+  try {
+    Long64_t n = envQueueBytes ? std::stoll(std::string(envQueueBytes)) : 0;
+    if (n > 0) fQueueBytes = n;
+  }
+  catch (...) {
+    NLogWarning("NDMSPC_WS_QUEUE_BYTES invalid: '%s'", envQueueBytes);
+  }
+  // NDMSPC_WS_SLOW_CLIENT: what to do when queue of client is full ("drop" or "disconnect")
+  const char * envSlowClient = gSystem->Getenv("NDMSPC_WS_SLOW_CLIENT");
+  if (envSlowClient) {
+    std::string policy = envSlowClient;
+    if (policy == "disconnect")
+      fDisconnectSlow = true;
+    else if (policy != "drop")
+      NLogWarning("NDMSPC_WS_SLOW_CLIENT invalid: '%s'", envSlowClient);
+  }
 }
 NWsHandler::~NWsHandler() {}
 
@@ -20,7 +72,8 @@ Bool_t NWsHandler::ProcessWS(THttpCallArg * arg)
 
   if (!arg || (arg->GetWSId() == 0)) return kTRUE;
 
-  std::lock_guard<std::mutex> lock(fMutex);
+  // Client map is locked only while it is changed and targets are collected, messages are queued after
+  std::unique_lock<std::mutex> lock(fMutex);
 
   if (arg->IsMethod("WS_CONNECT")) {
     NLogTrace("WS_CONNECT received for path: /%s", arg->GetPathName());
@@ -33,20 +86,17 @@ Bool_t NWsHandler::ProcessWS(THttpCallArg * arg)
 
     std::string username  = "User_" + std::to_string(currentWsId);
     fClients[currentWsId] = NWsClientInfo(currentWsId, username); // Use the constructor
+    auto queue            = std::make_shared<NWsOutQueue>();
+    {
+      std::lock_guard<std::mutex> queuesLock(fQueuesMutex);
+      fQueues[currentWsId] = queue;
+    }
 
     NLogDebug("New client connected with ID %lld and username '%s'.", currentWsId, username.c_str());
-    // Call the global SendCharStarWS function
     json welcomeData;
     welcomeData["event"]               = "welcome";
     welcomeData["payload"]["username"] = username;
     welcomeData["payload"]["wsId"]     = currentWsId;
-    SendCharStarWS(currentWsId, welcomeData.dump().c_str());
-
-    for (const auto & pair : fClients) {
-      if (pair.first != currentWsId) {
-        SendCharStarWS(pair.first, (username + " has joined the chat!").c_str());
-      }
-    }
 
     json clientsData;
     clientsData["event"]            = "clients";
@@ -60,7 +110,13 @@ Bool_t NWsHandler::ProcessWS(THttpCallArg * arg)
       userData["connectedAt"] = connectedAtMs;
       clientsData["payload"]["users"].push_back(userData);
     }
-    BroadcastUnsafe(clientsData.dump());
+    std::vector<Target> others  = GetTargetsUnsafe(currentWsId);
+    std::vector<Target> targets = GetTargetsUnsafe();
+    lock.unlock();
+
+    Enqueue(currentWsId, queue, std::make_shared<const std::string>(welcomeData.dump()), false, "");
+    Send(others, username + " has joined the chat!");
+    Send(targets, clientsData.dump(), "clients");
 
     return kTRUE;
   }
@@ -75,13 +131,27 @@ Bool_t NWsHandler::ProcessWS(THttpCallArg * arg)
       username = it->second.GetUsername();
       fClients.erase(it);
     }
+    std::shared_ptr<NWsOutQueue> queue;
+    {
+      std::lock_guard<std::mutex> queuesLock(fQueuesMutex);
+      auto                        itQueue = fQueues.find(closedWsId);
+      if (itQueue != fQueues.end()) {
+        queue = itQueue->second;
+        fQueues.erase(itQueue);
+      }
+    }
+    if (queue) {
+      std::lock_guard<std::mutex> queueLock(queue->mutex);
+      queue->closed = true;
+      queue->messages.clear();
+      queue->bytes = 0;
+    }
 
     NLogDebug("Client with ID %lld and username '%s' has disconnected.", closedWsId, username.c_str());
 
     json disconnectData;
     disconnectData["event"]   = "goodbye";
     disconnectData["payload"] = "Goodbye, " + username + "!";
-    BroadcastUnsafe(disconnectData.dump());
 
     json clientsData;
     clientsData["event"]            = "clients";
@@ -95,7 +165,11 @@ Bool_t NWsHandler::ProcessWS(THttpCallArg * arg)
       userData["connectedAt"] = connectedAtMs;
       clientsData["payload"]["users"].push_back(userData);
     }
-    BroadcastUnsafe(clientsData.dump());
+    std::vector<Target> targets = GetTargetsUnsafe();
+    lock.unlock();
+
+    Send(targets, disconnectData.dump());
+    Send(targets, clientsData.dump(), "clients");
 
     return kTRUE;
   }
@@ -112,6 +186,26 @@ Bool_t NWsHandler::ProcessWS(THttpCallArg * arg)
       senderUsername = it->second.GetUsername();
     }
 
+    // Format negotiation: {"event":"accept","payload":{"format":"binary","compression":"zstd"}}
+    json request = json::parse(receivedStr, nullptr, false);
+    if (it != fClients.end() && request.is_object() && request.value("event", "") == "accept") {
+      json        payload     = request.value("payload", json::object());
+      bool        binary      = payload.value("format", "json") == "binary";
+      std::string compression = payload.value("compression", "none");
+      auto        c           = NBinaryPayload::GetCompression(compression);
+      it->second.SetFormat(binary, c);
+      NLogDebug("Client %lld accepts %s messages (compression %s)", senderWsId, binary ? "binary" : "json",
+                NBinaryPayload::GetCompressionName(c).c_str());
+
+      json reply;
+      reply["event"]                  = "accept";
+      reply["payload"]["format"]      = binary ? "binary" : "json";
+      reply["payload"]["compression"] = binary ? NBinaryPayload::GetCompressionName(c) : "none";
+      lock.unlock();
+      Enqueue(senderWsId, GetQueue(senderWsId), std::make_shared<const std::string>(reply.dump()), false, "");
+      return kTRUE;
+    }
+
     std::string replyMsg = "Server received from " + senderUsername + ": " + receivedStr;
     // return kTRUE;
     // std::string broadcastMsg = senderUsername + ": " + receivedStr;
@@ -125,14 +219,11 @@ Bool_t NWsHandler::ProcessWS(THttpCallArg * arg)
     static std::unordered_map<ULong_t, std::string> recentMessages;
     recentMessages[senderWsId] = broadcastMsg;
 
-    for (const auto & pair : fClients) {
-      if (pair.first != senderWsId) {
-        auto itMsg = recentMessages.find(senderWsId);
-        if (itMsg != recentMessages.end()) {
-          SendCharStarWS(pair.first, itMsg->second.c_str());
-        }
-      }
-    }
+    std::string         relay   = recentMessages[senderWsId];
+    std::vector<Target> targets = GetTargetsUnsafe(senderWsId);
+    lock.unlock();
+
+    Send(targets, relay);
 
     return kTRUE;
   }
@@ -146,20 +237,268 @@ size_t NWsHandler::GetClientCount() const
   return fClients.size();
 }
 
-void NWsHandler::Broadcast(const std::string & message)
+void NWsHandler::Broadcast(const std::string & message, const std::string & key)
 {
-  // This method is protected by a mutex to ensure thread safety
-  std::lock_guard<std::mutex> lock(fMutex);
-  BroadcastUnsafe(message);
+  std::vector<Target> targets;
+  {
+    // Client map is locked only to collect queues, messages are queued and sent without it
+    std::lock_guard<std::mutex> lock(fMutex);
+    targets = GetTargetsUnsafe();
+  }
+  Send(targets, message, key);
 }
 
-void NWsHandler::BroadcastUnsafe(const std::string & message)
+void NWsHandler::Broadcast(const json & message, const NUtils::RawJsonInjections & injections, ULong_t exclude)
 {
-  NLogTrace("Broadcasting to %d clients : %s", fClients.size(), message.c_str());
+  std::vector<Target> targets;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    targets = GetTargetsUnsafe(exclude);
+  }
+  Send(targets, message, injections);
+}
+
+void NWsHandler::SendTo(ULong_t wsId, const json & message, const NUtils::RawJsonInjections & injections)
+{
+  std::vector<Target> targets;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    for (auto & target : GetTargetsUnsafe()) {
+      if (target.wsId == wsId) targets.push_back(target);
+    }
+  }
+  Send(targets, message, injections);
+}
+
+void NWsHandler::Send(const std::vector<Target> & targets, const json & message,
+                      const NUtils::RawJsonInjections & injections)
+{
+  ///
+  /// Sends message to targets, every format is built once
+  ///
+  const std::string                                 key = GetCoalesceKey(message);
+  std::shared_ptr<const std::string>                text;
+  std::map<int, std::shared_ptr<const std::string>> frames;
+  for (const auto & target : targets) {
+    if (target.binary) {
+      auto it = frames.find(target.compression);
+      if (it == frames.end()) {
+        auto c    = static_cast<NBinaryPayload::ECompression>(target.compression);
+        auto data = std::make_shared<const std::string>(NBinaryPayload::Pack(message, injections, c));
+        it        = frames.emplace(target.compression, data).first;
+        NLogTrace("Binary frame (compression %d) has %zu bytes", target.compression, data->size());
+      }
+      Enqueue(target.wsId, target.queue, it->second, true, key);
+    }
+    else {
+      if (!text) {
+        json tmp = message;
+        text     = std::make_shared<const std::string>(injections.empty() ? tmp.dump()
+                                                                          : NUtils::InjectRawJson(tmp, injections));
+      }
+      Enqueue(target.wsId, target.queue, text, false, key);
+    }
+  }
+}
+
+std::string NWsHandler::GetCoalesceKey(const json & message)
+{
+  ///
+  /// Coalescing key of message
+  ///
+  if (!message.is_object()) return "";
+  auto itEvent = message.find("event");
+  if (itEvent == message.end() || !itEvent->is_string()) return "";
+  const std::string & event = itEvent->get_ref<const std::string &>();
+  if (event == "heartbeat" || event == "clients") return event;
+  if (event != "ngnt") return "";
+
+  // State of the same parts (and pads) is superseded, parts appended to tabs are kept
+  auto itPayload = message.find("payload");
+  if (itPayload == message.end() || !itPayload->is_object()) return "";
+  std::string key = event;
+  for (const auto & [name, part] : itPayload->items()) {
+    key += ":" + name;
+    if (!part.is_object()) continue;
+    if (part.value("appendToTab", false)) return "";
+    auto itPad = part.find("targetPad");
+    if (itPad != part.end() && itPad->is_string()) key += "@" + itPad->get<std::string>();
+  }
+  return key;
+}
+
+std::vector<NWsHandler::Target> NWsHandler::GetTargetsUnsafe(ULong_t exclude)
+{
+  ///
+  /// Targets of all clients (client map lock must be held)
+  ///
+  std::vector<Target>         targets;
+  std::lock_guard<std::mutex> lock(fQueuesMutex);
   for (const auto & pair : fClients) {
-    ULong_t wsId = pair.first;
-    // Call the global SendCharStarWS function
-    SendCharStarWS(wsId, message.c_str());
+    if (pair.first == exclude) continue;
+    auto it = fQueues.find(pair.first);
+    if (it == fQueues.end()) continue;
+    targets.push_back({pair.first, it->second, pair.second.IsBinary(), pair.second.GetCompression()});
+  }
+  return targets;
+}
+
+std::shared_ptr<NWsOutQueue> NWsHandler::GetQueue(ULong_t wsId)
+{
+  ///
+  /// Outbound queue of client
+  ///
+  std::lock_guard<std::mutex> lock(fQueuesMutex);
+  auto                        it = fQueues.find(wsId);
+  return it != fQueues.end() ? it->second : nullptr;
+}
+
+void NWsHandler::Send(const std::vector<Target> & targets, const std::string & message, const std::string & key)
+{
+  ///
+  /// Sends message to targets
+  ///
+  NLogTrace("Broadcasting to %zu clients : %s", targets.size(), message.c_str());
+  auto data = std::make_shared<const std::string>(message);
+  for (const auto & target : targets) {
+    Enqueue(target.wsId, target.queue, data, false, key);
+  }
+}
+
+void NWsHandler::Enqueue(ULong_t wsId, const std::shared_ptr<NWsOutQueue> & queue,
+                         std::shared_ptr<const std::string> data, bool binary, const std::string & key)
+{
+  ///
+  /// Appends message to queue of client and starts sending
+  ///
+  if (!queue || !data) return;
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->closed) return;
+
+    // Queued message with the same key is superseded
+    if (!key.empty()) {
+      auto it = std::find_if(queue->messages.begin(), queue->messages.end(),
+                             [&key](const NWsOutQueue::Message & m) { return m.key == key; });
+      if (it != queue->messages.end()) {
+        queue->bytes -= it->data->size();
+        queue->messages.erase(it);
+        queue->coalesced++;
+      }
+    }
+    queue->bytes += data->size();
+    queue->messages.push_back({std::move(data), binary, key});
+
+    // Slow client, the newest message is always kept
+    while (queue->messages.size() > 1 && (queue->messages.size() > fQueueSize || queue->bytes > fQueueBytes)) {
+      if (fDisconnectSlow) {
+        NLogWarning("NWsHandler: Client %lu is too slow (%zu messages, %zu bytes queued), disconnecting", wsId,
+                    queue->messages.size(), queue->bytes);
+        queue->slow   = true;
+        queue->closed = true;
+        queue->messages.clear();
+        queue->bytes = 0;
+        return;
+      }
+      // Latest states are kept as long as there is other message to drop
+      auto drop = std::find_if(queue->messages.begin(), std::prev(queue->messages.end()),
+                               [](const NWsOutQueue::Message & m) { return m.key.empty(); });
+      if (drop == std::prev(queue->messages.end())) drop = queue->messages.begin();
+      queue->bytes -= drop->data->size();
+      queue->messages.erase(drop);
+      if (queue->dropped++ == 0) NLogWarning("NWsHandler: Client %lu is too slow, dropping its oldest messages", wsId);
+    }
+  }
+  Drain(wsId, queue);
+}
+
+void NWsHandler::Drain(ULong_t wsId, const std::shared_ptr<NWsOutQueue> & queue)
+{
+  ///
+  /// Sends queued messages of client until a send operation is postponed to sending thread
+  ///
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (queue->draining) return;
+  queue->draining = true;
+  while (!queue->sending && !queue->closed && !queue->messages.empty()) {
+    NWsOutQueue::Message message = std::move(queue->messages.front());
+    queue->messages.pop_front();
+    queue->bytes -= message.data->size();
+    queue->sending = true;
+
+    lock.unlock();
+    // 0: sent (CompleteWSSend() was already called), 1: sending thread calls CompleteWSSend() later
+    Int_t rc = SendFrame(wsId, *message.data, message.binary);
+    lock.lock();
+
+    if (rc < 0) {
+      NLogDebug("NWsHandler: Sending to client %lu failed, dropping %zu queued messages", wsId,
+                queue->messages.size());
+      queue->closed = true;
+      queue->messages.clear();
+      queue->bytes = 0;
+    }
+    if (rc <= 0) queue->sending = false;
+  }
+  queue->draining = false;
+}
+
+Int_t NWsHandler::SendFrame(ULong_t wsId, const std::string & data, bool binary)
+{
+  ///
+  /// Passes message to THttpWSHandler
+  ///
+  return binary ? SendWS(wsId, data.data(), data.size()) : SendCharStarWS(wsId, data.c_str());
+}
+
+void NWsHandler::CompleteWSSend(UInt_t wsId)
+{
+  ///
+  /// Sends next queued message of client
+  ///
+  auto queue = GetQueue(wsId);
+  if (!queue) return;
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->sending = false;
+    // Drain() in progress continues with next message
+    if (queue->draining) return;
+  }
+  Drain(wsId, queue);
+}
+
+void NWsHandler::CloseSlowClients()
+{
+  ///
+  /// Closes clients marked by disconnect policy
+  ///
+  std::vector<ULong_t> slow;
+  {
+    std::lock_guard<std::mutex> lock(fQueuesMutex);
+    for (auto it = fQueues.begin(); it != fQueues.end();) {
+      bool isSlow;
+      {
+        std::lock_guard<std::mutex> queueLock(it->second->mutex);
+        isSlow = it->second->slow;
+      }
+      if (isSlow) {
+        slow.push_back(it->first);
+        it = fQueues.erase(it);
+      }
+      else {
+        ++it;
+      }
+    }
+  }
+  if (slow.empty()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    for (ULong_t wsId : slow) fClients.erase(wsId);
+  }
+  for (ULong_t wsId : slow) {
+    NLogInfo("NWsHandler: Closing slow client %lu", wsId);
+    CloseWS(wsId);
   }
 }
 
@@ -169,12 +508,14 @@ Bool_t NWsHandler::HandleTimer(TTimer *)
   /// Handle timer event for heartbeat
   ///
 
-  std::lock_guard<std::mutex> lock(fMutex);
+  CloseSlowClients();
+
+  // Stats are collected without client map lock
+  std::unique_lock<std::mutex> statsLock(fStatsMutex);
 
   json data;
   data["event"]              = "heartbeat";
   data["payload"]["count"]   = ++fServCnt;
-  data["payload"]["clients"] = static_cast<int>(fClients.size());
   data["payload"]["serverStartedAt"] = std::chrono::duration_cast<std::chrono::milliseconds>(
       fServerStartedAt.time_since_epoch()).count();
   // add system and TFile IO statistics
@@ -285,16 +626,32 @@ Bool_t NWsHandler::HandleTimer(TTimer *)
   catch (...) {
     // if stats retrieval fails, continue without them
   }
-  for (const auto & pair : fClients) {
-    json userData;
-    userData["wsId"]     = pair.first;
-    userData["username"] = pair.second.GetUsername();
-    const auto connectedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-        pair.second.GetConnectedAt().time_since_epoch()).count();
-    userData["connectedAt"] = connectedAtMs;
-    data["payload"]["users"].push_back(userData);
+  statsLock.unlock();
+
+  std::vector<Target> targets;
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    data["payload"]["clients"] = static_cast<int>(fClients.size());
+    for (const auto & pair : fClients) {
+      json userData;
+      userData["wsId"]     = pair.first;
+      userData["username"] = pair.second.GetUsername();
+      const auto connectedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+          pair.second.GetConnectedAt().time_since_epoch()).count();
+      userData["connectedAt"] = connectedAtMs;
+      data["payload"]["users"].push_back(userData);
+    }
+    targets = GetTargetsUnsafe();
+  }
+  for (auto & userData : data["payload"]["users"]) {
+    auto queue = GetQueue(userData["wsId"].get<ULong_t>());
+    if (!queue) continue;
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    userData["queued"]    = queue->messages.size();
+    userData["dropped"]   = queue->dropped;
+    userData["coalesced"] = queue->coalesced;
   }
-  BroadcastUnsafe(data.dump());
+  Send(targets, data.dump(), "heartbeat");
 
   return kTRUE;
 }
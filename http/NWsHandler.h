@@ -1,8 +1,10 @@
 #ifndef NdmspcNWsHandler_H
 #define NdmspcNWsHandler_H
 #include <map>    // For std::map
+#include <memory> // For std::shared_ptr
 #include <string> // For std::string
 #include <mutex>  // For std::mutex
+#include <vector> // For std::vector
 #include <chrono> // For std::chrono::system_clock
 #include <cstdio>
 #include <THttpWSHandler.h>
@@ -15,6 +17,8 @@ class THttpCallArg;
 class TTimer;
 namespace Ndmspc {
 
+struct NWsOutQueue;
+
 /**
  * @class NWsHandler
  * @brief Handles WebSocket connections and messaging for NDMSPC.
@@ -22,6 +26,17 @@ namespace Ndmspc {
  * Inherits from THttpWSHandler to manage WebSocket events, broadcast messages,
  * and maintain client information in a thread-safe manner.
  *
+ * Every client has its own bounded outbound queue. Broadcasts only append to the queues (the client map
+ * lock is held just to collect them) and each queue is drained one message at a time: the next message
+ * is sent when THttpWSHandler reports the previous one as completed (CompleteWSSend()), from the sending
+ * thread of the client, so a slow client does not stall the others or the heartbeat. A queued state message
+ * ("heartbeat", "clients" and "ngnt" with the same payload keys) is replaced by a newer one with the
+ * same key. Configuration (environment):
+ * - NDMSPC_WS_QUEUE_SIZE: maximum number of queued messages per client (default 64)
+ * - NDMSPC_WS_QUEUE_BYTES: maximum size of queued messages per client (default 256 MB)
+ * - NDMSPC_WS_SLOW_CLIENT: "drop" (default) drops the oldest queued messages of a full queue (state
+ *   messages last), "disconnect" closes the client on the next heartbeat
+ *
  * @author Martin Vala <mvala@cern.ch>
  */
 class NWsHandler : public THttpWSHandler {
@@ -54,16 +69,47 @@ class NWsHandler : public THttpWSHandler {
   Bool_t ProcessWS(THttpCallArg * arg) override;
 
   /**
-   * @brief Broadcasts a message to all connected clients (unsafe, not thread-safe).
+   * @brief Broadcasts a message to all connected clients (thread-safe).
    * @param message Message string to broadcast.
+   * @param key Coalescing key, queued message with the same key is replaced (empty: never replaced).
    */
-  void BroadcastUnsafe(const std::string & message);
+  void Broadcast(const std::string & message, const std::string & key = "");
+  /// Broadcasts a C string message (not ambiguous with json overload)
+  void Broadcast(const char * message, const std::string & key = "") { Broadcast(std::string(message), key); }
 
   /**
-   * @brief Broadcasts a message to all connected clients (thread-safe).
-   * @param message Message string to broadcast.
+   * @brief Broadcasts a message with raw JSON injections to all connected clients (thread-safe).
+   *
+   * Clients which sent {"event":"accept","payload":{"format":"binary","compression":"zstd"}} get the message
+   * as binary frame (NBinaryPayload), other clients as JSON text. Every format is built once, after the
+   * client map lock is released.
+   *
+   * @param message Message to broadcast.
+   * @param injections Raw JSON strings and their paths in message (see NUtils::AddRawJsonInjection()).
+   * @param exclude Client which does not get the message (0: none).
+   */
+  void Broadcast(const json & message, const NUtils::RawJsonInjections & injections = {}, ULong_t exclude = 0);
+
+  /**
+   * @brief Sends a message to one client (thread-safe), in the format the client asked for.
+   * @param wsId Client ID.
+   * @param message Message to send.
+   * @param injections Raw JSON strings and their paths in message (see NUtils::AddRawJsonInjection()).
+   */
+  void SendTo(ULong_t wsId, const json & message, const NUtils::RawJsonInjections & injections = {});
+
+  /**
+   * @brief Coalescing key of message.
+   * @param message Message.
+   * @return Event for "heartbeat" and "clients", event and payload keys for "ngnt", empty otherwise.
    */
-  void Broadcast(const std::string & message);
+  static std::string GetCoalesceKey(const json & message);
+
+  /**
+   * @brief Allow sending from separate thread of every client.
+   * @return Always true.
+   */
+  Bool_t AllowMTSend() const override { return kTRUE; }
 
   /**
    * @brief Handles timer events for the handler.
@@ -73,6 +119,45 @@ class NWsHandler : public THttpWSHandler {
   Bool_t HandleTimer(TTimer * timer) override;
 
   protected:
+  /**
+   * @brief Sends next queued message of client when previous send operation is completed.
+   * @param wsId Client ID.
+   */
+  void CompleteWSSend(UInt_t wsId) override;
+
+  /// Client queue and format for broadcast
+  struct Target {
+    ULong_t                      wsId;        ///< Client ID
+    std::shared_ptr<NWsOutQueue> queue;       ///< Outbound queue
+    bool                         binary;      ///< Client accepts binary frames
+    int                          compression; ///< Compression of binary frames
+  };
+
+  /// Targets of all clients (client map lock must be held)
+  std::vector<Target> GetTargetsUnsafe(ULong_t exclude = 0);
+  /// Outbound queue of client (nullptr if client is gone)
+  std::shared_ptr<NWsOutQueue> GetQueue(ULong_t wsId);
+  /// Sends message to targets
+  void Send(const std::vector<Target> & targets, const std::string & message, const std::string & key = "");
+  /// Sends message to targets, every format is built once
+  void Send(const std::vector<Target> & targets, const json & message, const NUtils::RawJsonInjections & injections);
+  /// Appends message to queue of client and starts sending
+  void Enqueue(ULong_t wsId, const std::shared_ptr<NWsOutQueue> & queue, std::shared_ptr<const std::string> data,
+               bool binary, const std::string & key);
+  /**
+   * @brief Passes one message to THttpWSHandler (overridden in tests).
+   * @param wsId Client ID.
+   * @param data JSON text or binary frame.
+   * @param binary Send as binary.
+   * @return 0 if sent (CompleteWSSend() was already called), 1 if sending thread calls CompleteWSSend() later,
+   * negative on failure.
+   */
+  virtual Int_t SendFrame(ULong_t wsId, const std::string & data, bool binary);
+  /// Sends queued messages of client until a send operation is postponed to sending thread
+  void Drain(ULong_t wsId, const std::shared_ptr<NWsOutQueue> & queue);
+  /// Closes clients marked by disconnect policy
+  void CloseSlowClients();
+
   std::map<ULong_t, NWsClientInfo> fClients;    ///< Map of active clients by ID
   std::mutex                       fMutex;      ///< Mutex for thread-safe client map access
   Int_t                            fServCnt{0}; ///< Service counter
@@ -85,6 +170,12 @@ class NWsHandler : public THttpWSHandler {
   json                             fPrevFileStats; ///< previous TFile IO counters snapshot
   std::chrono::steady_clock::time_point fPrevFileTs; ///< timestamp of previous file snapshot
   bool                             fHavePrevFile{false}; ///< whether previous file snapshot exists
+  std::mutex                       fStatsMutex; ///< Mutex for stats snapshots (heartbeat)
+  std::map<ULong_t, std::shared_ptr<NWsOutQueue>> fQueues; ///<! Outbound queues by client ID
+  std::mutex                       fQueuesMutex; ///< Mutex for queue map (never held while sending)
+  size_t                           fQueueSize{64}; ///< Maximum number of queued messages per client
+  size_t                           fQueueBytes{256 * 1024 * 1024}; ///< Maximum size of queued messages per client
+  bool                             fDisconnectSlow{false}; ///< Disconnect (instead of drop) when queue is full
 
   /// \cond CLASSIMP
   ClassDefOverride(NWsHandler, 1);
@@ -1,7 +1,15 @@
 
 #include <gtest/gtest.h>
 #include <fstream>
+#include <cmath>
 #include <cstdio>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include "NDimensionalExecutor.h"
+#include "NDimensionalIpcRunner.h"
+#include "NTaskCostModel.h"
+#include "NThreadData.h"
 #include "01_executor/NExecutor1D.C"
 #include "01_executor/NExecutor2D.C"
 #include "01_executor/NExecutor5D.C"
@@ -60,6 +68,169 @@ TEST(NExecutor5DTest, CreatesOutputFile)
   std::remove(testFile.c_str());
 }
 
+TEST(NExecutorWorkStealingTest, VisitsEveryPointOnce)
+{
+  Ndmspc::NDimensionalExecutor executor({0, 1, -2}, {6, 4, 3});
+  executor.SetParallelScheduler(Ndmspc::ParallelScheduler::kWorkStealing, 3);
+
+  std::vector<Ndmspc::NThreadData> threadData(4);
+  for (size_t i = 0; i < threadData.size(); ++i) threadData[i].SetAssignedIndex(i);
+
+  std::mutex                      visitedMutex;
+  std::multiset<std::vector<int>> visited;
+  executor.ExecuteParallel<Ndmspc::NThreadData>(
+      [&](const std::vector<int> & coords, Ndmspc::NThreadData & obj) {
+        obj.SetItemCount(obj.GetItemCount() + 1);
+        std::lock_guard<std::mutex> lock(visitedMutex);
+        visited.insert(coords);
+      },
+      threadData);
+
+  std::multiset<std::vector<int>> expected;
+  executor.Execute([&](const std::vector<int> & coords) { expected.insert(coords); });
+  EXPECT_EQ(visited, expected);
+  EXPECT_EQ(expected.size(), executor.GetTotalPoints());
+
+  long long items = 0;
+  for (const auto & data : threadData) items += data.GetItemCount();
+  EXPECT_EQ(items, static_cast<long long>(executor.GetTotalPoints()));
+}
+
+TEST(NExecutorWorkStealingTest, PropagatesWorkerException)
+{
+  Ndmspc::NDimensionalExecutor executor({0, 0}, {20, 20});
+  executor.SetParallelScheduler(Ndmspc::ParallelScheduler::kWorkStealing);
+
+  std::vector<Ndmspc::NThreadData> threadData(4);
+  for (size_t i = 0; i < threadData.size(); ++i) threadData[i].SetAssignedIndex(i);
+
+  EXPECT_THROW(executor.ExecuteParallel<Ndmspc::NThreadData>(
+                   [](const std::vector<int> & coords, Ndmspc::NThreadData &) {
+                     if (coords[0] == 7 && coords[1] == 3) throw std::runtime_error("bin failed");
+                   },
+                   threadData),
+               std::runtime_error);
+}
+
+TEST(NExecutorCostSchedulingTest, LptOrderPutsExpensiveTasksFirst)
+{
+  // Unknown costs (-1, NaN) are treated as the mean of the known ones (5.2).
+  const std::vector<double> costs = {1.0, 10.0, -1.0, 5.0, 0.0, std::nan(""), 10.0};
+  const std::vector<size_t> order = Ndmspc::NDimensionalExecutor::BuildLptOrder(costs);
+
+  const std::vector<size_t> expected = {1, 6, 2, 5, 3, 0, 4};
+  EXPECT_EQ(order, expected);
+  EXPECT_TRUE(Ndmspc::NDimensionalExecutor::BuildLptOrder({}).empty());
+
+  size_t nKnown = 0;
+  EXPECT_DOUBLE_EQ(Ndmspc::NDimensionalExecutor::GetMeanKnownCost(costs, &nKnown), 5.2);
+  EXPECT_EQ(nKnown, 5u);
+  // An explicit zero fallback ranks the unknown tasks with the free ones
+  const std::vector<size_t> unknownLast = {1, 6, 3, 0, 2, 4, 5};
+  EXPECT_EQ(Ndmspc::NDimensionalExecutor::BuildLptOrder(costs, 0.0), unknownLast);
+}
+
+TEST(NExecutorCostSchedulingTest, CostModelEstimatesFromObservedCoordinates)
+{
+  Ndmspc::NTaskCostModel model({1, 1}, {3, 3});
+  EXPECT_DOUBLE_EQ(model.Estimate({1, 1}), -1.0);
+
+  model.Add({1, 1}, 2.0);
+  model.Add({1, 2}, 4.0);
+  model.Add({3, 3}, 10.0);
+  model.Add({2, 2}, -1.0); // ignored
+  EXPECT_EQ(model.GetNObserved(), 3u);
+  // Mean of x=1 (3.0) and y=3 (10.0)
+  EXPECT_DOUBLE_EQ(model.Estimate({1, 3}), 6.5);
+  // Only y=2 observed (4.0)
+  EXPECT_DOUBLE_EQ(model.Estimate({2, 2}), 4.0);
+  // x=2 not observed and y=7 out of range: mean of all observations
+  EXPECT_DOUBLE_EQ(model.Estimate({2, 7}), 16.0 / 3);
+}
+
+TEST(NExecutorCostSchedulingTest, ReorderLearnsFromBinCoordinates)
+{
+  using Ndmspc::NDimensionalExecutor;
+  // Six tasks over a list of bins (as NGnTree::Process dispatches definition ids), x alternates 1,2
+  const std::vector<std::vector<int>> bins = {{1, 1}, {2, 1}, {1, 2}, {2, 2}, {1, 3}, {2, 3}};
+  Ndmspc::NTaskCostModel              model({1, 1}, {2, 3});
+  model.Add(bins[0], 1.0);
+  model.Add(bins[1], 9.0);
+
+  std::vector<size_t> order = {0, 1, 2, 3, 4, 5};
+  NDimensionalExecutor::ReorderByEstimatedCost(order, 2, {}, bins, model);
+  EXPECT_EQ(order, (std::vector<size_t>{0, 1, 3, 5, 2, 4}));
+
+  // A known cost wins over the estimate
+  order = {0, 1, 2, 3, 4, 5};
+  NDimensionalExecutor::ReorderByEstimatedCost(order, 2, {-1, -1, -1, -1, 20.0, -1}, bins, model);
+  EXPECT_EQ(order, (std::vector<size_t>{0, 1, 4, 3, 5, 2}));
+
+  // Linear task indices alone carry nothing about tasks not run yet
+  const std::vector<std::vector<int>> linear = {{0}, {1}, {2}, {3}, {4}, {5}};
+  Ndmspc::NTaskCostModel              linearModel({0}, {5});
+  linearModel.Add(linear[0], 1.0);
+  linearModel.Add(linear[1], 9.0);
+  order = {0, 1, 2, 3, 4, 5};
+  NDimensionalExecutor::ReorderByEstimatedCost(order, 2, {}, linear, linearModel);
+  EXPECT_EQ(order, (std::vector<size_t>{0, 1, 2, 3, 4, 5}));
+}
+
+TEST(NExecutorCostSchedulingTest, BatchScalesWithThroughput)
+{
+  using Ndmspc::NDimensionalExecutor;
+  // No measurement yet: keep the base batch size.
+  EXPECT_EQ(NDimensionalExecutor::ScaleBatchByThroughput(4, 0.0, 2.0, 16), 4u);
+  EXPECT_EQ(NDimensionalExecutor::ScaleBatchByThroughput(4, 2.0, 0.0, 16), 4u);
+  // Twice as fast as average doubles the batch, half as fast halves it.
+  EXPECT_EQ(NDimensionalExecutor::ScaleBatchByThroughput(4, 4.0, 2.0, 16), 8u);
+  EXPECT_EQ(NDimensionalExecutor::ScaleBatchByThroughput(4, 1.0, 2.0, 16), 2u);
+  // Results stay within [1, maxBatch].
+  EXPECT_EQ(NDimensionalExecutor::ScaleBatchByThroughput(4, 100.0, 1.0, 16), 16u);
+  EXPECT_EQ(NDimensionalExecutor::ScaleBatchByThroughput(4, 0.01, 100.0, 16), 1u);
+}
+
+TEST(NIpcFramingTest, TaskBatchRoundTripsInBothVersions)
+{
+  using Ndmspc::NDimensionalIpcRunner;
+  std::vector<std::pair<size_t, std::vector<int>>> tasks;
+  for (size_t id = 1000; id < 2000; ++id) tasks.emplace_back(id, std::vector<int>{3, -7, static_cast<int>(id)});
+  tasks.emplace_back(5, std::vector<int>{1, 2, 3});
+  tasks.emplace_back(6, std::vector<int>{1, 3, 0});
+
+  for (int protocol = 1; protocol <= NDimensionalIpcRunner::kProtocolVersion; ++protocol) {
+    std::vector<std::pair<size_t, std::vector<int>>> decoded;
+    ASSERT_TRUE(NDimensionalIpcRunner::DecodeTaskBatch(NDimensionalIpcRunner::EncodeTaskBatch(tasks, protocol),
+                                                       protocol, decoded));
+    EXPECT_EQ(decoded, tasks);
+
+    const std::vector<size_t> ids = {7, 8, 9, 42, 3};
+    std::vector<size_t>       decodedIds;
+    ASSERT_TRUE(
+        NDimensionalIpcRunner::DecodeTaskIds(NDimensionalIpcRunner::EncodeTaskIds(ids, protocol), protocol, decodedIds));
+    EXPECT_EQ(decodedIds, ids);
+
+    size_t taskId = 0;
+    EXPECT_TRUE(NDimensionalIpcRunner::DecodeTaskId(NDimensionalIpcRunner::EncodeTaskId(1ULL << 40, protocol),
+                                                    protocol, taskId));
+    EXPECT_EQ(taskId, 1ULL << 40);
+  }
+
+  // The run of 1000 consecutive ids collapses into a single range record.
+  EXPECT_LT(NDimensionalIpcRunner::EncodeTaskBatch(tasks, 2).size(), 100u);
+  std::vector<std::pair<size_t, std::vector<int>>> decoded;
+  EXPECT_FALSE(NDimensionalIpcRunner::DecodeTaskBatch("1:2,3", 2, decoded));
+}
+
+TEST(NIpcFramingTest, MissingVersionFallsBackToText)
+{
+  using Ndmspc::NDimensionalIpcRunner;
+  EXPECT_EQ(NDimensionalIpcRunner::ParseProtocolVersion({"READY"}, 1), 1);
+  EXPECT_EQ(NDimensionalIpcRunner::ParseProtocolVersion({"READY", "2"}, 1), 2);
+  EXPECT_EQ(NDimensionalIpcRunner::ParseProtocolVersion({"READY", "99"}, 1), NDimensionalIpcRunner::kProtocolVersion);
+  EXPECT_EQ(NDimensionalIpcRunner::EncodeTaskId(12, 1), "12");
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
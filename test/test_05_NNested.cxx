@@ -1,9 +1,12 @@
 #include <gtest/gtest.h>
 #include <cstdio>
 #include <fstream>
+#include <TH1.h>
+#include <TSystem.h>
 #include "05_nested/NNested01Gaus.C"
 #include "NGnNavigator.h"
 #include "NGnTree.h"
+#include "NMetrics.h"
 
 class NNested01GausTest : public ::testing::Test {
   protected:
@@ -72,6 +75,92 @@ TEST_F(NNested01GausTest, ReshapeMultipleLevels)
   ngnt->Close();
 }
 
+TEST_F(NNested01GausTest, LazyReshapeMatchesFullBuild)
+{
+  Ndmspc::NGnTree * ngnt = Ndmspc::NGnTree::Open(testFile);
+  ASSERT_TRUE(ngnt);
+  ASSERT_TRUE(!ngnt->IsZombie());
+
+  gSystem->Setenv("NDMSPC_NAVIGATOR_LAZY", "0");
+  Ndmspc::NGnNavigator * full = ngnt->Reshape("", {{0}, {1, 2}});
+  gSystem->Unsetenv("NDMSPC_NAVIGATOR_LAZY");
+  gSystem->Setenv("NDMSPC_NAVIGATOR_CACHE_SIZE", "3");
+  Ndmspc::NGnNavigator * lazy = ngnt->Reshape("", {{0}, {1, 2}});
+  gSystem->Unsetenv("NDMSPC_NAVIGATOR_CACHE_SIZE");
+  ASSERT_TRUE(full);
+  ASSERT_TRUE(lazy);
+
+  // Only the root is built by Reshape
+  EXPECT_EQ(lazy->GetNMaterialized(), 0u);
+
+  // Export of built levels only does not project children
+  json jBuilt;
+  lazy->ExportToJson(jBuilt, lazy, {}, true);
+  EXPECT_EQ(lazy->GetNMaterialized(), 0u);
+  ASSERT_TRUE(jBuilt["children"]["content"].is_array());
+  for (const auto & c : jBuilt["children"]["content"]) EXPECT_TRUE(c.is_null());
+
+  Ndmspc::NGnNavigator * child = nullptr;
+  for (size_t i = 0; i < lazy->GetChildren().size() && !child; i++) child = lazy->GetChild(i);
+  ASSERT_TRUE(child);
+  EXPECT_TRUE(child->IsMaterialized());
+  EXPECT_NE(child->GetProjection(), nullptr);
+  EXPECT_EQ(lazy->GetNMaterialized(), 1u);
+  lazy->Prefetch(10);
+  EXPECT_LE(lazy->GetNMaterialized(), 3u);
+
+  json jFull, jLazy;
+  full->ExportToJson(jFull, full, {});
+  lazy->ExportToJson(jLazy, lazy, {});
+  EXPECT_TRUE(jFull == jLazy);
+  EXPECT_LE(lazy->GetNMaterialized(), 3u);
+
+  delete full;
+  delete lazy;
+  ngnt->Close();
+}
+
+TEST_F(NNested01GausTest, FastCloneImportMatchesImport)
+{
+  const std::string importDir = "test_NNested01Gaus_import";
+  for (const std::string dir : {"a", "b"}) {
+    gSystem->mkdir((importDir + "/" + dir).c_str(), kTRUE);
+    ASSERT_EQ(gSystem->CopyFile(testFile.c_str(), (importDir + "/" + dir + "/" + testFile).c_str(), kTRUE), 0);
+  }
+
+  Ndmspc::NMetrics::Reset();
+  Ndmspc::NGnTree * fast = Ndmspc::NGnTree::Import(importDir, testFile, {"dir"}, "test_import_fast.root", true, true);
+  EXPECT_EQ(Ndmspc::NMetrics::Get(Ndmspc::NMetrics::kTreeEntriesCloned), 300) << "Fast clone path was not used";
+  Ndmspc::NGnTree * slow = Ndmspc::NGnTree::Import(importDir, testFile, {"dir"}, "test_import_slow.root", true, false);
+  ASSERT_TRUE(fast);
+  ASSERT_TRUE(slow);
+  ASSERT_EQ(fast->GetStorageTree()->GetTree()->GetEntries(), 300);
+  ASSERT_EQ(slow->GetStorageTree()->GetTree()->GetEntries(), 300);
+  EXPECT_EQ(fast->GetBinning()->GetDefinition("default")->GetIds().size(),
+            slow->GetBinning()->GetDefinition("default")->GetIds().size());
+
+  const auto branches = fast->GetStorageTree()->GetBranchesMap();
+  ASSERT_EQ(branches.size(), slow->GetStorageTree()->GetBranchesMap().size());
+  for (Long64_t entry = 0; entry < 300; entry += 7) {
+    fast->GetEntry(entry);
+    slow->GetEntry(entry);
+    for (const auto & kv : branches) {
+      TH1 * hFast = dynamic_cast<TH1 *>(fast->GetStorageTree()->GetBranchObject(kv.first));
+      TH1 * hSlow = dynamic_cast<TH1 *>(slow->GetStorageTree()->GetBranchObject(kv.first));
+      if (!hFast && !hSlow) continue;
+      ASSERT_TRUE(hFast && hSlow) << kv.first << " entry " << entry;
+      EXPECT_DOUBLE_EQ(hFast->GetEntries(), hSlow->GetEntries()) << kv.first << " entry " << entry;
+      EXPECT_DOUBLE_EQ(hFast->Integral(), hSlow->Integral()) << kv.first << " entry " << entry;
+    }
+  }
+
+  fast->Close();
+  slow->Close();
+  gSystem->Exec(("rm -rf " + importDir).c_str());
+  std::remove("test_import_fast.root");
+  std::remove("test_import_slow.root");
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
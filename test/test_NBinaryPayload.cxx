@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <TBufferJSON.h>
+#include <TH1D.h>
+#include <TH2F.h>
+#include "NBinaryPayload.h"
+
+TEST(NBinaryPayloadTest, RoundTrip)
+{
+  const double edges[] = {0, 0.5, 1.5, 4};
+  TH1D         h1("h1", "h1", 3, edges);
+  TH2F         h2("h2", "h2", 4, 0, 4, 3, 0, 3);
+  h1.SetDirectory(nullptr);
+  h2.SetDirectory(nullptr);
+  h1.Sumw2();
+  for (int i = 0; i < 100; ++i) {
+    h1.Fill(i % 5 * 0.9);
+    h2.Fill(i % 4, i % 3);
+  }
+
+  json msg;
+  msg["event"]                 = "ngnt";
+  msg["payload"]["map"]["obj"] = {{"_typename", "TList"}, {"arr", json::array()}};
+  msg["payload"]["map"]["obj"]["arr"].push_back(json::parse(TBufferJSON::ConvertToJSON(&h2).Data()));
+  Ndmspc::NUtils::RawJsonInjections injections = {{{"payload", "content"}, TBufferJSON::ConvertToJSON(&h1, 3).Data()}};
+  json expected                  = msg;
+  expected["payload"]["content"] = json::parse(injections[0].second);
+
+  for (auto compression : {Ndmspc::NBinaryPayload::kNone, Ndmspc::NBinaryPayload::kZlib}) {
+    std::string frame = Ndmspc::NBinaryPayload::Pack(msg, injections, compression);
+    ASSERT_TRUE(Ndmspc::NBinaryPayload::IsFrame(frame));
+    EXPECT_EQ(frame.find("fArray"), std::string::npos) << "Histogram arrays must be moved to blobs";
+    json unpacked;
+    ASSERT_TRUE(Ndmspc::NBinaryPayload::Unpack(frame, unpacked));
+    EXPECT_TRUE(unpacked == expected) << Ndmspc::NBinaryPayload::GetCompressionName(compression);
+  }
+}
+
+TEST(NBinaryPayloadTest, RejectsMalformedFrames)
+{
+  TH1D h("h", "h", 4, 0, 4);
+  h.SetDirectory(nullptr);
+  h.Fill(1);
+  json msg;
+  msg["payload"]["content"] = json::parse(TBufferJSON::ConvertToJSON(&h).Data());
+  std::string frame         = Ndmspc::NBinaryPayload::Pack(msg);
+  uint32_t    jsonSize;
+  std::memcpy(&jsonSize, frame.data() + 4, sizeof(jsonSize));
+  const std::string blobs = frame.substr(8 + jsonSize);
+
+  json unpacked;
+  EXPECT_FALSE(Ndmspc::NBinaryPayload::Unpack("NDMB", unpacked));
+  EXPECT_FALSE(Ndmspc::NBinaryPayload::Unpack(frame.substr(0, frame.size() - 8), unpacked));
+
+  // Location of blob which is not [offset, size]
+  for (const char * location : {"\"x\"", "[-1,8]", "[\"0\",8]", "[0]"}) {
+    std::string js = "{\"h\":{\"_typename\":\"TH1D\",\"_blob\":" + std::string(location) + "}}";
+    js.resize((js.size() + 7) / 8 * 8, ' ');
+    std::string bad("NDMB", 4);
+    uint32_t    size = js.size();
+    bad.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    bad += js;
+    bad += blobs;
+    EXPECT_FALSE(Ndmspc::NBinaryPayload::Unpack(bad, unpacked)) << location;
+  }
+}
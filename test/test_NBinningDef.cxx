@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <TAxis.h>
+#include <TBufferFile.h>
+#include <TObjArray.h>
+#include "NBinning.h"
+#include "NBinningDef.h"
+
+TEST(NBinningDefTest, DenseContentMatchesSparse)
+{
+  TObjArray * axes = new TObjArray();
+  TAxis *     x    = new TAxis(8, 0., 8.);
+  x->SetNameTitle("x", "x");
+  axes->Add(x);
+  TAxis * y = new TAxis(6, 0., 6.);
+  y->SetNameTitle("y", "y");
+  axes->Add(y);
+  Ndmspc::NBinning binning(axes);
+
+  std::map<std::string, std::vector<std::vector<int>>> b0;
+  b0["x"] = {{2}};
+  b0["y"] = {{3}};
+  binning.AddBinningDefinition("b0", b0);
+
+  Ndmspc::NBinningDef * def = binning.GetDefinition("b0");
+  ASSERT_NE(def, nullptr);
+  EXPECT_TRUE(def->IsDense()); // all 4x2 bins are filled
+  // Linear bins of the content follow the ids, as with THnSparse filled directly
+  for (size_t k = 0; k < def->GetIds().size(); ++k) {
+    EXPECT_EQ((Long64_t)def->GetContent()->GetBinContent(k), def->GetIds()[k]);
+  }
+  def->RefreshContentFromIds();
+  const std::vector<Long64_t> ids = def->GetIds();
+  ASSERT_EQ(ids.size(), 8u);
+
+  Int_t          coords[2] = {3, 2};
+  const Long64_t value     = def->GetContentAt(coords);
+  EXPECT_GT(value, 0);
+  EXPECT_EQ(def->GetContent()->GetNbins(), 8);
+
+  EXPECT_TRUE(def->SetDense(false));
+  EXPECT_FALSE(def->IsDense());
+  EXPECT_EQ(def->GetContentAt(coords), value);
+  def->RefreshIdsFromContent();
+  EXPECT_EQ(def->GetIds(), ids);
+}
+
+TEST(NBinningDefTest, DenseContentIsDroppedAfterWriting)
+{
+  TObjArray * axes = new TObjArray();
+  TAxis *     x    = new TAxis(8, 0., 8.);
+  x->SetNameTitle("x", "x");
+  axes->Add(x);
+  TAxis * y = new TAxis(6, 0., 6.);
+  y->SetNameTitle("y", "y");
+  axes->Add(y);
+  Ndmspc::NBinning binning(axes);
+
+  std::map<std::string, std::vector<std::vector<int>>> b0;
+  b0["x"] = {{2}};
+  b0["y"] = {{3}};
+  binning.AddBinningDefinition("b0", b0);
+  Ndmspc::NBinningDef * def = binning.GetDefinition("b0");
+  ASSERT_NE(def, nullptr);
+  ASSERT_TRUE(def->IsDense());
+
+  // Axis accessors do not rebuild the THnSparse bins
+  EXPECT_EQ(def->GetNdimensions(), 2);
+  EXPECT_EQ(def->GetAxis(0)->GetNbins(), 4);
+  EXPECT_EQ(def->GetAxis(1)->GetNbins(), 2);
+  EXPECT_EQ(def->GetContentTemplate()->GetNbins(), 0);
+
+  TBufferFile buf(TBuffer::kWrite);
+  buf.WriteObject(def);
+  EXPECT_EQ(def->GetContentTemplate()->GetNbins(), 0);
+  EXPECT_EQ(def->GetContent()->GetNbins(), 8);
+}
+
+TEST(NBinningDefTest, HasIdFollowsIdChanges)
+{
+  TObjArray * axes = new TObjArray();
+  TAxis *     x    = new TAxis(10, 0., 10.);
+  x->SetNameTitle("x", "x");
+  axes->Add(x);
+  Ndmspc::NBinning binning(axes);
+
+  std::map<std::string, std::vector<std::vector<int>>> b0;
+  b0["x"] = {{5}};
+  binning.AddBinningDefinition("b0", b0);
+  Ndmspc::NBinningDef * def = binning.GetDefinition("b0");
+  ASSERT_NE(def, nullptr);
+  std::vector<Long64_t> ids = def->GetIds();
+  ASSERT_EQ(ids.size(), 2u);
+  std::sort(ids.begin(), ids.end());
+  EXPECT_TRUE(def->HasId(ids[0]));
+  EXPECT_FALSE(def->HasId(ids.back() + 1));
+
+  // Every mutation drops the sorted copy built by the previous HasId()
+  def->AddId(ids.back() + 1);
+  EXPECT_TRUE(def->HasId(ids.back() + 1));
+  def->SetIds({ids[1]});
+  EXPECT_FALSE(def->HasId(ids[0]));
+  EXPECT_TRUE(def->HasId(ids[1]));
+  def->ClearIds();
+  EXPECT_FALSE(def->HasId(ids[1]));
+}
+
+TEST(NBinningDefTest, ParallelCoordSortMatchesSequential)
+{
+  // Distinct 3D coordinates in a scrambled order
+  const Int_t         nDims = 3;
+  const size_t        n     = 10007;
+  std::vector<Int_t>  coords(n * nDims);
+  std::vector<size_t> perm(n);
+  for (size_t i = 0; i < n; ++i) perm[i] = (i * 7919) % n;
+  for (size_t i = 0; i < n; ++i) {
+    coords[i * nDims]     = static_cast<Int_t>(perm[i] / 400);
+    coords[i * nDims + 1] = static_cast<Int_t>(perm[i] / 20 % 20);
+    coords[i * nDims + 2] = static_cast<Int_t>(perm[i] % 20);
+  }
+
+  const std::vector<size_t> sequential = Ndmspc::NBinningDef::SortByCoords(coords, nDims, n, 1);
+  ASSERT_EQ(sequential.size(), n);
+  for (size_t i = 1; i < n; ++i) {
+    const Int_t * a = &coords[sequential[i - 1] * nDims];
+    const Int_t * b = &coords[sequential[i] * nDims];
+    ASSERT_TRUE(std::lexicographical_compare(a, a + nDims, b, b + nDims));
+  }
+  // Odd chunk counts leave an unpaired chunk in the merge passes
+  for (size_t nChunks : {2, 3, 5, 16}) {
+    EXPECT_EQ(Ndmspc::NBinningDef::SortByCoords(coords, nDims, n, nChunks), sequential) << nChunks << " chunks";
+  }
+  EXPECT_EQ(Ndmspc::NBinningDef::SortByCoords(coords, nDims, 2, 16).size(), 2u);
+  EXPECT_TRUE(Ndmspc::NBinningDef::SortByCoords(coords, nDims, 0, 4).empty());
+}
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <TFile.h>
+#include <THnSparse.h>
+#include "NBinning.h"
+#include "NBinningPoint.h"
+
+TEST(NBinningPointTest, AxisHandles)
+{
+  std::unique_ptr<TFile> f(TFile::Open("cernstaff.root"));
+  ASSERT_TRUE(f && !f->IsZombie());
+  std::unique_ptr<THnSparse> hSparse(f->Get<THnSparse>("hsparse"));
+  ASSERT_NE(hSparse, nullptr);
+  Ndmspc::NBinning binning(hSparse->GetListOfAxes());
+  Ndmspc::NBinningPoint point(&binning);
+
+  const std::string name   = binning.GetAxes()[3]->GetName();
+  const Int_t       handle = point.GetAxisHandle(name);
+  EXPECT_EQ(handle, 3);
+  EXPECT_EQ(point.GetAxisHandle("no-such-axis"), -1);
+
+  point.GetMins()[handle]    = 1.0;
+  point.GetMaxs()[handle]    = 3.0;
+  point.GetCenters()[handle] = 2.0;
+  EXPECT_DOUBLE_EQ(point.GetBinMin(handle), point.GetBinMin(name));
+  EXPECT_DOUBLE_EQ(point.GetBinMax(handle), 3.0);
+  EXPECT_DOUBLE_EQ(point.GetBinCenter(name), 2.0);
+  EXPECT_DOUBLE_EQ(point.GetBinCenter(-1), -1);
+  EXPECT_EQ(point.GetBin(handle), point.GetBin(name));
+}
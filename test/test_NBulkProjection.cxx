@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <TAxis.h>
+#include <TH1D.h>
+#include <THnSparse.h>
+#include <TObjArray.h>
+#include "NBinning.h"
+#include "NBinningDef.h"
+#include "NBinningPoint.h"
+#include "NBulkProjection.h"
+#include "NUtils.h"
+
+TEST(NBulkProjectionTest, MatchesPerCellProjection)
+{
+  TH1::AddDirectory(kFALSE);
+  Int_t      bins[3] = {20, 8, 6};
+  Double_t   min[3]  = {0, 0, 0};
+  Double_t   max[3]  = {2, 8, 6};
+  THnSparseD hns("hns", "hns", 3, bins, min, max);
+  hns.Sumw2();
+  for (int i = 0; i < 5000; ++i) {
+    Double_t x[3] = {0.0004 * i, 0.37 * (i % 23) - 0.5, 0.29 * (i % 29) - 0.5}; // includes under/overflow
+    hns.Fill(x, 1 + i % 3);
+  }
+
+  TObjArray * axes = new TObjArray();
+  axes->Add(hns.GetAxis(1)->Clone("x"));
+  axes->Add(hns.GetAxis(2)->Clone("y"));
+  Ndmspc::NBinning binning(axes);
+  std::map<std::string, std::vector<std::vector<int>>> b0;
+  b0["x"] = {{2}};
+  b0["y"] = {{3}};
+  binning.AddBinningDefinition("b0", b0);
+  const std::vector<Long64_t> ids = binning.GetDefinition("b0")->GetIds();
+  ASSERT_EQ(ids.size(), 8u);
+
+  Ndmspc::NBulkProjection bulk;
+  ASSERT_TRUE(bulk.Add("h", &hns, {1, 2}, 0));
+  EXPECT_FALSE(bulk.Add("h", &hns, {1, 2}, 0));
+  ASSERT_TRUE(bulk.Fill(&binning, ids, 2));
+
+  Ndmspc::NBinningPoint point(&binning);
+  for (const Long64_t id : ids) {
+    ASSERT_TRUE(point.SetPointContentFromLinearIndex(id));
+    std::map<int, std::vector<int>> ranges;
+    for (const auto & [axis, range] : point.GetBaseAxisRanges()) ranges[axis + 1] = range;
+    Ndmspc::NUtils::SetAxisRanges(&hns, ranges);
+    TH1D * expected = hns.Projection(0);
+    TH1 *  h        = bulk.Take("h", id);
+    ASSERT_NE(h, nullptr) << "id " << id;
+    EXPECT_EQ(bulk.Take("h", id), nullptr);
+    EXPECT_DOUBLE_EQ(h->GetEntries(), expected->GetEntries()) << "id " << id;
+    for (Int_t b = 0; b <= expected->GetNbinsX() + 1; ++b) {
+      EXPECT_DOUBLE_EQ(h->GetBinContent(b), expected->GetBinContent(b)) << "id " << id << " bin " << b;
+      EXPECT_DOUBLE_EQ(h->GetBinError(b), expected->GetBinError(b)) << "id " << id << " bin " << b;
+    }
+    delete expected;
+    delete h;
+  }
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include "NCheckpointJournal.h"
+
+TEST(NCheckpointJournalTest, ResumesCompleteRecordsOnly)
+{
+  const std::string journalFile = "test_NCheckpointJournal.ckpt";
+  std::remove(journalFile.c_str());
+  {
+    Ndmspc::NCheckpointJournal journal(journalFile);
+    ASSERT_FALSE(journal.Load());
+    ASSERT_TRUE(journal.Open(true));
+    const int w0 = journal.AddFile("/tmp/w0.root");
+    const int w1 = journal.AddFile("/tmp/w1.root");
+    ASSERT_TRUE(journal.AddIds(w0, {3, 1, 2, 7}));
+    ASSERT_TRUE(journal.AddIds(w1, {4}));
+  }
+  {
+    // Simulate a kill in the middle of a record
+    std::ofstream out(journalFile, std::ios::app);
+    out << "I 0 1";
+  }
+
+  Ndmspc::NCheckpointJournal journal(journalFile);
+  ASSERT_TRUE(journal.Load());
+  EXPECT_EQ(journal.GetDoneIds(), (std::set<Long64_t>{1, 2, 3, 4, 7}));
+  EXPECT_EQ(journal.GetFileIds().at("/tmp/w0.root"), (std::set<Long64_t>{1, 2, 3, 7}));
+  EXPECT_EQ(Ndmspc::NCheckpointJournal::FormatIds({7, 1, 3, 2}), "1-3,7");
+
+  // Rewrite keeps only files with ids and appends after them
+  ASSERT_TRUE(journal.Rewrite({{"/tmp/w1.root", {4}}, {"/tmp/empty.root", {}}}));
+  ASSERT_TRUE(journal.AddIds(journal.AddFile("/tmp/w2.root"), {10, 11}));
+  journal.Close();
+
+  Ndmspc::NCheckpointJournal reloaded(journalFile);
+  ASSERT_TRUE(reloaded.Load());
+  EXPECT_EQ(reloaded.GetFileIds().size(), 2u);
+  EXPECT_EQ(reloaded.GetDoneIds(), (std::set<Long64_t>{4, 10, 11}));
+  EXPECT_TRUE(reloaded.Remove());
+}
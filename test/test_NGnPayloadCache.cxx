@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "NGnPayloadCache.h"
+
+using namespace Ndmspc;
+
+/// Cache of 30 bytes holding three payloads of 10 bytes (key and payload)
+class NGnPayloadCacheTest : public ::testing::Test {
+  protected:
+  NGnPayloadCache cache{30};
+
+  void SetUp() override
+  {
+    cache.Put("a", "payload-a");
+    cache.Put("b", "payload-b");
+    cache.Put("c", "payload-c");
+  }
+};
+
+TEST_F(NGnPayloadCacheTest, EvictsLeastRecentlyUsed)
+{
+  ASSERT_EQ(cache.GetEntries(), 3u);
+  ASSERT_EQ(cache.GetBytes(), 30u);
+
+  std::string payload;
+  ASSERT_TRUE(cache.Get("a", payload));
+  EXPECT_EQ(payload, "payload-a");
+
+  cache.Put("d", "payload-d");
+  EXPECT_EQ(cache.GetEntries(), 3u);
+  EXPECT_EQ(cache.GetBytes(), 30u);
+  EXPECT_FALSE(cache.Get("b", payload)) << "b is least recently used";
+  EXPECT_TRUE(cache.Get("a", payload));
+  EXPECT_TRUE(cache.Get("c", payload));
+  EXPECT_TRUE(cache.Get("d", payload));
+
+  // Replacing a payload does not evict others
+  cache.Put("c", "payload-C");
+  ASSERT_TRUE(cache.Get("c", payload));
+  EXPECT_EQ(payload, "payload-C");
+  EXPECT_EQ(cache.GetEntries(), 3u);
+
+  cache.SetMaxBytes(20);
+  EXPECT_EQ(cache.GetEntries(), 2u);
+  EXPECT_FALSE(cache.Get("a", payload));
+  cache.SetMaxBytes(0);
+  EXPECT_EQ(cache.GetEntries(), 0u);
+  EXPECT_EQ(cache.GetBytes(), 0u);
+}
+
+TEST_F(NGnPayloadCacheTest, OverBudgetPayloadIsNotStored)
+{
+  const std::string big(40, 'x');
+  std::string       etag = cache.Put("big", big);
+  EXPECT_EQ(etag, NGnPayloadCache::ComputeETag(big)) << "ETag is returned even if payload is not cached";
+
+  std::string payload;
+  EXPECT_FALSE(cache.Get("big", payload));
+  EXPECT_EQ(cache.GetEntries(), 3u) << "Other payloads are kept";
+
+  // Over budget payload replacing a cached one removes the old one
+  cache.Put("a", big);
+  EXPECT_FALSE(cache.Get("a", payload));
+  EXPECT_EQ(cache.GetEntries(), 2u);
+  EXPECT_EQ(cache.GetBytes(), 20u);
+}
+
+TEST_F(NGnPayloadCacheTest, InvalidatesPrefix)
+{
+  NGnPayloadCache files(1000);
+  files.Put("f1.root/map", "1");
+  files.Put("f1.root/spectra", "2");
+  files.Put("f10.root/map", "3");
+  files.Put("f2.root/map", "4");
+
+  EXPECT_EQ(files.Invalidate("f1.root/"), 2u);
+  std::string payload;
+  EXPECT_FALSE(files.Get("f1.root/map", payload));
+  EXPECT_TRUE(files.Get("f10.root/map", payload));
+  EXPECT_TRUE(files.Get("f2.root/map", payload));
+  EXPECT_EQ(files.Invalidate("missing/"), 0u);
+  EXPECT_EQ(files.Invalidate(), 2u);
+  EXPECT_EQ(files.GetEntries(), 0u);
+  EXPECT_EQ(files.GetBytes(), 0u);
+}
+
+TEST_F(NGnPayloadCacheTest, CountsHitsAndMissesAndReturnsETag)
+{
+  std::string payload, etag;
+  EXPECT_TRUE(cache.Get("a", payload, &etag));
+  EXPECT_EQ(etag, NGnPayloadCache::ComputeETag("payload-a"));
+  EXPECT_EQ(etag.front(), '"');
+  EXPECT_EQ(etag.back(), '"');
+  EXPECT_NE(etag, NGnPayloadCache::ComputeETag("payload-b"));
+  EXPECT_TRUE(cache.Get("b", payload));
+  EXPECT_FALSE(cache.Get("x", payload));
+  EXPECT_EQ(cache.GetHits(), 2u);
+  EXPECT_EQ(cache.GetMisses(), 1u);
+}
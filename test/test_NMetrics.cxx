@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+#include "NLogger.h"
+#include "NMetrics.h"
+
+TEST(NMetricsTest, SamplesOnlyEveryInterval)
+{
+  const auto severity = Ndmspc::NLogger::GetMinSeverity();
+  Ndmspc::NLogger::SetMinSeverity(Ndmspc::logs::Severity::kInfo);
+  int evaluated = 0;
+  NLogDebug("not printed %d", ++evaluated);
+  EXPECT_EQ(evaluated, 0) << "Arguments of disabled log levels must not be evaluated";
+  Ndmspc::NLogger::SetMinSeverity(severity);
+
+  Ndmspc::NMetrics::Reset();
+  Ndmspc::NMetrics::SetSampleInterval(4);
+  for (int i = 0; i < 10; ++i) {
+    Ndmspc::NMetrics::Add(Ndmspc::NMetrics::kTreeBytesRead, 100);
+    Ndmspc::NMetrics::Tick(Ndmspc::NMetrics::kTreeEntriesRead);
+  }
+  EXPECT_EQ(Ndmspc::NMetrics::Get(Ndmspc::NMetrics::kTreeEntriesRead), 10);
+  EXPECT_EQ(Ndmspc::NMetrics::Get(Ndmspc::NMetrics::kTreeBytesRead), 1000);
+  EXPECT_EQ(Ndmspc::NMetrics::Get(Ndmspc::NMetrics::kRssSamples), 2);
+  EXPECT_GE(Ndmspc::NMetrics::Get(Ndmspc::NMetrics::kRssPeakKB), Ndmspc::NMetrics::Get(Ndmspc::NMetrics::kRssLastKB));
+
+  Ndmspc::NMetrics::SetSampleInterval(0);
+  Ndmspc::NMetrics::Tick(Ndmspc::NMetrics::kTreeEntriesRead);
+  EXPECT_EQ(Ndmspc::NMetrics::Get(Ndmspc::NMetrics::kRssSamples), 2);
+  Ndmspc::NMetrics::Reset();
+}
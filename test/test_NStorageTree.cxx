@@ -0,0 +1,312 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+#include <TFile.h>
+#include <TH1D.h>
+#include <TList.h>
+#include <TNamed.h>
+#include <TParameter.h>
+#include <TROOT.h>
+#include <TTree.h>
+#include "NBinning.h"
+#include "NGnTree.h"
+#include "NStorageTree.h"
+
+TEST(NStorageTreeTest, ReadAheadMatchesDirectRead)
+{
+  TH1::AddDirectory(kFALSE);
+  ROOT::EnableThreadSafety(); // the read-ahead does not enable it on its own
+  const std::string fileName = "test_NStorageTreeReadAhead.root";
+  const int         nEntries = 20;
+  {
+    TFile  f(fileName.c_str(), "RECREATE");
+    TTree  tree("ngnt", "ngnt");
+    TH1D * h = nullptr;
+    tree.Branch("h", &h);
+    for (int i = 0; i < nEntries; ++i) {
+      delete h;
+      h = new TH1D("h", "h", 10, 0, 10);
+      h->Fill(i % 10, i + 1);
+      tree.Fill();
+    }
+    tree.Write();
+    delete h;
+  }
+
+  TObjArray * axes = new TObjArray();
+  TAxis *     x    = new TAxis(nEntries, 0., nEntries);
+  x->SetNameTitle("x", "x");
+  axes->Add(x);
+  Ndmspc::NBinning                                     binning(axes);
+  std::map<std::string, std::vector<std::vector<int>>> b0;
+  b0["x"] = {{1}};
+  binning.AddBinningDefinition("b0", b0);
+  binning.SetCurrentDefinitionName("b0");
+
+  TFile * f = TFile::Open(fileName.c_str());
+  ASSERT_NE(f, nullptr);
+  Ndmspc::NStorageTree storage(&binning);
+  ASSERT_TRUE(storage.SetFileTree(f, f->Get<TTree>("ngnt")));
+  ASSERT_TRUE(storage.AddBranch("h", nullptr, "TH1D"));
+  storage.SetBranchAddresses();
+
+  ASSERT_TRUE(storage.StartReadAhead({3, 5, 6, 10, 15, 19}, 2));
+  // 5 and 15 are skipped, 2 is not in the list and is read directly
+  for (Long64_t e : std::vector<Long64_t>{3, 6, 10, 2, 19}) {
+    ASSERT_GT(storage.GetEntry(e, binning.GetPoint()), 0) << "entry " << e;
+    TH1D * h = dynamic_cast<TH1D *>(storage.GetBranchObject("h"));
+    ASSERT_NE(h, nullptr);
+    EXPECT_DOUBLE_EQ(h->GetSumOfWeights(), e + 1) << "entry " << e;
+  }
+  storage.StopReadAhead();
+  EXPECT_FALSE(storage.IsReadAhead());
+
+  f->Close();
+  delete f;
+  std::remove(fileName.c_str());
+}
+
+TEST(NStorageTreeTest, OutputPointColumns)
+{
+  TH1::AddDirectory(kFALSE);
+  Ndmspc::NStorageTree storage;
+  ASSERT_TRUE(storage.InitTree("", "ngnt"));
+
+  TList first;
+  first.SetOwner(kTRUE);
+  first.Add(new TH1D("h", "h", 10, 0, 10));
+  first.Add(new TParameter<double>("chi2", 1.5));
+  first.Add(new TNamed("note", "first"));
+  first.Add(new TNamed("pt/0.5*", "stays in the list"));
+  storage.SetOutputPoint(&first);
+  EXPECT_EQ(storage.GetOutputPointColumns(), (std::vector<std::string>{"h", "chi2", "note"}));
+  TBranch * chi2 = storage.GetTree()->GetBranch("_outputPoint_chi2.");
+  TBranch * h    = storage.GetTree()->GetBranch("_outputPoint_h.");
+  ASSERT_NE(chi2, nullptr);
+  ASSERT_NE(h, nullptr);
+  EXPECT_GT(chi2->GetListOfBranches()->GetEntries(), 0) << "Scalar parameters are split into columns";
+  EXPECT_NE(storage.GetTree()->GetBranch("_outputPoint_chi2.fVal"), nullptr) << "Sub-branches carry the column name";
+  EXPECT_EQ(h->GetListOfBranches()->GetEntries(), 0) << "Other objects are stored whole";
+  ASSERT_GT(storage.GetTree()->Fill(), 0);
+
+  // Later lists: missing columns are reported as missing, new names stay in the _outputPoint list
+  TList second;
+  second.SetOwner(kTRUE);
+  second.Add(new TParameter<double>("chi2", 2.5));
+  second.Add(new TNamed("extra", "second"));
+  storage.SetOutputPoint(&second);
+  EXPECT_EQ(storage.GetOutputPointObject("h"), nullptr);
+  EXPECT_EQ(storage.GetOutputPointObject("note"), nullptr);
+  auto * p = dynamic_cast<TParameter<double> *>(storage.GetOutputPointObject("chi2"));
+  ASSERT_NE(p, nullptr);
+  EXPECT_DOUBLE_EQ(p->GetVal(), 2.5);
+  ASSERT_NE(storage.GetOutputPointObject("extra"), nullptr);
+  TList * all = storage.GetOutputPoint();
+  ASSERT_NE(all, nullptr);
+  EXPECT_EQ(all->GetEntries(), 2);
+  ASSERT_GT(storage.GetTree()->Fill(), 0);
+  EXPECT_EQ(storage.GetTree()->GetEntries(), 2);
+}
+
+TEST(NStorageTreeTest, OutputPointColumnsRoundTrip)
+{
+  TH1::AddDirectory(kFALSE);
+  const std::string fileName = "test_NStorageTreeColumns.root";
+  const int         nBins    = 4;
+  std::remove(fileName.c_str());
+  {
+    TObjArray * axes = new TObjArray();
+    TAxis *     x    = new TAxis(nBins, 0., nBins);
+    x->SetNameTitle("x", "x");
+    axes->Add(x);
+    Ndmspc::NGnTree *                                    ngnt = new Ndmspc::NGnTree(axes, fileName);
+    std::map<std::string, std::vector<std::vector<int>>> b0;
+    b0["x"] = {{1}};
+    ngnt->GetBinning()->AddBinningDefinition("b0", b0);
+
+    Ndmspc::NGnProcessFuncPtr processFunc = [](Ndmspc::NBinningPoint * point, TList * /*output*/,
+                                               TList * outputPoint, int /*threadId*/) {
+      const double x = point->GetBinCenter("x");
+      outputPoint->Add(new TParameter<double>("chi2", x));
+      outputPoint->Add(new TParameter<double>("mass", 10 * x));
+      // Only the first bin has a histogram, the other entries mark the column as missing
+      if (x < 1) outputPoint->Add(new TH1D("h", "h", 10, 0, 10));
+    };
+    Ndmspc::NGnBeginFuncPtr beginFunc = [](Ndmspc::NBinningPoint * /*point*/, int /*threadId*/) {
+      TH1::AddDirectory(kFALSE);
+    };
+    Ndmspc::NGnEndFuncPtr endFunc = [](Ndmspc::NBinningPoint * /*point*/, int /*threadId*/) {};
+    ASSERT_TRUE(ngnt->Process(processFunc, json::object(), "", beginFunc, endFunc));
+    delete ngnt;
+  }
+
+  // Only _params is enabled, so the output point columns are read through the disabled-branch path
+  Ndmspc::NGnTree * ngnt = Ndmspc::NGnTree::Open(fileName, "_params");
+  ASSERT_NE(ngnt, nullptr);
+  ASSERT_EQ(ngnt->GetEntries(), nBins);
+  Ndmspc::NStorageTree * storage = ngnt->GetStorageTree();
+  TTree *                tree    = storage->GetTree();
+  ASSERT_NE(tree->GetBranch("_outputPoint_chi2.fVal"), nullptr);
+  ASSERT_NE(tree->GetBranch("_outputPoint_mass.fVal"), nullptr);
+  EXPECT_EQ(tree->GetBranchStatus("_outputPoint_chi2."), 0);
+
+  for (Long64_t e = 0; e < nBins; ++e) {
+    ngnt->GetEntry(e);
+    auto * chi2 = dynamic_cast<TParameter<double> *>(storage->GetOutputPointObject("chi2"));
+    auto * mass = dynamic_cast<TParameter<double> *>(storage->GetOutputPointObject("mass"));
+    ASSERT_NE(chi2, nullptr) << "entry " << e;
+    ASSERT_NE(mass, nullptr) << "entry " << e;
+    EXPECT_DOUBLE_EQ(mass->GetVal(), 10 * chi2->GetVal()) << "entry " << e;
+    TH1 * h = dynamic_cast<TH1 *>(storage->GetOutputPointObject("h"));
+    if (chi2->GetVal() < 1)
+      EXPECT_NE(h, nullptr) << "entry " << e;
+    else
+      EXPECT_EQ(h, nullptr) << "entry " << e;
+  }
+  EXPECT_EQ(tree->GetBranchStatus("_outputPoint_chi2."), 1);
+
+  ngnt->Close(false);
+  delete ngnt;
+  std::remove(fileName.c_str());
+}
+
+TEST(NStorageTreeTest, OutputPointColumnsMergeAcrossWorkers)
+{
+  TH1::AddDirectory(kFALSE);
+  const std::string fileName = "test_NStorageTreeColumnsMerge.root";
+  const int         nBins    = 16;
+  const int         nThreads = 2;
+  std::remove(fileName.c_str());
+  ROOT::EnableImplicitMT(nThreads);
+  {
+    TObjArray * axes = new TObjArray();
+    TAxis *     x    = new TAxis(nBins, 0., nBins);
+    x->SetNameTitle("x", "x");
+    axes->Add(x);
+    Ndmspc::NGnTree *                                    ngnt = new Ndmspc::NGnTree(axes, fileName);
+    std::map<std::string, std::vector<std::vector<int>>> b0;
+    b0["x"] = {{1}};
+    ngnt->GetBinning()->AddBinningDefinition("b0", b0);
+
+    // Every worker writes its own column, so each worker file lacks the columns of the others
+    Ndmspc::NGnProcessFuncPtr processFunc = [](Ndmspc::NBinningPoint * point, TList * /*output*/,
+                                               TList * outputPoint, int threadId) {
+      const double x = point->GetBinCenter("x");
+      outputPoint->Add(new TParameter<double>("chi2", x));
+      outputPoint->Add(new TParameter<double>(("w" + std::to_string(threadId)).c_str(), x));
+    };
+    Ndmspc::NGnBeginFuncPtr beginFunc = [](Ndmspc::NBinningPoint * /*point*/, int /*threadId*/) {
+      TH1::AddDirectory(kFALSE);
+    };
+    Ndmspc::NGnEndFuncPtr endFunc = [](Ndmspc::NBinningPoint * /*point*/, int /*threadId*/) {};
+    ASSERT_TRUE(ngnt->Process(processFunc, json::object(), "", beginFunc, endFunc));
+    delete ngnt;
+  }
+  ROOT::DisableImplicitMT();
+
+  Ndmspc::NGnTree * ngnt = Ndmspc::NGnTree::Open(fileName);
+  ASSERT_NE(ngnt, nullptr);
+  ASSERT_EQ(ngnt->GetEntries(), nBins);
+  Ndmspc::NStorageTree * storage = ngnt->GetStorageTree();
+  for (Long64_t e = 0; e < nBins; ++e) {
+    ngnt->GetEntry(e);
+    auto * chi2 = dynamic_cast<TParameter<double> *>(storage->GetOutputPointObject("chi2"));
+    ASSERT_NE(chi2, nullptr) << "entry " << e;
+    // Exactly one worker object per entry; the other workers' columns are marked missing
+    int nWorkers = 0;
+    for (int t = 0; t < nThreads; ++t) {
+      auto * w = dynamic_cast<TParameter<double> *>(storage->GetOutputPointObject("w" + std::to_string(t)));
+      if (w == nullptr) continue;
+      EXPECT_DOUBLE_EQ(w->GetVal(), chi2->GetVal()) << "entry " << e;
+      ++nWorkers;
+    }
+    EXPECT_EQ(nWorkers, 1) << "entry " << e;
+  }
+
+  ngnt->Close(false);
+  delete ngnt;
+  std::remove(fileName.c_str());
+}
+
+TEST(NStorageTreeTest, DefinitionIdsAreReadFromIndex)
+{
+  TH1::AddDirectory(kFALSE);
+  const std::string fileName = "test_NStorageTreeIndex.root";
+  const int         nBins    = 6;
+  std::remove(fileName.c_str());
+  std::vector<Long64_t> ids;
+  {
+    TObjArray * axes = new TObjArray();
+    TAxis *     x    = new TAxis(nBins, 0., nBins);
+    x->SetNameTitle("x", "x");
+    axes->Add(x);
+    Ndmspc::NGnTree *                                    ngnt = new Ndmspc::NGnTree(axes, fileName);
+    std::map<std::string, std::vector<std::vector<int>>> b0;
+    b0["x"] = {{1}};
+    ngnt->GetBinning()->AddBinningDefinition("b0", b0);
+
+    Ndmspc::NGnProcessFuncPtr processFunc = [](Ndmspc::NBinningPoint * point, TList * output, TList * outputPoint,
+                                               int /*threadId*/) {
+      TH1D * h = dynamic_cast<TH1D *>(output->FindObject("hx"));
+      if (h == nullptr) {
+        h = new TH1D("hx", "hx", 10, 0, 10);
+        output->Add(h);
+      }
+      h->Fill(point->GetBinCenter("x"));
+      outputPoint->Add(new TParameter<double>("x", point->GetBinCenter("x")));
+    };
+    Ndmspc::NGnBeginFuncPtr beginFunc = [](Ndmspc::NBinningPoint * /*point*/, int /*threadId*/) {
+      TH1::AddDirectory(kFALSE);
+    };
+    Ndmspc::NGnEndFuncPtr endFunc = [](Ndmspc::NBinningPoint * /*point*/, int /*threadId*/) {};
+    ASSERT_TRUE(ngnt->Process(processFunc, json::object(), "", beginFunc, endFunc));
+    ids = ngnt->GetBinning()->GetDefinition("b0")->GetIds();
+    delete ngnt;
+  }
+  ASSERT_EQ(ids.size(), static_cast<size_t>(nBins));
+
+  // The binning in the user info carries no ids, they are in the index
+  {
+    TFile   f(fileName.c_str());
+    TTree * tree = f.Get<TTree>("ngnt");
+    ASSERT_NE(tree, nullptr);
+    auto * binning = dynamic_cast<Ndmspc::NBinning *>(tree->GetUserInfo()->At(0));
+    ASSERT_NE(binning, nullptr);
+    EXPECT_TRUE(binning->GetDefinition("b0")->GetIds().empty());
+    auto * indexIds = f.Get<std::vector<Long64_t>>("index/b0");
+    ASSERT_NE(indexIds, nullptr);
+    EXPECT_EQ(*indexIds, ids);
+    delete indexIds;
+  }
+
+  Ndmspc::NGnTree * ngnt = Ndmspc::NGnTree::Open(fileName);
+  ASSERT_NE(ngnt, nullptr);
+  Ndmspc::NBinningDef * def = ngnt->GetBinning()->GetDefinition("b0");
+  ASSERT_NE(def, nullptr);
+  EXPECT_FALSE(def->HasIdsLoaded());
+  EXPECT_EQ(def->GetIds(), ids);
+  EXPECT_TRUE(def->HasIdsLoaded());
+  const std::map<std::string, TList *> outputs = ngnt->GetOutputs();
+  ASSERT_FALSE(outputs.empty());
+  const std::string outputName = outputs.begin()->first;
+  ngnt->Close(false);
+  delete ngnt;
+
+  // Closing the storage directly leaves neither ids nor outputs reading from the closed file
+  ngnt = Ndmspc::NGnTree::Open(fileName);
+  ASSERT_NE(ngnt, nullptr);
+  def = ngnt->GetBinning()->GetDefinition("b0");
+  ngnt->GetStorageTree()->Close(false);
+  TList * output = ngnt->GetOutput(outputName);
+  ASSERT_NE(output, nullptr);
+  EXPECT_TRUE(output->IsEmpty());
+  std::vector<Long64_t> fromContent = def->GetIds();
+  std::sort(fromContent.begin(), fromContent.end());
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(fromContent, ids);
+  delete ngnt;
+  std::remove(fileName.c_str());
+}
@@ -276,3 +276,115 @@ TEST_F(NTaskStateManagerTest, StressManyTasksAndWorkers) {
   // All should be back in pending
   ASSERT_EQ(mgr.PendingCount(), numTasks / 2); // Only running tasks recovered
 }
+
+/// Test speculative owners: first completion wins and clears every owner
+TEST_F(NTaskStateManagerTest, SpeculativeOwnerFirstDoneWins) {
+  mgr.AddPending(0, std::vector<int>{7});
+  
+  size_t taskId;
+  std::vector<int> payload;
+  mgr.ClaimNextPendingForWorker("worker_1", taskId, payload);
+  
+  ASSERT_TRUE(mgr.AddSpeculativeOwner("worker_2", 0));
+  ASSERT_FALSE(mgr.AddSpeculativeOwner("worker_2", 0)); // already owner
+  ASSERT_FALSE(mgr.AddSpeculativeOwner("worker_1", 0)); // primary owner
+  ASSERT_TRUE(mgr.IsTaskOwner(0, "worker_1"));
+  ASSERT_TRUE(mgr.IsTaskOwner(0, "worker_2"));
+  ASSERT_EQ(mgr.GetTaskWorkers(0).size(), 2);
+  ASSERT_EQ(mgr.GetTaskWorker(0), "worker_1");
+  ASSERT_EQ(mgr.RunningCount(), 1);
+  
+  ASSERT_TRUE(mgr.MarkDone(0));
+  ASSERT_FALSE(mgr.MarkDone(0)); // loser's late completion is rejected
+  ASSERT_FALSE(mgr.IsTaskOwner(0, "worker_1"));
+  ASSERT_FALSE(mgr.IsTaskOwner(0, "worker_2"));
+  ASSERT_TRUE(mgr.GetWorkerTasks("worker_1").empty());
+  ASSERT_TRUE(mgr.GetWorkerTasks("worker_2").empty());
+}
+
+/// Test that losing one owner of a speculated task keeps it running
+TEST_F(NTaskStateManagerTest, RecoverSpeculatedTaskKeepsOtherOwner) {
+  mgr.AddPending(0, std::vector<int>{1});
+  mgr.AddPending(1, std::vector<int>{2});
+  
+  size_t taskId;
+  std::vector<int> payload;
+  mgr.ClaimNextPendingForWorker("worker_1", taskId, payload);
+  mgr.ClaimNextPendingForWorker("worker_1", taskId, payload);
+  ASSERT_TRUE(mgr.AddSpeculativeOwner("worker_2", 0));
+  
+  // Primary fails: task 0 continues on worker_2, task 1 is requeued
+  auto recovered = mgr.RecoverWorkerTasks("worker_1");
+  ASSERT_EQ(recovered.size(), 1);
+  ASSERT_EQ(recovered[0].first, 1);
+  ASSERT_EQ(mgr.GetTaskWorker(0), "worker_2");
+  ASSERT_EQ(mgr.RunningCount(), 1);
+  ASSERT_EQ(mgr.PendingCount(), 1);
+  
+  // Last owner fails: task 0 is requeued as well
+  recovered = mgr.RecoverWorkerTasks("worker_2");
+  ASSERT_EQ(recovered.size(), 1);
+  ASSERT_EQ(mgr.PendingCount(), 2);
+  ASSERT_EQ(mgr.RunningCount(), 0);
+}
+
+/// Test that the range set merges neighbours and splits on erase
+TEST(NTaskRangeSetTest, MergesAndSplitsRanges) {
+  NTaskRangeSet set;
+  ASSERT_TRUE(set.Insert(5));
+  ASSERT_TRUE(set.Insert(7));
+  ASSERT_EQ(set.RangeCount(), 2);
+  ASSERT_TRUE(set.Insert(6)); // bridges [5,6) and [7,8)
+  ASSERT_FALSE(set.Insert(6));
+  ASSERT_EQ(set.RangeCount(), 1);
+  ASSERT_EQ(set.InsertRange(0, 10), 7);
+  ASSERT_EQ(set.Size(), 10);
+  
+  ASSERT_TRUE(set.Erase(4));
+  ASSERT_FALSE(set.Erase(4));
+  ASSERT_FALSE(set.Contains(4));
+  ASSERT_TRUE(set.Contains(3));
+  ASSERT_TRUE(set.Contains(5));
+  ASSERT_EQ(set.RangeCount(), 2);
+  ASSERT_EQ(set.Size(), 9);
+  
+  size_t id = 0;
+  ASSERT_TRUE(set.PopFront(id));
+  ASSERT_EQ(id, 0);
+  ASSERT_EQ(set.Front(), 1);
+  ASSERT_EQ(set.ToVector(), (std::vector<size_t>{1, 2, 3, 5, 6, 7, 8, 9}));
+}
+
+/// Test that derived payloads keep state compact and survive worker failure
+TEST(NTaskStateManagerRangeTest, ResolverKeepsStateCompact) {
+  NTaskStateManager mgr;
+  mgr.SetPayloadResolver([](size_t id, std::vector<int> & payload) { payload = {static_cast<int>(id), -1}; });
+  
+  const size_t numTasks = 100000;
+  size_t taskId;
+  std::vector<int> payload;
+  for (size_t i = 0; i < numTasks; ++i) {
+    mgr.AddPending(i, {});
+    ASSERT_TRUE(mgr.ClaimNextPendingForWorker(i < numTasks / 2 ? "worker_1" : "worker_2", taskId, payload));
+    ASSERT_EQ(payload, (std::vector<int>{static_cast<int>(i), -1}));
+  }
+  ASSERT_EQ(mgr.WorkerTaskCount("worker_1"), numTasks / 2);
+  
+  for (size_t i = 0; i < numTasks / 2; i += 2) mgr.MarkDone(i);
+  
+  // worker_1 fails: its unfinished (odd) tasks return to pending with their payloads
+  auto recovered = mgr.RecoverWorkerTasks("worker_1");
+  ASSERT_EQ(recovered.size(), numTasks / 4);
+  ASSERT_EQ(recovered[0].first, 1);
+  ASSERT_EQ(recovered[0].second, (std::vector<int>{1, -1}));
+  ASSERT_EQ(mgr.PendingCount(), numTasks / 4);
+  ASSERT_EQ(mgr.RunningCount(), numTasks / 2);
+  ASSERT_TRUE(mgr.GetTaskPayload(3, payload));
+  ASSERT_EQ(payload, (std::vector<int>{3, -1}));
+  
+  // Done tasks can be replayed without a stored payload
+  ASSERT_TRUE(mgr.RequeueTask(0));
+  ASSERT_TRUE(mgr.ClaimNextPendingForWorker("worker_3", taskId, payload));
+  ASSERT_EQ(taskId, 0);
+  ASSERT_EQ(mgr.DoneCount(), numTasks / 4 - 1);
+}
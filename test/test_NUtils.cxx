@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <TH1D.h>
+#include <THnSparse.h>
+#include <TList.h>
+#include <TString.h>
+#include "NUtils.h"
+
+namespace {
+TList * MakeMergeList(int seed)
+{
+  TH1::AddDirectory(kFALSE);
+  auto * lst = new TList();
+  lst->SetOwner(kTRUE);
+  auto * h = new TH1D("h", "h", 10, 0, 10);
+  for (int i = 0; i <= seed; ++i) h->Fill(0.1 * seed + i % 10, 1.0 / (seed + 1));
+  lst->Add(h);
+
+  Int_t    bins[2] = {4, 4};
+  Double_t min[2]  = {0, 0};
+  Double_t max[2]  = {4, 4};
+  auto *   hns     = new THnSparseD("hns", "hns", 2, bins, min, max);
+  Double_t x[2]    = {0.5 + seed % 4, 1.5};
+  hns->Fill(x);
+  lst->Add(hns);
+
+  auto * nested = new TList();
+  nested->SetName("nested");
+  nested->SetOwner(kTRUE);
+  nested->Add(new TH1D(TString::Format("only%d", seed % 2).Data(), "", 2, 0, 2));
+  lst->Add(nested);
+  return lst;
+}
+} // namespace
+
+TEST(NUtilsMergeTest, PairwiseReductionMergesMixedTypes)
+{
+  std::vector<TList *> lists;
+  for (int i = 0; i < 5; ++i) lists.push_back(MakeMergeList(i));
+  EXPECT_EQ(Ndmspc::NUtils::MergeListsPairwise(lists), 4);
+
+  auto * h = dynamic_cast<TH1D *>(lists[0]->FindObject("h"));
+  ASSERT_NE(h, nullptr);
+  EXPECT_DOUBLE_EQ(h->GetEntries(), 15);
+  auto * hns = dynamic_cast<THnSparse *>(lists[0]->FindObject("hns"));
+  ASSERT_NE(hns, nullptr);
+  EXPECT_DOUBLE_EQ(hns->GetEntries(), 5);
+  auto * nested = dynamic_cast<TList *>(lists[0]->FindObject("nested"));
+  ASSERT_NE(nested, nullptr);
+  EXPECT_NE(nested->FindObject("only0"), nullptr);
+  EXPECT_NE(nested->FindObject("only1"), nullptr);
+
+  for (auto * l : lists) delete l;
+}
+
+TEST(NUtilsMergeTest, PairwiseReductionIsReproducible)
+{
+  std::vector<double> sums;
+  for (int run = 0; run < 2; ++run) {
+    std::vector<TList *> lists;
+    for (int i = 0; i < 9; ++i) lists.push_back(MakeMergeList(i));
+    Ndmspc::NUtils::MergeListsPairwise(lists);
+    auto * h = dynamic_cast<TH1D *>(lists[0]->FindObject("h"));
+    ASSERT_NE(h, nullptr);
+    for (int b = 1; b <= h->GetNbinsX(); ++b) sums.push_back(h->GetBinContent(b));
+    for (auto * l : lists) delete l;
+  }
+  const size_t n = sums.size() / 2;
+  for (size_t i = 0; i < n; ++i) EXPECT_EQ(sums[i], sums[n + i]);
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <THttpCallArg.h>
+#include <TSystem.h>
+#include "NWsHandler.h"
+
+using namespace Ndmspc;
+
+/// Handler recording sent messages instead of passing them to websocket engine
+class NWsHandlerStub : public NWsHandler {
+  public:
+  using NWsHandler::CompleteWSSend;
+
+  std::vector<std::pair<ULong_t, std::string>> fSent;       ///< Sent messages
+  bool                                         fAsync{true}; ///< Sending thread completes send later
+
+  void Connect(ULong_t wsId)
+  {
+    THttpCallArg arg;
+    arg.SetMethod("WS_READY");
+    arg.SetWSId(wsId);
+    ProcessWS(&arg);
+  }
+
+  /// Completes send operations of client until its queue is empty
+  std::vector<std::string> DrainClient(ULong_t wsId)
+  {
+    std::vector<std::string> sent;
+    for (size_t n = fSent.size();; n = fSent.size()) {
+      CompleteWSSend(wsId);
+      if (fSent.size() == n) break;
+      sent.push_back(fSent.back().second);
+    }
+    return sent;
+  }
+
+  protected:
+  Int_t SendFrame(ULong_t wsId, const std::string & data, bool) override
+  {
+    fSent.emplace_back(wsId, data);
+    if (fAsync) return 1;
+    CompleteWSSend(wsId);
+    return 0;
+  }
+};
+
+/// Creates handler with queue limits set by environment
+std::unique_ptr<NWsHandlerStub> CreateHandler(const char * queueSize, const char * policy)
+{
+  gSystem->Setenv("NDMSPC_WS_QUEUE_SIZE", queueSize);
+  gSystem->Setenv("NDMSPC_WS_SLOW_CLIENT", policy);
+  auto handler = std::make_unique<NWsHandlerStub>();
+  gSystem->Unsetenv("NDMSPC_WS_QUEUE_SIZE");
+  gSystem->Unsetenv("NDMSPC_WS_SLOW_CLIENT");
+  return handler;
+}
+
+json MapMessage(int i, const std::string & pad = "pad1")
+{
+  json msg;
+  msg["event"]                       = "ngnt";
+  msg["payload"]["map"]["targetPad"] = pad;
+  msg["payload"]["map"]["i"]         = i;
+  return msg;
+}
+
+TEST(NWsHandlerTest, CoalesceKey)
+{
+  EXPECT_EQ(NWsHandler::GetCoalesceKey(json::parse(R"({"event":"heartbeat","payload":{}})")), "heartbeat");
+  EXPECT_EQ(NWsHandler::GetCoalesceKey(json::parse(R"({"event":"clients","payload":{}})")), "clients");
+  EXPECT_EQ(NWsHandler::GetCoalesceKey(MapMessage(0)), "ngnt:map@pad1");
+  EXPECT_NE(NWsHandler::GetCoalesceKey(MapMessage(0)), NWsHandler::GetCoalesceKey(MapMessage(0, "pad2")));
+  EXPECT_EQ(NWsHandler::GetCoalesceKey(
+                json::parse(R"({"event":"ngnt","payload":{"map":{"targetPad":"pad1"},"workspace":{}}})")),
+            "ngnt:map@pad1:workspace");
+
+  // Messages which are not states are never coalesced
+  EXPECT_EQ(NWsHandler::GetCoalesceKey(json::parse(R"({"event":"ngnt","payload":{"map":{"appendToTab":true}}})")),
+            "");
+  EXPECT_EQ(NWsHandler::GetCoalesceKey(json::parse(R"({"event":"welcome","payload":{}})")), "");
+  EXPECT_EQ(NWsHandler::GetCoalesceKey(json::parse(R"({"event":"ngnt","payload":null})")), "");
+  EXPECT_EQ(NWsHandler::GetCoalesceKey(json::parse(R"({"event":1})")), "");
+  EXPECT_EQ(NWsHandler::GetCoalesceKey(json::parse(R"("text")")), "");
+}
+
+TEST(NWsHandlerTest, CoalescesStatesAndDropsTransientMessagesFirst)
+{
+  auto handler = CreateHandler("4", "drop");
+  handler->Connect(1);
+  ASSERT_EQ(handler->fSent.size(), 1u) << "Only welcome is in flight";
+  EXPECT_NE(handler->fSent[0].second.find("welcome"), std::string::npos);
+
+  for (int i = 0; i < 10; ++i) handler->Broadcast(MapMessage(i));
+  for (int i = 0; i < 10; ++i) handler->Broadcast("chat" + std::to_string(i));
+  EXPECT_EQ(handler->fSent.size(), 1u) << "Nothing is sent before previous send is completed";
+
+  std::vector<std::string> sent = handler->DrainClient(1);
+  ASSERT_EQ(sent.size(), 4u);
+  EXPECT_NE(sent[0].find("\"clients\""), std::string::npos);
+  EXPECT_EQ(json::parse(sent[1]), MapMessage(9)) << "Only the latest state is kept";
+  EXPECT_EQ(sent[2], "chat8");
+  EXPECT_EQ(sent[3], "chat9");
+}
+
+TEST(NWsHandlerTest, SendsDirectlyWhenEngineIsIdle)
+{
+  auto handler    = CreateHandler("4", "drop");
+  handler->fAsync = false;
+  handler->Connect(1);
+  handler->Connect(2);
+  handler->fSent.clear();
+
+  // Completed sends continue in the same loop, nothing is dropped or coalesced
+  for (int i = 0; i < 100; ++i) handler->Broadcast(MapMessage(i));
+  ASSERT_EQ(handler->fSent.size(), 200u);
+  EXPECT_EQ(json::parse(handler->fSent.back().second), MapMessage(99));
+}
+
+TEST(NWsHandlerTest, DisconnectsSlowClient)
+{
+  auto handler = CreateHandler("2", "disconnect");
+  handler->Connect(1);
+  handler->fAsync = false;
+  handler->Connect(2);
+  ASSERT_EQ(handler->GetClientCount(), 2u);
+
+  // Client 1 never completes its welcome, its queue overflows
+  for (int i = 0; i < 3; ++i) handler->Broadcast("chat" + std::to_string(i));
+  handler->fSent.clear();
+  handler->Broadcast("late");
+  ASSERT_EQ(handler->fSent.size(), 1u);
+  EXPECT_EQ(handler->fSent[0].first, 2u) << "Closed queue does not take messages";
+  EXPECT_TRUE(handler->DrainClient(1).empty());
+
+  handler->HandleTimer(nullptr);
+  EXPECT_EQ(handler->GetClientCount(), 1u);
+}